@@ -1,53 +1,18 @@
-#version 330 core
+#version 430 core
 
 #pragma symbol SHADER_LIT
 
-#define MAX_POINT_LIGHTS 4
-#define MAX_SPOT_LIGHTS 2
-#define MAX_DIRECTIONAL_LIGHTS 1
-
-struct PointLight
-{
-	vec3 pos;
-	vec3 color;
-	vec3 ambient;
-	float range;
-	float max_strength;
-};
-
-struct SpotLight
-{
-	vec3 pos;
-	vec3 dir;
-	vec3 color;
-	vec3 ambient;
-	float range;
-	float umbra_cos;
-	float penumbra_cos;
-};
-
-
-struct DirectionalLight
-{
-	vec3 dir;
-	vec3 color;
-	vec3 ambient;
-	float intensity;
-};
+#include "lighting.glsl"
 
 in vec3 pos;
 in vec3 normal;
 in vec2 tex_coord;
+in vec4 object_color;
 
 out vec4 frag_color;
 
-uniform vec4 base_color = vec4(1);
 uniform sampler2D color_tex;
 
-uniform vec3 view_pos = vec3(0);
-uniform PointLight point_lights[MAX_POINT_LIGHTS];
-uniform SpotLight spot_lights[MAX_SPOT_LIGHTS];
-uniform DirectionalLight directional_lights[MAX_DIRECTIONAL_LIGHTS];
 uniform float specular_strength = 0.5;
 uniform float shinyness = 32;
 
@@ -76,12 +41,15 @@ float map(float value, float min1, float max1, float min2, float max2) {
 
 void main()
 {
-	vec4 obj_color = texture(color_tex, tex_coord) * base_color;
+	vec4 obj_color = texture(color_tex, tex_coord) * object_color;
 	vec3 lighting = vec3(0);
 
-	for (int i = 0; i < MAX_POINT_LIGHTS; i++)
+	LightCluster cluster = get_light_cluster(pos);
+	uint cluster_end = cluster.offset + cluster.num_point_lights;
+
+	for (uint i = cluster.offset; i < cluster_end; i++)
 	{
-		PointLight light = point_lights[i];
+		PointLight light = point_lights[light_indices[i]];
 
 		vec3 light_dir = normalize(light.pos - pos);
 		vec3 diffuse_color = calc_diffuse(light_dir, light.color);
@@ -93,9 +61,9 @@ void main()
 		lighting += attenuation * (light.ambient + diffuse_color + specular_color);
 	}
 
-	for (int i = 0; i < MAX_SPOT_LIGHTS; i++)
+	for (uint i = cluster_end; i < cluster_end + cluster.num_spot_lights; i++)
 	{
-		SpotLight light = spot_lights[i];
+		SpotLight light = spot_lights[light_indices[i]];
 
 		vec3 light_dir = normalize(light.pos - pos);
 		vec3 diffuse_color = calc_diffuse(light_dir, light.color);
@@ -111,7 +79,7 @@ void main()
 		lighting += cone_falloff * attenuation * (light.ambient + diffuse_color + specular_color);
 	}
 
-	for (int i = 0; i < MAX_DIRECTIONAL_LIGHTS; i++)
+	for (uint i = 0; i < num_directional_lights; i++)
 	{
 		DirectionalLight light = directional_lights[i];
 
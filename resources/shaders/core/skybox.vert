@@ -4,8 +4,10 @@ layout(location = 0) in vec3 a_pos;
 layout(location = 2) in vec2 a_tex_coord;
 
 out vec2 tex_coord;
+out vec4 object_color;
 
 uniform mat4 view_matrix = mat4(1);
+uniform vec4 base_color = vec4(1);
 
 void main()
 {
@@ -13,4 +15,5 @@ void main()
     gl_Position = pos.xyww;
     
     tex_coord = a_tex_coord;
+    object_color = base_color;
 }
\ No newline at end of file
@@ -2,9 +2,18 @@
 
 #pragma symbol SHADER_LIT
 
+// Defaults, which can be overridden with keywords
+#ifndef MAX_POINT_LIGHTS
 #define MAX_POINT_LIGHTS 4
+#endif
+
+#ifndef MAX_SPOT_LIGHTS
 #define MAX_SPOT_LIGHTS 0
+#endif
+
+#ifndef MAX_DIRECTIONAL_LIGHTS
 #define MAX_DIRECTIONAL_LIGHTS 0
+#endif
 
 struct PointLight
 {
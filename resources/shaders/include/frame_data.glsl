@@ -0,0 +1,15 @@
+// Per frame data shared by every shader, must match FrameRenderData
+layout (std430, binding = 0) readonly buffer frame_data
+{
+    mat4 view_matrix;
+    vec3 view_pos;
+    uint num_point_lights;
+    vec3 view_dir;
+    uint num_spot_lights;
+    uint num_directional_lights;
+    uint cluster_count_x;
+    uint cluster_count_y;
+    uint cluster_count_z;
+    float cluster_depth_scale;
+    float cluster_depth_bias;
+};
\ No newline at end of file
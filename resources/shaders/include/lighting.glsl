@@ -0,0 +1,77 @@
+#include "frame_data.glsl"
+
+// Clustered lights, must match the light render data in frame_data.h
+struct PointLight
+{
+	vec3 pos;
+	float range;
+	vec3 color;
+	float max_strength;
+	vec3 ambient;
+};
+
+struct SpotLight
+{
+	vec3 pos;
+	float range;
+	vec3 dir;
+	float umbra_cos;
+	vec3 color;
+	float penumbra_cos;
+	vec3 ambient;
+};
+
+struct DirectionalLight
+{
+	vec3 dir;
+	float intensity;
+	vec3 color;
+	vec3 ambient;
+};
+
+struct LightCluster
+{
+	uint offset;
+	uint num_point_lights;
+	uint num_spot_lights;
+	uint padding;
+};
+
+layout (std430, binding = 1) readonly buffer point_light_data
+{
+	PointLight point_lights[];
+};
+
+layout (std430, binding = 2) readonly buffer spot_light_data
+{
+	SpotLight spot_lights[];
+};
+
+layout (std430, binding = 3) readonly buffer directional_light_data
+{
+	DirectionalLight directional_lights[];
+};
+
+layout (std430, binding = 4) readonly buffer light_cluster_data
+{
+	LightCluster light_clusters[];
+};
+
+layout (std430, binding = 5) readonly buffer light_index_data
+{
+	uint light_indices[];
+};
+
+// Finds the cluster containing the fragment at pos, in world space
+// Must match the cluster calculation in LightClusterer
+LightCluster get_light_cluster(vec3 pos)
+{
+	vec4 clip_pos = view_matrix * vec4(pos, 1);
+	vec2 tile = floor((clip_pos.xy / clip_pos.w * 0.5 + 0.5) * vec2(cluster_count_x, cluster_count_y));
+	tile = clamp(tile, vec2(0), vec2(cluster_count_x - 1, cluster_count_y - 1));
+
+	float depth = max(dot(pos - view_pos, view_dir), 1e-5);
+	float slice = clamp(floor(log(depth) * cluster_depth_scale + cluster_depth_bias), 0, cluster_count_z - 1);
+
+	return light_clusters[uint(tile.x) + cluster_count_x * (uint(tile.y) + cluster_count_y * uint(slice))];
+}
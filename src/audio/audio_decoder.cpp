@@ -59,8 +59,8 @@ RawAudioData AudioDecoder::load_wave(const std::string& path)
         file.read(reinterpret_cast<char*>(dst), size);                      \
         DECODE_CHECK(                                                       \
             !file.eof(),                                                    \
-            "Invalid WAV file - EOF reached at %d bytes during decoding",   \
-            std::streamoff(file.tellg())                                    \
+            "Invalid WAV file - EOF reached at %lld bytes during decoding", \
+            static_cast<long long>(file.tellg())                            \
         );                                                                  \
     } while (0)
     // TRY_READ end
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <concepts>
+#include <string>
+#include <vector>
+
+#include <utils/timing.h>
+
+// Minimal benchmark harness for peng_benchmarks
+// Benchmarks are registered with BENCHMARK and run in registration order by the runner in benchmark_main.cpp,
+// which takes an optional filter on the benchmark name
+namespace benchmarks
+{
+    using BenchmarkFunction = void(*)();
+
+    struct Benchmark
+    {
+        std::string name;
+        BenchmarkFunction function;
+    };
+
+    [[nodiscard]] std::vector<Benchmark>& registered_benchmarks();
+
+    struct BenchmarkRegistrar
+    {
+        BenchmarkRegistrar(const char* name, BenchmarkFunction function);
+    };
+
+    // Keeps the compiler from optimizing away a value which is otherwise unused
+    template <typename T>
+    void do_not_optimize(const T& value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+
+    // Runs f once to warm up and then num_samples times, returning the median duration of a run in milliseconds
+    template <typename F>
+    [[nodiscard]] double measure_median_ms(F&& f, size_t num_samples = 15)
+    {
+        f();
+
+        std::vector<double> samples;
+        samples.reserve(num_samples);
+
+        for (size_t sample = 0; sample < num_samples; sample++)
+        {
+            samples.push_back(timing::measure_ms(f));
+        }
+
+        std::ranges::nth_element(samples, samples.begin() + samples.size() / 2);
+        return samples[samples.size() / 2];
+    }
+
+    // As above, but calls reset after every run without timing it, to undo any state the run built up
+    template <typename F, std::invocable R>
+    [[nodiscard]] double measure_median_ms(F&& f, R&& reset, size_t num_samples = 15)
+    {
+        f();
+        reset();
+
+        std::vector<double> samples;
+        samples.reserve(num_samples);
+
+        for (size_t sample = 0; sample < num_samples; sample++)
+        {
+            samples.push_back(timing::measure_ms(f));
+            reset();
+        }
+
+        std::ranges::nth_element(samples, samples.begin() + samples.size() / 2);
+        return samples[samples.size() / 2];
+    }
+
+    // Prints the time of a run, along with the time per item when the run covers more than one item
+    void report(const std::string& label, double duration_ms, size_t num_items = 1);
+}
+
+#define BENCHMARK(name)                                                                                    \
+    static void benchmark_##name();                                                                        \
+    static const ::benchmarks::BenchmarkRegistrar benchmark_registrar_##name(#name, &benchmark_##name);   \
+    static void benchmark_##name()
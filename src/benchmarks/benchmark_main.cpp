@@ -0,0 +1,62 @@
+#include "benchmark.h"
+
+#include <cstdio>
+#include <memory>
+#include <string_view>
+
+#include <rendering/device.h>
+#include <rendering/recording_device.h>
+
+using namespace benchmarks;
+
+std::vector<Benchmark>& benchmarks::registered_benchmarks()
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+BenchmarkRegistrar::BenchmarkRegistrar(const char* name, BenchmarkFunction function)
+{
+    registered_benchmarks().push_back(Benchmark{
+        .name = name,
+        .function = function
+    });
+}
+
+void benchmarks::report(const std::string& label, double duration_ms, size_t num_items)
+{
+    if (num_items > 1)
+    {
+        const double item_ns = duration_ms * 1e6 / static_cast<double>(num_items);
+        std::printf("  %-56s %12.3f ms %12.2f ns/item\n", label.c_str(), duration_ms, item_ns);
+    }
+    else
+    {
+        std::printf("  %-56s %12.3f ms\n", label.c_str(), duration_ms);
+    }
+
+    std::fflush(stdout);
+}
+
+// Usage: peng_benchmarks [filter], runs every benchmark whose name contains the filter
+// Must be run from the repository root so that resources can be found
+int main(int argc, char** argv)
+{
+    const std::string_view filter = argc > 1 ? argv[1] : "";
+
+    // Benchmarks run headless, without recording so that the device adds as little as possible to the timings
+    rendering::Device::set(std::make_unique<rendering::RecordingDevice>(false));
+
+    for (const Benchmark& benchmark : registered_benchmarks())
+    {
+        if (benchmark.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        std::printf("%s\n", benchmark.name.c_str());
+        benchmark.function();
+    }
+
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <rendering/draw_call_list.h>
+#include <rendering/render_queue_stats.h>
+#include <utils/strtools.h>
+
+#include "benchmark.h"
+#include "draw_call_tree.h"
+#include "draw_scene.h"
+
+using namespace benchmarks;
+using namespace rendering;
+
+namespace
+{
+    constexpr size_t num_shaders = 16;
+    constexpr size_t num_meshes = 64;
+    constexpr size_t num_materials = 1000;
+}
+
+// Building and executing a frame's draws, comparing DrawCallList with the DrawCallTree it replaced
+// Both are reused between frames as RenderQueue does, and execute against the non-recording device
+BENCHMARK(draw_call_list)
+{
+    const DrawScene scene(num_shaders, num_meshes, num_materials);
+
+    for (const size_t num_draws : { 10000, 100000, 1000000 })
+    {
+        const std::vector<DrawCall> draw_calls = scene.make_draws(num_draws);
+        const size_t num_samples = num_draws >= 1000000 ? 5 : 15;
+
+        RenderQueueStats stats;
+
+        DrawCallTree tree;
+        report(strtools::catf("%zu draws, DrawCallTree", num_draws), measure_median_ms([&]
+        {
+            tree.rebuild(std::vector(draw_calls));
+            tree.execute(stats);
+            tree.clear();
+        }, num_samples), num_draws);
+
+        DrawCallList list;
+        report(strtools::catf("%zu draws, DrawCallList", num_draws), measure_median_ms([&]
+        {
+            list.rebuild(std::vector(draw_calls));
+            list.execute(stats);
+            list.clear();
+        }, num_samples), num_draws);
+
+        do_not_optimize(stats);
+    }
+}
@@ -6,18 +6,24 @@
 #include <utils/vectools.h>
 #include <vector>
 
-#include "draw_call.h"
-#include "mesh.h"
-#include "shader.h"
-#include "material.h"
-#include "render_queue_stats.h"
-#include "utils.h"
+#include <rendering/draw_call.h>
+#include <rendering/mesh.h>
+#include <rendering/shader.h>
+#include <rendering/material.h>
+#include <rendering/render_queue_stats.h>
+#include <rendering/utils.h>
 
-using namespace rendering;
+using namespace benchmarks;
 
 DrawCallTree::DrawCallTree(std::vector<DrawCall>&& draw_calls)
 {
-    SCOPED_EVENT("Building DrawCallTree", strtools::catf_temp("%d draw calls", draw_calls.size()));
+    rebuild(std::move(draw_calls));
+}
+
+void DrawCallTree::rebuild(std::vector<DrawCall>&& draw_calls)
+{
+    SCOPED_EVENT("Building DrawCallTree", strtools::catf_temp("%zu draw calls", draw_calls.size()));
+    clear();
 
     std::vector<DrawCall> draw_calls_ordered(std::move(draw_calls));
     std::ranges::sort(draw_calls_ordered,
@@ -51,6 +57,13 @@ DrawCallTree::DrawCallTree(std::vector<DrawCall>&& draw_calls)
     merge_tree();
 }
 
+void DrawCallTree::clear()
+{
+    _shader_draws.clear();
+    _shader_draw_indices.clear();
+    _mesh_draw_indices.clear();
+}
+
 void DrawCallTree::execute(RenderQueueStats& stats) const
 {
     SCOPED_EVENT("DrawCallTree - execute");
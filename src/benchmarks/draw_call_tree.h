@@ -1,12 +1,12 @@
 #pragma once
 
 #include <vector>
-#include <unordered_map>
 
 #include <memory/shared_ref.h>
+#include <utils/flat_hash_map.h>
 #include <utils/hash_helpers.h>
 
-#include "draw_call.h"
+#include <rendering/draw_call.h>
 
 namespace rendering
 {
@@ -14,6 +14,16 @@ namespace rendering
     class Shader;
     class Material;
     struct RenderQueueStats;
+}
+
+// The draw call tree used by RenderQueue before it was replaced by rendering::DrawCallList
+// Kept as the baseline for the draw call benchmarks
+namespace benchmarks
+{
+    using rendering::DrawCall;
+    using rendering::Mesh;
+    using rendering::Shader;
+    using rendering::RenderQueueStats;
 
     // Draw calls aggregated by the mesh, only differing in the uniforms applied
     // It is illegal for the materials to use different underlying shaders
@@ -34,11 +44,19 @@ namespace rendering
 
     // Tree of draw calls aggregated by shader, then mesh, the uniforms
     // This allows all draw calls to be executed with minimal state switches
+    // Trees are intended to be reused between frames so that the lookup tables don't need reallocating
     class DrawCallTree
     {
     public:
+        DrawCallTree() = default;
         explicit DrawCallTree(std::vector<DrawCall>&& draw_calls);
 
+        // Clears the tree and rebuilds it from the provided draw calls
+        void rebuild(std::vector<DrawCall>&& draw_calls);
+
+        // Releases all draws held by the tree, but keeps any allocated memory for the next rebuild
+        void clear();
+
         void execute(RenderQueueStats& stats) const;
 
     private:
@@ -65,10 +83,10 @@ namespace rendering
         );
 
         std::vector<ShaderDrawTree> _shader_draws;
-        std::unordered_map<peng::shared_ref<const Shader>, size_t> _shader_draw_indices;
+        utils::flat_hash_map<peng::shared_ref<const Shader>, size_t> _shader_draw_indices;
 
         // Maps from a (shader, mesh) key to a (shader_draw index, mesh_draw sub index) value
-        std::unordered_map<
+        utils::flat_hash_map<
             std::tuple<
             peng::shared_ref<const Shader>,
             peng::shared_ref<const Mesh>
@@ -0,0 +1,98 @@
+#include <tuple>
+#include <unordered_map>
+
+#include <rendering/material.h>
+#include <rendering/mesh.h>
+#include <utils/flat_hash_map.h>
+#include <utils/hash_helpers.h>
+#include <utils/strtools.h>
+
+#include "benchmark.h"
+#include "draw_call_tree.h"
+#include "draw_scene.h"
+
+using namespace benchmarks;
+using namespace rendering;
+
+namespace
+{
+    constexpr size_t num_shaders = 16;
+    constexpr size_t num_meshes = 200;
+    constexpr size_t num_materials = 1000;
+
+    // Builds the same shader and (shader, mesh) lookup tables that DrawCallTree fills for every draw
+    template <template <typename...> typename Map>
+    size_t build_tables(
+        const std::vector<DrawCall>& draw_calls,
+        Map<peng::shared_ref<const Shader>, size_t>& shader_indices,
+        Map<std::tuple<peng::shared_ref<const Shader>, peng::shared_ref<const Mesh>>, std::tuple<size_t, size_t>>& mesh_indices
+    )
+    {
+        shader_indices.clear();
+        mesh_indices.clear();
+
+        for (const DrawCall& draw_call : draw_calls)
+        {
+            const peng::shared_ref<const Shader>& shader = draw_call.material->shader();
+            const auto key = std::make_tuple(shader, draw_call.mesh.to_shared_ref());
+            if (mesh_indices.find(key) != mesh_indices.end())
+            {
+                continue;
+            }
+
+            const size_t shader_index = shader_indices.try_emplace(shader, shader_indices.size()).first->second;
+            mesh_indices[key] = std::make_tuple(shader_index, mesh_indices.size());
+        }
+
+        return mesh_indices.size();
+    }
+
+    template <template <typename...> typename Map>
+    double measure_tables_ms(const std::vector<DrawCall>& draw_calls)
+    {
+        Map<peng::shared_ref<const Shader>, size_t> shader_indices;
+        Map<std::tuple<peng::shared_ref<const Shader>, peng::shared_ref<const Mesh>>, std::tuple<size_t, size_t>> mesh_indices;
+
+        return measure_median_ms([&]
+        {
+            do_not_optimize(build_tables(draw_calls, shader_indices, mesh_indices));
+        });
+    }
+
+    template <typename Key, typename Value>
+    using std_unordered_map = std::unordered_map<Key, Value>;
+
+    template <typename Key, typename Value>
+    using flat_hash_map = utils::flat_hash_map<Key, Value>;
+}
+
+// Building the draw call tree each frame, comparing a fresh tree per frame with a tree reused between frames
+// The lookup tables are also measured on their own, with std::unordered_map against utils::flat_hash_map
+BENCHMARK(draw_call_tree)
+{
+    const DrawScene scene(num_shaders, num_meshes, num_materials);
+
+    for (const size_t num_draws : { 1000, 10000 })
+    {
+        const std::vector<DrawCall> draw_calls = scene.make_draws(num_draws);
+
+        report(strtools::catf("%zu draws, unordered_map tables", num_draws),
+            measure_tables_ms<std_unordered_map>(draw_calls), num_draws);
+
+        report(strtools::catf("%zu draws, flat_hash_map tables", num_draws),
+            measure_tables_ms<flat_hash_map>(draw_calls), num_draws);
+
+        report(strtools::catf("%zu draws, new tree per frame", num_draws), measure_median_ms([&]
+        {
+            const DrawCallTree tree{ std::vector(draw_calls) };
+            do_not_optimize(tree);
+        }), num_draws);
+
+        DrawCallTree tree;
+        report(strtools::catf("%zu draws, reused tree", num_draws), measure_median_ms([&]
+        {
+            tree.rebuild(std::vector(draw_calls));
+            tree.clear();
+        }), num_draws);
+    }
+}
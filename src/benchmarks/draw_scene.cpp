@@ -0,0 +1,93 @@
+#include "draw_scene.h"
+
+#include <random>
+
+#include <rendering/shader.h>
+#include <rendering/mesh.h>
+#include <rendering/material.h>
+#include <rendering/raw_mesh_data.h>
+#include <utils/strtools.h>
+
+using namespace benchmarks;
+using namespace rendering;
+using namespace math;
+
+DrawScene::DrawScene(size_t num_shaders, size_t num_meshes, size_t num_materials, size_t blended_interval)
+{
+    for (size_t i = 0; i < num_shaders; i++)
+    {
+        peng::shared_ref<Shader> shader = peng::make_shared<Shader>(
+            strtools::catf("Benchmark Shader %zu", i),
+            "resources/shaders/core/projection.vert",
+            "resources/shaders/core/unlit.frag"
+        );
+
+        if (blended_interval > 0 && i % blended_interval == blended_interval - 1)
+        {
+            shader->blend_mode() = BlendMode::alpha_blend;
+            shader->draw_order() = 2;
+        }
+
+        _shaders.push_back(std::move(shader));
+    }
+
+    for (size_t i = 0; i < num_meshes; i++)
+    {
+        RawMeshData raw_data;
+        raw_data.vertices = {
+            Vertex(Vector3f(-0.5f, -0.5f, 0), Vector3f(0, 0, 1), Vector2f(0, 0)),
+            Vertex(Vector3f(0.5f, -0.5f, 0), Vector3f(0, 0, 1), Vector2f(1, 0)),
+            Vertex(Vector3f(0, 0.5f, 0), Vector3f(0, 0, 1), Vector2f(0.5f, 1)),
+        };
+        raw_data.triangles = { Vector3u(0, 1, 2) };
+
+        _meshes.push_back(peng::make_shared<const Mesh>(strtools::catf("Benchmark Mesh %zu", i), std::move(raw_data)));
+    }
+
+    for (size_t i = 0; i < num_materials; i++)
+    {
+        _materials.push_back(peng::make_shared<Material>(_shaders[i % _shaders.size()]));
+    }
+}
+
+std::vector<DrawCall> DrawScene::make_draws(size_t num_draws) const
+{
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<size_t> mesh_dist(0, _meshes.size() - 1);
+    std::uniform_int_distribution<size_t> material_dist(0, _materials.size() - 1);
+    std::uniform_real_distribution<float> depth_dist(0, 100);
+
+    std::vector<DrawCall> draw_calls;
+    draw_calls.reserve(num_draws);
+
+    for (size_t i = 0; i < num_draws; i++)
+    {
+        const peng::shared_ref<Material>& material = _materials[material_dist(rng)];
+        const float depth = depth_dist(rng);
+
+        draw_calls.push_back(DrawCall{
+            .mesh = _meshes[mesh_dist(rng)],
+            .material = material,
+            .order = material->shader()->requires_blending() ? -depth : depth,
+            .instance_count = 1,
+            .bounds = physics::BoundingSphere::infinite()
+        });
+    }
+
+    return draw_calls;
+}
+
+const std::vector<peng::shared_ref<Shader>>& DrawScene::shaders() const noexcept
+{
+    return _shaders;
+}
+
+const std::vector<peng::shared_ref<const Mesh>>& DrawScene::meshes() const noexcept
+{
+    return _meshes;
+}
+
+const std::vector<peng::shared_ref<Material>>& DrawScene::materials() const noexcept
+{
+    return _materials;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <memory/shared_ref.h>
+#include <rendering/draw_call.h>
+
+namespace rendering
+{
+    class Shader;
+    class Mesh;
+    class Material;
+}
+
+namespace benchmarks
+{
+    // A set of shaders, meshes and materials to generate draw calls from, created on the installed device
+    // Every blended_interval-th shader uses alpha blending, and each material belongs to one shader
+    class DrawScene
+    {
+    public:
+        DrawScene(size_t num_shaders, size_t num_meshes, size_t num_materials, size_t blended_interval = 4);
+
+        // Generates num_draws draw calls with a fixed seed, so every call gives the same draws
+        [[nodiscard]] std::vector<rendering::DrawCall> make_draws(size_t num_draws) const;
+
+        [[nodiscard]] const std::vector<peng::shared_ref<rendering::Shader>>& shaders() const noexcept;
+        [[nodiscard]] const std::vector<peng::shared_ref<const rendering::Mesh>>& meshes() const noexcept;
+        [[nodiscard]] const std::vector<peng::shared_ref<rendering::Material>>& materials() const noexcept;
+
+    private:
+        std::vector<peng::shared_ref<rendering::Shader>> _shaders;
+        std::vector<peng::shared_ref<const rendering::Mesh>> _meshes;
+        std::vector<peng::shared_ref<rendering::Material>> _materials;
+    };
+}
@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <vector>
+
+#include <core/entity.h>
+#include <core/component.h>
+#include <utils/small_vector.h>
+
+#include "benchmark.h"
+
+using namespace benchmarks;
+
+namespace
+{
+    constexpr size_t num_entities = 10000;
+    constexpr size_t components_per_entity = 2;
+
+    // Mirrors the component bookkeeping of Entity, so that the deferred list it had before can be compared
+    // against the current one within the same build
+    template <typename DeferredList>
+    struct ComponentBookkeeping
+    {
+        utils::small_vector<peng::shared_ref<Component>, 2> components;
+        DeferredList deferred_components;
+    };
+
+    // Adds components the way Entity::add_component does before post_create, which is where components
+    // added in an entity constructor end up
+    template <typename DeferredList>
+    double measure_bookkeeping_ms(const peng::shared_ref<Component>& component)
+    {
+        std::vector<ComponentBookkeeping<DeferredList>> bookkeeping;
+        bookkeeping.reserve(num_entities);
+
+        return measure_median_ms([&]
+        {
+            for (size_t i = 0; i < num_entities; i++)
+            {
+                ComponentBookkeeping<DeferredList>& entity = bookkeeping.emplace_back();
+                for (size_t component_index = 0; component_index < components_per_entity; component_index++)
+                {
+                    entity.components.push_back(component);
+                    entity.deferred_components.push_back(component);
+                }
+            }
+
+            bookkeeping.clear();
+        });
+    }
+}
+
+// Entities are created outside of the entity subsystem, so this only covers construction of the entity
+// and its bookkeeping, and not registration or post_create
+BENCHMARK(entity_creation)
+{
+    std::printf("sizeof(Entity) = %zu, sizeof(Component) = %zu\n", sizeof(Entity), sizeof(Component));
+
+    std::vector<peng::shared_ref<Entity>> entities;
+    entities.reserve(num_entities);
+
+    report("create and destroy", measure_median_ms([&]
+    {
+        for (size_t i = 0; i < num_entities; i++)
+        {
+            peng::shared_ref<Entity> entity = peng::make_shared<Entity>("Benchmark Entity");
+            for (size_t component = 0; component < components_per_entity; component++)
+            {
+                entity->add_component<Component>();
+            }
+
+            entities.push_back(std::move(entity));
+        }
+
+        entities.clear();
+    }), num_entities);
+}
+
+// Deferring the components of 10k entities, comparing the std::vector deferred list Entity used to have
+// against the inline one it has now
+// The same component is shared by every entity so that only the bookkeeping is timed
+BENCHMARK(entity_deferred_components)
+{
+    using BaselineList = std::vector<peng::shared_ref<Component>>;
+    using InlineList = utils::small_vector<peng::shared_ref<Component>, 2>;
+
+    const peng::shared_ref<Component> component = peng::make_shared<Component>();
+
+    std::printf(
+        "sizeof(bookkeeping) = %zu with std::vector, %zu with small_vector\n",
+        sizeof(ComponentBookkeeping<BaselineList>), sizeof(ComponentBookkeeping<InlineList>)
+    );
+
+    report("std::vector deferred list", measure_bookkeeping_ms<BaselineList>(component), num_entities);
+    report("small_vector deferred list", measure_bookkeeping_ms<InlineList>(component), num_entities);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+#include <rendering/raw_mesh_data.h>
+
+// The OBJ decoder used by MeshDecoder before it was rewritten around mapped files and string views
+// Kept as the baseline for the OBJ decoder benchmarks, it only supports triangles in the v/vt/vn format
+namespace benchmarks
+{
+    [[nodiscard]] rendering::RawMeshData load_obj_baseline(const std::string& path);
+}
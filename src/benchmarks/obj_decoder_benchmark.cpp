@@ -0,0 +1,82 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <rendering/mesh_decoder.h>
+#include <utils/strtools.h>
+
+#include "benchmark.h"
+#include "obj_decoder.h"
+
+using namespace benchmarks;
+using namespace rendering;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    // Writes a flat grid of cells_per_side^2 quads, each split into two triangles in the v/vt/vn format
+    // so that both decoders can read it
+    void write_grid_obj(const std::string& path, size_t cells_per_side)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        const size_t verts_per_side = cells_per_side + 1;
+
+        for (size_t y = 0; y < verts_per_side; y++)
+        {
+            for (size_t x = 0; x < verts_per_side; x++)
+            {
+                const float u = static_cast<float>(x) / static_cast<float>(cells_per_side);
+                const float v = static_cast<float>(y) / static_cast<float>(cells_per_side);
+
+                file << strtools::catf("v %.6f %.6f 0.000000\nvt %.6f %.6f\n", u * 10, v * 10, u, v);
+            }
+        }
+
+        file << "vn 0.000000 0.000000 1.000000\n";
+
+        // OBJ indices are 1 based
+        const auto vertex = [verts_per_side](size_t x, size_t y)
+        {
+            const size_t index = y * verts_per_side + x + 1;
+            return strtools::catf("%zu/%zu/1", index, index);
+        };
+
+        for (size_t y = 0; y < cells_per_side; y++)
+        {
+            for (size_t x = 0; x < cells_per_side; x++)
+            {
+                file << strtools::catf("f %s %s %s\n", vertex(x, y).c_str(), vertex(x + 1, y).c_str(), vertex(x + 1, y + 1).c_str());
+                file << strtools::catf("f %s %s %s\n", vertex(x, y).c_str(), vertex(x + 1, y + 1).c_str(), vertex(x, y + 1).c_str());
+            }
+        }
+    }
+}
+
+// Decoding OBJ files of 200k and 2M triangles, comparing MeshDecoder with the decoder it replaced
+// Only the decoding is timed, not the optimization that MeshDecoder::load_file applies afterwards
+BENCHMARK(obj_decoder)
+{
+    for (const size_t cells_per_side : { 317, 1000 })
+    {
+        const size_t num_triangles = cells_per_side * cells_per_side * 2;
+        const size_t num_samples = num_triangles >= 1000000 ? 3 : 7;
+        const std::string path = (fs::temp_directory_path() / strtools::catf("peng_grid_%zu.obj", cells_per_side)).string();
+
+        write_grid_obj(path, cells_per_side);
+        std::printf("  %zu triangles, %.1f MB\n", num_triangles, static_cast<double>(fs::file_size(path)) / (1024 * 1024));
+
+        report("baseline decoder", measure_median_ms([&]
+        {
+            do_not_optimize(load_obj_baseline(path));
+        }, num_samples), num_triangles);
+
+        report("MeshDecoder", measure_median_ms([&]
+        {
+            do_not_optimize(MeshDecoder::load_obj(path));
+        }, num_samples), num_triangles);
+
+        fs::remove(path);
+    }
+}
@@ -0,0 +1,70 @@
+#include <memory/weak_ptr.h>
+#include <math/vector3.h>
+
+#include "benchmark.h"
+
+using namespace benchmarks;
+
+namespace
+{
+    struct LightData
+    {
+        math::Vector3f pos;
+        math::Vector3f color;
+        float range = 1;
+    };
+
+    constexpr size_t num_lights = 1000;
+    constexpr size_t num_passes = 100;
+}
+
+// Mirrors light gathering in MeshRenderer, which dereferences each light several times
+BENCHMARK(weak_ptr_pinning)
+{
+    std::vector<peng::shared_ref<LightData>> lights;
+    std::vector<peng::weak_ptr<LightData>> weak_lights;
+
+    for (size_t i = 0; i < num_lights; i++)
+    {
+        lights.push_back(peng::make_shared<LightData>());
+        weak_lights.emplace_back(lights.back());
+    }
+
+    float sum = 0;
+
+    report("lock per access", measure_median_ms([&]
+    {
+        for (size_t pass = 0; pass < num_passes; pass++)
+        {
+            for (const peng::weak_ptr<LightData>& light : weak_lights)
+            {
+                sum += light->range * light->range + light->pos.x;
+            }
+        }
+    }), num_lights * num_passes);
+
+    report("pin per light", measure_median_ms([&]
+    {
+        for (size_t pass = 0; pass < num_passes; pass++)
+        {
+            for (const peng::weak_ptr<LightData>& light : weak_lights)
+            {
+                const peng::pinned_ptr<LightData> pinned = light.pin();
+                sum += pinned->range * pinned->range + pinned->pos.x;
+            }
+        }
+    }), num_lights * num_passes);
+
+    report("lock_all", measure_median_ms([&]
+    {
+        for (size_t pass = 0; pass < num_passes; pass++)
+        {
+            for (const peng::pinned_ptr<LightData>& light : peng::lock_all(weak_lights))
+            {
+                sum += light->range * light->range + light->pos.x;
+            }
+        }
+    }), num_lights * num_passes);
+
+    do_not_optimize(sum);
+}
@@ -0,0 +1,88 @@
+#include <thread>
+#include <vector>
+
+#include <concurrentqueue.h>
+#include <rendering/render_queue.h>
+#include <utils/strtools.h>
+
+#include "benchmark.h"
+#include "draw_scene.h"
+
+using namespace benchmarks;
+using namespace rendering;
+
+namespace
+{
+    constexpr size_t num_shaders = 16;
+    constexpr size_t num_meshes = 64;
+    constexpr size_t num_materials = 1000;
+    constexpr size_t num_draws = 200000;
+
+    // Starts a thread per share of the draws, each of which moves every draw in its share into enqueue
+    // Draws are moved as callers build their draws and hand them over, so only the enqueue itself is timed
+    template <typename F>
+    void enqueue_from_threads(std::vector<std::vector<DrawCall>>& thread_draws, F&& enqueue)
+    {
+        std::vector<std::thread> threads;
+        threads.reserve(thread_draws.size());
+
+        for (std::vector<DrawCall>& draws : thread_draws)
+        {
+            threads.emplace_back([&]
+            {
+                for (DrawCall& draw : draws)
+                {
+                    enqueue(std::move(draw));
+                }
+            });
+        }
+
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+}
+
+// Enqueueing draws from several threads at once, comparing the per thread command lists of RenderQueue with the
+// shared concurrent queue it used to push every command through
+// Threads are started for every run, so each run also registers and releases the threads' command lists
+BENCHMARK(render_queue_enqueue)
+{
+    const DrawScene scene(num_shaders, num_meshes, num_materials);
+    const std::vector<DrawCall> draw_calls = scene.make_draws(num_draws);
+
+    RenderQueue& render_queue = RenderQueue::get();
+
+    for (const size_t num_threads : { 1, 2, 4, 8 })
+    {
+        std::vector<std::vector<DrawCall>> thread_draw_calls(num_threads);
+        for (size_t i = 0; i < draw_calls.size(); i++)
+        {
+            thread_draw_calls[i % num_threads].push_back(draw_calls[i]);
+        }
+
+        std::vector<std::vector<DrawCall>> thread_draws = thread_draw_calls;
+
+        moodycamel::ConcurrentQueue<DrawCall> shared_queue;
+        std::vector<DrawCall> dequeued(num_draws);
+
+        report(strtools::catf("%zu threads, shared concurrent queue", num_threads), measure_median_ms([&]
+        {
+            enqueue_from_threads(thread_draws, [&](DrawCall&& draw) { shared_queue.enqueue(std::move(draw)); });
+        }, [&]
+        {
+            while (shared_queue.try_dequeue_bulk(dequeued.begin(), dequeued.size()) > 0) { }
+            thread_draws = thread_draw_calls;
+        }), num_draws);
+
+        report(strtools::catf("%zu threads, per thread command lists", num_threads), measure_median_ms([&]
+        {
+            enqueue_from_threads(thread_draws, [&](DrawCall&& draw) { render_queue.enqueue_command(std::move(draw)); });
+        }, [&]
+        {
+            render_queue.execute();
+            thread_draws = thread_draw_calls;
+        }), num_draws);
+    }
+}
@@ -38,14 +38,19 @@ void Collider2D::tick(float delta_time)
 	if (triggers_enabled)
 	{
 		const physics::AABB aabb = bounding_box();
-		std::vector<peng::weak_ptr<Collider2D>> old_overlaps = std::move(_current_overlaps);
+		utils::small_vector<peng::weak_ptr<Collider2D>, 4> old_overlaps = std::move(_current_overlaps);
 
 		// Check all other colliders for new overlaps
-		for (peng::weak_ptr<Collider2D> other : active_colliders())
+		// Only the collider being tested is pinned, so the walk doesn't allocate, and it goes by index as trigger
+		// events may add or remove colliders
+		for (size_t other_index = 0; other_index < _active_colliders.size(); other_index++)
 		{
-			if (this != other.lock().get())
+			const peng::weak_ptr<Collider2D> other = _active_colliders[other_index];
+			const peng::pinned_ptr<Collider2D> other_pinned = other.pin();
+
+			if (other_pinned && this != other_pinned.get())
 			{
-				const physics::AABB other_aabb = other->bounding_box();
+				const physics::AABB other_aabb = other_pinned->bounding_box();
 				if (aabb.overlaps(other_aabb))
 				{
 					// Add to the new overlap list if successful
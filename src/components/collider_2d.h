@@ -32,6 +32,6 @@ namespace components
 	private:
 		static std::vector<peng::weak_ptr<Collider2D>> _active_colliders;
 
-		std::vector<peng::weak_ptr<Collider2D>> _current_overlaps;
+		utils::small_vector<peng::weak_ptr<Collider2D>, 4> _current_overlaps;
 	};
 }
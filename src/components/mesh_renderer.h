@@ -2,12 +2,6 @@
 
 #include <core/component.h>
 
-namespace entities
-{
-	class PointLight;
-	class SpotLight;
-}
-
 namespace rendering
 {
 	class Mesh;
@@ -16,8 +10,9 @@ namespace rendering
 
 namespace components
 {
-	// TODO: set the actual number of lights in the shader (point, spot, directional) as uniforms so it can skip
-	//       non required calculations
+	// Lighting and camera data are shared by every draw through the render queue's frame buffers,
+	// so the only per object uniforms are the model and normal matrices
+	// Meshes with levels of detail are drawn at the level matching their size on screen
 	class MeshRenderer final : public Component
 	{
 		DECLARE_COMPONENT(MeshRenderer);
@@ -46,56 +41,18 @@ namespace components
 
 	private:
 		void cache_uniforms();
-		std::vector<peng::shared_ref<const entities::PointLight>> get_relevant_point_lights();
-		std::vector<peng::shared_ref<const entities::SpotLight>> get_relevant_spot_lights();
 
 		peng::shared_ptr<const rendering::Mesh> _mesh;
 		peng::shared_ptr<rendering::Material> _material;
 
-		struct PointLightUniformSet
-		{
-			int32_t pos = -1;
-			int32_t color = -1;
-			int32_t ambient = -1;
-			int32_t range = -1;
-			int32_t max_strength = -1;
-		};
-
-		struct SpotLightUniformSet
-		{
-			int32_t pos = -1;
-			int32_t dir = -1;
-			int32_t color = -1;
-			int32_t ambient = -1;
-			int32_t range = -1;
-			int32_t umbra_cos = -1;
-			int32_t penumbra_cos = -1;
-		};
-
-		struct DirectionalLightUniformSet
-		{
-			int32_t dir = -1;
-			int32_t color = -1;
-			int32_t ambient = -1;
-			int32_t intensity = -1;
-		};
-
 		struct UniformSet
 		{
 			int32_t model_matrix = -1;
 			int32_t normal_matrix = -1;
 			int32_t view_matrix = -1;
-			int32_t view_pos = -1;
-
-			std::vector<PointLightUniformSet> point_lights;
-			std::vector<SpotLightUniformSet> spot_lights;
-			std::vector<DirectionalLightUniformSet> directional_lights;
 		};
 
-		bool _uses_lighting = false;
-		int32_t _max_point_lights = 0;
-		int32_t _max_spot_lights = 0;
-		int32_t _max_directional_lights = 0;
 		UniformSet _cached_uniforms;
+		int32_t _lod = 0;
 	};
 }
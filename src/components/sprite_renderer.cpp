@@ -32,13 +32,14 @@ void SpriteRenderer::tick(float delta_time)
 {
 	Component::tick(delta_time);
 
-	if (!Camera::current())
+	const peng::pinned_ptr<Camera> camera = Camera::current().pin();
+	if (!camera)
 	{
 		return;
 	}
 
 	const Matrix4x4f model_matrix = owner().transform_matrix();
-	const Matrix4x4f view_matrix = Camera::current()->view_matrix();
+	const Matrix4x4f view_matrix = camera->view_matrix();
 	const Matrix4x4f mvp_matrix = view_matrix * model_matrix;
 
 	RenderQueue::get().enqueue_command(SpriteDrawCall{
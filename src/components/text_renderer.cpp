@@ -1,9 +1,16 @@
 #include "text_renderer.h"
 
+#include <algorithm>
+
 #include <entities/camera.h>
 #include <rendering/render_queue.h>
 #include <rendering/bitmap_font.h>
 #include <rendering/primitives.h>
+#include <rendering/material.h>
+#include <rendering/texture.h>
+#include <rendering/sprite.h>
+#include <rendering/mesh.h>
+#include <utils/strtools.h>
 
 IMPLEMENT_COMPONENT(components::TextRenderer);
 
@@ -25,20 +32,36 @@ void TextRenderer::tick(float delta_time)
 {
     Component::tick(delta_time);
 
-    if (!Camera::current())
+    if (_batches.empty())
+    {
+        return;
+    }
+
+    const peng::pinned_ptr<Camera> camera = Camera::current().pin();
+    if (!camera)
     {
         return;
     }
 
-    const Matrix4x4f view_matrix = Camera::current()->view_matrix();
+    const Matrix4x4f view_matrix = camera->view_matrix();
     const Matrix4x4f model_matrix = owner().transform_matrix();
     const Matrix4x4f mvp_matrix = view_matrix * model_matrix;
+    const float z_depth = mvp_matrix.get_translation().z;
 
-    for (const GlyphData& glyph : _current_glyphs)
+    for (const GlyphBatch& batch : _batches)
     {
-        RenderQueue::get().enqueue_command(SpriteDrawCall{
-            .sprite = glyph.sprite,
-            .mvp_matrix = mvp_matrix * glyph.transform
+        batch.material->set_parameter(batch.mvp_matrix_location, mvp_matrix);
+
+        const float order = batch.material->shader()->requires_blending()
+            ? -z_depth
+            : +z_depth;
+
+        RenderQueue::get().enqueue_command(DrawCall{
+            .mesh = batch.mesh,
+            .material = batch.material,
+            .order = order,
+            .instance_count = 1,
+            .bounds = batch.mesh->bounding_sphere().transformed(model_matrix)
         });
     }
 }
@@ -51,22 +74,101 @@ void TextRenderer::set_text(const std::string& str)
     }
 
     _current = str;
-    _current_glyphs.clear();
+    rebuild_batches();
+}
+
+void TextRenderer::rebuild_batches()
+{
+    // The meshes and materials of the previous text's batches are reused by the batches with the same texture
+    std::vector<GlyphBatch> old_batches = std::move(_batches);
+    _batches.clear();
 
-    const std::vector<peng::shared_ptr<const Sprite>> sprites = _font->get_sprites(str);
-    const int32_t num_chars = static_cast<int32_t>(sprites.size());
+    std::vector<RawMeshData> batch_data;
+    std::vector<bool> batch_requires_alpha;
 
+    const int32_t num_chars = static_cast<int32_t>(_current.size());
     for (int32_t char_index = 0; char_index < num_chars; char_index++)
     {
         // Only add a glyph if this character is visible
-        if (sprites[char_index])
+        const peng::shared_ptr<const Sprite>& sprite = _font->get_sprite(_current[char_index]);
+        if (!sprite)
         {
-            const Vector3f char_pos = Vector3f(char_index - 0.5f * (num_chars - 1), 0, 0);
+            continue;
+        }
 
-            _current_glyphs.push_back(GlyphData{
-                .sprite = sprites[char_index].to_shared_ref(),
-                .transform = Matrix4x4f::from_translation(char_pos)
+        size_t batch_index = 0;
+        while (batch_index < _batches.size() && _batches[batch_index].texture != sprite->texture())
+        {
+            batch_index++;
+        }
+
+        if (batch_index == _batches.size())
+        {
+            const auto old_batch = std::ranges::find_if(old_batches, [&](const GlyphBatch& batch)
+            {
+                return batch.texture == sprite->texture();
             });
+
+            const bool reused = old_batch != old_batches.end();
+            _batches.push_back(GlyphBatch{
+                .texture = sprite->texture(),
+                .mesh = reused ? std::move(old_batch->mesh) : peng::shared_ptr<Mesh>(),
+                .material = reused ? std::move(old_batch->material) : peng::shared_ptr<Material>(),
+                .mvp_matrix_location = reused ? old_batch->mvp_matrix_location : -1
+            });
+
+            batch_data.emplace_back();
+            batch_requires_alpha.push_back(false);
+        }
+
+        if (sprite->transparency() == TransparencyMode::translucent)
+        {
+            batch_requires_alpha[batch_index] = true;
+        }
+
+        // Glyphs are unit quads laid out left to right, centered on the text
+        RawMeshData& raw_data = batch_data[batch_index];
+        const Vector3f char_pos = Vector3f(char_index - 0.5f * (num_chars - 1), 0, 0);
+        const uint32_t first_vertex = static_cast<uint32_t>(raw_data.vertices.size());
+
+        for (const Vector2f corner : { Vector2f(0, 0), Vector2f(1, 0), Vector2f(1, 1), Vector2f(0, 1) })
+        {
+            raw_data.vertices.emplace_back(
+                char_pos + Vector3f(corner - Vector2f(0.5f, 0.5f), 0),
+                Vector3f(0, 0, 1),
+                sprite->tex_offset() + corner * sprite->tex_scale()
+            );
+        }
+
+        raw_data.triangles.emplace_back(first_vertex + 0, first_vertex + 1, first_vertex + 3);
+        raw_data.triangles.emplace_back(first_vertex + 3, first_vertex + 1, first_vertex + 2);
+    }
+
+    for (size_t batch_index = 0; batch_index < _batches.size(); batch_index++)
+    {
+        GlyphBatch& batch = _batches[batch_index];
+
+        if (batch.mesh)
+        {
+            batch.mesh->set_data(std::move(batch_data[batch_index]));
+        }
+        else
+        {
+            batch.mesh = peng::make_shared<Mesh>(
+                strtools::catf("Text(%s)", _current.c_str()), std::move(batch_data[batch_index]), MeshRetention::discard
+            );
+        }
+
+        const peng::shared_ref<const Shader> shader = batch_requires_alpha[batch_index]
+            ? Primitives::sprite_alpha_shader()
+            : Primitives::sprite_shader();
+
+        // A reused material can only be kept if the glyphs still need the same blending
+        if (!batch.material || batch.material->shader() != shader)
+        {
+            batch.material = peng::make_shared<Material>(shader);
+            batch.material->set_parameter("color_tex", batch.texture);
+            batch.mvp_matrix_location = batch.material->shader()->get_uniform_location("mvp_matrix");
         }
     }
 }
@@ -4,7 +4,9 @@
 
 namespace rendering
 {
-	class Sprite;
+	class Mesh;
+	class Texture;
+	class Material;
 	class BitmapFont;
 }
 
@@ -12,6 +14,8 @@ namespace components
 {
 	// TODO: add multi line text support
 	// TODO: add pivot options
+	// Glyphs are baked into a mesh when the text changes, so each frame only submits a single draw
+	// with one transform rather than a sprite per glyph
 	class TextRenderer final : public Component
 	{
 		DECLARE_COMPONENT(TextRenderer);
@@ -28,14 +32,21 @@ namespace components
 		[[nodiscard]] const peng::shared_ref<const rendering::BitmapFont>& font() const noexcept { return _font; }
 
 	private:
-		struct GlyphData
+		// Glyphs are grouped by texture, with each group baked into one mesh
+		// All glyphs of a font normally share a texture or atlas page, giving a single group
+		// The mesh and material are reused when the text changes, with the new glyphs uploaded into the mesh
+		struct GlyphBatch
 		{
-			peng::shared_ref<const rendering::Sprite> sprite;
-			math::Matrix4x4f transform;
+			peng::shared_ref<const rendering::Texture> texture;
+			peng::shared_ptr<rendering::Mesh> mesh;
+			peng::shared_ptr<rendering::Material> material;
+			int32_t mvp_matrix_location = -1;
 		};
 
+		void rebuild_batches();
+
 		std::string _current;
 		peng::shared_ref<const rendering::BitmapFont> _font;
-		std::vector<GlyphData> _current_glyphs;
+		std::vector<GlyphBatch> _batches;
 	};
 }
\ No newline at end of file
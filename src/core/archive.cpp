@@ -1,9 +1,10 @@
 #include "archive.h"
 
 #include <fstream>
+#include <stdexcept>
 #include <filesystem>
 
-#include <utils/check.h>
+#include <utils/strtools.h>
 #include <profiling/scoped_event.h>
 
 Archive Archive::from_disk(const std::string& path)
@@ -11,7 +12,10 @@ Archive Archive::from_disk(const std::string& path)
     SCOPED_EVENT("Loading archive", path.c_str());
 
     std::ifstream file(path);
-    check(file.is_open());
+    if (!file.is_open())
+    {
+        throw std::runtime_error(strtools::catf("Could not open archive '%s'", path.c_str()));
+    }
 
     Archive archive;
     archive.path = path;
@@ -1,11 +1,18 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+
 #include <core/logger.h>
 #include <memory/shared_ptr.h>
 #include <memory/weak_ptr.h>
 #include <profiling/scoped_event.h>
+#include <utils/timing.h>
+#include <utils/utils.h>
 
 #include "archive.h"
+#include "asset_loader.h"
+#include "asset_registry.h"
 
 // Concept for an item that can be contained as an asset
 template <typename T>
@@ -14,6 +21,66 @@ concept CAsset = requires(const Archive& archive)
     { T::load_asset(archive) } -> std::convertible_to<peng::shared_ref<T>>;
 };
 
+// Concept for an asset which splits loading into a decode step that is safe to run on a background thread,
+// and a finalize step which creates any GPU or audio objects from the decoded data on the main thread
+template <typename T>
+concept CAsyncAsset = CAsset<T> && requires(const Archive& archive)
+{
+    { T::finalize_asset(archive, T::decode_asset(archive)) } -> std::convertible_to<peng::shared_ref<T>>;
+};
+
+namespace core::detail
+{
+    // State of one asynchronous asset load, shared by every request for the asset and the threads loading it
+    template <typename T>
+    struct AsyncAssetLoad
+    {
+        explicit AsyncAssetLoad(const std::string& path)
+            : path(path)
+        { }
+
+        const std::string path;
+        std::atomic<LoadStatus> status = LoadStatus::queued;
+
+        // Requests which haven't been cancelled, the load is abandoned once this drops to 0
+        std::atomic<int32_t> num_requests = 0;
+
+        // Only accessed on the main thread
+        peng::shared_ptr<T> asset;
+    };
+}
+
+// Handle to an asynchronous asset load, see Asset<T>::load_async
+// Requests for the same asset share one load, which is only abandoned once every request for it has been cancelled
+// Dropping a request doesn't cancel it, so a load can be started just to warm up the asset
+template <CAsset T>
+class AssetRequest final : public IAssetRequest
+{
+public:
+    AssetRequest() = default;
+    explicit AssetRequest(const peng::shared_ref<core::detail::AsyncAssetLoad<T>>& load);
+
+    AssetRequest(const AssetRequest&) = delete;
+    AssetRequest(AssetRequest&&) noexcept = default;
+    AssetRequest& operator=(const AssetRequest&) = delete;
+    AssetRequest& operator=(AssetRequest&&) noexcept = default;
+
+    // Withdraws this request, the asset is still loaded if any other request for it is pending
+    void cancel() override;
+
+    [[nodiscard]] LoadStatus status() const noexcept override;
+    [[nodiscard]] bool done() const noexcept override;
+    [[nodiscard]] float progress() const noexcept override;
+
+    // Gets the loaded asset, or null if it hasn't finished loading or failed to load
+    // Must only be called on the main thread
+    [[nodiscard]] peng::shared_ptr<T> get() const;
+
+private:
+    peng::shared_ptr<core::detail::AsyncAssetLoad<T>> _load;
+    bool _cancelled = false;
+};
+
 // Base interface for all Assets
 class IAsset
 {
@@ -25,7 +92,8 @@ public:
 };
 
 // Generalized resource container for an asset T that meets the CAsset criteria
-// If two assets are loaded with the same path they will resolve to the same item in memory
+// If two assets are loaded with the same path they will resolve to the same item in memory, which is tracked by the
+// AssetRegistry
 template <CAsset T>
 class Asset : public IAsset
 {
@@ -35,19 +103,82 @@ public:
 
     [[nodiscard]] peng::shared_ref<T> load_mutable();
     [[nodiscard]] peng::shared_ref<const T> load();
+
+    // Starts loading the asset without blocking, must be called on the main thread
+    // The archive is read and, for assets which meet CAsyncAsset, decoded on the AssetLoader's background threads
+    // The asset is then created on the main thread within the AssetLoader's per-frame budget
+    [[nodiscard]] AssetRequest<T> load_async();
+
     [[nodiscard]] bool loaded() const noexcept override;
     [[nodiscard]] bool exists() const noexcept override;
     [[nodiscard]] bool empty() const noexcept override;
     [[nodiscard]] const std::string& path() const noexcept override;
 
 private:
+    using AsyncLoad = core::detail::AsyncAssetLoad<T>;
+    using Finalizer = std::function<peng::shared_ref<T>()>;
+
+    static void decode_async(const peng::shared_ref<AsyncLoad>& load);
+    static void finalize_async(const peng::shared_ref<AsyncLoad>& load, const Finalizer& finalizer);
+
     std::string _path;
 
-    static std::unordered_map<std::string, peng::weak_ptr<T>> _asset_map;
+    // Loads which are still being decoded or waiting to be finalized, only accessed on the main thread
+    static std::unordered_map<std::string, peng::weak_ptr<AsyncLoad>> _pending_loads;
 };
 
 template <CAsset T>
-std::unordered_map<std::string, peng::weak_ptr<T>> Asset<T>::_asset_map;
+std::unordered_map<std::string, peng::weak_ptr<core::detail::AsyncAssetLoad<T>>> Asset<T>::_pending_loads;
+
+template <CAsset T>
+AssetRequest<T>::AssetRequest(const peng::shared_ref<core::detail::AsyncAssetLoad<T>>& load)
+    : _load(load)
+{
+    _load->num_requests++;
+}
+
+template <CAsset T>
+void AssetRequest<T>::cancel()
+{
+    if (_load && !_cancelled)
+    {
+        _cancelled = true;
+        _load->num_requests--;
+    }
+}
+
+template <CAsset T>
+LoadStatus AssetRequest<T>::status() const noexcept
+{
+    if (_cancelled)
+    {
+        return LoadStatus::cancelled;
+    }
+
+    return _load
+        ? _load->status.load()
+        : LoadStatus::failed;
+}
+
+template <CAsset T>
+bool AssetRequest<T>::done() const noexcept
+{
+    return AssetLoader::done(status());
+}
+
+template <CAsset T>
+float AssetRequest<T>::progress() const noexcept
+{
+    return AssetLoader::progress(status());
+}
+
+template <CAsset T>
+peng::shared_ptr<T> AssetRequest<T>::get() const
+{
+    return status() == LoadStatus::loaded
+        ? _load->asset
+        : peng::shared_ptr<T>();
+}
 
 template <CAsset T>
 Asset<T>::Asset(const std::string& path)
@@ -62,37 +193,177 @@ Asset<T>::Asset(std::string&& path)
 template <CAsset T>
 peng::shared_ref<T> Asset<T>::load_mutable()
 {
-    peng::weak_ptr<T>& existing = _asset_map[_path];
+    AssetRegistry& registry = AssetRegistry::get();
+
+    if (const peng::shared_ptr<T> existing = registry.find<T>(_path))
+    {
+        return existing.to_shared_ref();
+    }
+
+    SCOPED_EVENT("Loading asset", _path.c_str());
+    Logger::log("Loading asset '%s'", _path.c_str());
+
+    const timing::clock::time_point start = timing::clock::now();
+
+    registry.begin_load(typeid(T), _path);
+    const auto end_load = utils::finally([&registry]
+    {
+        registry.end_load();
+    });
+
+    const Archive archive = Archive::from_disk(_path);
+    const peng::shared_ref<T> loaded = T::load_asset(archive);
+
+    return registry.add<T>(_path, loaded, timing::duration_ms(timing::clock::now() - start).count());
+}
+
+template <CAsset T>
+peng::shared_ref<const T> Asset<T>::load()
+{
+    return load_mutable();
+}
 
-    if (peng::shared_ptr<T> existing_locked = existing.lock())
+template <CAsset T>
+AssetRequest<T> Asset<T>::load_async()
+{
+    // Requests for an asset which is already being loaded share the pending load
+    peng::weak_ptr<AsyncLoad>& pending = _pending_loads[_path];
+    if (const peng::shared_ptr<AsyncLoad> pending_locked = pending.lock())
     {
-        return existing_locked.to_shared_ref();
+        if (pending_locked->status != LoadStatus::cancelled)
+        {
+            return AssetRequest<T>(pending_locked.to_shared_ref());
+        }
+    }
+
+    const peng::shared_ref<AsyncLoad> load = peng::make_shared<AsyncLoad>(_path);
+
+    if (const peng::shared_ptr<T> existing = AssetRegistry::get().find<T>(_path))
+    {
+        load->asset = existing;
+        load->status = LoadStatus::loaded;
     }
     else
     {
-        SCOPED_EVENT("Loading asset", _path.c_str());
-        Logger::log("Loading asset '%s'", _path.c_str());
+        Logger::log("Loading asset '%s' asynchronously", _path.c_str());
+
+        pending = load;
+        AssetLoader::get().schedule_decode(threading::Job([load]
+        {
+            decode_async(load);
+        }));
+    }
 
-        check(exists());
-        Archive archive = Archive::from_disk(_path);
+    return AssetRequest<T>(load);
+}
 
-        peng::shared_ref<T> loaded = T::load_asset(archive);
-        existing = loaded;
+template <CAsset T>
+void Asset<T>::decode_async(const peng::shared_ref<AsyncLoad>& load)
+{
+    // The finalizer is always scheduled, even when nothing was decoded, so the pending load is cleared up on the
+    // main thread
+    Finalizer finalizer;
 
-        return loaded;
+    if (load->num_requests > 0)
+    {
+        SCOPED_EVENT("Decoding asset", load->path.c_str());
+        load->status = LoadStatus::decoding;
+
+        try
+        {
+            const std::shared_ptr<const Archive> archive = std::make_shared<const Archive>(Archive::from_disk(load->path));
+
+            if constexpr (CAsyncAsset<T>)
+            {
+                using Decoded = decltype(T::decode_asset(std::declval<const Archive&>()));
+                const std::shared_ptr<Decoded> decoded = std::make_shared<Decoded>(T::decode_asset(*archive));
+
+                finalizer = [archive, decoded]
+                {
+                    return T::finalize_asset(*archive, std::move(*decoded));
+                };
+            }
+            else
+            {
+                finalizer = [archive]
+                {
+                    return T::load_asset(*archive);
+                };
+            }
+
+            load->status = LoadStatus::finalizing;
+        }
+        catch (const std::exception& e)
+        {
+            Logger::error("Failed to decode asset '%s': %s", load->path.c_str(), e.what());
+            load->status = LoadStatus::failed;
+        }
     }
+
+    AssetLoader::get().schedule_finalize(threading::Job([load, finalizer = std::move(finalizer)]
+    {
+        finalize_async(load, finalizer);
+    }));
 }
 
 template <CAsset T>
-peng::shared_ref<const T> Asset<T>::load()
+void Asset<T>::finalize_async(const peng::shared_ref<AsyncLoad>& load, const Finalizer& finalizer)
 {
-    return load_mutable();
+    if (const auto it = _pending_loads.find(load->path); it != _pending_loads.end() && it->second.lock().get() == load.get())
+    {
+        _pending_loads.erase(it);
+    }
+
+    if (load->num_requests == 0 || !finalizer)
+    {
+        if (load->status != LoadStatus::failed)
+        {
+            load->status = LoadStatus::cancelled;
+        }
+
+        return;
+    }
+
+    AssetRegistry& registry = AssetRegistry::get();
+
+    // The asset may have been loaded synchronously while this load was being decoded
+    if (const peng::shared_ptr<T> existing = registry.peek<T>(load->path))
+    {
+        load->asset = existing;
+        load->status = LoadStatus::loaded;
+        return;
+    }
+
+    SCOPED_EVENT("Finalizing asset", load->path.c_str());
+
+    const timing::clock::time_point start = timing::clock::now();
+
+    registry.begin_load(typeid(T), load->path);
+    const auto end_load = utils::finally([&registry]
+    {
+        registry.end_load();
+    });
+
+    try
+    {
+        const peng::shared_ref<T> loaded = finalizer();
+
+        load->asset = registry.add<T>(load->path, loaded, timing::duration_ms(timing::clock::now() - start).count());
+        load->status = LoadStatus::loaded;
+
+        Logger::log("Loaded asset '%s'", load->path.c_str());
+    }
+    catch (const std::exception& e)
+    {
+        Logger::error("Failed to finalize asset '%s': %s", load->path.c_str(), e.what());
+        load->status = LoadStatus::failed;
+    }
 }
 
 template <CAsset T>
 bool Asset<T>::loaded() const noexcept
 {
-    return _asset_map[_path].valid();
+    return AssetRegistry::get().loaded(typeid(T), _path);
 }
 
 template <CAsset T>
@@ -113,6 +384,16 @@ const std::string& Asset<T>::path() const noexcept
     return _path;
 }
 
+// Registers T with the AssetRegistry under type_name, so that manifests can refer to and preload it
+template <CAsset T>
+void register_asset_type(const std::string& type_name)
+{
+    AssetRegistry::get().register_type(typeid(T), type_name, [](const std::string& path)
+    {
+        return std::make_unique<AssetRequest<T>>(Asset<T>(path).load_async());
+    });
+}
+
 // JSON support for assets
 #pragma region JSON
 
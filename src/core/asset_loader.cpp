@@ -0,0 +1,128 @@
+#include "asset_loader.h"
+
+#include <algorithm>
+
+#include <profiling/scoped_event.h>
+#include <utils/timing.h>
+
+void AssetBatch::add(std::unique_ptr<IAssetRequest>&& request)
+{
+    _requests.push_back(std::move(request));
+}
+
+void AssetBatch::cancel()
+{
+    for (const std::unique_ptr<IAssetRequest>& request : _requests)
+    {
+        request->cancel();
+    }
+}
+
+bool AssetBatch::done() const noexcept
+{
+    return std::ranges::all_of(_requests, [](const std::unique_ptr<IAssetRequest>& request)
+    {
+        return request->done();
+    });
+}
+
+float AssetBatch::progress() const noexcept
+{
+    if (_requests.empty())
+    {
+        return 1;
+    }
+
+    float progress = 0;
+    for (const std::unique_ptr<IAssetRequest>& request : _requests)
+    {
+        progress += request->progress();
+    }
+
+    return progress / static_cast<float>(_requests.size());
+}
+
+size_t AssetBatch::size() const noexcept
+{
+    return _requests.size();
+}
+
+AssetLoader::AssetLoader()
+    : Subsystem()
+    , _decode_pool(num_decode_threads)
+    , _num_pending_finalize_jobs(0)
+    , _finalize_budget_ms(default_finalize_budget_ms)
+{ }
+
+void AssetLoader::start()
+{ }
+
+void AssetLoader::shutdown()
+{
+    // Loads still in flight are abandoned, their requests stay pending
+    _decode_pool.shutdown();
+}
+
+void AssetLoader::tick(float)
+{
+    SCOPED_EVENT("AssetLoader - tick");
+
+    const timing::clock::time_point start = timing::clock::now();
+    threading::Job job = threading::Job::empty();
+
+    // Only jobs which were already queued are run, anything they schedule is left for the next tick
+    for (size_t num_jobs = _num_pending_finalize_jobs; num_jobs > 0 && _finalize_queue.try_dequeue(job); num_jobs--)
+    {
+        _num_pending_finalize_jobs--;
+        job.execute();
+
+        if (timing::duration_ms(timing::clock::now() - start).count() >= _finalize_budget_ms)
+        {
+            break;
+        }
+    }
+}
+
+void AssetLoader::schedule_decode(threading::Job&& job)
+{
+    _decode_pool.schedule_job(std::move(job));
+}
+
+void AssetLoader::schedule_finalize(threading::Job&& job)
+{
+    _num_pending_finalize_jobs++;
+    _finalize_queue.enqueue(std::move(job));
+}
+
+void AssetLoader::set_finalize_budget(double budget_ms) noexcept
+{
+    _finalize_budget_ms = budget_ms;
+}
+
+double AssetLoader::finalize_budget() const noexcept
+{
+    return _finalize_budget_ms;
+}
+
+size_t AssetLoader::num_pending_jobs() const noexcept
+{
+    return _decode_pool.num_pending_jobs() + _decode_pool.num_executing_jobs() + _num_pending_finalize_jobs;
+}
+
+bool AssetLoader::done(LoadStatus status) noexcept
+{
+    return status == LoadStatus::loaded
+        || status == LoadStatus::failed
+        || status == LoadStatus::cancelled;
+}
+
+float AssetLoader::progress(LoadStatus status) noexcept
+{
+    switch (status)
+    {
+        case LoadStatus::queued: return 0;
+        case LoadStatus::decoding: return 0.25f;
+        case LoadStatus::finalizing: return 0.75f;
+        default: return 1;
+    }
+}
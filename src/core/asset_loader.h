@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <common/common.h>
+#include <threading/job.h>
+#include <threading/thread_pool.h>
+
+#include "subsystem.h"
+
+// Stages an asynchronous load moves through, a load only ever moves forwards
+enum class LoadStatus
+{
+    queued,
+    decoding,
+    finalizing,
+    loaded,
+    failed,
+    cancelled
+};
+
+// Type erased handle to an asynchronous load
+class IAssetRequest
+{
+public:
+    virtual ~IAssetRequest() = default;
+
+    virtual void cancel() = 0;
+
+    [[nodiscard]] virtual LoadStatus status() const noexcept = 0;
+    [[nodiscard]] virtual bool done() const noexcept = 0;
+    [[nodiscard]] virtual float progress() const noexcept = 0;
+};
+
+// A group of asynchronous loads which are waited on together
+class AssetBatch
+{
+public:
+    void add(std::unique_ptr<IAssetRequest>&& request);
+    void cancel();
+
+    [[nodiscard]] bool done() const noexcept;
+
+    // Average progress of every load in the batch, an empty batch is complete
+    [[nodiscard]] float progress() const noexcept;
+    [[nodiscard]] size_t size() const noexcept;
+
+private:
+    std::vector<std::unique_ptr<IAssetRequest>> _requests;
+};
+
+// Runs asynchronous loads in two stages
+// Decoding runs on a small pool of background threads and must not touch any GPU, audio or entity state
+// Finalizing runs on the main thread during tick, and only for as long as the per-frame budget allows so that
+// finishing a burst of loads is spread over several frames instead of causing a hitch
+class AssetLoader final : public Subsystem
+{
+    DECLARE_SUBSYSTEM(AssetLoader)
+
+public:
+    // Few threads are used since decoding is mostly IO and large decodes already parallelize internally
+    static constexpr size_t num_decode_threads = 2;
+    static constexpr double default_finalize_budget_ms = 2;
+
+    AssetLoader();
+
+    void start() override;
+    void shutdown() override;
+    void tick(float delta_time) override;
+
+    // Runs the job on a background decode thread, may be called from any thread
+    void schedule_decode(threading::Job&& job);
+
+    // Runs the job on the main thread during an upcoming tick, may be called from any thread
+    // Jobs scheduled from the same thread run in the order they were scheduled, and jobs scheduled by a finalize
+    // job wait for the next tick so a job can poll once per frame by rescheduling itself
+    void schedule_finalize(threading::Job&& job);
+
+    // At least one finalize job runs each frame regardless of the budget, so loads always make progress
+    void set_finalize_budget(double budget_ms) noexcept;
+
+    [[nodiscard]] double finalize_budget() const noexcept;
+    [[nodiscard]] size_t num_pending_jobs() const noexcept;
+
+    // True once a load has stopped, whether it succeeded or not
+    [[nodiscard]] static bool done(LoadStatus status) noexcept;
+
+    // Rough progress of a load between 0 and 1, based only on the stage it has reached
+    [[nodiscard]] static float progress(LoadStatus status) noexcept;
+
+private:
+    threading::ThreadPool _decode_pool;
+    common::concurrent_queue<threading::Job> _finalize_queue;
+    std::atomic<size_t> _num_pending_finalize_jobs;
+    double _finalize_budget_ms;
+};
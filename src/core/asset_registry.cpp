@@ -0,0 +1,325 @@
+#include "asset_registry.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include <utils/check.h>
+#include <utils/io.h>
+#include <utils/strtools.h>
+
+#include "logger.h"
+
+thread_local std::vector<AssetRegistry::Key> AssetRegistry::_loading_stack;
+
+void AssetRegistry::register_type(std::type_index type, const std::string& type_name, Preloader&& preloader)
+{
+    std::lock_guard lock(_mutex);
+
+    // Any stats counted before the type was registered are kept
+    TypeRecord& type_record = _types[type];
+    type_record.name = type_name;
+    type_record.preloader = std::move(preloader);
+
+    _types_by_name.insert_or_assign(type_name, type);
+}
+
+std::shared_ptr<void> AssetRegistry::find(std::type_index type, const std::string& path)
+{
+    std::lock_guard lock(_mutex);
+
+    Key key(type, path);
+    touch(key);
+
+    std::shared_ptr<void> asset;
+    if (const auto it = _records.find(key); it != _records.end())
+    {
+        asset = it->second.asset.lock();
+    }
+
+    AssetStats& stats = _types[type].stats;
+    if (asset)
+    {
+        stats.hits++;
+    }
+    else
+    {
+        stats.misses++;
+    }
+
+    return asset;
+}
+
+std::shared_ptr<void> AssetRegistry::peek(std::type_index type, const std::string& path) const
+{
+    std::lock_guard lock(_mutex);
+
+    if (const auto it = _records.find(Key(type, path)); it != _records.end())
+    {
+        return it->second.asset.lock();
+    }
+
+    return nullptr;
+}
+
+std::shared_ptr<void> AssetRegistry::add(
+    std::type_index type,
+    const std::string& path,
+    const std::shared_ptr<void>& asset,
+    double load_time_ms
+)
+{
+    std::lock_guard lock(_mutex);
+
+    _types[type].stats.load_time_ms += load_time_ms;
+
+    Record& record = _records[Key(type, path)];
+    if (std::shared_ptr<void> existing = record.asset.lock())
+    {
+        return existing;
+    }
+
+    record.asset = asset;
+    record.load_time_ms = load_time_ms;
+
+    return asset;
+}
+
+bool AssetRegistry::loaded(std::type_index type, const std::string& path) const
+{
+    return peek(type, path) != nullptr;
+}
+
+void AssetRegistry::begin_load(std::type_index type, const std::string& path)
+{
+    _loading_stack.emplace_back(type, path);
+}
+
+void AssetRegistry::end_load()
+{
+    check(!_loading_stack.empty());
+    _loading_stack.pop_back();
+}
+
+std::vector<AssetManifestEntry> AssetRegistry::dependencies(std::type_index type, const std::string& path) const
+{
+    std::lock_guard lock(_mutex);
+
+    std::vector<AssetManifestEntry> entries;
+    if (const auto it = _records.find(Key(type, path)); it != _records.end())
+    {
+        for (const Key& dependency : it->second.dependencies)
+        {
+            if (std::optional<AssetManifestEntry> entry = to_manifest_entry(dependency))
+            {
+                entries.push_back(std::move(*entry));
+            }
+        }
+    }
+
+    return entries;
+}
+
+AssetRegistry::RecordingId AssetRegistry::begin_recording()
+{
+    std::lock_guard lock(_mutex);
+
+    const RecordingId recording = _next_recording_id++;
+    _recordings[recording] = Recording();
+
+    return recording;
+}
+
+std::vector<AssetManifestEntry> AssetRegistry::end_recording(RecordingId recording)
+{
+    std::lock_guard lock(_mutex);
+
+    const auto it = _recordings.find(recording);
+    check(it != _recordings.end());
+
+    std::vector<AssetManifestEntry> manifest;
+    manifest.reserve(it->second.keys.size());
+
+    for (const Key& key : it->second.keys)
+    {
+        if (std::optional<AssetManifestEntry> entry = to_manifest_entry(key))
+        {
+            manifest.push_back(std::move(*entry));
+        }
+    }
+
+    _recordings.erase(it);
+    return manifest;
+}
+
+AssetBatch AssetRegistry::preload(const std::vector<AssetManifestEntry>& manifest)
+{
+    std::vector<std::pair<Preloader, std::string>> preloads;
+
+    {
+        std::lock_guard lock(_mutex);
+        preloads.reserve(manifest.size());
+
+        for (const AssetManifestEntry& entry : manifest)
+        {
+            if (const auto it = _types_by_name.find(entry.type); it != _types_by_name.end())
+            {
+                preloads.emplace_back(_types.at(it->second).preloader, entry.path);
+            }
+            else
+            {
+                Logger::warning("Cannot preload '%s' as its type '%s' isn't registered", entry.path.c_str(), entry.type.c_str());
+            }
+        }
+    }
+
+    // The lock is released first since starting a load looks the asset up in the registry
+    AssetBatch batch;
+    for (const auto& [preloader, path] : preloads)
+    {
+        batch.add(preloader(path));
+    }
+
+    return batch;
+}
+
+bool AssetRegistry::save_manifest(const std::string& path, const std::vector<AssetManifestEntry>& manifest)
+{
+    io::create_directories_for_file(path);
+
+    std::ofstream file(path, std::ios::trunc);
+    if (!file.is_open())
+    {
+        Logger::warning("Failed to write asset manifest '%s'", path.c_str());
+        return false;
+    }
+
+    const nlohmann::json manifest_def = {
+        { "assets", manifest }
+    };
+
+    file << manifest_def.dump(4);
+    return true;
+}
+
+std::optional<std::vector<AssetManifestEntry>> AssetRegistry::load_manifest(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        return std::nullopt;
+    }
+
+    try
+    {
+        const nlohmann::json manifest_def = nlohmann::json::parse(file);
+        return manifest_def.at("assets").get<std::vector<AssetManifestEntry>>();
+    }
+    catch (const nlohmann::json::exception& e)
+    {
+        Logger::warning("Ignoring invalid asset manifest '%s': %s", path.c_str(), e.what());
+        return std::nullopt;
+    }
+}
+
+AssetRegistryStats AssetRegistry::stats() const
+{
+    std::lock_guard lock(_mutex);
+
+    AssetRegistryStats stats;
+    for (const auto& [type, type_record] : _types)
+    {
+        const std::string& name = type_record.name.empty() ? type.name() : type_record.name;
+        stats.types[name] = type_record.stats;
+
+        stats.total.hits += type_record.stats.hits;
+        stats.total.misses += type_record.stats.misses;
+        stats.total.load_time_ms += type_record.stats.load_time_ms;
+    }
+
+    return stats;
+}
+
+void AssetRegistry::dump_stats() const
+{
+    if constexpr (!Logger::enabled())
+    {
+        return;
+    }
+
+    constexpr size_t num_slowest = 10;
+
+    const AssetRegistryStats registry_stats = stats();
+
+    std::string dump = strtools::catf("%-32s %8s %8s %12s\n", "Type", "Hits", "Misses", "Load ms");
+    const auto dump_row = [&](const std::string& name, const AssetStats& stats)
+    {
+        dump += strtools::catf(
+            "%-32s %8lld %8lld %12.2f\n",
+            name.c_str(), static_cast<long long>(stats.hits), static_cast<long long>(stats.misses), stats.load_time_ms
+        );
+    };
+
+    for (const auto& [name, stats] : registry_stats.types)
+    {
+        dump_row(name, stats);
+    }
+
+    dump_row("Total", registry_stats.total);
+
+    std::vector<std::pair<double, Key>> slowest;
+    {
+        std::lock_guard lock(_mutex);
+        for (const auto& [key, record] : _records)
+        {
+            slowest.emplace_back(record.load_time_ms, key);
+        }
+    }
+
+    const size_t num_shown = std::min(slowest.size(), num_slowest);
+    std::partial_sort(slowest.begin(), slowest.begin() + num_shown, slowest.end(), [](const auto& a, const auto& b)
+    {
+        return a.first > b.first;
+    });
+
+    dump += "Slowest assets\n";
+    for (size_t i = 0; i < num_shown; i++)
+    {
+        dump += strtools::catf("%12.2fms %s\n", slowest[i].first, std::get<std::string>(slowest[i].second).c_str());
+    }
+
+    Logger::log("Asset stats\n%s", dump.c_str());
+}
+
+void AssetRegistry::touch(const Key& key)
+{
+    if (!_loading_stack.empty() && _loading_stack.back() != key)
+    {
+        std::vector<Key>& dependencies = _records[_loading_stack.back()].dependencies;
+        if (std::ranges::find(dependencies, key) == dependencies.end())
+        {
+            dependencies.push_back(key);
+        }
+    }
+
+    for (auto& [id, recording] : _recordings)
+    {
+        if (recording.seen.insert(key).second)
+        {
+            recording.keys.push_back(key);
+        }
+    }
+}
+
+std::optional<AssetManifestEntry> AssetRegistry::to_manifest_entry(const Key& key) const
+{
+    const auto it = _types.find(std::get<std::type_index>(key));
+    if (it == _types.end() || it->second.name.empty())
+    {
+        return std::nullopt;
+    }
+
+    return AssetManifestEntry{
+        .type = it->second.name,
+        .path = std::get<std::string>(key)
+    };
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <libs/nlohmann/json.hpp>
+#include <memory/shared_ptr.h>
+#include <utils/hash_helpers.h>
+#include <utils/singleton.h>
+
+#include "asset_loader.h"
+
+// An asset as it's referred to by a manifest, type is the name the asset type was registered under
+struct AssetManifestEntry
+{
+    std::string type;
+    std::string path;
+
+    [[nodiscard]] bool operator==(const AssetManifestEntry& other) const = default;
+};
+
+NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(AssetManifestEntry, type, path);
+
+struct AssetStats
+{
+    // Loads which found the asset already in memory
+    int64_t hits = 0;
+
+    // Loads which had to load the asset from disk
+    int64_t misses = 0;
+
+    // Time spent in load_asset, or finalize_asset for asynchronous loads, including any assets loaded from it
+    double load_time_ms = 0;
+};
+
+struct AssetRegistryStats
+{
+    AssetStats total;
+    std::unordered_map<std::string, AssetStats> types;
+};
+
+// Tracks every loaded asset across all asset types, and is safe to use from any thread
+// Assets loaded while another asset is loading are recorded as its dependencies, and recordings capture every
+// asset touched while they're active so that they can be saved as a manifest and preloaded ahead of time
+// Assets are held weakly, the registry never keeps an asset alive by itself
+class AssetRegistry : public utils::Singleton<AssetRegistry>
+{
+    using Singleton::Singleton;
+
+public:
+    using Preloader = std::function<std::unique_ptr<IAssetRequest>(const std::string& path)>;
+    using RecordingId = int32_t;
+
+    // Registers an asset type so that manifests can refer to it, see register_asset_type
+    void register_type(std::type_index type, const std::string& type_name, Preloader&& preloader);
+
+    // Gets the asset if it's loaded and counts a hit or miss
+    [[nodiscard]] std::shared_ptr<void> find(std::type_index type, const std::string& path);
+
+    template <typename T>
+    [[nodiscard]] peng::shared_ptr<T> find(const std::string& path);
+
+    // Gets the asset if it's loaded without counting a hit or miss or recording that it was used
+    [[nodiscard]] std::shared_ptr<void> peek(std::type_index type, const std::string& path) const;
+
+    template <typename T>
+    [[nodiscard]] peng::shared_ptr<T> peek(const std::string& path) const;
+
+    // Adds a newly loaded asset, returning the asset which should be used
+    // If another thread added the same asset first then that asset is returned instead, so every user of an asset
+    // shares the same copy
+    [[nodiscard]] std::shared_ptr<void> add(
+        std::type_index type,
+        const std::string& path,
+        const std::shared_ptr<void>& asset,
+        double load_time_ms
+    );
+
+    template <typename T>
+    [[nodiscard]] peng::shared_ref<T> add(const std::string& path, const peng::shared_ref<T>& asset, double load_time_ms);
+
+    [[nodiscard]] bool loaded(std::type_index type, const std::string& path) const;
+
+    // Marks the asset as loading on this thread until end_load, so any assets it loads are recorded as dependencies
+    void begin_load(std::type_index type, const std::string& path);
+    void end_load();
+
+    // Assets directly loaded by the asset while it was loading
+    [[nodiscard]] std::vector<AssetManifestEntry> dependencies(std::type_index type, const std::string& path) const;
+
+    // Starts recording every asset touched by any thread, whether it was already loaded or not
+    [[nodiscard]] RecordingId begin_recording();
+
+    // Stops the recording, returning each asset it touched once in the order they were first touched
+    // Assets of types which haven't been registered are left out as they couldn't be preloaded
+    [[nodiscard]] std::vector<AssetManifestEntry> end_recording(RecordingId recording);
+
+    // Starts loading every asset in the manifest asynchronously, must be called on the main thread
+    [[nodiscard]] AssetBatch preload(const std::vector<AssetManifestEntry>& manifest);
+
+    static bool save_manifest(const std::string& path, const std::vector<AssetManifestEntry>& manifest);
+    [[nodiscard]] static std::optional<std::vector<AssetManifestEntry>> load_manifest(const std::string& path);
+
+    [[nodiscard]] AssetRegistryStats stats() const;
+
+    // Logs the stats of every asset type along with the slowest assets to load
+    void dump_stats() const;
+
+private:
+    using Key = std::tuple<std::type_index, std::string>;
+
+    struct Record
+    {
+        std::weak_ptr<void> asset;
+        std::vector<Key> dependencies;
+        double load_time_ms = 0;
+    };
+
+    struct Recording
+    {
+        std::vector<Key> keys;
+        std::unordered_set<Key> seen;
+    };
+
+    struct TypeRecord
+    {
+        std::string name;
+        Preloader preloader;
+        AssetStats stats;
+    };
+
+    // Must be called with the mutex held
+    void touch(const Key& key);
+    [[nodiscard]] std::optional<AssetManifestEntry> to_manifest_entry(const Key& key) const;
+
+    // Assets being loaded on this thread, the innermost is the one any assets loaded now are dependencies of
+    static thread_local std::vector<Key> _loading_stack;
+
+    mutable std::mutex _mutex;
+    std::unordered_map<Key, Record> _records;
+    std::unordered_map<std::type_index, TypeRecord> _types;
+    std::unordered_map<std::string, std::type_index> _types_by_name;
+    std::unordered_map<RecordingId, Recording> _recordings;
+    RecordingId _next_recording_id = 0;
+};
+
+template <typename T>
+peng::shared_ptr<T> AssetRegistry::find(const std::string& path)
+{
+    return peng::shared_ptr<T>(std::static_pointer_cast<T>(find(typeid(T), path)));
+}
+
+template <typename T>
+peng::shared_ptr<T> AssetRegistry::peek(const std::string& path) const
+{
+    return peng::shared_ptr<T>(std::static_pointer_cast<T>(peek(typeid(T), path)));
+}
+
+template <typename T>
+peng::shared_ref<T> AssetRegistry::add(const std::string& path, const peng::shared_ref<T>& asset, double load_time_ms)
+{
+    const std::shared_ptr<void> added = add(typeid(T), path, asset.get_impl(), load_time_ms);
+    return peng::shared_ref<T>(std::static_pointer_cast<T>(added));
+}
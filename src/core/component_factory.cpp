@@ -34,7 +34,7 @@ peng::weak_ptr<Component> ComponentFactory::load_component(const Archive& archiv
 	{
 		Logger::error(
 			"Could not load component on entity '%s' as no type was provided",
-			archive.json_def.dump().c_str(), entity->name().c_str()
+			entity->name().c_str()
 		);
 
 		return {};
@@ -2,9 +2,11 @@
 
 #include <vector>
 #include <memory>
+#include <span>
 
 #include <memory/weak_ptr.h>
 #include <math/transform.h>
+#include <utils/small_vector.h>
 
 #include "tickable.h"
 #include "serializable.h"
@@ -101,7 +103,7 @@ public:
 
 	[[nodiscard]] peng::weak_ptr<Entity> parent() noexcept { return _parent; }
 	[[nodiscard]] peng::weak_ptr<const Entity> parent() const noexcept { return _parent; }
-	[[nodiscard]] const std::vector<peng::weak_ptr<Entity>>& children() const noexcept { return _children; }
+	[[nodiscard]] std::span<const peng::weak_ptr<Entity>> children() const noexcept { return _children; }
 
 	[[nodiscard]] bool has_parent() const noexcept;
 	[[nodiscard]] bool has_spatial_parent() const noexcept;
@@ -111,7 +113,7 @@ public:
 	[[nodiscard]] math::Matrix4x4f transform_matrix_inv() const noexcept;
 	[[nodiscard]] math::Transform& local_transform() noexcept { return _local_transform; }
 	[[nodiscard]] const math::Transform& local_transform() const noexcept { return _local_transform; }
-	[[nodiscard]] const std::vector<peng::shared_ref<Component>>& components() const noexcept { return _components; }
+	[[nodiscard]] std::span<const peng::shared_ref<Component>> components() const noexcept { return _components; }
 
 	[[nodiscard]] math::Vector3f world_position() const noexcept;
 	// TODO: implement world_rotation
@@ -136,9 +138,11 @@ private:
 	peng::weak_ptr<Entity> _parent;
 	EntityRelationship _parent_relationship;
 
+	// Most entities are leaves with one or two components, so only the components are stored inline
+	// Components added in the constructor are deferred until post_create, so the deferred list matches
 	std::vector<peng::weak_ptr<Entity>> _children;
-	std::vector<peng::shared_ref<Component>> _components;
-	std::vector<peng::shared_ref<Component>> _deferred_components;
+	utils::small_vector<peng::shared_ref<Component>, 2> _components;
+	utils::small_vector<peng::shared_ref<Component>, 2> _deferred_components;
 };
 
 template <std::derived_from<Entity> T, typename...Args>
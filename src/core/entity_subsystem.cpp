@@ -287,7 +287,7 @@ std::string EntitySubsystem::build_entity_hierarchy(const std::vector<peng::weak
 }
 
 void EntitySubsystem::build_entity_hierarchy(
-	const std::vector<peng::weak_ptr<Entity>>& root_entities,
+	std::span<const peng::weak_ptr<Entity>> root_entities,
 	int32_t depth,
 	std::vector<bool>& draw_vertical,
 	std::string& result
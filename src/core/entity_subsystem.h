@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <concepts>
+#include <span>
 
 #include <memory/shared_ref.h>
 #include <memory/weak_ptr.h>
@@ -71,7 +72,7 @@ private:
 	void for_each_tickable(bool parallel, const std::vector<peng::shared_ref<ITickable>>& tickables, F&& invocable);
 
 	void build_entity_hierarchy(
-		const std::vector<peng::weak_ptr<Entity>>& root_entities,
+		std::span<const peng::weak_ptr<Entity>> root_entities,
 		int32_t depth,
 		std::vector<bool>& draw_vertical,
 		std::string& result
@@ -22,25 +22,36 @@ Logger::~Logger()
 }
 
 #ifdef NO_LOGGING
-void Logger::log(LogSeverity, const std::string&) {}
+void Logger::log(LogSeverity, std::string_view) {}
 #else
-void Logger::log(LogSeverity severity, const std::string& message)
+void Logger::log(LogSeverity severity, std::string_view message)
 {
-	Log log = {
-		.severity = severity,
-		.message = message,
-		.timestamp = time_now_info(),
-		.frame_number = PengEngine::exists()
-			? PengEngine::get().frame_number()
-			: 0
-	};
+	Log log = make_log(severity);
+	log.message = message;
+
+	enqueue_log(std::move(log));
+}
 
-    _worker_thread.schedule_job(threading::Job([this, log = std::move(log)]
+void Logger::enqueue_log(Log&& log)
+{
+	_pending_logs.enqueue(std::move(log));
+
+	// Capturing only this keeps the job small enough to not allocate
+    _worker_thread.schedule_job(threading::Job([this]
 	{
-		log_internal(log);
+		flush_pending_logs();
 	}));
 }
 
+void Logger::flush_pending_logs()
+{
+	Log log;
+	while (_pending_logs.try_dequeue(log))
+	{
+		log_internal(log);
+	}
+}
+
 void Logger::log_internal(const Log& log)
 {
 	// Open the log file if we haven't already
@@ -102,8 +113,16 @@ void Logger::log_internal(const Log& log)
 		log.frame_number
 	);
 
-	std::cout << log.message;
-	_log_file << time_code << log.message << std::endl;
+	// Deferred logs are expanded here on the logger thread rather than on the thread that logged them
+	const std::string* message = &log.message;
+	if (log.deferred_message.captured())
+	{
+		log.deferred_message.expand(_expanded_message);
+		message = &_expanded_message;
+	}
+
+	std::cout << *message;
+	_log_file << time_code << *message << std::endl;
 
 	switch (log.severity)
 	{
@@ -120,6 +139,19 @@ void Logger::log_internal(const Log& log)
 	std::cout << "\n";
 }
 
+Logger::Log Logger::make_log(LogSeverity severity) const
+{
+	return Log {
+		.severity = severity,
+		.message = {},
+		.deferred_message = {},
+		.timestamp = time_now_info(),
+		.frame_number = PengEngine::exists()
+			? PengEngine::get().frame_number()
+			: 0
+	};
+}
+
 tm Logger::time_now_info() const
 {
 	const time_t time_now = time(nullptr);
@@ -134,22 +166,22 @@ tm Logger::time_now_info() const
 }
 #endif
 
-void Logger::log(const std::string& message)
+void Logger::log(std::string_view message)
 {
 	get().log(LogSeverity::log, message);
 }
 
-void Logger::warning(const std::string& message)
+void Logger::warning(std::string_view message)
 {
 	get().log(LogSeverity::warning, message);
 }
 
-void Logger::error(const std::string& message)
+void Logger::error(std::string_view message)
 {
 	get().log(LogSeverity::error, message);
 }
 
-void Logger::success(const std::string& message)
+void Logger::success(std::string_view message)
 {
 	get().log(LogSeverity::success, message);
 }
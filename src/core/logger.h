@@ -1,13 +1,16 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <fstream>
 
 #ifndef NO_LOGGING
+#include <common/common.h>
 #include <threading/worker_thread.h>
 #endif
 
 #include <utils/strtools.h>
+#include <utils/deferred_format.h>
 #include <utils/singleton.h>
 
 enum class LogSeverity
@@ -18,41 +21,46 @@ enum class LogSeverity
 	success
 };
 
+// Formatted logs capture their arguments on the calling thread and are only expanded on the logger thread
+// so logging from hot paths does not allocate unless the arguments are too large to capture
 // TODO: automatically enable virtual terminal to get colors on standard windows terminal
 class Logger : public utils::Singleton<Logger>
 {
 	friend Singleton;
 
 public:
-	void log(LogSeverity severity, const std::string& message);
+	void log(LogSeverity severity, std::string_view message);
 
 	template <typename...Args>
-	void logf(LogSeverity severity, const char* format, Args&&...args);
+	void logf(LogSeverity severity, strtools::format_string_for<Args...> format, Args&&...args);
 
-	static void log(const std::string& message);
-	static void warning(const std::string& message);
-	static void error(const std::string& message);
-	static void success(const std::string& message);
+	static void log(std::string_view message);
+	static void warning(std::string_view message);
+	static void error(std::string_view message);
+	static void success(std::string_view message);
 
 	template <typename...Args>
-	static void log(const char* format, Args&&...args);
+	static void log(strtools::format_string_for<Args...> format, Args&&...args);
 
 	template <typename...Args>
-	static void warning(const char* format, Args&&...args);
+	static void warning(strtools::format_string_for<Args...> format, Args&&...args);
 
 	template <typename...Args>
-	static void error(const char* format, Args&&...args);
+	static void error(strtools::format_string_for<Args...> format, Args&&...args);
 
 	template <typename...Args>
-	static void success(const char* format, Args&&...args);
+	static void success(strtools::format_string_for<Args...> format, Args&&...args);
 
 	consteval static bool enabled();
 
 private:
+	static constexpr size_t log_capture_size = 256;
+
 	struct Log
 	{
 		LogSeverity severity;
 		std::string message;
+		strtools::DeferredFormat<log_capture_size> deferred_message;
 		tm timestamp;
 		int32_t frame_number;
 	};
@@ -61,10 +69,15 @@ private:
 	~Logger();
 
 #ifndef NO_LOGGING
+	void enqueue_log(Log&& log);
+	void flush_pending_logs();
     void log_internal(const Log& log);
+	[[nodiscard]] Log make_log(LogSeverity severity) const;
 	[[nodiscard]] tm time_now_info() const;
 
 	std::ofstream _log_file;
+	std::string _expanded_message;
+	common::concurrent_queue<Log> _pending_logs;
 	threading::WorkerThread _worker_thread;
 #endif
 };
@@ -79,17 +92,26 @@ consteval bool Logger::enabled()
 }
 
 template <typename...Args>
-void Logger::logf(LogSeverity severity, const char* format, Args&&... args)
+void Logger::logf(LogSeverity severity, strtools::format_string_for<Args...> format, Args&&... args)
 {
 	if constexpr (enabled())
 	{
 		if constexpr (sizeof...(args) == 0)
 		{
-			log(severity, std::string(format));
+			log(severity, std::string_view(format.get()));
 		}
 		else
 		{
-			log(severity, strtools::catf(format, std::forward<Args>(args)...));
+#ifndef NO_LOGGING
+			Log log = make_log(severity);
+			if (!log.deferred_message.capture<strtools::detail::format_arg_t<Args>...>(format, args...))
+			{
+				// Arguments were too large to capture so fall back to formatting immediately
+				log.message = strtools::catf<strtools::detail::format_arg_t<Args>...>(format, args...);
+			}
+
+			enqueue_log(std::move(log));
+#endif
 		}
 	}
 	else
@@ -102,25 +124,25 @@ void Logger::logf(LogSeverity severity, const char* format, Args&&... args)
 }
 
 template <typename ... Args>
-void Logger::log(const char* format, Args&&... args)
+void Logger::log(strtools::format_string_for<Args...> format, Args&&... args)
 {
 	get().logf(LogSeverity::log, format, std::forward<Args>(args)...);
 }
 
 template <typename ... Args>
-void Logger::warning(const char* format, Args&&... args)
+void Logger::warning(strtools::format_string_for<Args...> format, Args&&... args)
 {
 	get().logf(LogSeverity::warning, format, std::forward<Args>(args)...);
 }
 
 template <typename ... Args>
-void Logger::error(const char* format, Args&&... args)
+void Logger::error(strtools::format_string_for<Args...> format, Args&&... args)
 {
 	get().logf(LogSeverity::error, format, std::forward<Args>(args)...);
 }
 
 template <typename ... Args>
-void Logger::success(const char* format, Args&&... args)
+void Logger::success(strtools::format_string_for<Args...> format, Args&&... args)
 {
 	get().logf(LogSeverity::success, format, std::forward<Args>(args)...);
 }
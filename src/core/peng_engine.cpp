@@ -4,12 +4,21 @@
 
 #include <utils/timing.h>
 #include <memory/gc.h>
+#include <rendering/device.h>
+#include <rendering/mesh.h>
 #include <rendering/render_queue.h>
+#include <rendering/shader.h>
+#include <rendering/sprite.h>
+#include <rendering/texture.h>
+#include <rendering/window_icon.h>
 #include <rendering/window_subsystem.h>
+#include <audio/audio_clip.h>
 #include <audio/audio_subsystem.h>
 #include <input/input_subsystem.h>
 #include <profiling/scoped_event.h>
 
+#include "asset.h"
+#include "asset_loader.h"
 #include "logger.h"
 #include "entity_subsystem.h"
 
@@ -26,7 +35,16 @@ PengEngine::PengEngine()
 	Subsystem::load<rendering::WindowSubsystem>();
 	Subsystem::load<audio::AudioSubsystem>();
 	Subsystem::load<input::InputSubsystem>();
+	Subsystem::load<AssetLoader>();
 	Subsystem::load<EntitySubsystem>();
+
+	// Names are saved in preload manifests, so changing one invalidates any manifests referring to it
+	register_asset_type<rendering::Texture>("rendering::Texture");
+	register_asset_type<rendering::Mesh>("rendering::Mesh");
+	register_asset_type<rendering::Shader>("rendering::Shader");
+	register_asset_type<rendering::Sprite>("rendering::Sprite");
+	register_asset_type<rendering::WindowIcon>("rendering::WindowIcon");
+	register_asset_type<audio::AudioClip>("audio::AudioClip");
 }
 
 void PengEngine::run()
@@ -164,17 +182,17 @@ void PengEngine::tick_render()
 #ifndef PENG_MASTER
 	if (input::InputSubsystem::get()[input::KeyCode::num_row_1].pressed())
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		rendering::Device::get().set_polygon_mode(GL_FILL);
 	}
 
 	if (input::InputSubsystem::get()[input::KeyCode::num_row_2].pressed())
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		rendering::Device::get().set_polygon_mode(GL_LINE);
 	}
 
 	if (input::InputSubsystem::get()[input::KeyCode::num_row_3].pressed())
 	{
-		glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+		rendering::Device::get().set_polygon_mode(GL_POINT);
 	}
 #endif
 
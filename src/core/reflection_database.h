@@ -4,6 +4,7 @@
 
 #include <common/common.h>
 #include <memory/shared_ptr.h>
+#include <utils/flat_hash_map.h>
 #include <utils/singleton.h>
 
 #include "reflected_type.h"
@@ -35,8 +36,8 @@ public:
 
 private:
 	std::vector<peng::shared_ptr<ReflectedType>> _reflected_types;
-	std::unordered_map<std::string, peng::shared_ptr<ReflectedType>> _name_to_type;
-	std::unordered_map<const std::type_info*, peng::shared_ptr<ReflectedType>> _info_to_type;
+	utils::flat_hash_map<std::string, peng::shared_ptr<ReflectedType>> _name_to_type;
+	utils::flat_hash_map<const std::type_info*, peng::shared_ptr<ReflectedType>> _info_to_type;
 };
 
 template <typename T>
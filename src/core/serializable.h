@@ -1,8 +1,9 @@
 #pragma once
 
-#include <vector>
 #include <functional>
 
+#include <utils/small_vector.h>
+
 struct Archive;
 
 class Serializable
@@ -20,6 +21,7 @@ protected:
     void add_deserializer(std::function<void(const Archive& archive)>&& deserializer);
 
 private:
-    std::vector<std::function<void(Archive& archive)>> _serializers;
-    std::vector<std::function<void(const Archive& archive)>> _deserializers;
+    // Every entity serializes its transform, but few types have more than one serialized member
+    utils::small_vector<std::function<void(Archive& archive)>, 1> _serializers;
+    utils::small_vector<std::function<void(const Archive& archive)>, 1> _deserializers;
 };
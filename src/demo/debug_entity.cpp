@@ -1,5 +1,6 @@
 #include "debug_entity.h"
 
+#include <core/asset_registry.h>
 #include <core/peng_engine.h>
 #include <input/input_subsystem.h>
 #include <rendering/window_subsystem.h>
@@ -19,6 +20,11 @@ void DebugEntity::tick(float delta_time)
 		EntitySubsystem::get().dump_hierarchy();
 	}
 
+	if (InputSubsystem::get()[KeyCode::num_row_9].pressed())
+	{
+		AssetRegistry::get().dump_stats();
+	}
+
 	if (InputSubsystem::get()[KeyCode::f11].pressed())
 	{
 		WindowSubsystem::get().toggle_fullscreen();
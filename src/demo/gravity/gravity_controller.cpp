@@ -45,26 +45,21 @@ void GravityController::tick(float delta_time)
 	SCOPED_EVENT("GravityController - tick");
 	Entity::tick(delta_time);
 
-	// Accessing via weak-ptr is quite slow due to thread safety so cache raw ptrs
-	std::vector<Rock*> rock_ptrs;
+	// Accessing via weak-ptr is quite slow due to thread safety so pin all rocks up front
+	peng::pinned_list<Rock> rocks;
 
 	{
-		SCOPED_EVENT("GravityController - cache pointers");
-
-		rock_ptrs.reserve(_rocks.size());
-		for (auto& rock : _rocks)
-		{
-			rock_ptrs.push_back(rock.lock().get());
-		}
+		SCOPED_EVENT("GravityController - pin rocks");
+		rocks = peng::lock_all(_rocks);
 	}
 
 	{
 		SCOPED_EVENT("GravityController - apply attraction");
 
 		std::for_each(
-			std::execution::par_unseq, rock_ptrs.begin(), rock_ptrs.end(),
-			[&](Rock* rock1) {
-				for (Rock* rock2 : rock_ptrs)
+			std::execution::par_unseq, rocks.begin(), rocks.end(),
+			[&](const peng::pinned_ptr<Rock>& rock1) {
+				for (const peng::pinned_ptr<Rock>& rock2 : rocks)
 				{
 					if (rock1 != rock2)
 					{
@@ -15,7 +15,7 @@ void Rock::post_create()
 	Entity::post_create();
 
 	add_component<MeshRenderer>(
-		rendering::Primitives::icosphere(1),
+		rendering::Primitives::lod_icosphere(2),
 		rendering::Primitives::phong_material()
 	)->material()->set_parameter("base_color", math::Vector4f(math::rand3f(), 1));
 }
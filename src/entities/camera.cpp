@@ -1,10 +1,13 @@
 #include "camera.h"
 
+#include <cmath>
+#include <limits>
 #include <numbers>
 
 #include <core/logger.h>
 #include <core/serialized_member.h>
 #include <rendering/window_subsystem.h>
+#include <rendering/render_queue.h>
 #include <utils/utils.h>
 
 IMPLEMENT_ENTITY(entities::Camera);
@@ -72,6 +75,20 @@ void Camera::tick(float delta_time)
 	}
 
 	_view_matrix = calc_projection_matrix() * transform_inv;
+
+	if (_current.lock().get() == this)
+	{
+		// Both projections look down the camera's local z axis
+		const Vector3f view_dir = (transform_matrix() * Vector4f(0, 0, 1, 0)).xyz().normalized();
+
+		RenderQueue::get().enqueue_command(CameraRenderData{
+			.view_matrix = _view_matrix,
+			.view_pos = world_position(),
+			.view_dir = view_dir,
+			.near_clip = _near_clip,
+			.far_clip = _far_clip
+		});
+	}
 }
 
 void Camera::make_perspective(float fov, float near_clip, float far_clip)
@@ -119,6 +136,29 @@ Camera::Projection Camera::projection() const noexcept
 	return _projection;
 }
 
+float Camera::screen_size(const physics::BoundingSphere& bounds) const noexcept
+{
+	if (bounds.is_infinite())
+	{
+		return std::numeric_limits<float>::infinity();
+	}
+
+	// The orthographic size is half the height of the view
+	if (_projection == Projection::orthographic)
+	{
+		return bounds.radius / _ortho_size;
+	}
+
+	const float dist = (bounds.center - world_position()).magnitude();
+	if (dist <= bounds.radius)
+	{
+		return std::numeric_limits<float>::infinity();
+	}
+
+	const float fov_rads = _fov / 180 * std::numbers::pi_v<float>;
+	return bounds.radius / (dist * std::tan(fov_rads / 2));
+}
+
 void Camera::validate_config() const noexcept
 {
 	if (_near_clip >= _far_clip)
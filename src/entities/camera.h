@@ -3,6 +3,7 @@
 #include <core/entity.h>
 #include <math/transform.h>
 #include <memory/weak_ptr.h>
+#include <physics/bounding_sphere.h>
 
 namespace entities
 {
@@ -47,6 +48,10 @@ namespace entities
 		[[nodiscard]] const math::Matrix4x4f& view_matrix() const noexcept;
 		[[nodiscard]] Projection projection() const noexcept;
 
+		// Fraction of the screen's height covered by a world space sphere, used to pick levels of detail
+		// Spheres containing the camera are treated as covering the whole screen
+		[[nodiscard]] float screen_size(const physics::BoundingSphere& bounds) const noexcept;
+
 	private:
 		static peng::weak_ptr<Camera> _current;
 
@@ -57,6 +57,12 @@ void Bootloader::tick(float delta_time)
 {
     Entity::tick(delta_time);
 
+    if (_scene_load)
+    {
+        tick_scene_load();
+        return;
+    }
+
     const int32_t num_entries = static_cast<int32_t>(_entries.size());
     if (num_entries == 0)
     {
@@ -95,18 +101,48 @@ void Bootloader::update_entries_display()
     for (size_t i = 0; i < _entries.size(); i++)
     {
         const bool selected = i == _selected_entry;
-        const std::string label = strtools::catf(
+        std::string label = strtools::catf(
             "%s%s", selected ? ">" : " ", _entries[i].entity->name().c_str()
         );
 
+        if (selected && _scene_load)
+        {
+            label += strtools::catf(" %d%%", static_cast<int32_t>(_scene_load->progress() * 100));
+        }
+
         _entries[i].entity->get_component<TextRenderer>()->set_text(label);
     }
 }
 
 void Bootloader::load_entry(const Entry& entry)
 {
-    scene::SceneLoader loader;
-    loader.load_from_file(entry.path);
+    // The scene is streamed in over several frames, showing its progress until it's done
+    _scene_load = scene::SceneLoader::load_from_file_async(entry.path);
+    update_entries_display();
+}
+
+void Bootloader::tick_scene_load()
+{
+    if (InputSubsystem::get()[KeyCode::escape].pressed())
+    {
+        _scene_load->cancel();
+    }
+
+    update_entries_display();
+
+    if (!_scene_load->done())
+    {
+        return;
+    }
 
-    destroy();
+    if (_scene_load->status() == LoadStatus::loaded)
+    {
+        destroy();
+    }
+    else
+    {
+        // Lets another scene be picked, though any entities already created by a cancelled load are kept
+        _scene_load = nullptr;
+        update_entries_display();
+    }
 }
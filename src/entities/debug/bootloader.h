@@ -2,6 +2,7 @@
 
 #include <core/entity.h>
 #include <memory/weak_ptr.h>
+#include <scene/scene_loader.h>
 
 namespace entities::debug
 {
@@ -27,9 +28,11 @@ namespace entities::debug
 		std::string shorten_path(const std::string& scene_path) const;
 		void update_entries_display();
 		void load_entry(const Entry& entry);
+		void tick_scene_load();
 
 		std::vector<Entry> _entries;
 		int32_t _selected_entry = 0;
+		peng::shared_ptr<scene::AsyncSceneLoad> _scene_load;
 		std::string _scene_dir = "resources/scenes";
 		std::string _scene_ext = ".json";
 
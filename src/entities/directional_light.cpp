@@ -1,7 +1,7 @@
 #include "directional_light.h"
 
-#include <core/logger.h>
 #include <core/serialized_member.h>
+#include <rendering/render_queue.h>
 #include <utils/utils.h>
 
 IMPLEMENT_ENTITY(entities::DirectionalLight);
@@ -27,7 +27,7 @@ DirectionalLight::DirectionalLight(const std::string& name)
 { }
 
 DirectionalLight::DirectionalLight(std::string&& name)
-	: Entity(name, TickGroup::none)
+	: Entity(name, TickGroup::pre_render)
 	, _data({
 		math::Vector3f::one(),
 		math::Vector3f::one() * 0.01f,
@@ -45,15 +45,23 @@ void DirectionalLight::post_create()
 {
 	Entity::post_create();
 
-	if (_current.valid())
-	{
-		Logger::warning("Only one directional light can be used at a time");
-	}
-
 	_current = weak_this();
 	check(_current);
 }
 
+void DirectionalLight::tick(float delta_time)
+{
+	Entity::tick(delta_time);
+
+	// TODO: this doesn't work if light has spatial parents that rotate it
+	rendering::RenderQueue::get().enqueue_command(rendering::DirectionalLightRenderData{
+		.dir = -local_transform().local_up(),
+		.intensity = _data.intensity,
+		.color = _data.color,
+		.ambient = _data.ambient
+	});
+}
+
 DirectionalLight::LightData& DirectionalLight::data() noexcept
 {
 	return _data;
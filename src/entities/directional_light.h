@@ -23,6 +23,7 @@ namespace entities
 		static const peng::weak_ptr<DirectionalLight>& current();
 
 		void post_create() override;
+		void tick(float delta_time) override;
 
 		[[nodiscard]] LightData& data() noexcept;
 		[[nodiscard]] const LightData& data() const noexcept;
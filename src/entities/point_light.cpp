@@ -1,6 +1,7 @@
 #include "point_light.h"
 
 #include <core/serialized_member.h>
+#include <rendering/render_queue.h>
 #include <utils/vectools.h>
 #include <utils/utils.h>
 
@@ -27,7 +28,7 @@ PointLight::PointLight(const std::string& name)
 { }
 
 PointLight::PointLight(std::string&& name)
-	: Entity(name, TickGroup::none)
+	: Entity(name, TickGroup::pre_render)
 	, _data({
 		math::Vector3f::one(),
 		math::Vector3f::one() * 0.01f,
@@ -49,6 +50,19 @@ void PointLight::post_create()
 	_active_lights.push_back(weak_this());
 }
 
+void PointLight::tick(float delta_time)
+{
+	Entity::tick(delta_time);
+
+	rendering::RenderQueue::get().enqueue_command(rendering::PointLightRenderData{
+		.pos = world_position(),
+		.range = _data.range,
+		.color = _data.color,
+		.max_strength = 1,
+		.ambient = _data.ambient
+	});
+}
+
 void PointLight::pre_destroy()
 {
 	Entity::pre_destroy();
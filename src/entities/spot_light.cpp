@@ -1,6 +1,8 @@
 #include "spot_light.h"
 
 #include <core/serialized_member.h>
+#include <rendering/render_queue.h>
+#include <math/math.h>
 #include <utils/vectools.h>
 #include <utils/utils.h>
 
@@ -29,7 +31,7 @@ SpotLight::SpotLight(const std::string& name)
 { }
 
 SpotLight::SpotLight(std::string&& name)
-	: Entity(name, TickGroup::none)
+	: Entity(name, TickGroup::pre_render)
 	, _data({
 		math::Vector3f::one(),
 		math::Vector3f::one() * 0.01f,
@@ -51,6 +53,22 @@ void SpotLight::post_create()
 	_active_lights.push_back(weak_this());
 }
 
+void SpotLight::tick(float delta_time)
+{
+	Entity::tick(delta_time);
+
+	// TODO: this doesn't work if light has spatial parents that rotate it
+	rendering::RenderQueue::get().enqueue_command(rendering::SpotLightRenderData{
+		.pos = world_position(),
+		.range = _data.range,
+		.dir = local_transform().local_forwards(),
+		.umbra_cos = std::cos(math::degs_to_rads(_data.umbra)),
+		.color = _data.color,
+		.penumbra_cos = std::cos(math::degs_to_rads(_data.penumbra)),
+		.ambient = _data.ambient
+	});
+}
+
 void SpotLight::pre_destroy()
 {
 	Entity::pre_destroy();
@@ -31,6 +31,7 @@ namespace entities
 		static const std::vector<peng::weak_ptr<SpotLight>>& active_lights();
 
 		void post_create() override;
+		void tick(float delta_time) override;
 		void pre_destroy() override;
 
 		[[nodiscard]] LightData& data() noexcept;
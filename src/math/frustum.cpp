@@ -0,0 +1,86 @@
+#include "frustum.h"
+
+#include <cmath>
+
+#include <utils/check.h>
+
+using namespace math;
+
+Frustum::Frustum()
+    : _nx()
+    , _ny()
+    , _nz()
+    , _d()
+{ }
+
+Frustum::Frustum(const Matrix4x4f& view_projection)
+{
+    const Matrix4x4f& m = view_projection;
+
+    // Each plane is the last row of the matrix plus or minus one of the others (Gribb & Hartmann)
+    // In order: left, right, bottom, top, near, far
+    for (size_t plane = 0; plane < num_planes; plane++)
+    {
+        const uint8_t row = static_cast<uint8_t>(plane / 2);
+        const float sign = plane % 2 == 0 ? 1.0f : -1.0f;
+
+        const float a = m.get(3, 0) + sign * m.get(row, 0);
+        const float b = m.get(3, 1) + sign * m.get(row, 1);
+        const float c = m.get(3, 2) + sign * m.get(row, 2);
+        const float d = m.get(3, 3) + sign * m.get(row, 3);
+
+        // Normalize so that plane distances are in world units and can be compared against radii
+        const float length = std::sqrt(a * a + b * b + c * c);
+        const float inv_length = length > 0 ? 1 / length : 0;
+
+        _nx[plane] = a * inv_length;
+        _ny[plane] = b * inv_length;
+        _nz[plane] = c * inv_length;
+        _d[plane] = d * inv_length;
+    }
+}
+
+bool Frustum::intersects_sphere(const Vector3f& center, float radius) const noexcept
+{
+    bool inside = true;
+    for (size_t plane = 0; plane < num_planes; plane++)
+    {
+        const float dist = _nx[plane] * center.x + _ny[plane] * center.y + _nz[plane] * center.z + _d[plane];
+        inside &= dist >= -radius;
+    }
+
+    return inside;
+}
+
+void Frustum::cull_spheres(
+    std::span<const float> xs,
+    std::span<const float> ys,
+    std::span<const float> zs,
+    std::span<const float> radii,
+    std::span<uint8_t> visible
+) const noexcept
+{
+    const size_t count = visible.size();
+    check(xs.size() == count && ys.size() == count && zs.size() == count && radii.size() == count);
+
+    const float* const x = xs.data();
+    const float* const y = ys.data();
+    const float* const z = zs.data();
+    const float* const r = radii.data();
+    uint8_t* const out = visible.data();
+
+    // Planes on the outside keep the inner loop branchless so it vectorizes across spheres
+    for (size_t plane = 0; plane < num_planes; plane++)
+    {
+        const float nx = _nx[plane];
+        const float ny = _ny[plane];
+        const float nz = _nz[plane];
+        const float d = _d[plane];
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const float dist = nx * x[i] + ny * y[i] + nz * z[i] + d;
+            out[i] &= static_cast<uint8_t>(dist >= -r[i]);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <span>
+
+#include "vector3.h"
+#include "matrix4x4.h"
+
+namespace math
+{
+    // View frustum made of 6 planes with normals pointing inwards
+    // The planes are stored as structure of arrays so that batches of spheres can be
+    // tested against one plane at a time in a loop the compiler can vectorize
+    class Frustum
+    {
+    public:
+        static constexpr size_t num_planes = 6;
+
+        // Frustum that contains everything
+        Frustum();
+
+        // Extracts the planes from a combined projection and view matrix with OpenGL clip space conventions
+        explicit Frustum(const Matrix4x4f& view_projection);
+
+        [[nodiscard]] bool intersects_sphere(const Vector3f& center, float radius) const noexcept;
+
+        // Tests a batch of spheres given as separate coordinate arrays
+        // visible[i] is cleared for each sphere fully outside the frustum, and left untouched otherwise
+        void cull_spheres(
+            std::span<const float> xs,
+            std::span<const float> ys,
+            std::span<const float> zs,
+            std::span<const float> radii,
+            std::span<uint8_t> visible
+        ) const noexcept;
+
+    private:
+        std::array<float, num_planes> _nx;
+        std::array<float, num_planes> _ny;
+        std::array<float, num_planes> _nz;
+        std::array<float, num_planes> _d;
+    };
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "shared_ref.h"
+
+namespace peng
+{
+    // A strong reference pinned from a weak_ptr for the duration of a scope
+    // Pinning locks once up front, after which access is a plain pointer dereference
+    // instead of the lock per access that weak_ptr requires
+    // Pins are move only to discourage them from escaping the scope they were made in
+    template <typename T>
+    class pinned_ptr
+    {
+    public:
+        pinned_ptr()
+            : _ptr()
+        { }
+
+        explicit pinned_ptr(std::shared_ptr<T>&& ptr)
+            : _ptr(std::move(ptr))
+        { }
+
+        pinned_ptr(const pinned_ptr&) = delete;
+        pinned_ptr(pinned_ptr&&) noexcept = default;
+        pinned_ptr& operator=(const pinned_ptr&) = delete;
+        pinned_ptr& operator=(pinned_ptr&&) noexcept = default;
+
+        [[nodiscard]] T* get() const noexcept
+        {
+            return _ptr.get();
+        }
+
+        [[nodiscard]] T* operator->() const
+        {
+            check(_ptr);
+            return get();
+        }
+
+        [[nodiscard]] T& operator*() const
+        {
+            check(_ptr);
+            return *get();
+        }
+
+        [[nodiscard]] const std::shared_ptr<T>& get_impl() const noexcept
+        {
+            return _ptr;
+        }
+
+        [[nodiscard]] shared_ref<T> to_shared_ref() const noexcept
+        {
+            return shared_ref<T>(_ptr);
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return _ptr != nullptr;
+        }
+
+    private:
+        std::shared_ptr<T> _ptr;
+    };
+
+    // A set of objects pinned together, see lock_all
+    template <typename T>
+    using pinned_list = std::vector<pinned_ptr<T>>;
+
+#pragma region Comparison Operators
+
+    template <typename T, typename U>
+    requires std::equality_comparable_with<T*, U*>
+    [[nodiscard]] bool operator==(const pinned_ptr<T>& a, const pinned_ptr<U>& b)
+    {
+        return a.get() == b.get();
+    }
+
+#pragma endregion
+}
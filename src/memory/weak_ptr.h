@@ -1,6 +1,9 @@
 #pragma once
 
+#include <span>
+
 #include "shared_ptr.h"
+#include "pinned_ptr.h"
 
 namespace peng
 {
@@ -20,6 +23,10 @@ namespace peng
             : _ptr(ptr.get_impl())
         { }
 
+        weak_ptr(const pinned_ptr<T>& ptr)
+            : _ptr(ptr.get_impl())
+        { }
+
         template <typename U>
         requires std::convertible_to<U*, T*>
         weak_ptr(const weak_ptr<U>& other)
@@ -61,6 +68,13 @@ namespace peng
             return shared_ptr<T>(_ptr.lock());
         }
 
+        // Pins the object for the lifetime of the returned pointer so it can be accessed
+        // repeatedly without locking each time. Will be null if the object has expired
+        [[nodiscard]] pinned_ptr<T> pin() const noexcept
+        {
+            return pinned_ptr<T>(_ptr.lock());
+        }
+
         [[nodiscard]] T* operator->() const 
         {
             check(valid());
@@ -87,6 +101,31 @@ namespace peng
         std::weak_ptr<T> _ptr;
     };
 
+    // Pins every object that has not yet expired, skipping over any that have
+    // Useful for iterating over a list of weak_ptrs without locking on every access
+    template <typename T>
+    [[nodiscard]] pinned_list<T> lock_all(std::span<const weak_ptr<T>> ptrs)
+    {
+        pinned_list<T> pinned;
+        pinned.reserve(ptrs.size());
+
+        for (const weak_ptr<T>& ptr : ptrs)
+        {
+            if (pinned_ptr<T> pin = ptr.pin())
+            {
+                pinned.push_back(std::move(pin));
+            }
+        }
+
+        return pinned;
+    }
+
+    template <typename T>
+    [[nodiscard]] pinned_list<T> lock_all(const std::vector<weak_ptr<T>>& ptrs)
+    {
+        return lock_all(std::span<const weak_ptr<T>>(ptrs));
+    }
+
 #pragma region Comparison Operators
 
     template <typename T, typename U>
@@ -124,6 +163,13 @@ namespace peng
         return weak_ptr<T>(a) == b;
     }
 
+    template <typename T, typename U>
+    requires std::equality_comparable_with<T*, U*>
+    [[nodiscard]] bool operator==(const weak_ptr<T>& a, const pinned_ptr<U>& b)
+    {
+        return a.lock().get() == b.get();
+    }
+
 #pragma endregion
 }
 
@@ -0,0 +1,40 @@
+#include "bounding_sphere.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace physics;
+using namespace math;
+
+BoundingSphere::BoundingSphere(const Vector3f& center, float radius)
+    : center(center)
+    , radius(radius)
+{ }
+
+BoundingSphere BoundingSphere::transformed(const Matrix4x4f& matrix) const
+{
+    if (is_infinite())
+    {
+        return *this;
+    }
+
+    float max_scale_sqr = 0;
+    for (uint8_t col = 0; col < 3; col++)
+    {
+        const Vector3f axis(matrix.get(0, col), matrix.get(1, col), matrix.get(2, col));
+        max_scale_sqr = std::max(max_scale_sqr, axis.magnitude_sqr());
+    }
+
+    return BoundingSphere(matrix * center, radius * std::sqrt(max_scale_sqr));
+}
+
+bool BoundingSphere::is_infinite() const noexcept
+{
+    return std::isinf(radius);
+}
+
+BoundingSphere BoundingSphere::infinite()
+{
+    return BoundingSphere(Vector3f::zero(), std::numeric_limits<float>::infinity());
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <math/vector3.h>
+#include <math/matrix4x4.h>
+
+namespace physics
+{
+    // Sphere enclosing some geometry, cheaper to transform and test than an AABB
+    struct BoundingSphere
+    {
+        BoundingSphere(const math::Vector3f& center, float radius);
+
+        math::Vector3f center;
+        float radius;
+
+        // Gets a sphere enclosing this one once transformed by matrix
+        // Non uniform scales grow the radius by the largest scale so the result is never too small
+        [[nodiscard]] BoundingSphere transformed(const math::Matrix4x4f& matrix) const;
+
+        [[nodiscard]] bool is_infinite() const noexcept;
+
+        // A sphere that encloses everything, used for geometry that has no known bounds
+        [[nodiscard]] static BoundingSphere infinite();
+    };
+}
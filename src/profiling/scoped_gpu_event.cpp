@@ -2,18 +2,18 @@
 
 #include "scoped_gpu_event.h"
 
-#include <GL/glew.h>
+#include <rendering/device.h>
 
 using namespace profiling;
 
 ScopedGPUEvent::ScopedGPUEvent(const char* name)
 {
-    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+    rendering::Device::get().push_debug_group(name);
 }
 
 ScopedGPUEvent::~ScopedGPUEvent()
 {
-    glPopDebugGroup();
+    rendering::Device::get().pop_debug_group();
 }
 
 #endif
@@ -39,7 +39,7 @@ BitmapFont::BitmapFont(
     )
 { }
 
-peng::shared_ptr<const Sprite> BitmapFont::get_sprite(char character) const
+const peng::shared_ptr<const Sprite>& BitmapFont::get_sprite(char character) const
 {
     if (const auto it = _char_map.find(character); it != _char_map.end())
     {
@@ -49,15 +49,13 @@ peng::shared_ptr<const Sprite> BitmapFont::get_sprite(char character) const
     return _fallback_sprite;
 }
 
-std::vector<peng::shared_ptr<const Sprite>> BitmapFont::get_sprites(const std::string& str) const
+void BitmapFont::get_sprites(std::string_view str, std::vector<peng::shared_ptr<const Sprite>>& sprites_out) const
 {
-    std::vector<peng::shared_ptr<const Sprite>> sprites;
+    sprites_out.clear();
     for (const char c : str)
     {
-        sprites.push_back(get_sprite(c));
+        sprites_out.push_back(get_sprite(c));
     }
-
-    return sprites;
 }
 
 bool BitmapFont::validate_sprite(const peng::shared_ptr<const Sprite>& sprite) const
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 
@@ -31,8 +32,10 @@ namespace rendering
             bool pixel_perfect = false
         );
 
-        [[nodiscard]] peng::shared_ptr<const Sprite> get_sprite(char character) const;
-        [[nodiscard]] std::vector<peng::shared_ptr<const Sprite>> get_sprites(const std::string& str) const;
+        [[nodiscard]] const peng::shared_ptr<const Sprite>& get_sprite(char character) const;
+
+        // Writes the sprite for each character of str into sprites_out, reusing its existing capacity
+        void get_sprites(std::string_view str, std::vector<peng::shared_ptr<const Sprite>>& sprites_out) const;
         [[nodiscard]] bool pixel_perfect() const noexcept { return _pixel_perfect; }
 
     private:
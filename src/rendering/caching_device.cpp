@@ -0,0 +1,474 @@
+#include "caching_device.h"
+
+#include <ranges>
+
+#include <utils/check.h>
+
+using namespace rendering;
+using namespace math;
+
+namespace
+{
+    [[nodiscard]] bool uniform_values_equal(const UniformValue& a, const UniformValue& b)
+    {
+        if (a.index() != b.index())
+        {
+            return false;
+        }
+
+        return std::visit([&]<typename T>(const T& x)
+        {
+            const T& y = std::get<T>(b);
+            if constexpr (requires { x.elements; })
+            {
+                return x.elements == y.elements;
+            }
+            else
+            {
+                return x == y;
+            }
+        }, a);
+    }
+
+    template <typename T>
+    [[nodiscard]] std::optional<T>& slot_at(std::vector<std::optional<T>>& slots, size_t index)
+    {
+        if (index >= slots.size())
+        {
+            slots.resize(index + 1);
+        }
+
+        return slots[index];
+    }
+}
+
+CachingDevice::CachingDevice(std::unique_ptr<Device>&& backend)
+    : _backend(std::move(backend))
+    , _program_state(nullptr)
+{
+    check(_backend);
+}
+
+std::unique_ptr<Device> CachingDevice::set_backend(std::unique_ptr<Device>&& backend)
+{
+    check(backend);
+
+    invalidate();
+    _program_states.clear();
+    _storage_buffer_offset_alignment = std::nullopt;
+
+    return std::exchange(_backend, std::move(backend));
+}
+
+void CachingDevice::invalidate()
+{
+    _program = std::nullopt;
+    _program_state = nullptr;
+    _vertex_array = std::nullopt;
+    _textures.clear();
+    _active_texture_slot = std::nullopt;
+    _buffer_bindings.clear();
+    _blend_mode = std::nullopt;
+    _polygon_mode = std::nullopt;
+
+    // Uniform values and storage block bindings belong to the program so survive other state changes,
+    // but if the backend was touched directly they can't be trusted either
+    for (ProgramState& program_state : _program_states | std::views::values)
+    {
+        program_state.uniforms.clear();
+        program_state.storage_block_bindings.clear();
+    }
+}
+
+void CachingDevice::reset_stats() noexcept
+{
+    _stats = StateCacheStats();
+}
+
+Device& CachingDevice::backend() const noexcept
+{
+    return *_backend;
+}
+
+const StateCacheStats& CachingDevice::stats() const noexcept
+{
+    return _stats;
+}
+
+GLuint CachingDevice::create_buffer(const char* label)
+{
+    return _backend->create_buffer(label);
+}
+
+void CachingDevice::delete_buffer(GLuint buffer)
+{
+    _backend->delete_buffer(buffer);
+
+    for (auto it = _buffer_bindings.begin(); it != _buffer_bindings.end();)
+    {
+        it = it->second.buffer == buffer
+            ? _buffer_bindings.erase(it)
+            : std::next(it);
+    }
+}
+
+void CachingDevice::buffer_data(GLenum target, GLuint buffer, size_t size, const void* data, GLenum usage)
+{
+    _backend->buffer_data(target, buffer, size, data, usage);
+}
+
+void CachingDevice::buffer_sub_data(GLenum target, GLuint buffer, size_t offset, size_t size, const void* data)
+{
+    _backend->buffer_sub_data(target, buffer, offset, size, data);
+}
+
+void CachingDevice::bind_buffer_base(GLenum target, GLuint index, GLuint buffer)
+{
+    if (update_buffer_binding(target, index, BufferBinding{ .buffer = buffer, .offset = 0, .size = 0 }))
+    {
+        _backend->bind_buffer_base(target, index, buffer);
+    }
+}
+
+void CachingDevice::bind_buffer_range(GLenum target, GLuint index, GLuint buffer, size_t offset, size_t size)
+{
+    if (update_buffer_binding(target, index, BufferBinding{ .buffer = buffer, .offset = offset, .size = size }))
+    {
+        _backend->bind_buffer_range(target, index, buffer, offset, size);
+    }
+}
+
+void* CachingDevice::map_buffer_persistent(GLenum target, GLuint buffer, size_t size)
+{
+    return _backend->map_buffer_persistent(target, buffer, size);
+}
+
+size_t CachingDevice::storage_buffer_offset_alignment()
+{
+    if (!_storage_buffer_offset_alignment)
+    {
+        _storage_buffer_offset_alignment = _backend->storage_buffer_offset_alignment();
+    }
+
+    return *_storage_buffer_offset_alignment;
+}
+
+GLuint CachingDevice::create_vertex_array(const char* label)
+{
+    // Backends may bind the vertex array to create it
+    _vertex_array = std::nullopt;
+    return _backend->create_vertex_array(label);
+}
+
+void CachingDevice::delete_vertex_array(GLuint vertex_array)
+{
+    _backend->delete_vertex_array(vertex_array);
+
+    if (_vertex_array == vertex_array)
+    {
+        _vertex_array = std::nullopt;
+    }
+}
+
+void CachingDevice::bind_vertex_array(GLuint vertex_array)
+{
+    if (update_state(_vertex_array, vertex_array))
+    {
+        _backend->bind_vertex_array(vertex_array);
+    }
+}
+
+void CachingDevice::vertex_attribute(GLuint index, GLuint buffer, GLint num_components, GLenum type, GLboolean normalized, GLsizei stride, size_t offset)
+{
+    _backend->vertex_attribute(index, buffer, num_components, type, normalized, stride, offset);
+}
+
+GLuint CachingDevice::create_texture(const char* label)
+{
+    invalidate_active_texture_slot();
+    return _backend->create_texture(label);
+}
+
+void CachingDevice::delete_texture(GLuint texture)
+{
+    _backend->delete_texture(texture);
+
+    for (std::optional<GLuint>& bound_texture : _textures)
+    {
+        if (bound_texture == texture)
+        {
+            bound_texture = std::nullopt;
+        }
+    }
+}
+
+void CachingDevice::texture_parameter(GLuint texture, GLenum parameter, GLint value)
+{
+    invalidate_active_texture_slot();
+    _backend->texture_parameter(texture, parameter, value);
+}
+
+void CachingDevice::texture_image(
+    GLuint texture,
+    GLint level,
+    GLint internal_format,
+    const Vector2i& resolution,
+    GLenum format,
+    GLenum type,
+    const void* data
+)
+{
+    invalidate_active_texture_slot();
+    _backend->texture_image(texture, level, internal_format, resolution, format, type, data);
+}
+
+void CachingDevice::compressed_texture_image(
+    GLuint texture,
+    GLint level,
+    GLenum internal_format,
+    const Vector2i& resolution,
+    size_t size,
+    const void* data
+)
+{
+    invalidate_active_texture_slot();
+    _backend->compressed_texture_image(texture, level, internal_format, resolution, size, data);
+}
+
+void CachingDevice::texture_sub_image(
+    GLuint texture,
+    const Vector2i& offset,
+    const Vector2i& resolution,
+    GLenum format,
+    GLenum type,
+    const void* data
+)
+{
+    invalidate_active_texture_slot();
+    _backend->texture_sub_image(texture, offset, resolution, format, type, data);
+}
+
+void CachingDevice::read_texture_image(GLuint texture, GLenum format, GLenum type, size_t size, void* data)
+{
+    invalidate_active_texture_slot();
+    _backend->read_texture_image(texture, format, type, size, data);
+}
+
+void CachingDevice::generate_mipmaps(GLuint texture)
+{
+    invalidate_active_texture_slot();
+    _backend->generate_mipmaps(texture);
+}
+
+void CachingDevice::bind_texture(GLint slot, GLuint texture)
+{
+    check(slot >= 0);
+
+    if (update_state(slot_at(_textures, slot), texture))
+    {
+        _active_texture_slot = slot;
+        _backend->bind_texture(slot, texture);
+    }
+}
+
+GLuint CachingDevice::compile_shader(GLenum type, std::string_view source, const char* label)
+{
+    return _backend->compile_shader(type, source, label);
+}
+
+void CachingDevice::delete_shader(GLuint shader)
+{
+    _backend->delete_shader(shader);
+}
+
+GLuint CachingDevice::link_program(std::span<const GLuint> shaders, const char* label)
+{
+    return _backend->link_program(shaders, label);
+}
+
+void CachingDevice::delete_program(GLuint program)
+{
+    _backend->delete_program(program);
+    _program_states.erase(program);
+
+    // Erasing leaves other entries in place, but a deleted program in use can no longer be trusted
+    if (_program == program)
+    {
+        _program = std::nullopt;
+        _program_state = nullptr;
+    }
+}
+
+void CachingDevice::use_program(GLuint program)
+{
+    if (update_state(_program, program))
+    {
+        _program_state = &_program_states[program];
+        _backend->use_program(program);
+    }
+}
+
+bool CachingDevice::shader_compiled(GLuint shader, std::string& error_log)
+{
+    return _backend->shader_compiled(shader, error_log);
+}
+
+bool CachingDevice::program_linked(GLuint program, std::string& error_log)
+{
+    return _backend->program_linked(program, error_log);
+}
+
+std::vector<ActiveUniform> CachingDevice::active_uniforms(GLuint program)
+{
+    return _backend->active_uniforms(program);
+}
+
+std::optional<UniformValue> CachingDevice::uniform_value(GLuint program, GLint location, GLenum type)
+{
+    return _backend->uniform_value(program, location, type);
+}
+
+GLint CachingDevice::storage_block_index(GLuint program, const char* name)
+{
+    return _backend->storage_block_index(program, name);
+}
+
+void CachingDevice::storage_block_binding(GLuint program, GLuint index, GLuint binding)
+{
+    // Only programs that have been used are tracked, blocks of other programs are always bound
+    if (ProgramState* program_state = find_program_state(program))
+    {
+        if (!update_state(slot_at(program_state->storage_block_bindings, index), binding))
+        {
+            return;
+        }
+    }
+    else
+    {
+        _stats.state_changes_submitted++;
+    }
+
+    _backend->storage_block_binding(program, index, binding);
+}
+
+void CachingDevice::set_uniform(GLint location, const UniformValue& value)
+{
+    if (_program_state && location >= 0)
+    {
+        std::optional<UniformValue>& cached = slot_at(_program_state->uniforms, location);
+        if (cached && uniform_values_equal(*cached, value))
+        {
+            _stats.uniforms_skipped++;
+            return;
+        }
+
+        cached = value;
+    }
+
+    _stats.uniforms_submitted++;
+    _backend->set_uniform(location, value);
+}
+
+void CachingDevice::set_blend_mode(BlendMode blend_mode)
+{
+    if (update_state(_blend_mode, blend_mode))
+    {
+        _backend->set_blend_mode(blend_mode);
+    }
+}
+
+void CachingDevice::set_polygon_mode(GLenum mode)
+{
+    if (update_state(_polygon_mode, mode))
+    {
+        _backend->set_polygon_mode(mode);
+    }
+}
+
+void CachingDevice::draw_elements(GLsizei num_indices)
+{
+    _backend->draw_elements(num_indices);
+}
+
+void CachingDevice::draw_elements_instanced(GLsizei num_indices, GLsizei num_instances)
+{
+    _backend->draw_elements_instanced(num_indices, num_instances);
+}
+
+GLsync CachingDevice::fence_sync()
+{
+    return _backend->fence_sync();
+}
+
+bool CachingDevice::wait_sync(GLsync sync, uint64_t timeout)
+{
+    return _backend->wait_sync(sync, timeout);
+}
+
+void CachingDevice::delete_sync(GLsync sync)
+{
+    _backend->delete_sync(sync);
+}
+
+void CachingDevice::push_debug_group(const char* name)
+{
+    _backend->push_debug_group(name);
+}
+
+void CachingDevice::pop_debug_group()
+{
+    _backend->pop_debug_group();
+}
+
+template <typename T>
+bool CachingDevice::update_state(std::optional<T>& cached, const T& value) noexcept
+{
+    if (cached == value)
+    {
+        _stats.state_changes_skipped++;
+        return false;
+    }
+
+    cached = value;
+    _stats.state_changes_submitted++;
+    return true;
+}
+
+bool CachingDevice::update_buffer_binding(GLenum target, GLuint index, const BufferBinding& binding)
+{
+    const auto [it, inserted] = _buffer_bindings.try_emplace(std::make_tuple(target, index), binding);
+    if (!inserted && it->second == binding)
+    {
+        _stats.state_changes_skipped++;
+        return false;
+    }
+
+    it->second = binding;
+    _stats.state_changes_submitted++;
+    return true;
+}
+
+CachingDevice::ProgramState* CachingDevice::find_program_state(GLuint program)
+{
+    if (_program == program)
+    {
+        return _program_state;
+    }
+
+    const auto it = _program_states.find(program);
+    return it != _program_states.end()
+        ? &it->second
+        : nullptr;
+}
+
+void CachingDevice::invalidate_active_texture_slot() noexcept
+{
+    if (!_active_texture_slot)
+    {
+        _textures.clear();
+    }
+    else if (*_active_texture_slot < static_cast<GLint>(_textures.size()))
+    {
+        _textures[*_active_texture_slot] = std::nullopt;
+    }
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+#include <utils/flat_hash_map.h>
+#include <utils/hash_helpers.h>
+
+#include "device.h"
+
+namespace rendering
+{
+    struct StateCacheStats
+    {
+        int32_t state_changes_submitted = 0;
+        int32_t state_changes_skipped = 0;
+        int32_t uniforms_submitted = 0;
+        int32_t uniforms_skipped = 0;
+    };
+
+    // Device which shadows the bound state of a backend device and drops calls that wouldn't change anything
+    // Tracks the program in use, vertex array, texture units, indexed buffer ranges, storage block bindings,
+    // blend and polygon mode, and the last value uploaded to each uniform of each program
+    // Device::get always returns the cache, and Device::set installs the backend underneath it, so a
+    // RecordingDevice backend only ever sees the calls that made it past the cache
+    // State the cache doesn't know about is treated as unknown, so the next call to set it is always submitted
+    class CachingDevice final : public Device
+    {
+    public:
+        explicit CachingDevice(std::unique_ptr<Device>&& backend);
+
+        // Installs a new backend and returns the previous one, invalidating all cached state
+        std::unique_ptr<Device> set_backend(std::unique_ptr<Device>&& backend);
+
+        // Forgets all cached state, for use after something has touched the backend behind the cache's back
+        void invalidate();
+
+        void reset_stats() noexcept;
+
+        [[nodiscard]] Device& backend() const noexcept;
+        [[nodiscard]] const StateCacheStats& stats() const noexcept;
+
+        [[nodiscard]] GLuint create_buffer(const char* label) override;
+        void delete_buffer(GLuint buffer) override;
+        void buffer_data(GLenum target, GLuint buffer, size_t size, const void* data, GLenum usage) override;
+        void buffer_sub_data(GLenum target, GLuint buffer, size_t offset, size_t size, const void* data) override;
+        void bind_buffer_base(GLenum target, GLuint index, GLuint buffer) override;
+        void bind_buffer_range(GLenum target, GLuint index, GLuint buffer, size_t offset, size_t size) override;
+        [[nodiscard]] void* map_buffer_persistent(GLenum target, GLuint buffer, size_t size) override;
+        [[nodiscard]] size_t storage_buffer_offset_alignment() override;
+
+        [[nodiscard]] GLuint create_vertex_array(const char* label) override;
+        void delete_vertex_array(GLuint vertex_array) override;
+        void bind_vertex_array(GLuint vertex_array) override;
+        void vertex_attribute(GLuint index, GLuint buffer, GLint num_components, GLenum type, GLboolean normalized, GLsizei stride, size_t offset) override;
+
+        [[nodiscard]] GLuint create_texture(const char* label) override;
+        void delete_texture(GLuint texture) override;
+        void texture_parameter(GLuint texture, GLenum parameter, GLint value) override;
+        void texture_image(
+            GLuint texture,
+            GLint level,
+            GLint internal_format,
+            const math::Vector2i& resolution,
+            GLenum format,
+            GLenum type,
+            const void* data
+        ) override;
+
+        void compressed_texture_image(
+            GLuint texture,
+            GLint level,
+            GLenum internal_format,
+            const math::Vector2i& resolution,
+            size_t size,
+            const void* data
+        ) override;
+        void texture_sub_image(
+            GLuint texture,
+            const math::Vector2i& offset,
+            const math::Vector2i& resolution,
+            GLenum format,
+            GLenum type,
+            const void* data
+        ) override;
+        void read_texture_image(GLuint texture, GLenum format, GLenum type, size_t size, void* data) override;
+        void generate_mipmaps(GLuint texture) override;
+        void bind_texture(GLint slot, GLuint texture) override;
+
+        [[nodiscard]] GLuint compile_shader(GLenum type, std::string_view source, const char* label) override;
+        void delete_shader(GLuint shader) override;
+        [[nodiscard]] GLuint link_program(std::span<const GLuint> shaders, const char* label) override;
+        void delete_program(GLuint program) override;
+        void use_program(GLuint program) override;
+
+        [[nodiscard]] bool shader_compiled(GLuint shader, std::string& error_log) override;
+        [[nodiscard]] bool program_linked(GLuint program, std::string& error_log) override;
+
+        [[nodiscard]] std::vector<ActiveUniform> active_uniforms(GLuint program) override;
+        [[nodiscard]] std::optional<UniformValue> uniform_value(GLuint program, GLint location, GLenum type) override;
+        [[nodiscard]] GLint storage_block_index(GLuint program, const char* name) override;
+        void storage_block_binding(GLuint program, GLuint index, GLuint binding) override;
+
+        void set_uniform(GLint location, const UniformValue& value) override;
+
+        void set_blend_mode(BlendMode blend_mode) override;
+        void set_polygon_mode(GLenum mode) override;
+
+        void draw_elements(GLsizei num_indices) override;
+        void draw_elements_instanced(GLsizei num_indices, GLsizei num_instances) override;
+
+        [[nodiscard]] GLsync fence_sync() override;
+        [[nodiscard]] bool wait_sync(GLsync sync, uint64_t timeout) override;
+        void delete_sync(GLsync sync) override;
+
+        void push_debug_group(const char* name) override;
+        void pop_debug_group() override;
+
+    private:
+        // A range of a buffer bound to an indexed binding point, size is 0 when the whole buffer is bound
+        struct BufferBinding
+        {
+            GLuint buffer;
+            size_t offset;
+            size_t size;
+
+            bool operator==(const BufferBinding&) const = default;
+        };
+
+        struct ProgramState
+        {
+            std::vector<std::optional<UniformValue>> uniforms;
+            std::vector<std::optional<GLuint>> storage_block_bindings;
+        };
+
+        // Counts a state change, returning true if it needs submitting
+        template <typename T>
+        [[nodiscard]] bool update_state(std::optional<T>& cached, const T& value) noexcept;
+
+        [[nodiscard]] bool update_buffer_binding(GLenum target, GLuint index, const BufferBinding& binding);
+
+        [[nodiscard]] ProgramState* find_program_state(GLuint program);
+
+        // Backends edit textures by binding them to the last used texture unit, so it can no longer be trusted
+        void invalidate_active_texture_slot() noexcept;
+
+        std::unique_ptr<Device> _backend;
+        StateCacheStats _stats;
+
+        std::optional<GLuint> _program;
+        ProgramState* _program_state;
+        std::optional<GLuint> _vertex_array;
+        std::vector<std::optional<GLuint>> _textures;
+        std::optional<GLint> _active_texture_slot;
+        utils::flat_hash_map<std::tuple<GLenum, GLuint>, BufferBinding> _buffer_bindings;
+        std::optional<BlendMode> _blend_mode;
+        std::optional<GLenum> _polygon_mode;
+        std::optional<size_t> _storage_buffer_offset_alignment;
+
+        utils::flat_hash_map<GLuint, ProgramState> _program_states;
+    };
+}
@@ -0,0 +1,25 @@
+#include "device.h"
+
+#include <utils/check.h>
+
+#include "gl_device.h"
+#include "caching_device.h"
+
+using namespace rendering;
+
+Device& Device::get()
+{
+    return state_cache();
+}
+
+std::unique_ptr<Device> Device::set(std::unique_ptr<Device>&& device)
+{
+    check(device);
+    return state_cache().set_backend(std::move(device));
+}
+
+CachingDevice& Device::state_cache()
+{
+    static CachingDevice device(std::make_unique<GLDevice>());
+    return device;
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include <GL/glew.h>
+#include <math/vector2.h>
+#include <math/vector3.h>
+#include <math/vector4.h>
+#include <math/matrix3x3.h>
+#include <math/matrix4x4.h>
+
+#include "blend_mode.h"
+
+namespace rendering
+{
+    class CachingDevice;
+
+    // A value that can be uploaded to a shader uniform
+    using UniformValue = std::variant<
+        int32_t,
+        uint32_t,
+        float,
+        double,
+        math::Vector2i,
+        math::Vector2u,
+        math::Vector2f,
+        math::Vector2d,
+        math::Vector3i,
+        math::Vector3u,
+        math::Vector3f,
+        math::Vector3d,
+        math::Vector4i,
+        math::Vector4u,
+        math::Vector4f,
+        math::Vector4d,
+        math::Matrix3x3f,
+        math::Matrix3x3d,
+        math::Matrix4x4f,
+        math::Matrix4x4d
+    >;
+
+    // A uniform reported by a linked program
+    struct ActiveUniform
+    {
+        GLint location = -1;
+        std::string name;
+        GLenum type = GL_INT;
+    };
+
+    // The backend that all GPU resources and commands go through
+    // Handles and enums follow OpenGL conventions since that is what the rest of the renderer is built around,
+    // but nothing outside of the backend implementations should call OpenGL directly
+    // By default this is the OpenGL backend, a different backend such as RecordingDevice can be installed
+    // with set, which must happen before any GPU resources are created since handles aren't portable between backends
+    // The backend always sits behind a CachingDevice, which drops calls that wouldn't change any state
+    class Device
+    {
+    public:
+        Device() = default;
+        virtual ~Device() = default;
+
+        Device(const Device&) = delete;
+        Device(Device&&) = delete;
+        Device& operator=(const Device&) = delete;
+        Device& operator=(Device&&) = delete;
+
+        [[nodiscard]] static Device& get();
+
+        // Installs a new backend behind the state cache and returns the previous one
+        static std::unique_ptr<Device> set(std::unique_ptr<Device>&& device);
+
+        [[nodiscard]] static CachingDevice& state_cache();
+
+        // Buffers
+        [[nodiscard]] virtual GLuint create_buffer(const char* label) = 0;
+        virtual void delete_buffer(GLuint buffer) = 0;
+        virtual void buffer_data(GLenum target, GLuint buffer, size_t size, const void* data, GLenum usage) = 0;
+        virtual void buffer_sub_data(GLenum target, GLuint buffer, size_t offset, size_t size, const void* data) = 0;
+        virtual void bind_buffer_base(GLenum target, GLuint index, GLuint buffer) = 0;
+        virtual void bind_buffer_range(GLenum target, GLuint index, GLuint buffer, size_t offset, size_t size) = 0;
+
+        // Gives buffer immutable storage of size bytes, mapped for writing for the rest of the buffer's lifetime
+        // Writes through the mapping are seen by the GPU without flushing, but must not touch memory still
+        // read by submitted commands, which can be tracked with fence_sync
+        // Returns null if persistent mapping isn't supported, the storage is still allocated and can be written
+        // with buffer_sub_data instead
+        [[nodiscard]] virtual void* map_buffer_persistent(GLenum target, GLuint buffer, size_t size) = 0;
+
+        // Alignment required for offsets given to bind_buffer_range for storage buffers
+        [[nodiscard]] virtual size_t storage_buffer_offset_alignment() = 0;
+
+        // Vertex arrays
+        [[nodiscard]] virtual GLuint create_vertex_array(const char* label) = 0;
+        virtual void delete_vertex_array(GLuint vertex_array) = 0;
+        virtual void bind_vertex_array(GLuint vertex_array) = 0;
+
+        // Describes a float attribute read from buffer for the currently bound vertex array
+        // Integer types are converted to floats, mapped to [0, 1] or [-1, 1] if normalized is set
+        virtual void vertex_attribute(GLuint index, GLuint buffer, GLint num_components, GLenum type, GLboolean normalized, GLsizei stride, size_t offset) = 0;
+
+        // Textures
+        [[nodiscard]] virtual GLuint create_texture(const char* label) = 0;
+        virtual void delete_texture(GLuint texture) = 0;
+        virtual void texture_parameter(GLuint texture, GLenum parameter, GLint value) = 0;
+
+        // Sets the image of one mip level, the pixel rows of data must be tightly packed
+        virtual void texture_image(
+            GLuint texture,
+            GLint level,
+            GLint internal_format,
+            const math::Vector2i& resolution,
+            GLenum format,
+            GLenum type,
+            const void* data
+        ) = 0;
+
+        // Sets the image of one mip level from data already compressed in internal_format
+        virtual void compressed_texture_image(
+            GLuint texture,
+            GLint level,
+            GLenum internal_format,
+            const math::Vector2i& resolution,
+            size_t size,
+            const void* data
+        ) = 0;
+
+        // Replaces a region of an existing texture's base level, offset is in texels from the bottom left
+        virtual void texture_sub_image(
+            GLuint texture,
+            const math::Vector2i& offset,
+            const math::Vector2i& resolution,
+            GLenum format,
+            GLenum type,
+            const void* data
+        ) = 0;
+
+        // Reads back the texture's base level into data, converting it to format and type
+        // This waits for the GPU so should only be used when loading, never during a frame
+        virtual void read_texture_image(GLuint texture, GLenum format, GLenum type, size_t size, void* data) = 0;
+
+        virtual void generate_mipmaps(GLuint texture) = 0;
+        virtual void bind_texture(GLint slot, GLuint texture) = 0;
+
+        // Shaders and programs
+        [[nodiscard]] virtual GLuint compile_shader(GLenum type, std::string_view source, const char* label) = 0;
+        virtual void delete_shader(GLuint shader) = 0;
+        [[nodiscard]] virtual GLuint link_program(std::span<const GLuint> shaders, const char* label) = 0;
+        virtual void delete_program(GLuint program) = 0;
+        virtual void use_program(GLuint program) = 0;
+
+        // Returns false and fills error_log if the shader failed to compile
+        [[nodiscard]] virtual bool shader_compiled(GLuint shader, std::string& error_log) = 0;
+
+        // Returns false and fills error_log if the program failed to link
+        [[nodiscard]] virtual bool program_linked(GLuint program, std::string& error_log) = 0;
+
+        [[nodiscard]] virtual std::vector<ActiveUniform> active_uniforms(GLuint program) = 0;
+        [[nodiscard]] virtual std::optional<UniformValue> uniform_value(GLuint program, GLint location, GLenum type) = 0;
+        [[nodiscard]] virtual GLint storage_block_index(GLuint program, const char* name) = 0;
+        virtual void storage_block_binding(GLuint program, GLuint index, GLuint binding) = 0;
+
+        // Uploads a uniform to the program currently in use
+        virtual void set_uniform(GLint location, const UniformValue& value) = 0;
+
+        // State and drawing
+        virtual void set_blend_mode(BlendMode blend_mode) = 0;
+        virtual void set_polygon_mode(GLenum mode) = 0;
+
+        // Draws triangles from the currently bound vertex array using 32 bit indices
+        virtual void draw_elements(GLsizei num_indices) = 0;
+        virtual void draw_elements_instanced(GLsizei num_indices, GLsizei num_instances) = 0;
+
+        // Synchronization
+        // Inserts a fence which is signalled once all previously submitted commands have completed
+        [[nodiscard]] virtual GLsync fence_sync() = 0;
+
+        // Waits up to timeout nanoseconds for a fence, returns true if it has been signalled
+        [[nodiscard]] virtual bool wait_sync(GLsync sync, uint64_t timeout) = 0;
+        virtual void delete_sync(GLsync sync) = 0;
+
+        // Debugging
+        virtual void push_debug_group(const char* name) = 0;
+        virtual void pop_debug_group() = 0;
+    };
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory/shared_ptr.h>
+#include <physics/bounding_sphere.h>
 
 namespace rendering
 {
@@ -17,5 +18,8 @@ namespace rendering
         peng::shared_ptr<Material> material;
         float order = 0;
         int32_t instance_count = 1;
+
+        // World space bounds used for culling, draws with infinite bounds are never culled
+        physics::BoundingSphere bounds = physics::BoundingSphere::infinite();
     };
 }
@@ -0,0 +1,143 @@
+#include "draw_call_list.h"
+
+#include <algorithm>
+
+#include <profiling/scoped_event.h>
+#include <profiling/scoped_gpu_event.h>
+#include <utils/check.h>
+#include <utils/radix_sort.h>
+#include <utils/strtools.h>
+
+#include "mesh.h"
+#include "shader.h"
+#include "material.h"
+#include "render_queue_stats.h"
+
+using namespace rendering;
+
+namespace
+{
+    [[nodiscard]] uint64_t pack_bits(uint64_t value, uint32_t num_bits, uint32_t shift) noexcept
+    {
+        return (value & ((1ull << num_bits) - 1)) << shift;
+    }
+}
+
+void DrawCallList::rebuild(std::vector<DrawCall>&& draw_calls)
+{
+    SCOPED_EVENT("Building DrawCallList", strtools::catf_temp("%zu draw calls", draw_calls.size()));
+    clear();
+
+    // Swap rather than move so the caller gets our old buffer back to fill next frame
+    _draw_calls.swap(draw_calls);
+
+    _sorted_draws.resize(_draw_calls.size());
+    for (size_t i = 0; i < _draw_calls.size(); i++)
+    {
+        _sorted_draws[i] = SortEntry{
+            .key = make_sort_key(_draw_calls[i]),
+            .index = static_cast<uint32_t>(i)
+        };
+    }
+
+    _sort_scratch.resize(_sorted_draws.size());
+    utils::radix_sort<SortEntry>(_sorted_draws, _sort_scratch, [](const SortEntry& x) { return x.key; });
+}
+
+void DrawCallList::clear()
+{
+    _draw_calls.clear();
+    _sorted_draws.clear();
+}
+
+void DrawCallList::execute(RenderQueueStats& stats) const
+{
+    SCOPED_EVENT("DrawCallList - execute");
+    SCOPED_GPU_EVENT("Draw Scene");
+
+    // Vertex array bindings are independent of the program in use, so the bound mesh is tracked across shader switches
+    const Mesh* bound_mesh = nullptr;
+
+    const size_t num_draws = _sorted_draws.size();
+    size_t draw_index = 0;
+
+    auto get_draw = [&](size_t i) -> const DrawCall& { return _draw_calls[_sorted_draws[i].index]; };
+
+    while (draw_index < num_draws)
+    {
+        const peng::shared_ref<const Shader>& shader = get_draw(draw_index).material->shader();
+
+        SCOPED_GPU_EVENT(strtools::catf_temp("Shader - %s", shader->name().c_str()));
+        shader->use();
+        stats.shader_switches++;
+
+        while (draw_index < num_draws && get_draw(draw_index).material->shader() == shader)
+        {
+            const Mesh* mesh = get_draw(draw_index).mesh.get();
+
+            SCOPED_GPU_EVENT(strtools::catf_temp("Mesh - %s", mesh->name().c_str()));
+            if (mesh != bound_mesh)
+            {
+                mesh->bind();
+                bound_mesh = mesh;
+                stats.mesh_switches++;
+            }
+
+            for (; draw_index < num_draws; draw_index++)
+            {
+                const DrawCall& draw_call = get_draw(draw_index);
+                if (draw_call.mesh.get() != mesh || draw_call.material->shader() != shader)
+                {
+                    break;
+                }
+
+                draw_call.material->apply_uniforms();
+                draw_call.material->bind_buffers();
+
+                if (draw_call.instance_count == 1)
+                {
+                    mesh->draw();
+                }
+                else
+                {
+                    mesh->draw_instanced(draw_call.instance_count);
+                }
+
+                stats.draw_calls++;
+                stats.triangles += draw_call.instance_count * mesh->num_triangles();
+            }
+        }
+    }
+}
+
+uint64_t DrawCallList::make_sort_key(const DrawCall& draw_call)
+{
+    check(draw_call.material);
+    check(draw_call.mesh);
+
+    const Shader& shader = *draw_call.material->shader().get();
+    const uint64_t draw_order = static_cast<uint64_t>(std::clamp(shader.draw_order(), -128, 127) + 128);
+    const uint64_t shader_id = shader.sort_id();
+    const uint64_t mesh_id = draw_call.mesh->sort_id();
+    const uint64_t material_id = draw_call.material->sort_id();
+    const uint64_t depth = utils::to_sortable_bits(draw_call.order);
+
+    uint64_t key = pack_bits(draw_order, 8, 56);
+    if (shader.requires_blending())
+    {
+        key |= pack_bits(1, 1, 55);
+        key |= pack_bits(depth >> 8, 24, 31);
+        key |= pack_bits(shader_id, 12, 19);
+        key |= pack_bits(mesh_id, 12, 7);
+        key |= pack_bits(material_id, 7, 0);
+    }
+    else
+    {
+        key |= pack_bits(shader_id, 12, 43);
+        key |= pack_bits(mesh_id, 12, 31);
+        key |= pack_bits(material_id, 15, 16);
+        key |= pack_bits(depth >> 16, 16, 0);
+    }
+
+    return key;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "draw_call.h"
+
+namespace rendering
+{
+    struct RenderQueueStats;
+
+    // List of draw calls sorted so they can be executed with minimal state switches
+    // Each draw is given a packed 64 bit sort key and the keys are radix sorted, so building
+    // the list is linear in the number of draws and doesn't need any lookup tables
+    // Lists are intended to be reused between frames so that the buffers don't need reallocating
+    class DrawCallList
+    {
+    public:
+        DrawCallList() = default;
+
+        // Clears the list and rebuilds it from the provided draw calls
+        // draw_calls is left empty, but may hold onto memory from a previous rebuild for reuse
+        void rebuild(std::vector<DrawCall>&& draw_calls);
+
+        // Releases all draws held by the list, but keeps any allocated memory for the next rebuild
+        void clear();
+
+        void execute(RenderQueueStats& stats) const;
+
+        // Builds the sort key of a draw, from most to least significant
+        //  - Opaque:  shader draw order (8) | 0 (1) | shader (12) | mesh (12) | material (15) | depth (16)
+        //  - Blended: shader draw order (8) | 1 (1) | depth (24)  | shader (12) | mesh (12) | material (7)
+        // Opaque draws are grouped to minimize state switches, whereas blended draws must respect depth
+        // Depth is taken from the draw order, which is already negated for blended draws so that ascending
+        // keys are front to back for opaque draws and back to front for blended draws
+        // Sort ids are recycled so they stay below the number of live objects, if there are more than a field
+        // can hold the ids wrap, which costs extra state switches but still draws correctly
+        [[nodiscard]] static uint64_t make_sort_key(const DrawCall& draw_call);
+
+    private:
+        struct SortEntry
+        {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        std::vector<DrawCall> _draw_calls;
+        std::vector<SortEntry> _sorted_draws;
+        std::vector<SortEntry> _sort_scratch;
+    };
+}
@@ -0,0 +1,129 @@
+#include "draw_culler.h"
+
+#include <algorithm>
+#include <execution>
+#include <span>
+
+#include <profiling/scoped_event.h>
+#include <utils/strtools.h>
+
+#include "sprite.h"
+#include "draw_call.h"
+#include "sprite_draw_call.h"
+
+using namespace rendering;
+using namespace math;
+
+namespace
+{
+    // Sprites are drawn on a unit quad scaled by the sprite size
+    [[nodiscard]] bool sprite_visible(const SpriteDrawCall& sprite_draw)
+    {
+        const Vector2f half_size = sprite_draw.sprite->size() / 2;
+        const Vector4f corners[] = {
+            sprite_draw.mvp_matrix * Vector4f(-half_size.x, -half_size.y, 0, 1),
+            sprite_draw.mvp_matrix * Vector4f(+half_size.x, -half_size.y, 0, 1),
+            sprite_draw.mvp_matrix * Vector4f(+half_size.x, +half_size.y, 0, 1),
+            sprite_draw.mvp_matrix * Vector4f(-half_size.x, +half_size.y, 0, 1),
+        };
+
+        // The quad is only culled if every corner is outside of the same clip plane
+        auto all_outside = [&](auto&& outside)
+        {
+            return std::ranges::all_of(corners, outside);
+        };
+
+        return !(
+            all_outside([](const Vector4f& c) { return c.x < -c.w; }) ||
+            all_outside([](const Vector4f& c) { return c.x > +c.w; }) ||
+            all_outside([](const Vector4f& c) { return c.y < -c.w; }) ||
+            all_outside([](const Vector4f& c) { return c.y > +c.w; }) ||
+            all_outside([](const Vector4f& c) { return c.z < -c.w; }) ||
+            all_outside([](const Vector4f& c) { return c.z > +c.w; })
+        );
+    }
+}
+
+size_t DrawCuller::cull_draws(const Frustum& frustum, std::vector<DrawCall>& draws_in_out)
+{
+    SCOPED_EVENT("DrawCuller - cull draws", strtools::catf_temp("%zu draws", draws_in_out.size()));
+
+    const size_t count = draws_in_out.size();
+    _xs.resize(count);
+    _ys.resize(count);
+    _zs.resize(count);
+    _radii.resize(count);
+    _visible.assign(count, 1);
+
+    build_chunks(count);
+    std::for_each(std::execution::par, _chunks.begin(), _chunks.end(), [&](const Chunk& chunk)
+    {
+        for (size_t i = chunk.begin; i < chunk.end; i++)
+        {
+            const physics::BoundingSphere& bounds = draws_in_out[i].bounds;
+            _xs[i] = bounds.center.x;
+            _ys[i] = bounds.center.y;
+            _zs[i] = bounds.center.z;
+            _radii[i] = bounds.radius;
+        }
+
+        const size_t num = chunk.end - chunk.begin;
+        frustum.cull_spheres(
+            std::span(_xs).subspan(chunk.begin, num),
+            std::span(_ys).subspan(chunk.begin, num),
+            std::span(_zs).subspan(chunk.begin, num),
+            std::span(_radii).subspan(chunk.begin, num),
+            std::span(_visible).subspan(chunk.begin, num)
+        );
+    });
+
+    return remove_culled(draws_in_out);
+}
+
+size_t DrawCuller::cull_sprite_draws(std::vector<SpriteDrawCall>& sprite_draws_in_out)
+{
+    SCOPED_EVENT("DrawCuller - cull sprites", strtools::catf_temp("%zu sprites", sprite_draws_in_out.size()));
+
+    _visible.resize(sprite_draws_in_out.size());
+    std::transform(std::execution::par_unseq,
+        sprite_draws_in_out.begin(), sprite_draws_in_out.end(), _visible.begin(),
+        [](const SpriteDrawCall& sprite_draw) { return static_cast<uint8_t>(sprite_visible(sprite_draw)); }
+    );
+
+    return remove_culled(sprite_draws_in_out);
+}
+
+template <typename T>
+size_t DrawCuller::remove_culled(std::vector<T>& items_in_out)
+{
+    size_t num_kept = 0;
+    for (size_t i = 0; i < items_in_out.size(); i++)
+    {
+        if (_visible[i])
+        {
+            if (num_kept != i)
+            {
+                items_in_out[num_kept] = std::move(items_in_out[i]);
+            }
+
+            num_kept++;
+        }
+    }
+
+    const size_t num_culled = items_in_out.size() - num_kept;
+    items_in_out.erase(items_in_out.begin() + static_cast<ptrdiff_t>(num_kept), items_in_out.end());
+
+    return num_culled;
+}
+
+void DrawCuller::build_chunks(size_t count)
+{
+    _chunks.clear();
+    for (size_t begin = 0; begin < count; begin += chunk_size)
+    {
+        _chunks.push_back(Chunk{
+            .begin = begin,
+            .end = std::min(begin + chunk_size, count)
+        });
+    }
+}
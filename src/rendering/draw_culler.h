@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+#include <math/frustum.h>
+
+namespace rendering
+{
+    struct DrawCall;
+    struct SpriteDrawCall;
+
+    // Removes draws that can't be seen before they are batched and sorted
+    // Tests run in parallel over chunks of draws, with the bounds gathered into
+    // separate coordinate arrays so that each chunk is tested with vectorized loops
+    class DrawCuller
+    {
+    public:
+        // Removes draws whose bounds lie fully outside of the frustum, returns the number removed
+        size_t cull_draws(const math::Frustum& frustum, std::vector<DrawCall>& draws_in_out);
+
+        // Removes sprites whose quads lie fully outside of clip space, returns the number removed
+        size_t cull_sprite_draws(std::vector<SpriteDrawCall>& sprite_draws_in_out);
+
+    private:
+        struct Chunk
+        {
+            size_t begin;
+            size_t end;
+        };
+
+        // Removes every item not marked as visible, keeping the order of the rest
+        template <typename T>
+        size_t remove_culled(std::vector<T>& items_in_out);
+
+        void build_chunks(size_t count);
+
+        std::vector<float> _xs;
+        std::vector<float> _ys;
+        std::vector<float> _zs;
+        std::vector<float> _radii;
+        std::vector<uint8_t> _visible;
+        std::vector<Chunk> _chunks;
+
+        static constexpr size_t chunk_size = 2048;
+    };
+}
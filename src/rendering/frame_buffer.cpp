@@ -37,7 +37,7 @@ void FrameBuffer::add_color_attachment()
         ));
     }
 
-    std::string texture_name = strtools::catf("%s.ColorAttachment[%d]", _name.c_str(), _color_attachments.size());
+    std::string texture_name = strtools::catf("%s.ColorAttachment[%zu]", _name.c_str(), _color_attachments.size());
     _color_attachments.push_back(peng::make_shared<Texture>(std::move(texture_name), 3, _resolution));
 }
 
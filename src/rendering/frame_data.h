@@ -0,0 +1,99 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <math/vector3.h>
+#include <math/matrix4x4.h>
+
+namespace rendering
+{
+    // Storage buffer bindings reserved for data shared by every draw in a frame
+    // Buffers bound through materials are bound after these so the two never collide
+    enum class FrameBinding : GLuint
+    {
+        frame_data,
+        point_lights,
+        spot_lights,
+        directional_lights,
+        light_clusters,
+        light_indices,
+
+        count
+    };
+
+    // Camera data for the frame, submitted by the active camera
+    struct CameraRenderData
+    {
+        math::Matrix4x4f view_matrix = math::Matrix4x4f::identity();
+        math::Vector3f view_pos = math::Vector3f::zero();
+        math::Vector3f view_dir = math::Vector3f::forwards();
+        float near_clip = 0.01f;
+        float far_clip = 1000.0f;
+    };
+
+    // Lights submitted for the frame, laid out to match the light structs in std430
+    struct PointLightRenderData
+    {
+        math::Vector3f pos;
+        float range;
+        math::Vector3f color;
+        float max_strength;
+        math::Vector3f ambient;
+        float padding = 0;
+    };
+
+    struct SpotLightRenderData
+    {
+        math::Vector3f pos;
+        float range;
+        math::Vector3f dir;
+        float umbra_cos;
+        math::Vector3f color;
+        float penumbra_cos;
+        math::Vector3f ambient;
+        float padding = 0;
+    };
+
+    struct DirectionalLightRenderData
+    {
+        math::Vector3f dir;
+        float intensity;
+        math::Vector3f color;
+        float padding0 = 0;
+        math::Vector3f ambient;
+        float padding1 = 0;
+    };
+
+    // Range of light_indices used by a cluster, the point light indices come first followed by the spot lights
+    struct LightClusterRenderData
+    {
+        uint32_t offset;
+        uint32_t num_point_lights;
+        uint32_t num_spot_lights;
+        uint32_t padding = 0;
+    };
+
+    // Contents of the frame_data block, laid out to match std430
+    // Fragments find their cluster from their clip space position and the log of their view depth,
+    // slice = log(depth) * cluster_depth_scale + cluster_depth_bias
+    struct FrameRenderData
+    {
+        math::Matrix4x4f view_matrix;
+        math::Vector3f view_pos;
+        uint32_t num_point_lights;
+        math::Vector3f view_dir;
+        uint32_t num_spot_lights;
+        uint32_t num_directional_lights;
+        uint32_t cluster_count_x;
+        uint32_t cluster_count_y;
+        uint32_t cluster_count_z;
+        float cluster_depth_scale;
+        float cluster_depth_bias;
+        uint32_t padding[2] = { };
+    };
+
+    static_assert(sizeof(PointLightRenderData) == 48);
+    static_assert(sizeof(SpotLightRenderData) == 64);
+    static_assert(sizeof(DirectionalLightRenderData) == 48);
+    static_assert(sizeof(LightClusterRenderData) == 16);
+    static_assert(sizeof(FrameRenderData) == 128);
+}
@@ -0,0 +1,476 @@
+#include "gl_device.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include <utils/functional.h>
+#include <utils/strtools.h>
+
+using namespace rendering;
+using namespace math;
+
+namespace
+{
+    void get_uniform(GLuint program, GLint location, int32_t* values, size_t count)
+    {
+        glGetnUniformiv(program, location, static_cast<GLsizei>(count * sizeof(int32_t)), values);
+    }
+
+    void get_uniform(GLuint program, GLint location, uint32_t* values, size_t count)
+    {
+        glGetnUniformuiv(program, location, static_cast<GLsizei>(count * sizeof(uint32_t)), values);
+    }
+
+    void get_uniform(GLuint program, GLint location, float* values, size_t count)
+    {
+        glGetnUniformfv(program, location, static_cast<GLsizei>(count * sizeof(float)), values);
+    }
+
+    void get_uniform(GLuint program, GLint location, double* values, size_t count)
+    {
+        glGetnUniformdv(program, location, static_cast<GLsizei>(count * sizeof(double)), values);
+    }
+
+    template <typename T, size_t N>
+    std::array<T, N> get_uniform(GLuint program, GLint location)
+    {
+        std::array<T, N> values;
+        get_uniform(program, location, values.data(), N);
+
+        return values;
+    }
+
+    template <typename T>
+    T get_uniform_vector(GLuint program, GLint location)
+    {
+        using Element = decltype(T::x);
+
+        if constexpr (requires { T::w; })
+        {
+            const auto v = get_uniform<Element, 4>(program, location);
+            return T(v[0], v[1], v[2], v[3]);
+        }
+        else if constexpr (requires { T::z; })
+        {
+            const auto v = get_uniform<Element, 3>(program, location);
+            return T(v[0], v[1], v[2]);
+        }
+        else
+        {
+            const auto v = get_uniform<Element, 2>(program, location);
+            return T(v[0], v[1]);
+        }
+    }
+}
+
+GLuint GLDevice::create_buffer(const char* label)
+{
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+
+    // Buffers only exist once they have been bound, which is required for labelling
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glObjectLabel(GL_BUFFER, buffer, -1, label);
+
+    return buffer;
+}
+
+void GLDevice::delete_buffer(GLuint buffer)
+{
+    glDeleteBuffers(1, &buffer);
+}
+
+void GLDevice::buffer_data(GLenum target, GLuint buffer, size_t size, const void* data, GLenum usage)
+{
+    glBindBuffer(target, buffer);
+    glBufferData(target, static_cast<GLsizeiptr>(size), data, usage);
+}
+
+void GLDevice::buffer_sub_data(GLenum target, GLuint buffer, size_t offset, size_t size, const void* data)
+{
+    glBindBuffer(target, buffer);
+    glBufferSubData(target, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size), data);
+}
+
+void GLDevice::bind_buffer_base(GLenum target, GLuint index, GLuint buffer)
+{
+    glBindBufferBase(target, index, buffer);
+}
+
+void GLDevice::bind_buffer_range(GLenum target, GLuint index, GLuint buffer, size_t offset, size_t size)
+{
+    glBindBufferRange(target, index, buffer, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+}
+
+void* GLDevice::map_buffer_persistent(GLenum target, GLuint buffer, size_t size)
+{
+    glBindBuffer(target, buffer);
+
+    if (!GLEW_ARB_buffer_storage)
+    {
+        glBufferData(target, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_DRAW);
+        return nullptr;
+    }
+
+    // Dynamic storage keeps buffer_sub_data usable in case the mapping fails
+    constexpr GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(target, static_cast<GLsizeiptr>(size), nullptr, map_flags | GL_DYNAMIC_STORAGE_BIT);
+
+    return glMapBufferRange(target, 0, static_cast<GLsizeiptr>(size), map_flags);
+}
+
+size_t GLDevice::storage_buffer_offset_alignment()
+{
+    GLint alignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+    return static_cast<size_t>(std::max(alignment, 1));
+}
+
+GLuint GLDevice::create_vertex_array(const char* label)
+{
+    GLuint vertex_array;
+    glGenVertexArrays(1, &vertex_array);
+
+    glBindVertexArray(vertex_array);
+    glObjectLabel(GL_VERTEX_ARRAY, vertex_array, -1, label);
+
+    return vertex_array;
+}
+
+void GLDevice::delete_vertex_array(GLuint vertex_array)
+{
+    glDeleteVertexArrays(1, &vertex_array);
+}
+
+void GLDevice::bind_vertex_array(GLuint vertex_array)
+{
+    glBindVertexArray(vertex_array);
+}
+
+void GLDevice::vertex_attribute(GLuint index, GLuint buffer, GLint num_components, GLenum type, GLboolean normalized, GLsizei stride, size_t offset)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribPointer(index, num_components, type, normalized, stride, reinterpret_cast<void*>(offset));
+    glEnableVertexAttribArray(index);
+}
+
+GLuint GLDevice::create_texture(const char* label)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glObjectLabel(GL_TEXTURE, texture, -1, label);
+
+    return texture;
+}
+
+void GLDevice::delete_texture(GLuint texture)
+{
+    glDeleteTextures(1, &texture);
+}
+
+void GLDevice::texture_parameter(GLuint texture, GLenum parameter, GLint value)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, parameter, value);
+}
+
+void GLDevice::texture_image(
+    GLuint texture,
+    GLint level,
+    GLint internal_format,
+    const Vector2i& resolution,
+    GLenum format,
+    GLenum type,
+    const void* data
+)
+{
+    // RGB rows aren't padded to 4 bytes, which is GL's default row alignment
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, level, internal_format, resolution.x, resolution.y, 0, format, type, data);
+}
+
+void GLDevice::compressed_texture_image(
+    GLuint texture,
+    GLint level,
+    GLenum internal_format,
+    const Vector2i& resolution,
+    size_t size,
+    const void* data
+)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glCompressedTexImage2D(
+        GL_TEXTURE_2D, level, internal_format, resolution.x, resolution.y, 0, static_cast<GLsizei>(size), data
+    );
+}
+
+void GLDevice::texture_sub_image(
+    GLuint texture,
+    const Vector2i& offset,
+    const Vector2i& resolution,
+    GLenum format,
+    GLenum type,
+    const void* data
+)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, offset.x, offset.y, resolution.x, resolution.y, format, type, data);
+}
+
+void GLDevice::read_texture_image(GLuint texture, GLenum format, GLenum type, size_t, void* data)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glGetTexImage(GL_TEXTURE_2D, 0, format, type, data);
+}
+
+void GLDevice::generate_mipmaps(GLuint texture)
+{
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+void GLDevice::bind_texture(GLint slot, GLuint texture)
+{
+    glActiveTexture(GL_TEXTURE0 + slot);
+    glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+GLuint GLDevice::compile_shader(GLenum type, std::string_view source, const char* label)
+{
+    const GLuint shader = glCreateShader(type);
+    const char* shader_src = source.data();
+    const GLint shader_length = static_cast<GLint>(source.size());
+
+    glShaderSource(shader, 1, &shader_src, &shader_length);
+    glCompileShader(shader);
+    glObjectLabel(GL_SHADER, shader, -1, label);
+
+    return shader;
+}
+
+void GLDevice::delete_shader(GLuint shader)
+{
+    glDeleteShader(shader);
+}
+
+GLuint GLDevice::link_program(std::span<const GLuint> shaders, const char* label)
+{
+    const GLuint program = glCreateProgram();
+    for (const GLuint shader : shaders)
+    {
+        glAttachShader(program, shader);
+    }
+
+    glLinkProgram(program);
+    glObjectLabel(GL_PROGRAM, program, -1, label);
+
+    return program;
+}
+
+void GLDevice::delete_program(GLuint program)
+{
+    glDeleteProgram(program);
+}
+
+void GLDevice::use_program(GLuint program)
+{
+    glUseProgram(program);
+}
+
+bool GLDevice::shader_compiled(GLuint shader, std::string& error_log)
+{
+    GLint success;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+    if (!success)
+    {
+        GLint error_length;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &error_length);
+
+        error_log.resize(error_length);
+        glGetShaderInfoLog(shader, error_length, nullptr, error_log.data());
+    }
+
+    return success == GL_TRUE;
+}
+
+bool GLDevice::program_linked(GLuint program, std::string& error_log)
+{
+    GLint success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+    if (!success)
+    {
+        GLint error_length;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &error_length);
+
+        error_log.resize(error_length);
+        glGetProgramInfoLog(program, error_length, nullptr, error_log.data());
+    }
+
+    return success == GL_TRUE;
+}
+
+std::vector<ActiveUniform> GLDevice::active_uniforms(GLuint program)
+{
+    GLint num_uniforms;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &num_uniforms);
+
+    std::vector<ActiveUniform> uniforms;
+    uniforms.reserve(num_uniforms);
+
+    for (GLint i = 0; i < num_uniforms; i++)
+    {
+        constexpr int32_t buf_size = 512;
+        char name_buf[buf_size];
+        GLint name_length;
+        GLint size;
+        GLenum type;
+
+        glGetActiveUniform(program, i, buf_size, &name_length, &size, &type, name_buf);
+        uniforms.push_back(ActiveUniform{
+            .location = glGetUniformLocation(program, name_buf),
+            .name = name_buf,
+            .type = type
+        });
+    }
+
+    return uniforms;
+}
+
+std::optional<UniformValue> GLDevice::uniform_value(GLuint program, GLint location, GLenum type)
+{
+    switch (type)
+    {
+        case GL_INT:               return get_uniform<int32_t, 1>(program, location)[0];
+        case GL_UNSIGNED_INT:      return get_uniform<uint32_t, 1>(program, location)[0];
+        case GL_FLOAT:             return get_uniform<float, 1>(program, location)[0];
+        case GL_DOUBLE:            return get_uniform<double, 1>(program, location)[0];
+        case GL_INT_VEC2:          return get_uniform_vector<Vector2i>(program, location);
+        case GL_UNSIGNED_INT_VEC2: return get_uniform_vector<Vector2u>(program, location);
+        case GL_FLOAT_VEC2:        return get_uniform_vector<Vector2f>(program, location);
+        case GL_DOUBLE_VEC2:       return get_uniform_vector<Vector2d>(program, location);
+        case GL_INT_VEC3:          return get_uniform_vector<Vector3i>(program, location);
+        case GL_UNSIGNED_INT_VEC3: return get_uniform_vector<Vector3u>(program, location);
+        case GL_FLOAT_VEC3:        return get_uniform_vector<Vector3f>(program, location);
+        case GL_DOUBLE_VEC3:       return get_uniform_vector<Vector3d>(program, location);
+        case GL_INT_VEC4:          return get_uniform_vector<Vector4i>(program, location);
+        case GL_UNSIGNED_INT_VEC4: return get_uniform_vector<Vector4u>(program, location);
+        case GL_FLOAT_VEC4:        return get_uniform_vector<Vector4f>(program, location);
+        case GL_DOUBLE_VEC4:       return get_uniform_vector<Vector4d>(program, location);
+        case GL_FLOAT_MAT3:        return Matrix3x3f(get_uniform<float, 9>(program, location));
+        case GL_DOUBLE_MAT3:       return Matrix3x3d(get_uniform<double, 9>(program, location));
+        case GL_FLOAT_MAT4:        return Matrix4x4f(get_uniform<float, 16>(program, location));
+        case GL_DOUBLE_MAT4:       return Matrix4x4d(get_uniform<double, 16>(program, location));
+        default:                   return std::nullopt;
+    }
+}
+
+GLint GLDevice::storage_block_index(GLuint program, const char* name)
+{
+    const GLuint index = glGetProgramResourceIndex(program, GL_SHADER_STORAGE_BLOCK, name);
+    return index == GL_INVALID_INDEX
+        ? -1
+        : static_cast<GLint>(index);
+}
+
+void GLDevice::storage_block_binding(GLuint program, GLuint index, GLuint binding)
+{
+    glShaderStorageBlockBinding(program, index, binding);
+}
+
+void GLDevice::set_uniform(GLint location, const UniformValue& value)
+{
+    std::visit(functional::overload{
+        [=](int32_t x) { glUniform1i(location, x); },
+        [=](uint32_t x) { glUniform1ui(location, x); },
+        [=](float x) { glUniform1f(location, x); },
+        [=](double x) { glUniform1d(location, x); },
+        [=](const Vector2i& x) { glUniform2i(location, x.x, x.y); },
+        [=](const Vector2u& x) { glUniform2ui(location, x.x, x.y); },
+        [=](const Vector2f& x) { glUniform2f(location, x.x, x.y); },
+        [=](const Vector2d& x) { glUniform2d(location, x.x, x.y); },
+        [=](const Vector3i& x) { glUniform3i(location, x.x, x.y, x.z); },
+        [=](const Vector3u& x) { glUniform3ui(location, x.x, x.y, x.z); },
+        [=](const Vector3f& x) { glUniform3f(location, x.x, x.y, x.z); },
+        [=](const Vector3d& x) { glUniform3d(location, x.x, x.y, x.z); },
+        [=](const Vector4i& x) { glUniform4i(location, x.x, x.y, x.z, x.w); },
+        [=](const Vector4u& x) { glUniform4ui(location, x.x, x.y, x.z, x.w); },
+        [=](const Vector4f& x) { glUniform4f(location, x.x, x.y, x.z, x.w); },
+        [=](const Vector4d& x) { glUniform4d(location, x.x, x.y, x.z, x.w); },
+        [=](const Matrix3x3f& x) { glUniformMatrix3fv(location, 1, GL_FALSE, x.elements.data()); },
+        [=](const Matrix3x3d& x) { glUniformMatrix3dv(location, 1, GL_FALSE, x.elements.data()); },
+        [=](const Matrix4x4f& x) { glUniformMatrix4fv(location, 1, GL_FALSE, x.elements.data()); },
+        [=](const Matrix4x4d& x) { glUniformMatrix4dv(location, 1, GL_FALSE, x.elements.data()); }
+    }, value);
+}
+
+void GLDevice::set_blend_mode(BlendMode blend_mode)
+{
+    switch (blend_mode)
+    {
+        case BlendMode::opaque:
+        {
+            glDisable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ZERO);
+            break;
+        }
+        case BlendMode::alpha_blend:
+        {
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            break;
+        }
+        default:
+        {
+            throw std::runtime_error(strtools::catf("Invalid blend mode %d", blend_mode));
+        }
+    }
+}
+
+void GLDevice::set_polygon_mode(GLenum mode)
+{
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GLDevice::draw_elements(GLsizei num_indices)
+{
+    glDrawElements(GL_TRIANGLES, num_indices, GL_UNSIGNED_INT, nullptr);
+}
+
+void GLDevice::draw_elements_instanced(GLsizei num_indices, GLsizei num_instances)
+{
+    glDrawElementsInstanced(GL_TRIANGLES, num_indices, GL_UNSIGNED_INT, nullptr, num_instances);
+}
+
+void GLDevice::push_debug_group(const char* name)
+{
+    glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+}
+
+GLsync GLDevice::fence_sync()
+{
+    return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool GLDevice::wait_sync(GLsync sync, uint64_t timeout)
+{
+    // A failed wait can't succeed by retrying, so is treated as signalled rather than leaving callers waiting forever
+    const GLenum result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    return result != GL_TIMEOUT_EXPIRED;
+}
+
+void GLDevice::delete_sync(GLsync sync)
+{
+    glDeleteSync(sync);
+}
+
+void GLDevice::pop_debug_group()
+{
+    glPopDebugGroup();
+}
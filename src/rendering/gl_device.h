@@ -0,0 +1,87 @@
+#pragma once
+
+#include "device.h"
+
+namespace rendering
+{
+    // Device backend which forwards everything to the current OpenGL context
+    class GLDevice final : public Device
+    {
+    public:
+        [[nodiscard]] GLuint create_buffer(const char* label) override;
+        void delete_buffer(GLuint buffer) override;
+        void buffer_data(GLenum target, GLuint buffer, size_t size, const void* data, GLenum usage) override;
+        void buffer_sub_data(GLenum target, GLuint buffer, size_t offset, size_t size, const void* data) override;
+        void bind_buffer_base(GLenum target, GLuint index, GLuint buffer) override;
+        void bind_buffer_range(GLenum target, GLuint index, GLuint buffer, size_t offset, size_t size) override;
+        [[nodiscard]] void* map_buffer_persistent(GLenum target, GLuint buffer, size_t size) override;
+        [[nodiscard]] size_t storage_buffer_offset_alignment() override;
+
+        [[nodiscard]] GLuint create_vertex_array(const char* label) override;
+        void delete_vertex_array(GLuint vertex_array) override;
+        void bind_vertex_array(GLuint vertex_array) override;
+        void vertex_attribute(GLuint index, GLuint buffer, GLint num_components, GLenum type, GLboolean normalized, GLsizei stride, size_t offset) override;
+
+        [[nodiscard]] GLuint create_texture(const char* label) override;
+        void delete_texture(GLuint texture) override;
+        void texture_parameter(GLuint texture, GLenum parameter, GLint value) override;
+        void texture_image(
+            GLuint texture,
+            GLint level,
+            GLint internal_format,
+            const math::Vector2i& resolution,
+            GLenum format,
+            GLenum type,
+            const void* data
+        ) override;
+
+        void compressed_texture_image(
+            GLuint texture,
+            GLint level,
+            GLenum internal_format,
+            const math::Vector2i& resolution,
+            size_t size,
+            const void* data
+        ) override;
+        void texture_sub_image(
+            GLuint texture,
+            const math::Vector2i& offset,
+            const math::Vector2i& resolution,
+            GLenum format,
+            GLenum type,
+            const void* data
+        ) override;
+        void read_texture_image(GLuint texture, GLenum format, GLenum type, size_t size, void* data) override;
+        void generate_mipmaps(GLuint texture) override;
+        void bind_texture(GLint slot, GLuint texture) override;
+
+        [[nodiscard]] GLuint compile_shader(GLenum type, std::string_view source, const char* label) override;
+        void delete_shader(GLuint shader) override;
+        [[nodiscard]] GLuint link_program(std::span<const GLuint> shaders, const char* label) override;
+        void delete_program(GLuint program) override;
+        void use_program(GLuint program) override;
+
+        [[nodiscard]] bool shader_compiled(GLuint shader, std::string& error_log) override;
+        [[nodiscard]] bool program_linked(GLuint program, std::string& error_log) override;
+
+        [[nodiscard]] std::vector<ActiveUniform> active_uniforms(GLuint program) override;
+        [[nodiscard]] std::optional<UniformValue> uniform_value(GLuint program, GLint location, GLenum type) override;
+        [[nodiscard]] GLint storage_block_index(GLuint program, const char* name) override;
+        void storage_block_binding(GLuint program, GLuint index, GLuint binding) override;
+
+        void set_uniform(GLint location, const UniformValue& value) override;
+
+        void set_blend_mode(BlendMode blend_mode) override;
+        void set_polygon_mode(GLenum mode) override;
+
+        void draw_elements(GLsizei num_indices) override;
+        void draw_elements_instanced(GLsizei num_indices, GLsizei num_instances) override;
+
+        [[nodiscard]] GLsync fence_sync() override;
+        [[nodiscard]] bool wait_sync(GLsync sync, uint64_t timeout) override;
+        void delete_sync(GLsync sync) override;
+
+        void push_debug_group(const char* name) override;
+        void pop_debug_group() override;
+    };
+}
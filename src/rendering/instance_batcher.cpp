@@ -0,0 +1,406 @@
+#include "instance_batcher.h"
+
+#include <ranges>
+
+#include <profiling/scoped_event.h>
+#include <utils/strtools.h>
+#include <core/logger.h>
+
+#include "mesh.h"
+#include "shader.h"
+#include "material.h"
+#include "draw_call.h"
+
+using namespace rendering;
+using namespace math;
+
+namespace
+{
+    constexpr size_t no_batch = std::numeric_limits<size_t>::max();
+
+    [[nodiscard]] bool parameters_equal(const Shader::Parameter& a, const Shader::Parameter& b)
+    {
+        if (a.index() != b.index())
+        {
+            return false;
+        }
+
+        return std::visit([&]<typename T>(const T& x)
+        {
+            const T& y = std::get<T>(b);
+            if constexpr (requires { x.elements; })
+            {
+                return x.elements == y.elements;
+            }
+            else
+            {
+                return x == y;
+            }
+        }, a);
+    }
+
+    [[nodiscard]] Matrix4x4f to_matrix4x4(const Matrix3x3f& m)
+    {
+        Matrix4x4f result = Matrix4x4f::identity();
+        for (size_t col = 0; col < 3; col++)
+        {
+            for (size_t row = 0; row < 3; row++)
+            {
+                result.elements[col * 4 + row] = m.elements[col * 3 + row];
+            }
+        }
+
+        return result;
+    }
+}
+
+void InstanceBatcher::batch_draws(std::vector<DrawCall>& draws_in_out)
+{
+    SCOPED_EVENT("InstanceBatcher - batch draws", strtools::catf_temp("%zu draws", draws_in_out.size()));
+
+    for (ResourcePool<Material>& pool : _material_pools | std::views::values)
+    {
+        pool.begin_frame();
+    }
+
+    _buffer_pool.begin_frame();
+
+    if (++_frame % trim_interval == 0)
+    {
+        trim();
+    }
+
+    if (build_batches(draws_in_out) == 0)
+    {
+        return;
+    }
+
+    _instanced_draws.clear();
+    for (const Batch& batch : _batches)
+    {
+        if (batch.num_draws > 1)
+        {
+            _instanced_draws.push_back(emit_instanced_draw(batch, draws_in_out));
+        }
+    }
+
+    // Compact the draws that weren't merged in place, then append the instanced draws
+    size_t num_kept = 0;
+    for (size_t i = 0; i < draws_in_out.size(); i++)
+    {
+        const size_t batch_index = _draw_batches[i];
+        if (batch_index == no_batch || _batches[batch_index].num_draws == 1)
+        {
+            if (num_kept != i)
+            {
+                draws_in_out[num_kept] = std::move(draws_in_out[i]);
+            }
+
+            num_kept++;
+        }
+    }
+
+    draws_in_out.resize(num_kept);
+    std::ranges::move(_instanced_draws, std::back_inserter(draws_in_out));
+    _instanced_draws.clear();
+}
+
+void InstanceBatcher::flush()
+{
+    SCOPED_EVENT("InstanceBatcher - flush");
+
+    _shader_infos.clear();
+    _material_pools.clear();
+    _buffer_pool.resources.clear();
+    _buffer_pool.peak_used = 0;
+}
+
+void InstanceBatcher::trim()
+{
+    SCOPED_EVENT("InstanceBatcher - trim");
+
+    for (auto it = _shader_infos.begin(); it != _shader_infos.end();)
+    {
+        it = _frame - it->second.last_used_frame >= trim_interval
+            ? _shader_infos.erase(it)
+            : std::next(it);
+    }
+
+    for (auto it = _material_pools.begin(); it != _material_pools.end();)
+    {
+        ResourcePool<Material>& pool = it->second;
+        if (pool.peak_used == 0)
+        {
+            it = _material_pools.erase(it);
+        }
+        else
+        {
+            pool.trim();
+            ++it;
+        }
+    }
+
+    _buffer_pool.trim();
+}
+
+size_t InstanceBatcher::build_batches(const std::vector<DrawCall>& draws)
+{
+    SCOPED_EVENT("InstanceBatcher - build batches");
+
+    _batch_lookup.clear();
+    _batches.clear();
+    _draw_batches.assign(draws.size(), no_batch);
+    _next_draw.assign(draws.size(), no_batch);
+
+    size_t num_merged = 0;
+    for (size_t i = 0; i < draws.size(); i++)
+    {
+        const DrawCall& draw = draws[i];
+        if (draw.instance_count != 1 || !draw.mesh || !draw.material || !draw.material->buffers().empty())
+        {
+            continue;
+        }
+
+        const peng::shared_ref<const Shader>& shader = draw.material->shader();
+        const ShaderInfo* shader_info = get_shader_info(shader);
+        if (!shader_info)
+        {
+            continue;
+        }
+
+        // Look for an existing batch that this draw is compatible with, otherwise start a new one
+        utils::small_vector<size_t, 2>& candidates = _batch_lookup[std::make_tuple(draw.mesh.get(), shader.get())];
+        size_t batch_index = no_batch;
+        for (const size_t candidate : candidates)
+        {
+            const DrawCall& batch_draw = draws[_batches[candidate].first_draw];
+            if (compatible(*shader_info, *batch_draw.material.get(), *draw.material.get()))
+            {
+                batch_index = candidate;
+                break;
+            }
+        }
+
+        if (batch_index == no_batch)
+        {
+            batch_index = _batches.size();
+            candidates.push_back(batch_index);
+            _batches.push_back(Batch{
+                .shader_info = shader_info,
+                .first_draw = i,
+                .last_draw = i,
+                .num_draws = 1,
+                .order = draw.order
+            });
+        }
+        else
+        {
+            Batch& batch = _batches[batch_index];
+            _next_draw[batch.last_draw] = i;
+            batch.last_draw = i;
+            batch.num_draws++;
+            batch.order = std::min(batch.order, draw.order);
+
+            num_merged += batch.num_draws == 2 ? 2 : 1;
+        }
+
+        _draw_batches[i] = batch_index;
+    }
+
+    return num_merged;
+}
+
+DrawCall InstanceBatcher::emit_instanced_draw(const Batch& batch, const std::vector<DrawCall>& draws)
+{
+    const ShaderInfo& shader_info = *batch.shader_info;
+    const DrawCall& first_draw = draws[batch.first_draw];
+
+    _instance_data.clear();
+    for (size_t i = batch.first_draw; i != no_batch; i = _next_draw[i])
+    {
+        const Material& material = *draws[i].material.get();
+        MeshInstanceData& instance_data = _instance_data.emplace_back(MeshInstanceData{
+            .model_matrix = Matrix4x4f::identity(),
+            .normal_matrix = Matrix4x4f::identity(),
+            .base_color = Vector4f::one()
+        });
+
+        if (const Shader::Parameter* model_matrix = material.find_parameter(shader_info.model_matrix))
+        {
+            if (const Matrix4x4f* value = std::get_if<Matrix4x4f>(model_matrix))
+            {
+                instance_data.model_matrix = *value;
+            }
+        }
+
+        if (const Shader::Parameter* normal_matrix = material.find_parameter(shader_info.normal_matrix))
+        {
+            if (const Matrix3x3f* value = std::get_if<Matrix3x3f>(normal_matrix))
+            {
+                instance_data.normal_matrix = to_matrix4x4(*value);
+            }
+        }
+
+        if (const Shader::Parameter* base_color = material.find_parameter(shader_info.base_color))
+        {
+            if (const Vector4f* value = std::get_if<Vector4f>(base_color))
+            {
+                instance_data.base_color = *value;
+            }
+        }
+    }
+
+    peng::shared_ref<StructuredBuffer<MeshInstanceData>> buffer = get_pooled_buffer();
+    buffer->upload(_instance_data);
+
+    // All draws in the batch share the remaining uniforms, so they can be copied over from the first
+    peng::shared_ref<Material> material = get_pooled_material(shader_info.instanced_shader);
+    for (const auto& [location, parameter] : first_draw.material->parameters())
+    {
+        if (location == shader_info.model_matrix
+            || location == shader_info.normal_matrix
+            || location == shader_info.base_color)
+        {
+            continue;
+        }
+
+        const GLint instanced_location = shader_info.location_remap[location];
+        if (instanced_location >= 0)
+        {
+            std::visit([&](const auto& x) { material->set_parameter(instanced_location, x); }, parameter);
+        }
+    }
+
+    material->set_buffer(shader_info.instance_buffer, buffer);
+
+    return DrawCall{
+        .mesh = first_draw.mesh,
+        .material = material,
+        .order = batch.order,
+        .instance_count = batch.num_draws
+    };
+}
+
+const InstanceBatcher::ShaderInfo* InstanceBatcher::get_shader_info(const peng::shared_ref<const Shader>& shader)
+{
+    auto [it, inserted] = _shader_infos.try_emplace(shader);
+    ShaderEntry& entry = it->second;
+    if (inserted)
+    {
+        entry.info = build_shader_info(shader);
+    }
+
+    entry.last_used_frame = _frame;
+    return entry.info.get();
+}
+
+std::unique_ptr<InstanceBatcher::ShaderInfo> InstanceBatcher::build_shader_info(
+    const peng::shared_ref<const Shader>& shader
+) const
+{
+    const peng::shared_ptr<const Shader>& instanced_shader = shader->instanced_variant();
+    if (!instanced_shader || shader->requires_blending())
+    {
+        return nullptr;
+    }
+
+    const GLint model_matrix = shader->get_uniform_location("model_matrix");
+    const GLint instance_buffer = instanced_shader->get_buffer_location("mesh_instance_data");
+    if (model_matrix < 0 || instance_buffer < 0)
+    {
+        Logger::warning(
+            "Shader '%s' has an instanced variant '%s' but it can't be used for instancing",
+            shader->name().c_str(), instanced_shader->name().c_str()
+        );
+
+        return nullptr;
+    }
+
+    std::unique_ptr<ShaderInfo> new_info = std::make_unique<ShaderInfo>(ShaderInfo{
+        .instanced_shader = instanced_shader.to_shared_ref(),
+        .model_matrix = model_matrix,
+        .normal_matrix = shader->get_uniform_location("normal_matrix"),
+        .base_color = shader->get_uniform_location("base_color"),
+        .instance_buffer = instance_buffer,
+        .location_remap = {}
+    });
+
+    new_info->location_remap.resize(shader->uniforms().size(), -1);
+    for (const Shader::Uniform& uniform : shader->uniforms())
+    {
+        if (uniform.location >= 0)
+        {
+            if (static_cast<size_t>(uniform.location) >= new_info->location_remap.size())
+            {
+                new_info->location_remap.resize(uniform.location + 1, -1);
+            }
+
+            new_info->location_remap[uniform.location] = instanced_shader->get_uniform_location(uniform.name);
+        }
+    }
+
+    return new_info;
+}
+
+bool InstanceBatcher::compatible(const ShaderInfo& shader_info, const Material& a, const Material& b) const
+{
+    if (&a == &b)
+    {
+        return true;
+    }
+
+    if (a.parameters().size() != b.parameters().size())
+    {
+        return false;
+    }
+
+    for (const auto& [location, parameter] : a.parameters())
+    {
+        if (location == shader_info.model_matrix
+            || location == shader_info.normal_matrix
+            || location == shader_info.base_color)
+        {
+            continue;
+        }
+
+        const Shader::Parameter* other = b.find_parameter(location);
+        if (!other || !parameters_equal(parameter, *other))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+peng::shared_ref<Material> InstanceBatcher::get_pooled_material(const peng::shared_ref<const Shader>& shader)
+{
+    ResourcePool<Material>& pool = _material_pools[shader];
+
+    if (pool.num_used == pool.resources.size())
+    {
+        pool.resources.push_back(peng::make_shared<Material>(shader));
+    }
+    else
+    {
+        // Don't let uniforms or buffers from the batch which last used the material leak into this one
+        pool.resources[pool.num_used]->clear_parameters();
+    }
+
+    return pool.resources[pool.num_used++];
+}
+
+peng::shared_ref<StructuredBuffer<InstanceBatcher::MeshInstanceData>> InstanceBatcher::get_pooled_buffer()
+{
+    if (_buffer_pool.num_used == _buffer_pool.resources.size())
+    {
+        _buffer_pool.resources.push_back(
+            peng::make_shared<StructuredBuffer<MeshInstanceData>>(
+                strtools::catf("InstanceBatcher[%zu]", _buffer_pool.num_used),
+                GL_STREAM_DRAW
+            )
+        );
+    }
+
+    return _buffer_pool.resources[_buffer_pool.num_used++];
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <memory/shared_ptr.h>
+#include <math/matrix4x4.h>
+#include <utils/flat_hash_map.h>
+#include <utils/hash_helpers.h>
+#include <utils/small_vector.h>
+
+#include "structured_buffer.h"
+
+namespace rendering
+{
+    struct DrawCall;
+
+    class Mesh;
+    class Material;
+    class Shader;
+
+    // Merges draw calls that share a mesh and shader and only differ in per instance uniforms into instanced draws
+    // The per instance uniforms are model_matrix, normal_matrix and base_color, which are uploaded to a buffer
+    // read by the instanced variant of the shader. Only opaque shaders with an instanced variant are batched
+    class InstanceBatcher
+    {
+    public:
+        // Replaces draws that can be batched together with instanced draws, all other draws are left untouched
+        void batch_draws(std::vector<DrawCall>& draws_in_out);
+
+        // Frees internal resources that may no longer be in use
+        // Should be used sparingly to avoid thrashing
+        void flush();
+
+    private:
+        // How many frames pass between releasing pooled resources and shader infos which went unused in that time
+        // This stops the batcher from keeping shaders and materials alive after the scene using them is unloaded
+        static constexpr uint64_t trim_interval = 300;
+
+        // Instance data that can vary per mesh between draws, laid out to match mesh_instance_data in std140
+        struct MeshInstanceData
+        {
+            math::Matrix4x4f model_matrix;
+            math::Matrix4x4f normal_matrix;
+            math::Vector4f base_color;
+        };
+
+        // Everything needed to batch draws of a shader, built the first time the shader is seen
+        struct ShaderInfo
+        {
+            peng::shared_ref<const Shader> instanced_shader;
+            GLint model_matrix = -1;
+            GLint normal_matrix = -1;
+            GLint base_color = -1;
+            GLint instance_buffer = -1;
+
+            // Maps uniform locations in the shader to locations in the instanced shader
+            std::vector<GLint> location_remap;
+        };
+
+        // Info is null if the shader can't be batched
+        struct ShaderEntry
+        {
+            std::unique_ptr<ShaderInfo> info;
+            uint64_t last_used_frame = 0;
+        };
+
+        // Draws in a batch are chained through _next_draw, starting from first_draw
+        struct Batch
+        {
+            const ShaderInfo* shader_info;
+            size_t first_draw;
+            size_t last_draw;
+            int32_t num_draws;
+            float order;
+        };
+
+        template <typename T>
+        struct ResourcePool
+        {
+            std::vector<peng::shared_ref<T>> resources;
+            size_t num_used = 0;
+
+            // Most resources used in a single frame since the pool was last trimmed
+            size_t peak_used = 0;
+
+            void begin_frame() noexcept
+            {
+                peak_used = std::max(peak_used, num_used);
+                num_used = 0;
+            }
+
+            // Releases the resources beyond the peak usage, and starts tracking the peak again
+            void trim()
+            {
+                resources.erase(resources.begin() + static_cast<std::ptrdiff_t>(peak_used), resources.end());
+                peak_used = 0;
+            }
+        };
+
+        using BatchKey = std::tuple<const Mesh*, const Shader*>;
+
+        // Builds batches of compatible draws, returns the number of draws that will be merged
+        size_t build_batches(const std::vector<DrawCall>& draws);
+
+        // Emits an instanced draw call for a batch of draws
+        [[nodiscard]] DrawCall emit_instanced_draw(const Batch& batch, const std::vector<DrawCall>& draws);
+
+        [[nodiscard]] const ShaderInfo* get_shader_info(const peng::shared_ref<const Shader>& shader);
+        [[nodiscard]] std::unique_ptr<ShaderInfo> build_shader_info(const peng::shared_ref<const Shader>& shader) const;
+
+        // Releases the shader infos and pools which went unused since the last trim, and shrinks the rest
+        void trim();
+
+        // If two materials only differ in per instance uniforms
+        [[nodiscard]] bool compatible(const ShaderInfo& shader_info, const Material& a, const Material& b) const;
+
+        [[nodiscard]] peng::shared_ref<Material> get_pooled_material(const peng::shared_ref<const Shader>& shader);
+        [[nodiscard]] peng::shared_ref<StructuredBuffer<MeshInstanceData>> get_pooled_buffer();
+
+        // ShaderInfo is boxed so that pointers to it stay valid as the map grows
+        utils::flat_hash_map<peng::shared_ref<const Shader>, ShaderEntry> _shader_infos;
+        utils::flat_hash_map<peng::shared_ref<const Shader>, ResourcePool<Material>> _material_pools;
+        ResourcePool<StructuredBuffer<MeshInstanceData>> _buffer_pool;
+        uint64_t _frame = 0;
+
+        utils::flat_hash_map<BatchKey, utils::small_vector<size_t, 2>> _batch_lookup;
+        std::vector<Batch> _batches;
+        std::vector<size_t> _draw_batches;
+        std::vector<size_t> _next_draw;
+        std::vector<DrawCall> _instanced_draws;
+        std::vector<MeshInstanceData> _instance_data;
+    };
+}
@@ -0,0 +1,236 @@
+#include "light_clusterer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <profiling/scoped_event.h>
+#include <utils/strtools.h>
+
+using namespace rendering;
+using namespace math;
+
+namespace
+{
+    // Contributions below this are invisible at 8 bits per channel, so lights stop affecting clusters beyond it
+    constexpr float light_cutoff = 1.0f / 256;
+
+    // Smallest depth used for slicing, keeps log finite for fragments on or behind the camera
+    constexpr float min_slice_depth = 1e-5f;
+
+    // Corners with a smaller clip space w than this are on or behind the camera plane
+    constexpr float min_clip_w = 1e-5f;
+
+    [[nodiscard]] float max_component(const Vector3f& v) noexcept
+    {
+        return std::max({ v.x, v.y, v.z });
+    }
+
+    // Distance at which min(max_strength, range / (1 + d^2)) scaled by the light's brightness drops below the cutoff
+    [[nodiscard]] float influence_radius(float range, const Vector3f& color, const Vector3f& ambient) noexcept
+    {
+        const float brightness = max_component(color) + max_component(ambient);
+        return std::sqrt(std::max(range * brightness / light_cutoff - 1, 0.0f));
+    }
+
+    [[nodiscard]] uint32_t to_tile(float ndc, uint32_t count) noexcept
+    {
+        const float tile = std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(count));
+        return static_cast<uint32_t>(std::clamp(tile, 0.0f, static_cast<float>(count - 1)));
+    }
+}
+
+void LightClusterer::build(
+    const CameraRenderData& camera,
+    std::span<const PointLightRenderData> point_lights,
+    std::span<const SpotLightRenderData> spot_lights
+)
+{
+    SCOPED_EVENT("LightClusterer - build", strtools::catf_temp(
+        "%zu point lights, %zu spot lights", point_lights.size(), spot_lights.size()
+    ));
+
+    _view_projection = camera.view_matrix;
+    _frustum = Frustum(camera.view_matrix);
+    _view_pos = camera.view_pos;
+    _view_dir = camera.view_dir.normalized();
+
+    // Exponential slices keep clusters roughly cubic in view space, near slices being thin and far slices thick
+    const float near_clip = std::max(camera.near_clip, min_slice_depth);
+    const float far_clip = std::max(camera.far_clip, near_clip * 2);
+    const float log_depth_range = std::log(far_clip / near_clip);
+    _depth_scale = static_cast<float>(cluster_count_z) / log_depth_range;
+    _depth_bias = -static_cast<float>(cluster_count_z) * std::log(near_clip) / log_depth_range;
+
+    _point_ranges.clear();
+    _visible_point_lights.clear();
+    for (uint32_t i = 0; i < point_lights.size(); i++)
+    {
+        const PointLightRenderData& light = point_lights[i];
+        const float radius = influence_radius(light.range, light.color, light.ambient);
+
+        ClusterRange range;
+        if (find_cluster_range(light.pos, radius, range))
+        {
+            _point_ranges.push_back(range);
+            _visible_point_lights.push_back(i);
+        }
+    }
+
+    // Spot lights are bounded by the sphere around their whole range rather than their cone
+    _spot_ranges.clear();
+    _visible_spot_lights.clear();
+    for (uint32_t i = 0; i < spot_lights.size(); i++)
+    {
+        const SpotLightRenderData& light = spot_lights[i];
+        const float radius = influence_radius(light.range, light.color, light.ambient);
+
+        ClusterRange range;
+        if (find_cluster_range(light.pos, radius, range))
+        {
+            _spot_ranges.push_back(range);
+            _visible_spot_lights.push_back(i);
+        }
+    }
+
+    // Count the lights in each cluster, then pack the index lists of all clusters into a single array
+    _clusters.assign(num_clusters, LightClusterRenderData{
+        .offset = 0,
+        .num_point_lights = 0,
+        .num_spot_lights = 0
+    });
+
+    for (const ClusterRange& range : _point_ranges)
+    {
+        for_each_cluster(range, [&](LightClusterRenderData& cluster) { cluster.num_point_lights++; });
+    }
+
+    for (const ClusterRange& range : _spot_ranges)
+    {
+        for_each_cluster(range, [&](LightClusterRenderData& cluster) { cluster.num_spot_lights++; });
+    }
+
+    uint32_t num_indices = 0;
+    for (LightClusterRenderData& cluster : _clusters)
+    {
+        cluster.offset = num_indices;
+        num_indices += cluster.num_point_lights + cluster.num_spot_lights;
+
+        // The counts are rebuilt while writing the indices, and the point light count is final before spot lights are written
+        cluster.num_point_lights = 0;
+        cluster.num_spot_lights = 0;
+    }
+
+    _light_indices.resize(num_indices);
+    for (size_t i = 0; i < _point_ranges.size(); i++)
+    {
+        const uint32_t light_index = _visible_point_lights[i];
+        for_each_cluster(_point_ranges[i], [&](LightClusterRenderData& cluster)
+        {
+            _light_indices[cluster.offset + cluster.num_point_lights++] = light_index;
+        });
+    }
+
+    for (size_t i = 0; i < _spot_ranges.size(); i++)
+    {
+        const uint32_t light_index = _visible_spot_lights[i];
+        for_each_cluster(_spot_ranges[i], [&](LightClusterRenderData& cluster)
+        {
+            _light_indices[cluster.offset + cluster.num_point_lights + cluster.num_spot_lights++] = light_index;
+        });
+    }
+}
+
+void LightClusterer::write_frame_data(FrameRenderData& frame_data) const noexcept
+{
+    frame_data.view_dir = _view_dir;
+    frame_data.cluster_count_x = cluster_count_x;
+    frame_data.cluster_count_y = cluster_count_y;
+    frame_data.cluster_count_z = cluster_count_z;
+    frame_data.cluster_depth_scale = _depth_scale;
+    frame_data.cluster_depth_bias = _depth_bias;
+}
+
+std::vector<LightClusterRenderData>& LightClusterer::clusters() noexcept
+{
+    return _clusters;
+}
+
+std::vector<uint32_t>& LightClusterer::light_indices() noexcept
+{
+    return _light_indices;
+}
+
+bool LightClusterer::find_cluster_range(const Vector3f& pos, float radius, ClusterRange& range) const noexcept
+{
+    if (!_frustum.intersects_sphere(pos, radius))
+    {
+        return false;
+    }
+
+    const Vector3f offset = pos - _view_pos;
+    const float depth = offset.x * _view_dir.x + offset.y * _view_dir.y + offset.z * _view_dir.z;
+    range.min_z = depth_slice(depth - radius);
+    range.max_z = depth_slice(depth + radius);
+
+    // Bound the sphere in clip space by projecting the corners of its bounding box
+    // If any corner is behind the camera the projection is meaningless, so the light covers every tile
+    Vector2f ndc_min = Vector2f(+1, +1);
+    Vector2f ndc_max = Vector2f(-1, -1);
+    bool covers_all_tiles = false;
+
+    for (uint8_t corner = 0; corner < 8; corner++)
+    {
+        const Vector3f corner_pos = pos + Vector3f(
+            corner & 1 ? radius : -radius,
+            corner & 2 ? radius : -radius,
+            corner & 4 ? radius : -radius
+        );
+
+        const Vector4f clip_pos = _view_projection * Vector4f(corner_pos, 1);
+        if (clip_pos.w <= min_clip_w)
+        {
+            covers_all_tiles = true;
+            break;
+        }
+
+        const Vector2f ndc = Vector2f(clip_pos.x, clip_pos.y) / clip_pos.w;
+        ndc_min = Vector2f(std::min(ndc_min.x, ndc.x), std::min(ndc_min.y, ndc.y));
+        ndc_max = Vector2f(std::max(ndc_max.x, ndc.x), std::max(ndc_max.y, ndc.y));
+    }
+
+    if (covers_all_tiles)
+    {
+        ndc_min = Vector2f(-1, -1);
+        ndc_max = Vector2f(+1, +1);
+    }
+
+    range.min_x = to_tile(ndc_min.x, cluster_count_x);
+    range.max_x = to_tile(ndc_max.x, cluster_count_x);
+    range.min_y = to_tile(ndc_min.y, cluster_count_y);
+    range.max_y = to_tile(ndc_max.y, cluster_count_y);
+
+    return range.min_x <= range.max_x && range.min_y <= range.max_y;
+}
+
+uint32_t LightClusterer::depth_slice(float depth) const noexcept
+{
+    // Must match the slice calculation in the shaders
+    const float slice = std::floor(std::log(std::max(depth, min_slice_depth)) * _depth_scale + _depth_bias);
+    return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(cluster_count_z - 1)));
+}
+
+template <typename F>
+void LightClusterer::for_each_cluster(const ClusterRange& range, F&& f)
+{
+    for (uint32_t z = range.min_z; z <= range.max_z; z++)
+    {
+        for (uint32_t y = range.min_y; y <= range.max_y; y++)
+        {
+            const size_t row = (z * cluster_count_y + y) * cluster_count_x;
+            for (uint32_t x = range.min_x; x <= range.max_x; x++)
+            {
+                f(_clusters[row + x]);
+            }
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+#include <math/frustum.h>
+#include <math/vector2.h>
+
+#include "frame_data.h"
+
+namespace rendering
+{
+    // Assigns the point and spot lights of a frame to a grid of clusters spanning the camera's view
+    // Clusters are tiles in clip space x and y, and slices of view depth spaced exponentially,
+    // so each fragment only iterates the lights whose range overlaps its cluster
+    // Built once per frame, the cost is linear in the number of lights and the clusters each one touches
+    class LightClusterer
+    {
+    public:
+        static constexpr uint32_t cluster_count_x = 16;
+        static constexpr uint32_t cluster_count_y = 9;
+        static constexpr uint32_t cluster_count_z = 24;
+        static constexpr uint32_t num_clusters = cluster_count_x * cluster_count_y * cluster_count_z;
+
+        void build(
+            const CameraRenderData& camera,
+            std::span<const PointLightRenderData> point_lights,
+            std::span<const SpotLightRenderData> spot_lights
+        );
+
+        // Fills in the cluster grid description used by shaders to look up their cluster
+        void write_frame_data(FrameRenderData& frame_data) const noexcept;
+
+        [[nodiscard]] std::vector<LightClusterRenderData>& clusters() noexcept;
+        [[nodiscard]] std::vector<uint32_t>& light_indices() noexcept;
+
+    private:
+        // Inclusive range of clusters touched by a light
+        struct ClusterRange
+        {
+            uint32_t min_x;
+            uint32_t max_x;
+            uint32_t min_y;
+            uint32_t max_y;
+            uint32_t min_z;
+            uint32_t max_z;
+        };
+
+        // Finds the clusters touched by a light, returns false if the light can't be seen at all
+        [[nodiscard]] bool find_cluster_range(
+            const math::Vector3f& pos,
+            float radius,
+            ClusterRange& range
+        ) const noexcept;
+
+        [[nodiscard]] uint32_t depth_slice(float depth) const noexcept;
+
+        template <typename F>
+        void for_each_cluster(const ClusterRange& range, F&& f);
+
+        math::Frustum _frustum;
+        math::Matrix4x4f _view_projection = math::Matrix4x4f::identity();
+        math::Vector3f _view_pos = math::Vector3f::zero();
+        math::Vector3f _view_dir = math::Vector3f::forwards();
+        float _depth_scale = 0;
+        float _depth_bias = 0;
+
+        std::vector<ClusterRange> _point_ranges;
+        std::vector<ClusterRange> _spot_ranges;
+        std::vector<uint32_t> _visible_point_lights;
+        std::vector<uint32_t> _visible_spot_lights;
+
+        std::vector<LightClusterRenderData> _clusters;
+        std::vector<uint32_t> _light_indices;
+    };
+}
@@ -4,6 +4,7 @@
 #include <utils/functional.h>
 #include <utils/utils.h>
 
+#include "device.h"
 #include "texture.h"
 #include "texture_binding_cache.h"
 
@@ -24,13 +25,7 @@ Material::Material(peng::shared_ref<const Shader>&& shader)
         _shader = Shader::fallback();
     }
 
-    for (const Shader::Uniform& uniform : _shader->uniforms())
-    {
-        if (uniform.default_value)
-        {
-            set_parameter(uniform.location, *uniform.default_value);
-        }
-    }
+    set_default_parameters();
 }
 
 Material::Material(const peng::shared_ref<const Shader>& shader)
@@ -68,6 +63,15 @@ void Material::set_buffer(const std::string& buffer_name, const peng::shared_ref
     }
 }
 
+void Material::clear_parameters()
+{
+    _set_parameters.clear();
+    _existing_parameters.clear();
+    _bound_buffers.clear();
+
+    set_default_parameters();
+}
+
 void Material::set_parameter(GLint uniform_location, const Shader::Parameter& parameter)
 {
     if (const auto it = _existing_parameters.find(uniform_location); it != _existing_parameters.end())
@@ -106,11 +110,14 @@ void Material::use()
 
 void Material::apply_uniforms()
 {
+    Device& device = Device::get();
+
     _num_bound_textures = 0;
     for (const auto& [location, parameter] : _set_parameters)
     {
         std::visit(functional::overload{
-            [&](const auto& x) { apply_parameter(location, x); }
+            [&](const peng::shared_ref<const Texture>& x) { apply_parameter(location, x); },
+            [&](const auto& x) { device.set_uniform(location, x); }
         }, parameter);
     }
 }
@@ -123,109 +130,34 @@ void Material::bind_buffers()
     }
 }
 
-peng::shared_ref<const Shader> Material::shader() const
+const peng::shared_ref<const Shader>& Material::shader() const noexcept
 {
     return _shader;
 }
 
-void Material::apply_parameter(GLint location, int32_t value)
-{
-    glUniform1i(location, value);
-}
-
-void Material::apply_parameter(GLint location, uint32_t value)
-{
-    glUniform1ui(location, value);
-}
-
-void Material::apply_parameter(GLint location, float value)
-{
-    glUniform1f(location, value);
-}
-
-void Material::apply_parameter(GLint location, double value)
-{
-    glUniform1d(location, value);
-}
-
-void Material::apply_parameter(GLint location, const Vector2i& value)
-{
-    glUniform2i(location, value.x, value.y);
-}
-
-void Material::apply_parameter(GLint location, const Vector2u& value)
-{
-    glUniform2ui(location, value.x, value.y);
-}
-
-void Material::apply_parameter(GLint location, const Vector2f& value)
-{
-    glUniform2f(location, value.x, value.y);
-}
-
-void Material::apply_parameter(GLint location, const Vector2d& value)
-{
-    glUniform2d(location, value.x, value.y);
-}
-
-void Material::apply_parameter(GLint location, const Vector3i& value)
+uint32_t Material::sort_id() const noexcept
 {
-    glUniform3i(location, value.x, value.y, value.z);
+    return _sort_id.value();
 }
 
-void Material::apply_parameter(GLint location, const Vector3u& value)
+const Shader::Parameter* Material::find_parameter(GLint uniform_location) const
 {
-    glUniform3ui(location, value.x, value.y, value.z);
-}
-
-void Material::apply_parameter(GLint location, const Vector3f& value)
-{
-    glUniform3f(location, value.x, value.y, value.z);
-}
-
-void Material::apply_parameter(GLint location, const Vector3d& value)
-{
-    glUniform3d(location, value.x, value.y, value.z);
-}
-
-void Material::apply_parameter(GLint location, const Vector4i& value)
-{
-    glUniform4i(location, value.x, value.y, value.z, value.w);
-}
-
-void Material::apply_parameter(GLint location, const Vector4u& value)
-{
-    glUniform4ui(location, value.x, value.y, value.z, value.w);
-}
-
-void Material::apply_parameter(GLint location, const Vector4f& value)
-{
-    glUniform4f(location, value.x, value.y, value.z, value.w);
-}
-
-void Material::apply_parameter(GLint location, const Vector4d& value)
-{
-    glUniform4d(location, value.x, value.y, value.z, value.w);
-}
-
-void Material::apply_parameter(GLint location, const Matrix3x3f& value)
-{
-    glUniformMatrix3fv(location, 1, GL_FALSE, value.elements.data());
-}
+    if (const auto it = _existing_parameters.find(uniform_location); it != _existing_parameters.end())
+    {
+        return &std::get<Shader::Parameter>(_set_parameters[it->second]);
+    }
 
-void Material::apply_parameter(GLint location, const Matrix3x3d& value)
-{
-    glUniformMatrix3dv(location, 1, GL_FALSE, value.elements.data());
+    return nullptr;
 }
 
-void Material::apply_parameter(GLint location, const Matrix4x4f& value)
+const std::vector<std::tuple<GLint, Shader::Parameter>>& Material::parameters() const noexcept
 {
-    glUniformMatrix4fv(location, 1, GL_FALSE, value.elements.data());
+    return _set_parameters;
 }
 
-void Material::apply_parameter(GLint location, const Matrix4x4d& value)
+const std::vector<std::tuple<GLint, peng::shared_ref<const IShaderBuffer>>>& Material::buffers() const noexcept
 {
-    glUniformMatrix4dv(location, 1, GL_FALSE, value.elements.data());
+    return _bound_buffers;
 }
 
 void Material::apply_parameter(GLint location, const peng::shared_ref<const Texture>& texture)
@@ -236,5 +168,16 @@ void Material::apply_parameter(GLint location, const peng::shared_ref<const Text
     }
 
     const GLint texture_slot = TextureBindingCache::get().bind_texture(texture);
-    glUniform1i(location, static_cast<GLint>(texture_slot));
+    Device::get().set_uniform(location, static_cast<int32_t>(texture_slot));
+}
+
+void Material::set_default_parameters()
+{
+    for (const Shader::Uniform& uniform : _shader->uniforms())
+    {
+        if (uniform.default_value)
+        {
+            set_parameter(uniform.location, *uniform.default_value);
+        }
+    }
 }
@@ -1,11 +1,12 @@
 #pragma once
 
 #include <tuple>
-#include <unordered_map>
-#include <unordered_set>
 
 #include <memory/shared_ref.h>
 #include <utils/concepts.h>
+#include <utils/flat_hash_map.h>
+#include <utils/flat_hash_set.h>
+#include <utils/sequential_id.h>
 
 #include "shader.h"
 #include "shader_buffer.h"
@@ -50,41 +51,35 @@ namespace rendering
         void set_buffer(GLint buffer_index, const peng::shared_ref<const IShaderBuffer>& buffer);
         void set_buffer(const std::string& buffer_name, const peng::shared_ref<const IShaderBuffer>& buffer);
 
-        [[nodiscard]] peng::shared_ref<const Shader> shader() const;
+        // Removes every parameter and buffer that has been set, leaving only the shader's default uniform values
+        void clear_parameters();
+
+        [[nodiscard]] const peng::shared_ref<const Shader>& shader() const noexcept;
+
+        // Small id unique among live materials, used when sorting draws and reused once this material is destroyed
+        [[nodiscard]] uint32_t sort_id() const noexcept;
+
+        // Gets the value set for a uniform, or nullptr if none has been set
+        [[nodiscard]] const Shader::Parameter* find_parameter(GLint uniform_location) const;
+
+        [[nodiscard]] const std::vector<std::tuple<GLint, Shader::Parameter>>& parameters() const noexcept;
+        [[nodiscard]] const std::vector<std::tuple<GLint, peng::shared_ref<const IShaderBuffer>>>& buffers() const noexcept;
 
     private:
         void set_parameter(GLint uniform_location, const Shader::Parameter& parameter);
         void set_parameter(const std::string& parameter_name, const Shader::Parameter& parameter);
 
-        void apply_parameter(GLint location, int32_t value);
-        void apply_parameter(GLint location, uint32_t value);
-        void apply_parameter(GLint location, float value);
-        void apply_parameter(GLint location, double value);
-        void apply_parameter(GLint location, const math::Vector2i& value);
-        void apply_parameter(GLint location, const math::Vector2u& value);
-        void apply_parameter(GLint location, const math::Vector2f& value);
-        void apply_parameter(GLint location, const math::Vector2d& value);
-        void apply_parameter(GLint location, const math::Vector3i& value);
-        void apply_parameter(GLint location, const math::Vector3u& value);
-        void apply_parameter(GLint location, const math::Vector3f& value);
-        void apply_parameter(GLint location, const math::Vector3d& value);
-        void apply_parameter(GLint location, const math::Vector4i& value);
-        void apply_parameter(GLint location, const math::Vector4u& value);
-        void apply_parameter(GLint location, const math::Vector4f& value);
-        void apply_parameter(GLint location, const math::Vector4d& value);
-        void apply_parameter(GLint location, const math::Matrix3x3f& value);
-        void apply_parameter(GLint location, const math::Matrix3x3d& value);
-        void apply_parameter(GLint location, const math::Matrix4x4f& value);
-        void apply_parameter(GLint location, const math::Matrix4x4d& value);
         void apply_parameter(GLint location, const peng::shared_ref<const Texture>& texture);
+        void set_default_parameters();
 
         peng::shared_ref<const Shader> _shader;
+        utils::SequentialId<Material> _sort_id;
 
         std::vector<std::tuple<GLint, Shader::Parameter>> _set_parameters;
         std::vector<std::tuple<GLint, peng::shared_ref<const IShaderBuffer>>> _bound_buffers;
-        std::unordered_map<GLint, size_t> _existing_parameters;
-        std::unordered_set<std::string> _bad_parameter_names;
-        std::unordered_set<std::string> _bad_buffer_names;
+        utils::flat_hash_map<GLint, size_t> _existing_parameters;
+        utils::flat_hash_set<std::string> _bad_parameter_names;
+        utils::flat_hash_set<std::string> _bad_buffer_names;
         uint32_t _num_bound_textures;
     };
 }
@@ -1,82 +1,242 @@
 #include "mesh.h"
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
 #include <utils/utils.h>
 #include <utils/check.h>
 #include <utils/vectools.h>
+#include <utils/strtools.h>
 #include <core/archive.h>
 #include <core/logger.h>
 #include <memory/gc.h>
 #include <profiling/scoped_event.h>
 
-#include "mesh_decoder.h"
+#include "device.h"
+#include "mesh_cache.h"
 
 using namespace rendering;
 using namespace math;
 
-Mesh::Mesh(std::string&& name, RawMeshData&& raw_data)
-    : _name(std::move(name))
-    , _raw_data(std::move(raw_data))
-    , _num_indices(static_cast<GLuint>(_raw_data.triangles.size() * 3))
+namespace
 {
-    SCOPED_EVENT("Building mesh", _name.c_str());
-    Logger::log("Building mesh '%s'", _name.c_str());
-
-    _raw_data.check_valid();
-
-    glGenBuffers(1, &_vbo);
-    glGenBuffers(1, &_ebo);
-    glGenVertexArrays(1, &_vao);
-
-    glBindVertexArray(_vao);
-    glObjectLabel(GL_VERTEX_ARRAY, _vao, -1, _name.c_str());
+    [[nodiscard]] CachedMesh load_mesh_file(const std::string& name, const std::string& mesh_path)
+    {
+        CachedMesh cached_mesh = MeshCache::load(mesh_path);
+        if (cached_mesh.corrupt())
+        {
+            throw std::runtime_error(strtools::catf("Mesh %s could not be loaded from %s", name.c_str(), mesh_path.c_str()));
+        }
 
-    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
-    glBufferData(GL_ARRAY_BUFFER, vectools::buffer_size(_raw_data.vertices), _raw_data.vertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, vectools::buffer_size(_raw_data.triangles), _raw_data.triangles.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, position));
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    glEnableVertexAttribArray(1);
+        return cached_mesh;
+    }
+}
 
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tex_coord));
-    glEnableVertexAttribArray(2);
+Mesh::Mesh(std::string&& name, RawMeshData&& raw_data, MeshRetention retention, VertexFormat vertex_format)
+    : Mesh(
+        std::move(name),
+        peng::make_shared<const RawMeshData>(std::move(raw_data)),
+        retention,
+        vertex_format
+    )
+{ }
 
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, color));
-    glEnableVertexAttribArray(3);
-}
+Mesh::Mesh(const std::string& name, const RawMeshData& raw_data, MeshRetention retention, VertexFormat vertex_format)
+    : Mesh(
+        utils::copy(name),
+        utils::copy(raw_data),
+        retention,
+        vertex_format
+    )
+{ }
 
-Mesh::Mesh(const std::string& name, const RawMeshData& raw_data)
+Mesh::Mesh(const std::string& name, const MeshDataView& data, MeshRetention retention, VertexFormat vertex_format)
     : Mesh(
         utils::copy(name),
-        utils::copy(raw_data)
+        data,
+        peng::shared_ptr<const RawMeshData>(),
+        retention,
+        vertex_format
     )
 { }
 
-Mesh::Mesh(const std::string& name, const std::string& mesh_path)
+Mesh::Mesh(const std::string& name, const std::string& mesh_path, MeshRetention retention, VertexFormat vertex_format)
     : Mesh(
         name,
-        MeshDecoder::load_file(mesh_path)
+        load_mesh_file(name, mesh_path).level(0),
+        retention,
+        vertex_format
+    )
+{
+    _source_path = mesh_path;
+}
+
+Mesh::Mesh(
+    std::string&& name,
+    const peng::shared_ref<const RawMeshData>& raw_data,
+    MeshRetention retention,
+    VertexFormat vertex_format
+)
+    : Mesh(
+        std::move(name),
+        raw_data->view(),
+        raw_data,
+        retention,
+        vertex_format
     )
 { }
 
+Mesh::Mesh(
+    std::string&& name,
+    const MeshDataView& data,
+    const peng::shared_ptr<const RawMeshData>& raw_data,
+    MeshRetention retention,
+    VertexFormat vertex_format
+)
+    : _name(std::move(name))
+    , _retention(retention)
+    , _vertex_format(vertex_format)
+    , _bounds(data.bounds)
+    , _bounding_sphere(data.bounding_sphere)
+    , _num_vertices(static_cast<int32_t>(data.vertices.size()))
+    , _num_triangles(static_cast<int32_t>(data.triangles.size()))
+    , _num_indices(static_cast<GLuint>(data.triangles.size() * 3))
+{
+    SCOPED_EVENT("Building mesh", _name.c_str());
+    Logger::log("Building mesh '%s'", _name.c_str());
+
+    Device& device = Device::get();
+
+    _vbo = device.create_buffer(_name.c_str());
+    _ebo = device.create_buffer(_name.c_str());
+    _vao = device.create_vertex_array(_name.c_str());
+
+    upload(data, raw_data);
+}
+
 Mesh::~Mesh()
 {
     SCOPED_EVENT("Destroying mesh", _name.c_str());
     Logger::log("Destroying mesh '%s'", _name.c_str());
 
-    glDeleteBuffers(1, &_vbo);
-    glDeleteBuffers(1, &_ebo);
-    glDeleteVertexArrays(1, &_vao);
+    Device& device = Device::get();
+    device.delete_buffer(_vbo);
+    device.delete_buffer(_ebo);
+    device.delete_vertex_array(_vao);
 }
 
 peng::shared_ref<Mesh> Mesh::load_asset(const Archive& archive)
+{
+    return finalize_asset(archive, decode_asset(archive));
+}
+
+CachedMesh Mesh::decode_asset(const Archive& archive)
+{
+    const std::string mesh_path = archive.read<std::string>("mesh");
+    const int32_t num_lods = archive.read_or("lods", 0);
+
+    // Levels of detail are generated when the mesh is imported and cached along with it
+    return MeshCache::load(mesh_path, num_lods);
+}
+
+peng::shared_ref<Mesh> Mesh::finalize_asset(const Archive& archive, CachedMesh&& cached_mesh)
 {
     const std::string mesh_path = archive.read<std::string>("mesh");
-    return memory::GC::alloc<Mesh>(archive.name, mesh_path);
+    const MeshRetention retention = archive.read_or("retention", MeshRetention::keep);
+    const VertexFormat vertex_format = archive.read_or("vertex_format", VertexFormat::full);
+    const int32_t num_lods = archive.read_or("lods", 0);
+
+    if (cached_mesh.corrupt())
+    {
+        throw std::runtime_error(strtools::catf("Mesh %s could not be loaded from %s", archive.name.c_str(), mesh_path.c_str()));
+    }
+
+    peng::shared_ref<Mesh> mesh = memory::GC::alloc<Mesh>(archive.name, cached_mesh.level(0), retention, vertex_format);
+    mesh->_source_path = mesh_path;
+
+    if (num_lods > 0)
+    {
+        std::vector<peng::shared_ref<const Mesh>> lods;
+        for (size_t level = 1; level < cached_mesh.num_levels(); level++)
+        {
+            lods.push_back(peng::make_shared<Mesh>(
+                strtools::catf("%s[LOD%zu]", archive.name.c_str(), level), cached_mesh.level(level), retention, vertex_format
+            ));
+        }
+
+        mesh->set_lods(std::move(lods));
+    }
+
+    return mesh;
+}
+
+void Mesh::set_data(RawMeshData&& raw_data)
+{
+    SCOPED_EVENT("Updating mesh", _name.c_str());
+
+    const peng::shared_ref<const RawMeshData> new_data = peng::make_shared<const RawMeshData>(std::move(raw_data));
+    const MeshDataView data = new_data->view();
+
+    _source_path.clear();
+    _raw_data = nullptr;
+    _lods.clear();
+    _bounds = data.bounds;
+    _bounding_sphere = data.bounding_sphere;
+    _num_vertices = static_cast<int32_t>(data.vertices.size());
+    _num_triangles = static_cast<int32_t>(data.triangles.size());
+    _num_indices = static_cast<GLuint>(data.triangles.size() * 3);
+
+    // The element buffer binding is part of the vertex array's state, so ours must be bound while uploading
+    bind();
+    upload(data, new_data);
+    unbind();
+}
+
+void Mesh::upload(const MeshDataView& data, const peng::shared_ptr<const RawMeshData>& raw_data)
+{
+    Device& device = Device::get();
+
+    device.buffer_data(GL_ELEMENT_ARRAY_BUFFER, _ebo, data.triangles.size_bytes(), data.triangles.data(), GL_STATIC_DRAW);
+
+    switch (_vertex_format)
+    {
+        case VertexFormat::full:
+        {
+            device.buffer_data(GL_ARRAY_BUFFER, _vbo, data.vertices.size_bytes(), data.vertices.data(), GL_STATIC_DRAW);
+
+            device.vertex_attribute(0, _vbo, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, position));
+            device.vertex_attribute(1, _vbo, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, normal));
+            device.vertex_attribute(2, _vbo, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, tex_coord));
+            device.vertex_attribute(3, _vbo, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), offsetof(Vertex, color));
+            break;
+        }
+        case VertexFormat::compact:
+        {
+            const std::vector<CompactVertex> compact_vertices(data.vertices.begin(), data.vertices.end());
+            device.buffer_data(GL_ARRAY_BUFFER, _vbo, vectools::buffer_size(compact_vertices), compact_vertices.data(), GL_STATIC_DRAW);
+
+            // The normal's 2 bit w component is left as 0 and is ignored by the shader's vec3 input
+            device.vertex_attribute(0, _vbo, 3, GL_FLOAT, GL_FALSE, sizeof(CompactVertex), offsetof(CompactVertex, position));
+            device.vertex_attribute(1, _vbo, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(CompactVertex), offsetof(CompactVertex, normal));
+            device.vertex_attribute(2, _vbo, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(CompactVertex), offsetof(CompactVertex, tex_coord));
+            device.vertex_attribute(3, _vbo, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(CompactVertex), offsetof(CompactVertex, color));
+            break;
+        }
+        default:
+        {
+            throw std::runtime_error(strtools::catf("Invalid vertex format %d", _vertex_format));
+        }
+    }
+
+    // Once the data lives on the GPU we only need to hold onto the CPU copy if requested
+    // Views don't own their data, so it has to be copied to be kept
+    if (_retention == MeshRetention::keep)
+    {
+        _raw_data = raw_data
+            ? raw_data
+            : peng::make_shared<const RawMeshData>(RawMeshData::from_view(data));
+    }
 }
 
 void Mesh::render() const
@@ -88,23 +248,52 @@ void Mesh::render() const
 
 void Mesh::bind() const
 {
-    glBindVertexArray(_vao);
+    Device::get().bind_vertex_array(_vao);
 }
 
 void Mesh::unbind() const
 {
-    glBindVertexArray(0);
+    Device::get().bind_vertex_array(0);
 }
 
 void Mesh::draw() const
 {
-    glDrawElements(GL_TRIANGLES, _num_indices, GL_UNSIGNED_INT, nullptr);
+    Device::get().draw_elements(static_cast<GLsizei>(_num_indices));
 }
 
 void Mesh::draw_instanced(int32_t num) const
 {
     check(num >= 0);
-    glDrawElementsInstanced(GL_TRIANGLES, _num_indices, GL_UNSIGNED_INT, nullptr, num);
+    Device::get().draw_elements_instanced(static_cast<GLsizei>(_num_indices), num);
+}
+
+peng::shared_ref<const RawMeshData> Mesh::load_raw_data() const
+{
+    if (_raw_data)
+    {
+        return _raw_data.to_shared_ref();
+    }
+
+    SCOPED_EVENT("Reloading mesh data", _name.c_str());
+
+    if (_source_path.empty())
+    {
+        Logger::error(
+            "Cannot reload data for mesh '%s' as it has no source file and was built with a retention of %d",
+            _name.c_str(), _retention
+        );
+
+        return peng::make_shared<const RawMeshData>(RawMeshData::corrupt_data());
+    }
+
+    Logger::log("Reloading data for mesh '%s'", _name.c_str());
+
+    const CachedMesh cached_mesh = MeshCache::load(_source_path);
+    return peng::make_shared<const RawMeshData>(
+        cached_mesh.corrupt()
+            ? RawMeshData::corrupt_data()
+            : RawMeshData::from_view(cached_mesh.level(0))
+    );
 }
 
 const std::string& Mesh::name() const noexcept
@@ -112,8 +301,85 @@ const std::string& Mesh::name() const noexcept
     return _name;
 }
 
+uint32_t Mesh::sort_id() const noexcept
+{
+    return _sort_id.value();
+}
+
+MeshRetention Mesh::retention() const noexcept
+{
+    return _retention;
+}
+
+VertexFormat Mesh::vertex_format() const noexcept
+{
+    return _vertex_format;
+}
+
+bool Mesh::has_raw_data() const noexcept
+{
+    return static_cast<bool>(_raw_data);
+}
+
+int32_t Mesh::num_vertices() const noexcept
+{
+    return _num_vertices;
+}
+
 int32_t Mesh::num_triangles() const noexcept
 {
-    return static_cast<int32_t>(_raw_data.triangles.size());
+    return _num_triangles;
+}
+
+const physics::AABB& Mesh::bounds() const noexcept
+{
+    return _bounds;
+}
+
+const physics::BoundingSphere& Mesh::bounding_sphere() const noexcept
+{
+    return _bounding_sphere;
 }
 
+void Mesh::set_lods(std::vector<peng::shared_ref<const Mesh>>&& lods)
+{
+    _lods.clear();
+    _lods.reserve(lods.size());
+
+    for (peng::shared_ref<const Mesh>& lod : lods)
+    {
+        const float triangle_ratio = _num_triangles > 0
+            ? static_cast<float>(lod->num_triangles()) / static_cast<float>(_num_triangles)
+            : 1.0f;
+
+        const float screen_size = full_detail_screen_size * std::sqrt(triangle_ratio);
+        _lods.push_back(MeshLod{
+            .mesh = std::move(lod),
+            .screen_size = screen_size
+        });
+    }
+}
+
+int32_t Mesh::select_lod(float screen_size, int32_t current_lod) const noexcept
+{
+    const int32_t num_lods = static_cast<int32_t>(_lods.size());
+    int32_t lod = std::clamp(current_lod, 0, num_lods);
+
+    // Drop detail once clearly below the threshold of the next level, and regain it once clearly above the current one
+    while (lod < num_lods && screen_size < _lods[lod].screen_size * (1 - lod_hysteresis))
+    {
+        lod++;
+    }
+
+    while (lod > 0 && screen_size > _lods[lod - 1].screen_size * (1 + lod_hysteresis))
+    {
+        lod--;
+    }
+
+    return lod;
+}
+
+const std::vector<MeshLod>& Mesh::lods() const noexcept
+{
+    return _lods;
+}
@@ -1,23 +1,64 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <GL/glew.h>
 
-#include <memory/shared_ref.h>
+#include <memory/shared_ptr.h>
+#include <physics/aabb.h>
+#include <physics/bounding_sphere.h>
+#include <utils/sequential_id.h>
 
 #include "raw_mesh_data.h"
+#include "mesh_retention.h"
+#include "vertex_format.h"
 
 struct Archive;
 
 namespace rendering
 {
-    // TODO: generate bounds for the mesh to be used in culling
+    class CachedMesh;
+    class Mesh;
+
+    // A lower detail version of a mesh, used once the mesh covers less than screen_size of the screen's height
+    struct MeshLod
+    {
+        peng::shared_ref<const Mesh> mesh;
+        float screen_size;
+    };
+
     class Mesh
     {
     public:
-        Mesh(std::string&& name, RawMeshData&& raw_data);
-        Mesh(const std::string& name, const RawMeshData& raw_data);
-        Mesh(const std::string& name, const std::string& mesh_path);
+        Mesh(
+            std::string&& name,
+            RawMeshData&& raw_data,
+            MeshRetention retention = MeshRetention::keep,
+            VertexFormat vertex_format = VertexFormat::full
+        );
+
+        Mesh(
+            const std::string& name,
+            const RawMeshData& raw_data,
+            MeshRetention retention = MeshRetention::keep,
+            VertexFormat vertex_format = VertexFormat::full
+        );
+
+        // Builds the mesh from data it doesn't own, which is copied if it needs to be kept
+        Mesh(
+            const std::string& name,
+            const MeshDataView& data,
+            MeshRetention retention = MeshRetention::keep,
+            VertexFormat vertex_format = VertexFormat::full
+        );
+
+        // Builds the mesh from a mesh file, loaded through the MeshCache
+        Mesh(
+            const std::string& name,
+            const std::string& mesh_path,
+            MeshRetention retention = MeshRetention::keep,
+            VertexFormat vertex_format = VertexFormat::full
+        );
 
         Mesh(const Mesh&) = delete;
         Mesh(Mesh&&) = delete;
@@ -25,6 +66,14 @@ namespace rendering
 
         static peng::shared_ref<Mesh> load_asset(const Archive& archive);
 
+        // Splits load_asset so that the mesh can be imported on a background thread, see Asset<T>::load_async
+        [[nodiscard]] static CachedMesh decode_asset(const Archive& archive);
+        [[nodiscard]] static peng::shared_ref<Mesh> finalize_asset(const Archive& archive, CachedMesh&& cached_mesh);
+
+        // Replaces the mesh's data, re-uploading it into the mesh's existing buffers
+        // Levels of detail are dropped, since they were built from the old data
+        void set_data(RawMeshData&& raw_data);
+
         // Renders the mesh
         // A shader/material must already be in use before calling this
         void render() const;
@@ -34,12 +83,71 @@ namespace rendering
         void draw() const;
         void draw_instanced(int32_t num) const;
 
+        // Gets the CPU side mesh data
+        // If the data was released after upload it will be reloaded from the source file, which is expensive
+        // so callers should hold onto the result for as long as they need it rather than calling this repeatedly
+        [[nodiscard]] peng::shared_ref<const RawMeshData> load_raw_data() const;
+
         [[nodiscard]] const std::string& name() const noexcept;
+
+        // Small id unique among live meshes, used when sorting draws and reused once this mesh is destroyed
+        [[nodiscard]] uint32_t sort_id() const noexcept;
+
+        [[nodiscard]] MeshRetention retention() const noexcept;
+        [[nodiscard]] VertexFormat vertex_format() const noexcept;
+        [[nodiscard]] bool has_raw_data() const noexcept;
+        [[nodiscard]] int32_t num_vertices() const noexcept;
         [[nodiscard]] int32_t num_triangles() const noexcept;
 
+        // Local space bounds of the mesh, calculated when the mesh is built
+        [[nodiscard]] const physics::AABB& bounds() const noexcept;
+        [[nodiscard]] const physics::BoundingSphere& bounding_sphere() const noexcept;
+
+        // Uses the given meshes as levels of detail, ordered from most to least detailed
+        // Each level's screen size is scaled from full_detail_screen_size by the square root of its triangle ratio,
+        // so the triangle density on screen stays roughly the same between levels
+        void set_lods(std::vector<peng::shared_ref<const Mesh>>&& lods);
+
+        // Picks the level of detail for the mesh covering screen_size of the screen's height,
+        // where 0 is this mesh and level n is lods()[n - 1]
+        // Thresholds are widened either side of current_lod so meshes sitting near a threshold don't flicker
+        [[nodiscard]] int32_t select_lod(float screen_size, int32_t current_lod) const noexcept;
+        [[nodiscard]] const std::vector<MeshLod>& lods() const noexcept;
+
+        static constexpr float full_detail_screen_size = 0.5f;
+        static constexpr float lod_hysteresis = 0.1f;
+
     private:
+        Mesh(
+            std::string&& name,
+            const peng::shared_ref<const RawMeshData>& raw_data,
+            MeshRetention retention,
+            VertexFormat vertex_format
+        );
+
+        // raw_data is the owner of the viewed data if there is one, which is held onto instead of copying the data
+        Mesh(
+            std::string&& name,
+            const MeshDataView& data,
+            const peng::shared_ptr<const RawMeshData>& raw_data,
+            MeshRetention retention,
+            VertexFormat vertex_format
+        );
+
+        // Uploads the data into the buffers and keeps hold of raw_data if the mesh's retention asks for it
+        void upload(const MeshDataView& data, const peng::shared_ptr<const RawMeshData>& raw_data);
+
         std::string _name;
-        RawMeshData _raw_data;
+        utils::SequentialId<Mesh> _sort_id;
+        std::string _source_path;
+        MeshRetention _retention;
+        VertexFormat _vertex_format;
+        peng::shared_ptr<const RawMeshData> _raw_data;
+        physics::AABB _bounds;
+        physics::BoundingSphere _bounding_sphere;
+        std::vector<MeshLod> _lods;
+        int32_t _num_vertices;
+        int32_t _num_triangles;
         GLuint _num_indices;
 
         GLuint _ebo;
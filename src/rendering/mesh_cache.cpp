@@ -0,0 +1,319 @@
+#include "mesh_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+
+#include <core/logger.h>
+#include <profiling/scoped_event.h>
+#include <utils/cache_file.h>
+#include <utils/check.h>
+#include <utils/strtools.h>
+
+#include "mesh_decoder.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+
+using namespace rendering;
+using namespace math;
+
+namespace fs = std::filesystem;
+
+namespace
+{
+    constexpr std::array<char, 4> pmesh_magic = { 'P', 'M', 'S', 'H' };
+
+    struct FileHeader
+    {
+        std::array<char, 4> magic;
+        uint32_t version;
+        uint32_t vertex_size;
+        int32_t num_lods;
+        uint32_t num_levels;
+        uint32_t reserved;
+        uint64_t source_size;
+        int64_t source_write_time;
+    };
+
+    struct LevelHeader
+    {
+        uint64_t vertex_offset;
+        uint64_t num_vertices;
+        uint64_t triangle_offset;
+        uint64_t num_triangles;
+        Vector3f bounds_center;
+        Vector3f bounds_size;
+        Vector3f sphere_center;
+        float sphere_radius;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Vertex>);
+    static_assert(std::is_trivially_copyable_v<LevelHeader>);
+
+    [[nodiscard]] bool indices_in_range(std::span<const Vector3u> triangles, uint64_t num_vertices) noexcept
+    {
+        return std::ranges::all_of(triangles, [num_vertices](const Vector3u& triangle)
+        {
+            return triangle.x < num_vertices && triangle.y < num_vertices && triangle.z < num_vertices;
+        });
+    }
+}
+
+CachedMesh::CachedMesh(io::MappedFile&& file, std::vector<MeshDataView>&& levels)
+    : _file(std::move(file))
+    , _levels(std::move(levels))
+    , _corrupt(false)
+{ }
+
+CachedMesh::CachedMesh(std::vector<RawMeshData>&& levels)
+    : _level_data(std::move(levels))
+    , _corrupt(_level_data.empty() || _level_data.front().corrupt)
+{
+    if (!_corrupt)
+    {
+        _levels.reserve(_level_data.size());
+        for (const RawMeshData& level_data : _level_data)
+        {
+            _levels.push_back(level_data.view());
+        }
+    }
+}
+
+bool CachedMesh::corrupt() const noexcept
+{
+    return _corrupt;
+}
+
+size_t CachedMesh::num_levels() const noexcept
+{
+    return _levels.size();
+}
+
+const MeshDataView& CachedMesh::level(size_t index) const
+{
+    check(!_corrupt);
+    check(index < _levels.size());
+
+    return _levels[index];
+}
+
+CachedMesh MeshCache::load(const std::string& source_path, int32_t num_lods)
+{
+    SCOPED_EVENT("MeshCache - load", source_path.c_str());
+
+    if (const std::optional<SourceStamp> stamp = stamp_source(source_path))
+    {
+        if (std::optional<CachedMesh> cached = try_load(cache_path(source_path), *stamp, num_lods))
+        {
+            return std::move(*cached);
+        }
+    }
+
+    return import(source_path, num_lods);
+}
+
+std::string MeshCache::cache_path(const std::string& source_path)
+{
+    return io::cache_path(source_path, ".pmesh");
+}
+
+std::optional<MeshCache::SourceStamp> MeshCache::stamp_source(const std::string& source_path)
+{
+    std::error_code error;
+    const uintmax_t size = fs::file_size(source_path, error);
+    const fs::file_time_type write_time = fs::last_write_time(source_path, error);
+
+    if (error)
+    {
+        return std::nullopt;
+    }
+
+    return SourceStamp{
+        .size = static_cast<uint64_t>(size),
+        .write_time = static_cast<int64_t>(write_time.time_since_epoch().count())
+    };
+}
+
+std::optional<CachedMesh> MeshCache::try_load(const std::string& path, const SourceStamp& stamp, int32_t num_lods)
+{
+    io::MappedFile file(path);
+    if (!file.is_open() || file.size() < sizeof(FileHeader))
+    {
+        return std::nullopt;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, file.data(), sizeof(FileHeader));
+
+    const bool up_to_date = header.magic == pmesh_magic
+        && header.version == format_version
+        && header.vertex_size == sizeof(Vertex)
+        && header.source_size == stamp.size
+        && header.source_write_time == stamp.write_time
+        && (num_lods <= 0 || header.num_lods == num_lods)
+        && header.num_levels > 0
+        && io::cache_headers_in_range(sizeof(FileHeader), header.num_levels, sizeof(LevelHeader), file.size());
+
+    if (!up_to_date)
+    {
+        Logger::log("Mesh cache file '%s' is out of date", path.c_str());
+        return std::nullopt;
+    }
+
+    std::vector<MeshDataView> levels;
+    levels.reserve(header.num_levels);
+
+    for (uint32_t level = 0; level < header.num_levels; level++)
+    {
+        LevelHeader level_header;
+        std::memcpy(
+            &level_header,
+            file.data() + sizeof(FileHeader) + level * sizeof(LevelHeader),
+            sizeof(LevelHeader)
+        );
+
+        if (!io::cache_block_in_range(level_header.vertex_offset, level_header.num_vertices, sizeof(Vertex), file.size())
+            || !io::cache_block_in_range(level_header.triangle_offset, level_header.num_triangles, sizeof(Vector3u), file.size()))
+        {
+            Logger::warning("Mesh cache file '%s' is truncated", path.c_str());
+            return std::nullopt;
+        }
+
+        // The mapping is page aligned and every block is aligned within the file, so the data can be used in place
+        const std::span<const Vector3u> triangles(
+            reinterpret_cast<const Vector3u*>(file.data() + level_header.triangle_offset),
+            static_cast<size_t>(level_header.num_triangles)
+        );
+
+        // The triangles are handed straight to the GPU, so an index past the vertices must never get through
+        if (!indices_in_range(triangles, level_header.num_vertices))
+        {
+            Logger::warning("Mesh cache file '%s' has out of range indices", path.c_str());
+            return std::nullopt;
+        }
+
+        levels.push_back(MeshDataView{
+            .vertices = std::span(
+                reinterpret_cast<const Vertex*>(file.data() + level_header.vertex_offset),
+                static_cast<size_t>(level_header.num_vertices)
+            ),
+            .triangles = triangles,
+            .bounds = physics::AABB(level_header.bounds_center, level_header.bounds_size),
+            .bounding_sphere = physics::BoundingSphere(level_header.sphere_center, level_header.sphere_radius)
+        });
+    }
+
+    return CachedMesh(std::move(file), std::move(levels));
+}
+
+CachedMesh MeshCache::import(const std::string& source_path, int32_t num_lods)
+{
+    SCOPED_EVENT("MeshCache - import", source_path.c_str());
+
+    std::vector<RawMeshData> levels;
+    levels.push_back(MeshDecoder::load_file(source_path));
+
+    if (levels.front().corrupt)
+    {
+        return CachedMesh(std::move(levels));
+    }
+
+    if (num_lods > 0)
+    {
+        for (RawMeshData& lod_data : MeshSimplifier::generate_lods(levels.front(), num_lods))
+        {
+            MeshOptimizer::optimize(lod_data);
+            levels.push_back(std::move(lod_data));
+        }
+    }
+
+    // The cache is only written if the source can be stamped, otherwise it could never be validated
+    if (const std::optional<SourceStamp> stamp = stamp_source(source_path))
+    {
+        const std::string path = cache_path(source_path);
+        if (write(path, *stamp, num_lods, levels))
+        {
+            Logger::log("Wrote mesh cache file '%s'", path.c_str());
+        }
+        else
+        {
+            Logger::warning("Failed to write mesh cache file '%s'", path.c_str());
+        }
+    }
+
+    return CachedMesh(std::move(levels));
+}
+
+bool MeshCache::write(
+    const std::string& path,
+    const SourceStamp& stamp,
+    int32_t num_lods,
+    const std::vector<RawMeshData>& levels
+)
+{
+    SCOPED_EVENT("MeshCache - write", path.c_str());
+
+    const FileHeader header = {
+        .magic = pmesh_magic,
+        .version = format_version,
+        .vertex_size = sizeof(Vertex),
+        .num_lods = num_lods,
+        .num_levels = static_cast<uint32_t>(levels.size()),
+        .reserved = 0,
+        .source_size = stamp.size,
+        .source_write_time = stamp.write_time
+    };
+
+    std::vector<LevelHeader> level_headers;
+    level_headers.reserve(levels.size());
+
+    size_t offset = io::align_cache_offset(sizeof(FileHeader) + levels.size() * sizeof(LevelHeader));
+    for (const RawMeshData& level_data : levels)
+    {
+        const MeshDataView view = level_data.view();
+
+        const size_t vertex_offset = offset;
+        offset = io::align_cache_offset(vertex_offset + view.vertices.size_bytes());
+
+        const size_t triangle_offset = offset;
+        offset = io::align_cache_offset(triangle_offset + view.triangles.size_bytes());
+
+        level_headers.push_back(LevelHeader{
+            .vertex_offset = vertex_offset,
+            .num_vertices = view.vertices.size(),
+            .triangle_offset = triangle_offset,
+            .num_triangles = view.triangles.size(),
+            .bounds_center = view.bounds.center,
+            .bounds_size = view.bounds.size,
+            .sphere_center = view.bounding_sphere.center,
+            .sphere_radius = view.bounding_sphere.radius
+        });
+    }
+
+    try
+    {
+        io::CacheFileWriter writer(path);
+        if (!writer.is_open())
+        {
+            return false;
+        }
+
+        writer.write_at(0, &header, sizeof(FileHeader));
+        writer.write_at(sizeof(FileHeader), level_headers.data(), level_headers.size() * sizeof(LevelHeader));
+
+        for (size_t level = 0; level < levels.size(); level++)
+        {
+            const LevelHeader& level_header = level_headers[level];
+            writer.write_at(level_header.vertex_offset, levels[level].vertices.data(), level_header.num_vertices * sizeof(Vertex));
+            writer.write_at(level_header.triangle_offset, levels[level].triangles.data(), level_header.num_triangles * sizeof(Vector3u));
+        }
+
+        return writer.commit();
+    }
+    catch (const std::exception& e)
+    {
+        Logger::warning("Error writing mesh cache file '%s': %s", path.c_str(), e.what());
+        return false;
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <utils/mapped_file.h>
+
+#include "raw_mesh_data.h"
+
+namespace rendering
+{
+    // Imported data for a mesh file, either mapped from its cache file or freshly imported
+    // Level 0 is the full detail mesh, followed by any levels of detail in order of decreasing detail
+    // Views into the data are only valid for as long as the CachedMesh is alive
+    class CachedMesh
+    {
+    public:
+        explicit CachedMesh(io::MappedFile&& file, std::vector<MeshDataView>&& levels);
+        explicit CachedMesh(std::vector<RawMeshData>&& levels);
+
+        CachedMesh(const CachedMesh&) = delete;
+        CachedMesh(CachedMesh&&) = default;
+
+        [[nodiscard]] bool corrupt() const noexcept;
+        [[nodiscard]] size_t num_levels() const noexcept;
+        [[nodiscard]] const MeshDataView& level(size_t index) const;
+
+    private:
+        io::MappedFile _file;
+        std::vector<RawMeshData> _level_data;
+        std::vector<MeshDataView> _levels;
+        bool _corrupt;
+    };
+
+    // Binary cache of imported meshes, so mesh files are only decoded and optimized the first time they're loaded
+    // Each .pmesh file holds the final vertex and triangle data of every level of detail, laid out so that it can be
+    // memory mapped and handed straight to the GPU upload without any parsing
+    // Cache files are rebuilt whenever their source file's size or modification time changes, or the format changes
+    class MeshCache
+    {
+    public:
+        // Bumped whenever the file layout or the import process changes, invalidating every existing cache file
+        static constexpr uint32_t format_version = 1;
+
+        // Gets the imported data for a mesh file, importing and caching it first if needed
+        // If num_lods is above 0 the data will include that many levels of detail, or fewer if the mesh can't be
+        // simplified that far, otherwise the data may or may not include levels of detail
+        [[nodiscard]] static CachedMesh load(const std::string& source_path, int32_t num_lods = 0);
+
+        [[nodiscard]] static std::string cache_path(const std::string& source_path);
+
+    private:
+        // Size and modification time of the source file, a cache file is only valid while these match
+        struct SourceStamp
+        {
+            uint64_t size;
+            int64_t write_time;
+        };
+
+        [[nodiscard]] static std::optional<SourceStamp> stamp_source(const std::string& source_path);
+
+        [[nodiscard]] static std::optional<CachedMesh> try_load(
+            const std::string& path,
+            const SourceStamp& stamp,
+            int32_t num_lods
+        );
+
+        [[nodiscard]] static CachedMesh import(const std::string& source_path, int32_t num_lods);
+
+        static bool write(
+            const std::string& path,
+            const SourceStamp& stamp,
+            int32_t num_lods,
+            const std::vector<RawMeshData>& levels
+        );
+    };
+}
@@ -1,10 +1,22 @@
 #include "mesh_decoder.h"
 
-#include <fstream>
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <execution>
 #include <filesystem>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <tuple>
 
 #include <core/logger.h>
 #include <profiling/scoped_event.h>
+#include <utils/flat_hash_map.h>
+#include <utils/hash_helpers.h>
+#include <utils/mapped_file.h>
+
+#include "mesh_optimizer.h"
 
 using namespace rendering;
 using namespace math;
@@ -23,6 +35,275 @@ using namespace math;
     } do {} while (0)
 // DECODE_CHECK end
 
+namespace
+{
+    constexpr uint32_t no_obj_index = std::numeric_limits<uint32_t>::max();
+
+    // Lines are parsed in parallel in chunks of this many
+    constexpr size_t obj_chunk_size = 16 * 1024;
+
+    // Position, tex coord and normal indices of a face vertex, with no_obj_index for a missing tex coord or normal
+    using ObjVertexKey = std::tuple<uint32_t, uint32_t, uint32_t>;
+
+    struct ObjLine
+    {
+        std::string_view line;
+
+        // Everything after the keyword
+        std::string_view args;
+
+        int32_t line_number;
+    };
+
+    // Up to N numbers read from a line, missing trailing numbers are 0
+    template <size_t N>
+    struct ObjNumbers
+    {
+        std::array<float, N> values;
+        size_t count;
+    };
+
+    [[nodiscard]] bool is_obj_space(char c) noexcept
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    // Takes the next whitespace separated token from the front of text
+    // Returns an empty token once text runs out or a comment is reached
+    [[nodiscard]] std::string_view next_token(std::string_view& text) noexcept
+    {
+        size_t begin = 0;
+        while (begin < text.size() && is_obj_space(text[begin]))
+        {
+            begin++;
+        }
+
+        if (begin == text.size() || text[begin] == '#')
+        {
+            text = std::string_view();
+            return std::string_view();
+        }
+
+        size_t end = begin;
+        while (end < text.size() && !is_obj_space(text[end]))
+        {
+            end++;
+        }
+
+        const std::string_view token = text.substr(begin, end - begin);
+        text.remove_prefix(end);
+
+        return token;
+    }
+
+    template <typename T>
+    [[nodiscard]] bool parse_number(std::string_view token, T& value) noexcept
+    {
+        // from_chars doesn't accept an explicit positive sign
+        if (!token.empty() && token.front() == '+')
+        {
+            token.remove_prefix(1);
+        }
+
+        const char* const last = token.data() + token.size();
+        const auto [ptr, error] = std::from_chars(token.data(), last, value);
+
+        return error == std::errc() && ptr == last;
+    }
+
+    template <size_t N>
+    [[nodiscard]] bool parse_numbers(std::string_view args, size_t min_count, ObjNumbers<N>& numbers) noexcept
+    {
+        numbers.values.fill(0);
+        numbers.count = 0;
+
+        for (std::string_view token = next_token(args); !token.empty(); token = next_token(args))
+        {
+            if (numbers.count == N || !parse_number(token, numbers.values[numbers.count]))
+            {
+                return false;
+            }
+
+            numbers.count++;
+        }
+
+        return numbers.count >= min_count;
+    }
+
+    // Parses the numbers of every line in parallel chunks
+    // Returns the first invalid line, or nullptr if every line was valid
+    template <size_t N>
+    [[nodiscard]] const ObjLine* parse_number_lines(
+        const std::vector<ObjLine>& lines,
+        size_t min_count,
+        std::vector<ObjNumbers<N>>& numbers_out
+    )
+    {
+        struct Chunk
+        {
+            size_t begin;
+            size_t end;
+            const ObjLine* invalid_line;
+        };
+
+        numbers_out.resize(lines.size());
+
+        std::vector<Chunk> chunks;
+        for (size_t begin = 0; begin < lines.size(); begin += obj_chunk_size)
+        {
+            chunks.push_back(Chunk{
+                .begin = begin,
+                .end = std::min(begin + obj_chunk_size, lines.size()),
+                .invalid_line = nullptr
+            });
+        }
+
+        std::for_each(std::execution::par, chunks.begin(), chunks.end(), [&](Chunk& chunk)
+        {
+            for (size_t i = chunk.begin; i < chunk.end; i++)
+            {
+                if (!parse_numbers(lines[i].args, min_count, numbers_out[i]))
+                {
+                    chunk.invalid_line = &lines[i];
+                    break;
+                }
+            }
+        });
+
+        for (const Chunk& chunk : chunks)
+        {
+            if (chunk.invalid_line)
+            {
+                return chunk.invalid_line;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Converts a 1 based index, or a negative index relative to the end, to a 0 based index
+    [[nodiscard]] std::optional<uint32_t> parse_obj_index(std::string_view token, size_t count) noexcept
+    {
+        int64_t index;
+        if (!parse_number(token, index))
+        {
+            return std::nullopt;
+        }
+
+        if (index < 0)
+        {
+            index += static_cast<int64_t>(count);
+        }
+        else
+        {
+            index--;
+        }
+
+        if (index < 0 || index >= static_cast<int64_t>(count))
+        {
+            return std::nullopt;
+        }
+
+        return static_cast<uint32_t>(index);
+    }
+
+    // Parses a face vertex in the v, v/vt, v//vn or v/vt/vn format
+    [[nodiscard]] std::optional<ObjVertexKey> parse_vertex_key(
+        std::string_view token,
+        size_t num_positions,
+        size_t num_tex_coords,
+        size_t num_normals
+    ) noexcept
+    {
+        std::array<std::string_view, 3> parts;
+        size_t num_parts = 0;
+
+        while (true)
+        {
+            if (num_parts == parts.size())
+            {
+                return std::nullopt;
+            }
+
+            const size_t slash = token.find('/');
+            parts[num_parts++] = token.substr(0, slash);
+            if (slash == std::string_view::npos)
+            {
+                break;
+            }
+
+            token.remove_prefix(slash + 1);
+        }
+
+        const std::optional<uint32_t> position_index = parse_obj_index(parts[0], num_positions);
+        if (!position_index)
+        {
+            return std::nullopt;
+        }
+
+        uint32_t tex_coord_index = no_obj_index;
+        if (num_parts > 1 && !parts[1].empty())
+        {
+            const std::optional<uint32_t> index = parse_obj_index(parts[1], num_tex_coords);
+            if (!index)
+            {
+                return std::nullopt;
+            }
+
+            tex_coord_index = *index;
+        }
+
+        uint32_t normal_index = no_obj_index;
+        if (num_parts > 2)
+        {
+            const std::optional<uint32_t> index = parse_obj_index(parts[2], num_normals);
+            if (!index)
+            {
+                return std::nullopt;
+            }
+
+            normal_index = *index;
+        }
+
+        return ObjVertexKey(*position_index, tex_coord_index, normal_index);
+    }
+
+    // Gives each of the listed vertices the area weighted average normal of the triangles using it
+    void generate_normals(RawMeshData& raw_data, const std::vector<uint32_t>& vertices)
+    {
+        std::vector<bool> needs_normal(raw_data.vertices.size(), false);
+        for (const uint32_t vertex : vertices)
+        {
+            needs_normal[vertex] = true;
+        }
+
+        for (const Vector3u& triangle : raw_data.triangles)
+        {
+            const Vector3f& p0 = raw_data.vertices[triangle.x].position;
+            const Vector3f face_normal = Vector3f::cross(
+                raw_data.vertices[triangle.y].position - p0,
+                raw_data.vertices[triangle.z].position - p0
+            );
+
+            for (const uint32_t vertex : { triangle.x, triangle.y, triangle.z })
+            {
+                if (needs_normal[vertex])
+                {
+                    raw_data.vertices[vertex].normal += face_normal;
+                }
+            }
+        }
+
+        for (const uint32_t vertex : vertices)
+        {
+            Vector3f& normal = raw_data.vertices[vertex].normal;
+            normal = normal.magnitude_sqr() > 0
+                ? normal.normalized()
+                : Vector3f::up();
+        }
+    }
+}
+
 RawMeshData MeshDecoder::load_file(const std::string& path)
 {
     SCOPED_EVENT("MeshDecoder - loading mesh file", path.c_str());
@@ -33,7 +314,13 @@ RawMeshData MeshDecoder::load_file(const std::string& path)
 
     if (ext == ".obj")
     {
-        return load_obj(path);
+        RawMeshData raw_data = load_obj(path);
+        if (!raw_data.corrupt)
+        {
+            optimize(raw_data, path);
+        }
+
+        return raw_data;
     }
 
     DECODE_ERROR(
@@ -46,148 +333,233 @@ RawMeshData MeshDecoder::load_obj(const std::string& path)
 {
     SCOPED_EVENT("MeshDecoder - loading OBJ file");
 
-    std::ifstream file(path);
-    DECODE_CHECK(file.is_open(), "Cannot open file %s", path.c_str());
+    const io::MappedFile file(path);
+    if (!file.is_open())
+    {
+        // Empty files can't be mapped, but are still valid OBJ files that just don't have any faces
+        namespace fs = std::filesystem;
+        std::error_code error;
 
-    std::string line;
-    int32_t line_number = 0;
-    std::vector<Vector3f> vertex_positions;
-    std::vector<Vector3f> vertex_normals;
-    std::vector<Vector2f> uv_coords;
-    std::unordered_map<std::string, uint32_t> vertex_cache;
+        DECODE_CHECK(fs::is_regular_file(path, error) && fs::file_size(path, error) == 0 && !error,
+            "Cannot open file %s", path.c_str()
+        );
 
-    RawMeshData raw_data;
+        return RawMeshData();
+    }
 
-    while (std::getline(file, line))
-    {
-        line_number++;
+    const std::string_view contents(reinterpret_cast<const char*>(file.data()), file.size());
 
-        static thread_local std::vector<std::string> tokens;
-        tokens.clear();
-        strtools::split(line, ' ', std::back_inserter(tokens));
+    // Sort the lines by their keyword first, so each kind can be parsed separately
+    std::vector<ObjLine> position_lines;
+    std::vector<ObjLine> normal_lines;
+    std::vector<ObjLine> tex_coord_lines;
+    std::vector<ObjLine> face_lines;
 
-        // Skip empty lines
-        if (tokens.empty())
+    {
+        SCOPED_EVENT("MeshDecoder - splitting OBJ lines");
+
+        int32_t line_number = 0;
+        for (size_t line_start = 0; line_start < contents.size();)
         {
-            continue;
+            line_number++;
+
+            size_t line_end = contents.find('\n', line_start);
+            if (line_end == std::string_view::npos)
+            {
+                line_end = contents.size();
+            }
+
+            std::string_view line = contents.substr(line_start, line_end - line_start);
+            line_start = line_end + 1;
+
+            std::string_view args = line;
+            const std::string_view keyword = next_token(args);
+
+            if (keyword == "v")
+            {
+                position_lines.push_back(ObjLine{ .line = line, .args = args, .line_number = line_number });
+            }
+            else if (keyword == "vn")
+            {
+                normal_lines.push_back(ObjLine{ .line = line, .args = args, .line_number = line_number });
+            }
+            else if (keyword == "vt")
+            {
+                tex_coord_lines.push_back(ObjLine{ .line = line, .args = args, .line_number = line_number });
+            }
+            else if (keyword == "f")
+            {
+                face_lines.push_back(ObjLine{ .line = line, .args = args, .line_number = line_number });
+            }
         }
+    }
+
+    std::vector<ObjNumbers<6>> positions;
+    std::vector<ObjNumbers<3>> normals;
+    std::vector<ObjNumbers<3>> tex_coords;
 
-        // Vertex positions
-        if (tokens[0] == "v")
+    {
+        SCOPED_EVENT("MeshDecoder - parsing OBJ vertex data");
+
+        // Positions may have a w component, or an rgb color in place of it
+        if (const ObjLine* invalid_line = parse_number_lines(position_lines, 3, positions))
         {
-            DECODE_CHECK(tokens.size() == 4,
+            DECODE_ERROR(
                 "Invalid OBJ file - invalid vertex\n%d: %s",
-                line_number, line.c_str()
-            );
-
-            vertex_positions.emplace_back(
-                std::stof(tokens[1]),
-                std::stof(tokens[2]),
-                std::stof(tokens[3])
+                invalid_line->line_number, std::string(invalid_line->line).c_str()
             );
         }
 
-        // Vertex normals
-        if (tokens[0] == "vn")
+        if (const ObjLine* invalid_line = parse_number_lines(normal_lines, 3, normals))
         {
-            DECODE_CHECK(tokens.size() == 4,
+            DECODE_ERROR(
                 "Invalid OBJ file - invalid vertex normal\n%d: %s",
-                line_number, line.c_str()
-            );
-
-            vertex_normals.emplace_back(
-                std::stof(tokens[1]),
-                std::stof(tokens[2]),
-                std::stof(tokens[3])
+                invalid_line->line_number, std::string(invalid_line->line).c_str()
             );
         }
 
-        // UV coords
-        if (tokens[0] == "vt")
+        if (const ObjLine* invalid_line = parse_number_lines(tex_coord_lines, 1, tex_coords))
         {
-            DECODE_CHECK(tokens.size() == 3,
+            DECODE_ERROR(
                 "Invalid OBJ file - invalid UV coord\n%d: %s",
-                line_number, line.c_str()
+                invalid_line->line_number, std::string(invalid_line->line).c_str()
             );
+        }
+    }
 
-            uv_coords.emplace_back(
-                std::stof(tokens[1]),
-                std::stof(tokens[2])
-            );
+    SCOPED_EVENT("MeshDecoder - building OBJ faces");
+
+    RawMeshData raw_data;
+    raw_data.vertices.reserve(positions.size());
+    raw_data.triangles.reserve(face_lines.size());
+
+    // Vertices are shared between faces when they use the same position, tex coord and normal indices
+    // Most positions are only ever used with one tex coord and normal, so the first vertex made from each position
+    // is checked before falling back to looking up the full set of indices in the vertex cache
+    struct PositionVertex
+    {
+        uint32_t vertex = no_obj_index;
+        uint32_t tex_coord = no_obj_index;
+        uint32_t normal = no_obj_index;
+    };
+
+    std::vector<PositionVertex> position_vertices(positions.size());
+    utils::flat_hash_map<ObjVertexKey, uint32_t> vertex_cache;
+
+    // Vertices without a normal are given the area weighted average normal of the faces using them
+    std::vector<uint32_t> missing_normals;
+    std::vector<uint32_t> polygon;
+
+    const auto add_vertex = [&](const ObjVertexKey& key)
+    {
+        const auto [position_index, tex_coord_index, normal_index] = key;
+        const ObjNumbers<6>& position = positions[position_index];
+        const uint32_t vertex_index = static_cast<uint32_t>(raw_data.vertices.size());
+
+        Vertex& vertex = raw_data.vertices.emplace_back(
+            Vector3f(position.values[0], position.values[1], position.values[2]),
+            Vector3f::zero(),
+            Vector2f::zero(),
+            Vector3f::zero()
+        );
+
+        if (position.count == 6)
+        {
+            vertex.color = Vector3f(position.values[3], position.values[4], position.values[5]);
+        }
+
+        if (tex_coord_index != no_obj_index)
+        {
+            const ObjNumbers<3>& tex_coord = tex_coords[tex_coord_index];
+            vertex.tex_coord = Vector2f(tex_coord.values[0], tex_coord.values[1]);
         }
 
-        // Faces
-        if (tokens[0] == "f")
+        if (normal_index != no_obj_index)
+        {
+            const ObjNumbers<3>& normal = normals[normal_index];
+            vertex.normal = Vector3f(normal.values[0], normal.values[1], normal.values[2]);
+        }
+        else
         {
-            DECODE_CHECK(tokens.size() == 4,
-                "Invalid OBJ file - non triangular face enountered which is not supported\n%d: %s",
-                line_number, line.c_str()
+            missing_normals.push_back(vertex_index);
+        }
+
+        return vertex_index;
+    };
+
+    for (const ObjLine& face_line : face_lines)
+    {
+        polygon.clear();
+
+        std::string_view args = face_line.args;
+        for (std::string_view vertex_token = next_token(args); !vertex_token.empty(); vertex_token = next_token(args))
+        {
+            const std::optional<ObjVertexKey> key = parse_vertex_key(
+                vertex_token, positions.size(), tex_coords.size(), normals.size()
             );
 
-            uint32_t triangle[3];
-            for (uint8_t i = 0; i < 3; i++)
+            DECODE_CHECK(key,
+                "Invalid OBJ file - vertex '%s' is not a valid v, v/vt, v//vn or v/vt/vn vertex\n%d: %s",
+                std::string(vertex_token).c_str(), face_line.line_number, std::string(face_line.line).c_str()
+            );
+
+            const auto [position_index, tex_coord_index, normal_index] = *key;
+            PositionVertex& position_vertex = position_vertices[position_index];
+
+            if (position_vertex.vertex == no_obj_index)
             {
-                const std::string& vertex_token = tokens[1 + i];
-                uint32_t vertex_index;
+                position_vertex = PositionVertex{
+                    .vertex = add_vertex(*key),
+                    .tex_coord = tex_coord_index,
+                    .normal = normal_index
+                };
 
-                if (const auto it = vertex_cache.find(vertex_token); it != vertex_cache.end())
-                {
-                    vertex_index = it->second;
-                }
-                else
+                polygon.push_back(position_vertex.vertex);
+            }
+            else if (position_vertex.tex_coord == tex_coord_index && position_vertex.normal == normal_index)
+            {
+                polygon.push_back(position_vertex.vertex);
+            }
+            else
+            {
+                const auto [it, inserted] = vertex_cache.try_emplace(*key, static_cast<uint32_t>(raw_data.vertices.size()));
+                if (inserted)
                 {
-                    // Decode token
-                    static thread_local std::vector<std::string> inner_tokens;
-                    inner_tokens.clear();
-                    strtools::split(vertex_token, '/', std::back_inserter(inner_tokens));
-
-                    DECODE_CHECK(inner_tokens.size() == 3,
-                        "Invalid OBJ file - vertex '%s' does not use the v/vt/vn format\n%d: %s",
-                        line_number, vertex_token.c_str(), line.c_str()
-                    );
-
-                    // OBJ files use 1 indexing instead of 0 indexing
-                    const uint32_t position_index = std::stoi(inner_tokens[0]);
-                    const uint32_t tex_coord_index = std::stoi(inner_tokens[1]);
-                    const uint32_t normal_index = std::stoi(inner_tokens[2]);
-
-                    DECODE_CHECK(position_index <= vertex_positions.size(),
-                        "Invalid OBJ file - vertex '%s' has invalid position index %d\n%d: %s",
-                        vertex_token.c_str(), position_index, line_number, line.c_str()
-                    );
-
-                    DECODE_CHECK(tex_coord_index <= uv_coords.size(),
-                        "Invalid OBJ file - vertex '%s' has invalid tex coord index %d\n%d: %s",
-                        vertex_token.c_str(), tex_coord_index, line_number, line.c_str()
-                    );
-
-                    DECODE_CHECK(normal_index <= vertex_normals.size(),
-                        "Invalid OBJ file - vertex '%s' has invalid normal index %d\n%d: %s",
-                        vertex_token.c_str(), normal_index, line_number, line.c_str()
-                    );
-
-                    const Vertex vertex(
-                        vertex_positions[position_index - 1],
-                        vertex_normals[normal_index - 1],
-                        uv_coords[tex_coord_index - 1]
-                    );
-
-                    vertex_index = static_cast<uint32_t>(raw_data.vertices.size());
-                    vertex_cache[vertex_token] = vertex_index;
-
-                    raw_data.vertices.push_back(vertex);
+                    add_vertex(*key);
                 }
 
-                triangle[i] = vertex_index;
+                polygon.push_back(it->second);
             }
+        }
 
-            raw_data.triangles.emplace_back(
-                triangle[0],
-                triangle[1],
-                triangle[2]
-            );
+        DECODE_CHECK(polygon.size() >= 3,
+            "Invalid OBJ file - face has fewer than 3 vertices\n%d: %s",
+            face_line.line_number, std::string(face_line.line).c_str()
+        );
+
+        // Polygons are assumed to be convex and are triangulated as a fan around their first vertex
+        for (size_t i = 2; i < polygon.size(); i++)
+        {
+            raw_data.triangles.emplace_back(polygon[0], polygon[i - 1], polygon[i]);
         }
     }
 
+    if (!missing_normals.empty())
+    {
+        generate_normals(raw_data, missing_normals);
+    }
+
     return raw_data;
 }
+
+void MeshDecoder::optimize(RawMeshData& raw_data, const std::string& path)
+{
+    const VertexCacheStats stats_before = MeshOptimizer::analyze_vertex_cache(raw_data);
+    MeshOptimizer::optimize(raw_data);
+    const VertexCacheStats stats_after = MeshOptimizer::analyze_vertex_cache(raw_data);
+
+    Logger::log(
+        "Optimized mesh file '%s': ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+        path.c_str(), stats_before.acmr, stats_after.acmr, stats_before.atvr, stats_after.atvr
+    );
+}
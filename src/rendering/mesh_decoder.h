@@ -11,7 +11,12 @@ namespace rendering
     public:
         static RawMeshData load_file(const std::string& path);
 
-    private:
+        // Decodes an OBJ file as it is, without the optimization load_file applies
         static RawMeshData load_obj(const std::string& path);
+
+    private:
+
+        // Reorders freshly imported data for the GPU and reports the vertex cache improvement
+        static void optimize(RawMeshData& raw_data, const std::string& path);
     };
 }
\ No newline at end of file
@@ -0,0 +1,468 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#include <profiling/scoped_event.h>
+
+using namespace rendering;
+using namespace math;
+
+namespace
+{
+    constexpr uint32_t no_index = std::numeric_limits<uint32_t>::max();
+
+    // Tuning values from Forsyth's paper, the cache size here only shapes the scoring curve
+    constexpr int32_t forsyth_cache_size = 32;
+    constexpr float cache_decay_power = 1.5f;
+    constexpr float last_triangle_score = 0.75f;
+    constexpr float valence_boost_scale = 2.0f;
+    constexpr float valence_boost_power = 0.5f;
+
+    [[nodiscard]] std::array<uint32_t, 3> corners(const Vector3u& triangle) noexcept
+    {
+        return { triangle.x, triangle.y, triangle.z };
+    }
+
+    [[nodiscard]] float dot(const Vector3f& a, const Vector3f& b) noexcept
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    // Vertices recently used are favoured so they're reused before being evicted, except for the last triangle's
+    // which are slightly penalised to avoid strips. Vertices with few remaining triangles are favoured so they're
+    // finished off rather than left behind to be transformed again later
+    [[nodiscard]] float vertex_score(int32_t cache_position, uint32_t remaining_triangles) noexcept
+    {
+        if (remaining_triangles == 0)
+        {
+            return -1;
+        }
+
+        float score = 0;
+        if (cache_position >= 0)
+        {
+            if (cache_position < 3)
+            {
+                score = last_triangle_score;
+            }
+            else
+            {
+                const float scaler = 1.0f / (forsyth_cache_size - 3);
+                score = std::pow(1.0f - static_cast<float>(cache_position - 3) * scaler, cache_decay_power);
+            }
+        }
+
+        score += valence_boost_scale * std::pow(static_cast<float>(remaining_triangles), -valence_boost_power);
+        return score;
+    }
+
+    // Simulates a FIFO post transform cache, where hits don't refresh a vertex's place in the queue
+    // Each vertex remembers when it was inserted, counted in cache misses, so lookups and evictions are free
+    class FifoCache
+    {
+    public:
+        FifoCache(size_t num_vertices, int32_t cache_size)
+            : _insert_time(num_vertices, 0)
+            , _time(static_cast<uint64_t>(cache_size) + 1)
+            , _cache_size(static_cast<uint64_t>(cache_size))
+        { }
+
+        // Returns whether the vertex missed the cache
+        bool touch(uint32_t vertex) noexcept
+        {
+            if (_time - _insert_time[vertex] <= _cache_size)
+            {
+                return false;
+            }
+
+            _insert_time[vertex] = _time++;
+            return true;
+        }
+
+        int32_t touch(const Vector3u& triangle) noexcept
+        {
+            return touch(triangle.x) + touch(triangle.y) + touch(triangle.z);
+        }
+
+        // Evicts everything
+        void reset() noexcept
+        {
+            _time += _cache_size + 1;
+        }
+
+    private:
+        std::vector<uint64_t> _insert_time;
+        uint64_t _time;
+        uint64_t _cache_size;
+    };
+}
+
+void MeshOptimizer::optimize(RawMeshData& raw_data)
+{
+    SCOPED_EVENT("MeshOptimizer - optimize");
+
+    optimize_vertex_cache(raw_data);
+    optimize_overdraw(raw_data);
+    optimize_vertex_fetch(raw_data);
+}
+
+void MeshOptimizer::optimize_vertex_cache(RawMeshData& raw_data)
+{
+    SCOPED_EVENT("MeshOptimizer - optimize vertex cache");
+
+    const size_t num_vertices = raw_data.vertices.size();
+    const size_t num_triangles = raw_data.triangles.size();
+
+    if (num_triangles == 0)
+    {
+        return;
+    }
+
+    // Triangles using each vertex, stored contiguously per vertex
+    // The first remaining[v] entries of a vertex's range are the triangles not yet emitted
+    std::vector<uint32_t> adjacency_offsets(num_vertices + 1, 0);
+    std::vector<uint32_t> remaining(num_vertices, 0);
+
+    for (const Vector3u& triangle : raw_data.triangles)
+    {
+        for (const uint32_t vertex : corners(triangle))
+        {
+            remaining[vertex]++;
+        }
+    }
+
+    for (size_t vertex = 0; vertex < num_vertices; vertex++)
+    {
+        adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + remaining[vertex];
+    }
+
+    std::vector<uint32_t> adjacency(num_triangles * 3);
+    std::vector<uint32_t> adjacency_cursor(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+
+    for (size_t triangle = 0; triangle < num_triangles; triangle++)
+    {
+        for (const uint32_t vertex : corners(raw_data.triangles[triangle]))
+        {
+            adjacency[adjacency_cursor[vertex]++] = static_cast<uint32_t>(triangle);
+        }
+    }
+
+    std::vector<int32_t> cache_position(num_vertices, -1);
+    std::vector<float> vertex_scores(num_vertices);
+    std::vector<float> triangle_scores(num_triangles);
+    std::vector<bool> emitted(num_triangles, false);
+
+    for (size_t vertex = 0; vertex < num_vertices; vertex++)
+    {
+        vertex_scores[vertex] = vertex_score(-1, remaining[vertex]);
+    }
+
+    const auto score_triangle = [&](uint32_t triangle)
+    {
+        const Vector3u& corner = raw_data.triangles[triangle];
+        return vertex_scores[corner.x] + vertex_scores[corner.y] + vertex_scores[corner.z];
+    };
+
+    uint32_t best_triangle = 0;
+    for (uint32_t triangle = 0; triangle < num_triangles; triangle++)
+    {
+        triangle_scores[triangle] = score_triangle(triangle);
+        if (triangle_scores[triangle] > triangle_scores[best_triangle])
+        {
+            best_triangle = triangle;
+        }
+    }
+
+    std::vector<Vector3u> optimized_triangles;
+    optimized_triangles.reserve(num_triangles);
+
+    std::vector<uint32_t> cache;
+    std::vector<uint32_t> new_cache;
+    cache.reserve(forsyth_cache_size + 3);
+    new_cache.reserve(forsyth_cache_size + 3);
+
+    size_t next_unemitted = 0;
+
+    while (optimized_triangles.size() < num_triangles)
+    {
+        // Nothing in the cache has triangles left, so restart from the next triangle in the original order
+        if (best_triangle == no_index)
+        {
+            while (emitted[next_unemitted])
+            {
+                next_unemitted++;
+            }
+
+            best_triangle = static_cast<uint32_t>(next_unemitted);
+        }
+
+        const Vector3u triangle = raw_data.triangles[best_triangle];
+        optimized_triangles.push_back(triangle);
+        emitted[best_triangle] = true;
+
+        new_cache.clear();
+        for (const uint32_t vertex : corners(triangle))
+        {
+            const auto first = adjacency.begin() + adjacency_offsets[vertex];
+            const auto last = first + remaining[vertex];
+
+            std::iter_swap(std::find(first, last, best_triangle), last - 1);
+            remaining[vertex]--;
+
+            if (std::find(new_cache.begin(), new_cache.end(), vertex) == new_cache.end())
+            {
+                new_cache.push_back(vertex);
+            }
+        }
+
+        for (const uint32_t vertex : cache)
+        {
+            if (std::find(new_cache.begin(), new_cache.end(), vertex) == new_cache.end())
+            {
+                new_cache.push_back(vertex);
+            }
+        }
+
+        // Vertices pushed past the end of the cache are rescored as evicted before being dropped
+        for (size_t i = 0; i < new_cache.size(); i++)
+        {
+            const uint32_t vertex = new_cache[i];
+            cache_position[vertex] = i < forsyth_cache_size ? static_cast<int32_t>(i) : -1;
+            vertex_scores[vertex] = vertex_score(cache_position[vertex], remaining[vertex]);
+        }
+
+        best_triangle = no_index;
+        float best_score = -std::numeric_limits<float>::max();
+
+        for (const uint32_t vertex : new_cache)
+        {
+            const uint32_t adjacency_begin = adjacency_offsets[vertex];
+            for (uint32_t i = adjacency_begin; i < adjacency_begin + remaining[vertex]; i++)
+            {
+                const uint32_t adjacent_triangle = adjacency[i];
+                triangle_scores[adjacent_triangle] = score_triangle(adjacent_triangle);
+
+                if (triangle_scores[adjacent_triangle] > best_score)
+                {
+                    best_triangle = adjacent_triangle;
+                    best_score = triangle_scores[adjacent_triangle];
+                }
+            }
+        }
+
+        if (new_cache.size() > forsyth_cache_size)
+        {
+            new_cache.resize(forsyth_cache_size);
+        }
+
+        std::swap(cache, new_cache);
+    }
+
+    raw_data.triangles = std::move(optimized_triangles);
+}
+
+void MeshOptimizer::optimize_overdraw(RawMeshData& raw_data, float threshold)
+{
+    SCOPED_EVENT("MeshOptimizer - optimize overdraw");
+
+    const size_t num_triangles = raw_data.triangles.size();
+    if (num_triangles < 2)
+    {
+        return;
+    }
+
+    FifoCache cache(raw_data.vertices.size(), simulated_cache_size);
+
+    // Hard boundaries are where every vertex of a triangle misses, so the cache was effectively cold already
+    std::vector<size_t> hard_boundaries = { 0 };
+    for (size_t triangle = 0; triangle < num_triangles; triangle++)
+    {
+        if (cache.touch(raw_data.triangles[triangle]) == 3 && triangle > 0)
+        {
+            hard_boundaries.push_back(triangle);
+        }
+    }
+
+    hard_boundaries.push_back(num_triangles);
+
+    // Split further wherever the triangles so far would stay close to their original ACMR if drawn with a cold cache
+    std::vector<size_t> cluster_boundaries;
+    for (size_t hard_cluster = 0; hard_cluster + 1 < hard_boundaries.size(); hard_cluster++)
+    {
+        const size_t begin = hard_boundaries[hard_cluster];
+        const size_t end = hard_boundaries[hard_cluster + 1];
+
+        int32_t cluster_misses = 0;
+        cache.reset();
+
+        for (size_t triangle = begin; triangle < end; triangle++)
+        {
+            cluster_misses += cache.touch(raw_data.triangles[triangle]);
+        }
+
+        const float max_acmr = threshold * static_cast<float>(cluster_misses) / static_cast<float>(end - begin);
+
+        size_t soft_begin = begin;
+        int32_t soft_misses = 0;
+
+        cluster_boundaries.push_back(begin);
+        cache.reset();
+
+        for (size_t triangle = begin; triangle < end; triangle++)
+        {
+            soft_misses += cache.touch(raw_data.triangles[triangle]);
+
+            const float soft_acmr = static_cast<float>(soft_misses) / static_cast<float>(triangle + 1 - soft_begin);
+            if (triangle + 1 < end && soft_acmr <= max_acmr)
+            {
+                soft_begin = triangle + 1;
+                soft_misses = 0;
+
+                cluster_boundaries.push_back(soft_begin);
+                cache.reset();
+            }
+        }
+    }
+
+    cluster_boundaries.push_back(num_triangles);
+
+    // Clusters further from the center in the direction they face are more likely to be in front, so draw them first
+    struct Cluster
+    {
+        size_t begin;
+        size_t end;
+        float sort_key;
+    };
+
+    const auto triangle_geometry = [&](const Vector3u& triangle)
+    {
+        const Vector3f& p0 = raw_data.vertices[triangle.x].position;
+        const Vector3f& p1 = raw_data.vertices[triangle.y].position;
+        const Vector3f& p2 = raw_data.vertices[triangle.z].position;
+
+        // The cross product's magnitude is twice the area, which is fine as every weight is scaled the same
+        const Vector3f normal = Vector3f::cross(p1 - p0, p2 - p0);
+        return std::make_pair((p0 + p1 + p2) / 3, normal);
+    };
+
+    Vector3f mesh_centroid = Vector3f::zero();
+    float mesh_area = 0;
+
+    for (const Vector3u& triangle : raw_data.triangles)
+    {
+        const auto [centroid, normal] = triangle_geometry(triangle);
+        const float area = normal.magnitude();
+
+        mesh_centroid += centroid * area;
+        mesh_area += area;
+    }
+
+    if (mesh_area > 0)
+    {
+        mesh_centroid /= mesh_area;
+    }
+
+    std::vector<Cluster> clusters;
+    clusters.reserve(cluster_boundaries.size() - 1);
+
+    for (size_t cluster = 0; cluster + 1 < cluster_boundaries.size(); cluster++)
+    {
+        const size_t begin = cluster_boundaries[cluster];
+        const size_t end = cluster_boundaries[cluster + 1];
+
+        Vector3f cluster_centroid = Vector3f::zero();
+        Vector3f cluster_normal = Vector3f::zero();
+        float cluster_area = 0;
+
+        for (size_t triangle = begin; triangle < end; triangle++)
+        {
+            const auto [centroid, normal] = triangle_geometry(raw_data.triangles[triangle]);
+            const float area = normal.magnitude();
+
+            cluster_centroid += centroid * area;
+            cluster_normal += normal;
+            cluster_area += area;
+        }
+
+        float sort_key = 0;
+        if (cluster_area > 0 && cluster_normal.magnitude_sqr() > 0)
+        {
+            cluster_centroid /= cluster_area;
+            sort_key = dot(cluster_centroid - mesh_centroid, cluster_normal.normalized());
+        }
+
+        clusters.push_back(Cluster{
+            .begin = begin,
+            .end = end,
+            .sort_key = sort_key
+        });
+    }
+
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& lhs, const Cluster& rhs)
+    {
+        return lhs.sort_key > rhs.sort_key;
+    });
+
+    std::vector<Vector3u> sorted_triangles;
+    sorted_triangles.reserve(num_triangles);
+
+    for (const Cluster& cluster : clusters)
+    {
+        sorted_triangles.insert(
+            sorted_triangles.end(),
+            raw_data.triangles.begin() + cluster.begin,
+            raw_data.triangles.begin() + cluster.end
+        );
+    }
+
+    raw_data.triangles = std::move(sorted_triangles);
+}
+
+void MeshOptimizer::optimize_vertex_fetch(RawMeshData& raw_data)
+{
+    SCOPED_EVENT("MeshOptimizer - optimize vertex fetch");
+
+    std::vector<uint32_t> remap(raw_data.vertices.size(), no_index);
+    std::vector<Vertex> remapped_vertices;
+    remapped_vertices.reserve(raw_data.vertices.size());
+
+    for (Vector3u& triangle : raw_data.triangles)
+    {
+        for (uint32_t* corner : { &triangle.x, &triangle.y, &triangle.z })
+        {
+            if (remap[*corner] == no_index)
+            {
+                remap[*corner] = static_cast<uint32_t>(remapped_vertices.size());
+                remapped_vertices.push_back(raw_data.vertices[*corner]);
+            }
+
+            *corner = remap[*corner];
+        }
+    }
+
+    raw_data.vertices = std::move(remapped_vertices);
+}
+
+VertexCacheStats MeshOptimizer::analyze_vertex_cache(const RawMeshData& raw_data, int32_t cache_size)
+{
+    if (raw_data.triangles.empty() || raw_data.vertices.empty())
+    {
+        return VertexCacheStats();
+    }
+
+    FifoCache cache(raw_data.vertices.size(), cache_size);
+
+    int64_t misses = 0;
+    for (const Vector3u& triangle : raw_data.triangles)
+    {
+        misses += cache.touch(triangle);
+    }
+
+    return VertexCacheStats{
+        .acmr = static_cast<float>(misses) / static_cast<float>(raw_data.triangles.size()),
+        .atvr = static_cast<float>(misses) / static_cast<float>(raw_data.vertices.size())
+    };
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "raw_mesh_data.h"
+
+namespace rendering
+{
+    // How well a triangle order reuses the GPU's post transform vertex cache
+    struct VertexCacheStats
+    {
+        // Average cache misses per triangle, between 0.5 for an ideal grid and 3 when nothing is reused
+        float acmr = 0;
+
+        // Average cache misses per vertex, 1 is ideal as every vertex is transformed exactly once
+        float atvr = 0;
+    };
+
+    // Reorders mesh data so the GPU spends less time transforming, shading and fetching vertices
+    // None of these change what is drawn, only the order triangles and vertices are stored in
+    class MeshOptimizer
+    {
+    public:
+        // Cache size used when measuring, a typical FIFO post transform cache
+        static constexpr int32_t simulated_cache_size = 16;
+
+        // Runs every optimization in the order they should be applied
+        static void optimize(RawMeshData& raw_data);
+
+        // Reorders triangles so that vertices are reused while they're still in the post transform cache
+        // Uses Tom Forsyth's linear speed vertex cache optimization, which doesn't depend on the exact cache size
+        static void optimize_vertex_cache(RawMeshData& raw_data);
+
+        // Reorders clusters of triangles so outward facing parts of the mesh are drawn first and occlude the rest
+        // Clusters are split wherever the cache would be cold anyway, and then further as long as the ACMR doesn't
+        // grow beyond threshold times the original, so this should follow optimize_vertex_cache
+        static void optimize_overdraw(RawMeshData& raw_data, float threshold = 1.05f);
+
+        // Reorders vertices into the order they are first used so vertex fetches read memory linearly
+        // Vertices which aren't used by any triangle are removed
+        static void optimize_vertex_fetch(RawMeshData& raw_data);
+
+        [[nodiscard]] static VertexCacheStats analyze_vertex_cache(
+            const RawMeshData& raw_data,
+            int32_t cache_size = simulated_cache_size
+        );
+    };
+}
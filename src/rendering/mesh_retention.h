@@ -0,0 +1,22 @@
+#pragma once
+
+#include <libs/nlohmann/json.hpp>
+
+namespace rendering
+{
+    // Controls what CPU side data a mesh holds onto after it has been uploaded to the GPU
+    enum class MeshRetention
+    {
+        // Keeps the full vertex and triangle data in memory
+        keep,
+
+        // Releases all vertex and triangle data
+        // The element counts and bounds are always kept, so discarded meshes can still be drawn and culled
+        discard
+    };
+
+    NLOHMANN_JSON_SERIALIZE_ENUM(MeshRetention, {
+        { MeshRetention::keep, "keep" },
+        { MeshRetention::discard, "discard" }
+    });
+}
@@ -0,0 +1,554 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <numeric>
+#include <queue>
+
+#include <profiling/scoped_event.h>
+#include <utils/check.h>
+#include <utils/strtools.h>
+
+using namespace rendering;
+using namespace math;
+
+namespace
+{
+    constexpr uint32_t no_vertex = std::numeric_limits<uint32_t>::max();
+
+    // Cosine of the largest rotation a collapse may apply to any surviving triangle
+    constexpr float max_normal_cos = 0.5f;
+
+    // Symmetric 4x4 matrix stored as its upper triangle
+    // Evaluating it at a point gives the sum of weighted squared distances to the planes it was built from
+    struct Quadric
+    {
+        double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+        double a11 = 0, a12 = 0, a13 = 0;
+        double a22 = 0, a23 = 0;
+        double a33 = 0;
+
+        [[nodiscard]] static Quadric from_plane(double a, double b, double c, double d, double weight) noexcept
+        {
+            return Quadric{
+                .a00 = a * a * weight, .a01 = a * b * weight, .a02 = a * c * weight, .a03 = a * d * weight,
+                .a11 = b * b * weight, .a12 = b * c * weight, .a13 = b * d * weight,
+                .a22 = c * c * weight, .a23 = c * d * weight,
+                .a33 = d * d * weight
+            };
+        }
+
+        Quadric& operator+=(const Quadric& other) noexcept
+        {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+            a11 += other.a11; a12 += other.a12; a13 += other.a13;
+            a22 += other.a22; a23 += other.a23;
+            a33 += other.a33;
+
+            return *this;
+        }
+
+        [[nodiscard]] Quadric operator+(const Quadric& other) const noexcept
+        {
+            Quadric sum = *this;
+            sum += other;
+
+            return sum;
+        }
+
+        [[nodiscard]] double error(const Vector3f& pos) const noexcept
+        {
+            const double x = pos.x;
+            const double y = pos.y;
+            const double z = pos.z;
+
+            return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+                 + a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+                 + a22 * z * z + 2 * a23 * z
+                 + a33;
+        }
+    };
+
+    struct Collapse
+    {
+        double cost;
+        uint32_t from;
+        uint32_t to;
+        uint32_t version;
+
+        [[nodiscard]] bool operator>(const Collapse& other) const noexcept
+        {
+            return cost > other.cost;
+        }
+    };
+
+    [[nodiscard]] float dot(const Vector3f& a, const Vector3f& b) noexcept
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    [[nodiscard]] uint32_t& corner(Vector3u& triangle, int32_t index) noexcept
+    {
+        return index == 0 ? triangle.x : index == 1 ? triangle.y : triangle.z;
+    }
+
+    [[nodiscard]] uint32_t corner(const Vector3u& triangle, int32_t index) noexcept
+    {
+        return index == 0 ? triangle.x : index == 1 ? triangle.y : triangle.z;
+    }
+
+    // Working state for a single simplification
+    // Collapses operate on welded vertices, which group every vertex sharing a position
+    class Simplifier
+    {
+    public:
+        explicit Simplifier(const RawMeshData& raw_data)
+            : _raw_data(raw_data)
+            , _triangles(raw_data.triangles)
+            , _welded(raw_data.vertices.size())
+            , _num_alive_triangles(raw_data.triangles.size())
+        {
+            weld_vertices();
+            build_adjacency();
+            lock_borders();
+            build_quadrics();
+        }
+
+        void run(size_t target_triangles, double max_error)
+        {
+            for (uint32_t vertex = 0; vertex < _welded.size(); vertex++)
+            {
+                if (_welded[vertex] == vertex)
+                {
+                    push_best_collapse(vertex);
+                }
+            }
+
+            while (_num_alive_triangles > target_triangles && !_collapses.empty())
+            {
+                const Collapse collapse = _collapses.top();
+                _collapses.pop();
+
+                if (collapse.cost > max_error)
+                {
+                    break;
+                }
+
+                if (!_alive[collapse.from] || collapse.version != _versions[collapse.from])
+                {
+                    continue;
+                }
+
+                apply_collapse(collapse.from, collapse.to);
+            }
+        }
+
+        [[nodiscard]] RawMeshData build_output() const
+        {
+            RawMeshData output;
+            std::vector<uint32_t> remap(_raw_data.vertices.size(), no_vertex);
+
+            for (size_t triangle_index = 0; triangle_index < _triangles.size(); triangle_index++)
+            {
+                if (_removed[triangle_index])
+                {
+                    continue;
+                }
+
+                Vector3u triangle = _triangles[triangle_index];
+                for (int32_t i = 0; i < 3; i++)
+                {
+                    uint32_t& index = corner(triangle, i);
+                    if (remap[index] == no_vertex)
+                    {
+                        remap[index] = static_cast<uint32_t>(output.vertices.size());
+                        output.vertices.push_back(_raw_data.vertices[index]);
+                    }
+
+                    index = remap[index];
+                }
+
+                output.triangles.push_back(triangle);
+            }
+
+            return output;
+        }
+
+    private:
+        // Vertices sharing a position are welded onto the first of them, and exact duplicates are merged
+        // Any welded vertex left with several distinct copies sits on an attribute seam, so it's locked in place
+        void weld_vertices()
+        {
+            const std::vector<Vertex>& vertices = _raw_data.vertices;
+
+            std::vector<uint32_t> order(vertices.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::ranges::sort(order, [&](uint32_t a, uint32_t b)
+            {
+                const Vector3f& pos_a = vertices[a].position;
+                const Vector3f& pos_b = vertices[b].position;
+                return std::tie(pos_a.x, pos_a.y, pos_a.z, a) < std::tie(pos_b.x, pos_b.y, pos_b.z, b);
+            });
+
+            _locked.assign(vertices.size(), false);
+            _alive.assign(vertices.size(), true);
+            _versions.assign(vertices.size(), 0);
+            _refreshed.assign(vertices.size(), 0);
+            _duplicate_of.resize(vertices.size());
+
+            for (size_t i = 0; i < order.size();)
+            {
+                size_t group_end = i + 1;
+                while (group_end < order.size() && vertices[order[group_end]].position == vertices[order[i]].position)
+                {
+                    group_end++;
+                }
+
+                const uint32_t welded = order[i];
+                size_t num_copies = 0;
+
+                for (size_t j = i; j < group_end; j++)
+                {
+                    const Vertex& vertex = vertices[order[j]];
+                    _welded[order[j]] = welded;
+                    _duplicate_of[order[j]] = order[j];
+
+                    for (size_t k = i; k < j; k++)
+                    {
+                        const Vertex& other = vertices[order[k]];
+                        if (vertex.normal == other.normal && vertex.tex_coord == other.tex_coord && vertex.color == other.color)
+                        {
+                            _duplicate_of[order[j]] = _duplicate_of[order[k]];
+                            break;
+                        }
+                    }
+
+                    if (_duplicate_of[order[j]] == order[j])
+                    {
+                        num_copies++;
+                    }
+                }
+
+                _locked[welded] = num_copies > 1;
+                i = group_end;
+            }
+
+            for (Vector3u& triangle : _triangles)
+            {
+                for (int32_t i = 0; i < 3; i++)
+                {
+                    corner(triangle, i) = _duplicate_of[corner(triangle, i)];
+                }
+            }
+        }
+
+        void build_adjacency()
+        {
+            _vertex_triangles.resize(_raw_data.vertices.size());
+            _removed.assign(_triangles.size(), false);
+
+            for (uint32_t triangle_index = 0; triangle_index < _triangles.size(); triangle_index++)
+            {
+                Vector3u& triangle = _triangles[triangle_index];
+                for (int32_t i = 0; i < 3; i++)
+                {
+                    _vertex_triangles[_welded[corner(triangle, i)]].push_back(triangle_index);
+                }
+            }
+        }
+
+        // Edges used by a single triangle are on an open border, so their vertices are locked in place
+        void lock_borders()
+        {
+            std::vector<std::pair<uint32_t, uint32_t>> edges;
+            edges.reserve(_triangles.size() * 3);
+
+            for (Vector3u triangle : _triangles)
+            {
+                for (int32_t i = 0; i < 3; i++)
+                {
+                    const uint32_t a = _welded[corner(triangle, i)];
+                    const uint32_t b = _welded[corner(triangle, (i + 1) % 3)];
+                    edges.emplace_back(std::min(a, b), std::max(a, b));
+                }
+            }
+
+            std::ranges::sort(edges);
+            for (size_t i = 0; i < edges.size();)
+            {
+                size_t edge_end = i + 1;
+                while (edge_end < edges.size() && edges[edge_end] == edges[i])
+                {
+                    edge_end++;
+                }
+
+                if (edge_end - i == 1)
+                {
+                    _locked[edges[i].first] = true;
+                    _locked[edges[i].second] = true;
+                }
+
+                i = edge_end;
+            }
+        }
+
+        // Each vertex starts with the planes of its triangles, weighted by area so slivers contribute little
+        void build_quadrics()
+        {
+            _quadrics.resize(_raw_data.vertices.size());
+
+            for (Vector3u triangle : _triangles)
+            {
+                const Vector3f& p0 = position(triangle.x);
+                const Vector3f normal = Vector3f::cross(position(triangle.y) - p0, position(triangle.z) - p0);
+                const float double_area = normal.magnitude();
+
+                if (double_area <= 0)
+                {
+                    continue;
+                }
+
+                const Vector3f unit_normal = normal / double_area;
+                const Quadric quadric = Quadric::from_plane(
+                    unit_normal.x, unit_normal.y, unit_normal.z, -dot(unit_normal, p0), double_area / 2
+                );
+
+                for (int32_t i = 0; i < 3; i++)
+                {
+                    _quadrics[_welded[corner(triangle, i)]] += quadric;
+                }
+            }
+        }
+
+        [[nodiscard]] const Vector3f& position(uint32_t vertex) const noexcept
+        {
+            return _raw_data.vertices[vertex].position;
+        }
+
+        [[nodiscard]] bool contains(Vector3u triangle, uint32_t welded_vertex) const noexcept
+        {
+            return _welded[triangle.x] == welded_vertex
+                || _welded[triangle.y] == welded_vertex
+                || _welded[triangle.z] == welded_vertex;
+        }
+
+        // Checks that moving from onto to doesn't flip or fully collapse any triangle that survives the collapse
+        [[nodiscard]] bool collapse_valid(uint32_t from, uint32_t to) const
+        {
+            const Vector3f& to_pos = position(to);
+
+            for (const uint32_t triangle_index : _vertex_triangles[from])
+            {
+                const Vector3u triangle = _triangles[triangle_index];
+                if (_removed[triangle_index] || contains(triangle, to))
+                {
+                    continue;
+                }
+
+                Vector3f corners[3] = { position(triangle.x), position(triangle.y), position(triangle.z) };
+                const Vector3f old_normal = Vector3f::cross(corners[1] - corners[0], corners[2] - corners[0]);
+
+                for (int32_t i = 0; i < 3; i++)
+                {
+                    if (corner(triangle, i) == from)
+                    {
+                        corners[i] = to_pos;
+                    }
+                }
+
+                // Small rotations are allowed, but anything close to a right angle would let repeated collapses fold the surface
+                const Vector3f new_normal = Vector3f::cross(corners[1] - corners[0], corners[2] - corners[0]);
+                if (dot(old_normal, new_normal) <= max_normal_cos * old_normal.magnitude() * new_normal.magnitude())
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        void push_best_collapse(uint32_t from)
+        {
+            _versions[from]++;
+            if (_locked[from] || !_alive[from])
+            {
+                return;
+            }
+
+            Collapse best{
+                .cost = std::numeric_limits<double>::max(),
+                .from = from,
+                .to = no_vertex,
+                .version = _versions[from]
+            };
+
+            for (const uint32_t triangle_index : _vertex_triangles[from])
+            {
+                if (_removed[triangle_index])
+                {
+                    continue;
+                }
+
+                const Vector3u triangle = _triangles[triangle_index];
+                for (const uint32_t vertex : { triangle.x, triangle.y, triangle.z })
+                {
+                    const uint32_t to = _welded[vertex];
+                    if (to == from)
+                    {
+                        continue;
+                    }
+
+                    const double cost = (_quadrics[from] + _quadrics[to]).error(position(to));
+                    if (cost < best.cost && collapse_valid(from, to))
+                    {
+                        best.cost = cost;
+                        best.to = to;
+                    }
+                }
+            }
+
+            if (best.to != no_vertex)
+            {
+                _collapses.push(best);
+            }
+        }
+
+        void apply_collapse(uint32_t from, uint32_t to)
+        {
+            // Unlocked vertices have a single copy, so from is the only index to replace
+            // The copy of to used on the collapsed edge is the one the surviving triangles should use
+            uint32_t to_index = to;
+            for (const uint32_t triangle_index : _vertex_triangles[from])
+            {
+                const Vector3u triangle = _triangles[triangle_index];
+                if (!_removed[triangle_index] && contains(triangle, to))
+                {
+                    for (const uint32_t vertex : { triangle.x, triangle.y, triangle.z })
+                    {
+                        if (_welded[vertex] == to)
+                        {
+                            to_index = vertex;
+                        }
+                    }
+
+                    break;
+                }
+            }
+
+            for (const uint32_t triangle_index : _vertex_triangles[from])
+            {
+                if (_removed[triangle_index])
+                {
+                    continue;
+                }
+
+                Vector3u& triangle = _triangles[triangle_index];
+                if (contains(triangle, to))
+                {
+                    _removed[triangle_index] = true;
+                    _num_alive_triangles--;
+                    continue;
+                }
+
+                for (int32_t i = 0; i < 3; i++)
+                {
+                    if (corner(triangle, i) == from)
+                    {
+                        corner(triangle, i) = to_index;
+                    }
+                }
+
+                _vertex_triangles[to].push_back(triangle_index);
+            }
+
+            _alive[from] = false;
+            _quadrics[to] += _quadrics[from];
+            _vertex_triangles[from].clear();
+
+            // Drop removed triangles so the lists stay short, then refresh every vertex whose options changed
+            std::erase_if(_vertex_triangles[to], [&](uint32_t triangle_index) { return _removed[triangle_index]; });
+
+            _num_collapses++;
+            _refreshed[to] = _num_collapses;
+            push_best_collapse(to);
+
+            for (const uint32_t triangle_index : _vertex_triangles[to])
+            {
+                const Vector3u triangle = _triangles[triangle_index];
+                for (const uint32_t vertex : { triangle.x, triangle.y, triangle.z })
+                {
+                    const uint32_t neighbour = _welded[vertex];
+                    if (_refreshed[neighbour] != _num_collapses)
+                    {
+                        _refreshed[neighbour] = _num_collapses;
+                        push_best_collapse(neighbour);
+                    }
+                }
+            }
+        }
+
+        const RawMeshData& _raw_data;
+        std::vector<Vector3u> _triangles;
+        std::vector<uint32_t> _welded;
+        std::vector<uint32_t> _duplicate_of;
+        std::vector<bool> _locked;
+        std::vector<bool> _alive;
+        std::vector<bool> _removed;
+        std::vector<uint32_t> _versions;
+        std::vector<size_t> _refreshed;
+        std::vector<std::vector<uint32_t>> _vertex_triangles;
+        std::vector<Quadric> _quadrics;
+        std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> _collapses;
+        size_t _num_alive_triangles;
+        size_t _num_collapses = 0;
+    };
+}
+
+RawMeshData MeshSimplifier::simplify(const RawMeshData& raw_data, size_t target_triangles, float max_error)
+{
+    SCOPED_EVENT("MeshSimplifier - simplify", strtools::catf_temp(
+        "%zu -> %zu triangles", raw_data.triangles.size(), target_triangles
+    ));
+
+    raw_data.check_valid();
+    if (raw_data.triangles.size() <= target_triangles)
+    {
+        return raw_data;
+    }
+
+    Simplifier simplifier(raw_data);
+    simplifier.run(target_triangles, max_error);
+
+    return simplifier.build_output();
+}
+
+std::vector<RawMeshData> MeshSimplifier::generate_lods(const RawMeshData& raw_data, int32_t num_lods, float reduction)
+{
+    SCOPED_EVENT("MeshSimplifier - generate lods", strtools::catf_temp("%d lods", num_lods));
+    check(reduction > 0 && reduction < 1);
+
+    std::vector<RawMeshData> lods;
+    lods.reserve(num_lods);
+
+    const RawMeshData* previous = &raw_data;
+
+    for (int32_t lod = 0; lod < num_lods; lod++)
+    {
+        const size_t previous_triangles = previous->triangles.size();
+        const size_t target_triangles = static_cast<size_t>(static_cast<float>(previous_triangles) * reduction);
+
+        // Each level is built from the one before, which is cheaper and keeps the levels consistent
+        RawMeshData simplified = simplify(*previous, target_triangles);
+
+        // Levels that barely differ from the one before just cost memory without saving any work
+        constexpr float min_gain = 0.9f;
+        if (simplified.triangles.empty() || simplified.triangles.size() > previous_triangles * min_gain)
+        {
+            break;
+        }
+
+        lods.push_back(std::move(simplified));
+        previous = &lods.back();
+    }
+
+    return lods;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "raw_mesh_data.h"
+
+namespace rendering
+{
+    // Reduces the triangle count of meshes using quadric error metrics
+    // Each step collapses a vertex onto the neighbour that moves the surface the least, measured as the squared
+    // distance to the planes of all triangles the vertex has absorbed so far. Vertices are always collapsed onto
+    // an existing vertex so attributes never need interpolating, and vertices on attribute seams or open borders
+    // never move so texture coordinates and outlines are preserved. Collapses that would flip a triangle are skipped
+    class MeshSimplifier
+    {
+    public:
+        // Simplifies the mesh to at most target_triangles, or as close as possible without exceeding max_error
+        [[nodiscard]] static RawMeshData simplify(
+            const RawMeshData& raw_data,
+            size_t target_triangles,
+            float max_error = std::numeric_limits<float>::max()
+        );
+
+        // Generates up to num_lods levels of detail, each with roughly reduction times the triangles of the one before
+        // Stops early once a level can't be reduced meaningfully, so fewer levels may be returned
+        [[nodiscard]] static std::vector<RawMeshData> generate_lods(
+            const RawMeshData& raw_data,
+            int32_t num_lods,
+            float reduction = 0.5f
+        );
+    };
+}
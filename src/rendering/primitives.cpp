@@ -314,6 +314,33 @@ peng::shared_ref<const Mesh> Primitives::icosphere(uint32_t order)
     return icosphere;
 }
 
+peng::shared_ref<const Mesh> Primitives::lod_icosphere(uint32_t order)
+{
+    static std::unordered_map<uint32_t, peng::weak_ptr<const Mesh>> weak_icospheres;
+    if (const auto it = weak_icospheres.find(order); it != weak_icospheres.end())
+    {
+        if (const peng::shared_ptr<const Mesh> strong_icosphere = it->second.lock())
+        {
+            return strong_icosphere.to_shared_ref();
+        }
+    }
+
+    std::vector<peng::shared_ref<const Mesh>> lods;
+    for (uint32_t lod_order = order; lod_order-- > 0;)
+    {
+        lods.push_back(icosphere(lod_order));
+    }
+
+    peng::shared_ref<Mesh> icosphere_mesh = peng::make_shared<Mesh>(
+        strtools::catf("LodIcosphere(%d)", order), *icosphere(order)->load_raw_data().get()
+    );
+
+    icosphere_mesh->set_lods(std::move(lods));
+
+    weak_icospheres[order] = icosphere_mesh;
+    return icosphere_mesh;
+}
+
 peng::shared_ref<const Texture> Primitives::white_tex()
 {
     static peng::weak_ptr<const Texture> weak_tex;
@@ -324,6 +351,10 @@ peng::shared_ref<const Texture> Primitives::white_tex()
 
     const std::vector<Vector3u8> rgb_data = { Vector3u8(0xFF, 0xFF, 0xFF) };
     Texture::Config config;
+    config.wrap_x = GL_CLAMP_TO_EDGE;
+    config.wrap_y = GL_CLAMP_TO_EDGE;
+    config.min_filter = GL_NEAREST;
+    config.max_filter = GL_NEAREST;
     config.generate_mipmaps = false;
 
     peng::shared_ref<Texture> white_tex = peng::make_shared<Texture>(
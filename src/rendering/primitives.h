@@ -23,6 +23,9 @@ namespace rendering
         [[nodiscard]] static peng::shared_ref<const Mesh> icosahedron();
         [[nodiscard]] static peng::shared_ref<const Mesh> icosphere(uint32_t order = 3);
 
+        // An icosphere which uses the icospheres of every lower order as its levels of detail
+        [[nodiscard]] static peng::shared_ref<const Mesh> lod_icosphere(uint32_t order = 3);
+
         [[nodiscard]] static peng::shared_ref<const Texture> white_tex();
 
         [[nodiscard]] static peng::shared_ref<const Sprite> white_sprite();
@@ -1,17 +1,80 @@
 #include "raw_mesh_data.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include <utils/check.h>
 
 using namespace rendering;
+using namespace math;
 
 void RawMeshData::check_valid() const
 {
     check(!corrupt);
 }
 
+physics::AABB RawMeshData::calc_bounds() const
+{
+    if (vertices.empty())
+    {
+        return physics::AABB(Vector3f::zero(), Vector3f::zero());
+    }
+
+    Vector3f min_pos = vertices[0].position;
+    Vector3f max_pos = vertices[0].position;
+
+    for (const Vertex& vertex : vertices)
+    {
+        min_pos.x = std::min(min_pos.x, vertex.position.x);
+        min_pos.y = std::min(min_pos.y, vertex.position.y);
+        min_pos.z = std::min(min_pos.z, vertex.position.z);
+        max_pos.x = std::max(max_pos.x, vertex.position.x);
+        max_pos.y = std::max(max_pos.y, vertex.position.y);
+        max_pos.z = std::max(max_pos.z, vertex.position.z);
+    }
+
+    return physics::AABB(
+        (min_pos + max_pos) / 2,
+        (max_pos - min_pos) / 2
+    );
+}
+
+physics::BoundingSphere RawMeshData::calc_bounding_sphere(const physics::AABB& bounds) const
+{
+    // Tighter than the sphere around the box corners for most meshes, since few vertices sit in the corners
+    float radius_sqr = 0;
+    for (const Vertex& vertex : vertices)
+    {
+        radius_sqr = std::max(radius_sqr, (vertex.position - bounds.center).magnitude_sqr());
+    }
+
+    return physics::BoundingSphere(bounds.center, std::sqrt(radius_sqr));
+}
+
+MeshDataView RawMeshData::view() const
+{
+    check_valid();
+
+    const physics::AABB bounds = calc_bounds();
+    return MeshDataView{
+        .vertices = vertices,
+        .triangles = triangles,
+        .bounds = bounds,
+        .bounding_sphere = calc_bounding_sphere(bounds)
+    };
+}
+
 RawMeshData RawMeshData::corrupt_data()
 {
     return RawMeshData{
         .corrupt = true
     };
 }
+
+RawMeshData RawMeshData::from_view(const MeshDataView& view)
+{
+    return RawMeshData{
+        .vertices = std::vector<Vertex>(view.vertices.begin(), view.vertices.end()),
+        .triangles = std::vector<Vector3u>(view.triangles.begin(), view.triangles.end())
+    };
+}
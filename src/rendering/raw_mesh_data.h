@@ -1,11 +1,24 @@
 #pragma once
 
+#include <span>
 #include <vector>
 
+#include <physics/aabb.h>
+#include <physics/bounding_sphere.h>
+
 #include "vertex.h"
 
 namespace rendering
 {
+    // Non owning view of mesh data along with its bounds, such as data mapped straight from a mesh cache file
+    struct MeshDataView
+    {
+        std::span<const Vertex> vertices;
+        std::span<const math::Vector3u> triangles;
+        physics::AABB bounds;
+        physics::BoundingSphere bounding_sphere;
+    };
+
     struct RawMeshData
     {
         std::vector<Vertex> vertices;
@@ -15,6 +28,16 @@ namespace rendering
 
         void check_valid() const;
 
+        // Calculates the local space bounding box enclosing all vertices
+        [[nodiscard]] physics::AABB calc_bounds() const;
+
+        // Calculates a local space sphere enclosing all vertices, centered on the bounding box
+        [[nodiscard]] physics::BoundingSphere calc_bounding_sphere(const physics::AABB& bounds) const;
+
+        // Views the data, calculating its bounds
+        [[nodiscard]] MeshDataView view() const;
+
         static RawMeshData corrupt_data();
+        static RawMeshData from_view(const MeshDataView& view);
     };
 }
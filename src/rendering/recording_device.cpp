@@ -0,0 +1,593 @@
+#include "recording_device.h"
+
+#include <algorithm>
+#include <cstring>
+#include <regex>
+
+#include <utils/check.h>
+#include <utils/vectools.h>
+
+using namespace rendering;
+using namespace math;
+
+namespace
+{
+    std::optional<GLenum> glsl_type_to_opengl(const std::string& type)
+    {
+        static const utils::flat_hash_map<std::string, GLenum> types = [] {
+            utils::flat_hash_map<std::string, GLenum> map;
+            map["int"] = GL_INT;
+            map["uint"] = GL_UNSIGNED_INT;
+            map["float"] = GL_FLOAT;
+            map["double"] = GL_DOUBLE;
+            map["ivec2"] = GL_INT_VEC2;
+            map["uvec2"] = GL_UNSIGNED_INT_VEC2;
+            map["vec2"] = GL_FLOAT_VEC2;
+            map["dvec2"] = GL_DOUBLE_VEC2;
+            map["ivec3"] = GL_INT_VEC3;
+            map["uvec3"] = GL_UNSIGNED_INT_VEC3;
+            map["vec3"] = GL_FLOAT_VEC3;
+            map["dvec3"] = GL_DOUBLE_VEC3;
+            map["ivec4"] = GL_INT_VEC4;
+            map["uvec4"] = GL_UNSIGNED_INT_VEC4;
+            map["vec4"] = GL_FLOAT_VEC4;
+            map["dvec4"] = GL_DOUBLE_VEC4;
+            map["mat3"] = GL_FLOAT_MAT3;
+            map["dmat3"] = GL_DOUBLE_MAT3;
+            map["mat4"] = GL_FLOAT_MAT4;
+            map["dmat4"] = GL_DOUBLE_MAT4;
+            map["sampler2D"] = GL_SAMPLER_2D;
+            return map;
+        }();
+
+        if (const auto it = types.find(type); it != types.end())
+        {
+            return it->second;
+        }
+
+        return std::nullopt;
+    }
+
+    std::optional<UniformValue> default_uniform_value(GLenum type)
+    {
+        switch (type)
+        {
+            case GL_INT:               return int32_t(0);
+            case GL_UNSIGNED_INT:      return uint32_t(0);
+            case GL_FLOAT:             return 0.0f;
+            case GL_DOUBLE:            return 0.0;
+            case GL_INT_VEC2:          return Vector2i();
+            case GL_UNSIGNED_INT_VEC2: return Vector2u();
+            case GL_FLOAT_VEC2:        return Vector2f();
+            case GL_DOUBLE_VEC2:       return Vector2d();
+            case GL_INT_VEC3:          return Vector3i();
+            case GL_UNSIGNED_INT_VEC3: return Vector3u();
+            case GL_FLOAT_VEC3:        return Vector3f();
+            case GL_DOUBLE_VEC3:       return Vector3d();
+            case GL_INT_VEC4:          return Vector4i();
+            case GL_UNSIGNED_INT_VEC4: return Vector4u();
+            case GL_FLOAT_VEC4:        return Vector4f();
+            case GL_DOUBLE_VEC4:       return Vector4d();
+            case GL_FLOAT_MAT3:        return Matrix3x3f();
+            case GL_DOUBLE_MAT3:       return Matrix3x3d();
+            case GL_FLOAT_MAT4:        return Matrix4x4f();
+            case GL_DOUBLE_MAT4:       return Matrix4x4d();
+            default:                   return std::nullopt;
+        }
+    }
+}
+
+std::ostream& rendering::operator<<(std::ostream& os, DeviceCommandType command_type)
+{
+    switch (command_type)
+    {
+        case DeviceCommandType::create_buffer: os << "create_buffer"; break;
+        case DeviceCommandType::delete_buffer: os << "delete_buffer"; break;
+        case DeviceCommandType::buffer_data: os << "buffer_data"; break;
+        case DeviceCommandType::buffer_sub_data: os << "buffer_sub_data"; break;
+        case DeviceCommandType::bind_buffer_base: os << "bind_buffer_base"; break;
+        case DeviceCommandType::bind_buffer_range: os << "bind_buffer_range"; break;
+        case DeviceCommandType::map_buffer_persistent: os << "map_buffer_persistent"; break;
+        case DeviceCommandType::create_vertex_array: os << "create_vertex_array"; break;
+        case DeviceCommandType::delete_vertex_array: os << "delete_vertex_array"; break;
+        case DeviceCommandType::bind_vertex_array: os << "bind_vertex_array"; break;
+        case DeviceCommandType::vertex_attribute: os << "vertex_attribute"; break;
+        case DeviceCommandType::create_texture: os << "create_texture"; break;
+        case DeviceCommandType::delete_texture: os << "delete_texture"; break;
+        case DeviceCommandType::texture_parameter: os << "texture_parameter"; break;
+        case DeviceCommandType::texture_image: os << "texture_image"; break;
+        case DeviceCommandType::compressed_texture_image: os << "compressed_texture_image"; break;
+        case DeviceCommandType::texture_sub_image: os << "texture_sub_image"; break;
+        case DeviceCommandType::read_texture_image: os << "read_texture_image"; break;
+        case DeviceCommandType::generate_mipmaps: os << "generate_mipmaps"; break;
+        case DeviceCommandType::bind_texture: os << "bind_texture"; break;
+        case DeviceCommandType::compile_shader: os << "compile_shader"; break;
+        case DeviceCommandType::delete_shader: os << "delete_shader"; break;
+        case DeviceCommandType::link_program: os << "link_program"; break;
+        case DeviceCommandType::delete_program: os << "delete_program"; break;
+        case DeviceCommandType::use_program: os << "use_program"; break;
+        case DeviceCommandType::storage_block_binding: os << "storage_block_binding"; break;
+        case DeviceCommandType::set_uniform: os << "set_uniform"; break;
+        case DeviceCommandType::set_blend_mode: os << "set_blend_mode"; break;
+        case DeviceCommandType::set_polygon_mode: os << "set_polygon_mode"; break;
+        case DeviceCommandType::draw_elements: os << "draw_elements"; break;
+        case DeviceCommandType::draw_elements_instanced: os << "draw_elements_instanced"; break;
+        case DeviceCommandType::fence_sync: os << "fence_sync"; break;
+        case DeviceCommandType::delete_sync: os << "delete_sync"; break;
+        case DeviceCommandType::push_debug_group: os << "push_debug_group"; break;
+        case DeviceCommandType::pop_debug_group: os << "pop_debug_group"; break;
+        default: os << "???"; break;
+    }
+
+    return os;
+}
+
+RecordingDevice::RecordingDevice(bool record_commands)
+    : _record_commands(record_commands)
+    , _last_handle(0)
+    , _bound_program(0)
+    , _bound_vertex_array(0)
+{ }
+
+GLuint RecordingDevice::create_buffer(const char*)
+{
+    const GLuint buffer = next_handle();
+    record(DeviceCommandType::create_buffer, buffer);
+
+    return buffer;
+}
+
+void RecordingDevice::delete_buffer(GLuint buffer)
+{
+    _mapped_buffers.erase(buffer);
+    record(DeviceCommandType::delete_buffer, buffer);
+}
+
+void RecordingDevice::buffer_data(GLenum target, GLuint buffer, size_t size, const void*, GLenum usage)
+{
+    _stats.buffer_uploads++;
+    _stats.bytes_uploaded += size;
+    record(DeviceCommandType::buffer_data, buffer, target, usage);
+}
+
+void RecordingDevice::buffer_sub_data(GLenum target, GLuint buffer, size_t offset, size_t size, const void*)
+{
+    _stats.buffer_uploads++;
+    _stats.bytes_uploaded += size;
+    record(DeviceCommandType::buffer_sub_data, buffer, target, offset);
+}
+
+void RecordingDevice::bind_buffer_base(GLenum target, GLuint index, GLuint buffer)
+{
+    record(DeviceCommandType::bind_buffer_base, buffer, target, index);
+}
+
+void RecordingDevice::bind_buffer_range(GLenum, GLuint index, GLuint buffer, size_t offset, size_t)
+{
+    record(DeviceCommandType::bind_buffer_range, buffer, index, offset);
+}
+
+void* RecordingDevice::map_buffer_persistent(GLenum target, GLuint buffer, size_t size)
+{
+    std::unique_ptr<uint8_t[]>& memory = _mapped_buffers[buffer];
+    memory = std::make_unique<uint8_t[]>(size);
+
+    record(DeviceCommandType::map_buffer_persistent, buffer, target, size);
+    return memory.get();
+}
+
+size_t RecordingDevice::storage_buffer_offset_alignment()
+{
+    // The largest alignment OpenGL implementations are allowed to require, so offsets are valid on any of them
+    return 256;
+}
+
+GLuint RecordingDevice::create_vertex_array(const char*)
+{
+    const GLuint vertex_array = next_handle();
+    record(DeviceCommandType::create_vertex_array, vertex_array);
+
+    // Matches OpenGL where the new vertex array is left bound
+    _bound_vertex_array = vertex_array;
+
+    return vertex_array;
+}
+
+void RecordingDevice::delete_vertex_array(GLuint vertex_array)
+{
+    if (_bound_vertex_array == vertex_array)
+    {
+        _bound_vertex_array = 0;
+    }
+
+    record(DeviceCommandType::delete_vertex_array, vertex_array);
+}
+
+void RecordingDevice::bind_vertex_array(GLuint vertex_array)
+{
+    _stats.vertex_array_binds++;
+    if (_bound_vertex_array == vertex_array)
+    {
+        _stats.redundant_vertex_array_binds++;
+    }
+
+    _bound_vertex_array = vertex_array;
+    record(DeviceCommandType::bind_vertex_array, vertex_array);
+}
+
+void RecordingDevice::vertex_attribute(GLuint index, GLuint buffer, GLint num_components, GLenum, GLboolean, GLsizei, size_t)
+{
+    record(DeviceCommandType::vertex_attribute, buffer, index, num_components);
+}
+
+GLuint RecordingDevice::create_texture(const char*)
+{
+    const GLuint texture = next_handle();
+    record(DeviceCommandType::create_texture, texture);
+
+    return texture;
+}
+
+void RecordingDevice::delete_texture(GLuint texture)
+{
+    record(DeviceCommandType::delete_texture, texture);
+}
+
+void RecordingDevice::texture_parameter(GLuint texture, GLenum parameter, GLint value)
+{
+    record(DeviceCommandType::texture_parameter, texture, parameter, value);
+}
+
+void RecordingDevice::texture_image(
+    GLuint texture,
+    GLint,
+    GLint internal_format,
+    const Vector2i& resolution,
+    GLenum,
+    GLenum,
+    const void*
+)
+{
+    _stats.buffer_uploads++;
+    _stats.bytes_uploaded += resolution.area() * 4;
+    record(DeviceCommandType::texture_image, texture, internal_format, resolution.area());
+}
+
+void RecordingDevice::compressed_texture_image(
+    GLuint texture,
+    GLint,
+    GLenum internal_format,
+    const Vector2i&,
+    size_t size,
+    const void*
+)
+{
+    _stats.buffer_uploads++;
+    _stats.bytes_uploaded += size;
+    record(DeviceCommandType::compressed_texture_image, texture, internal_format, static_cast<int64_t>(size));
+}
+
+void RecordingDevice::texture_sub_image(
+    GLuint texture,
+    const Vector2i&,
+    const Vector2i& resolution,
+    GLenum,
+    GLenum,
+    const void*
+)
+{
+    _stats.buffer_uploads++;
+    _stats.bytes_uploaded += resolution.area() * 4;
+    record(DeviceCommandType::texture_sub_image, texture, resolution.area());
+}
+
+void RecordingDevice::read_texture_image(GLuint texture, GLenum, GLenum, size_t size, void* data)
+{
+    std::memset(data, 0, size);
+    record(DeviceCommandType::read_texture_image, texture, static_cast<int64_t>(size));
+}
+
+void RecordingDevice::generate_mipmaps(GLuint texture)
+{
+    record(DeviceCommandType::generate_mipmaps, texture);
+}
+
+void RecordingDevice::bind_texture(GLint slot, GLuint texture)
+{
+    check(slot >= 0);
+
+    if (_bound_textures.size() <= static_cast<size_t>(slot))
+    {
+        _bound_textures.resize(slot + 1, 0);
+    }
+
+    _stats.texture_binds++;
+    if (_bound_textures[slot] == texture)
+    {
+        _stats.redundant_texture_binds++;
+    }
+
+    _bound_textures[slot] = texture;
+    record(DeviceCommandType::bind_texture, texture, slot);
+}
+
+GLuint RecordingDevice::compile_shader(GLenum type, std::string_view source, const char*)
+{
+    const GLuint shader = next_handle();
+    _shaders[shader] = parse_interface(source);
+    record(DeviceCommandType::compile_shader, shader, type);
+
+    return shader;
+}
+
+void RecordingDevice::delete_shader(GLuint shader)
+{
+    _shaders.erase(shader);
+    record(DeviceCommandType::delete_shader, shader);
+}
+
+GLuint RecordingDevice::link_program(std::span<const GLuint> shaders, const char*)
+{
+    const GLuint program = next_handle();
+    ShaderInterface& program_interface = _programs[program];
+
+    // Uniforms and blocks declared in several stages are shared, so are only reported once
+    for (const GLuint shader : shaders)
+    {
+        const auto it = _shaders.find(shader);
+        check(it != _shaders.end());
+
+        for (const ActiveUniform& uniform : it->second.uniforms)
+        {
+            const bool seen = std::ranges::any_of(program_interface.uniforms,
+                [&](const ActiveUniform& x) { return x.name == uniform.name; });
+
+            if (!seen)
+            {
+                ActiveUniform& added = program_interface.uniforms.emplace_back(uniform);
+                added.location = static_cast<GLint>(program_interface.uniforms.size() - 1);
+            }
+        }
+
+        for (const std::string& block : it->second.storage_blocks)
+        {
+            if (!vectools::contains(program_interface.storage_blocks, block))
+            {
+                program_interface.storage_blocks.push_back(block);
+            }
+        }
+    }
+
+    record(DeviceCommandType::link_program, program, static_cast<int64_t>(shaders.size()));
+
+    return program;
+}
+
+void RecordingDevice::delete_program(GLuint program)
+{
+    if (_bound_program == program)
+    {
+        _bound_program = 0;
+    }
+
+    _programs.erase(program);
+    record(DeviceCommandType::delete_program, program);
+}
+
+void RecordingDevice::use_program(GLuint program)
+{
+    _stats.program_binds++;
+    if (_bound_program == program)
+    {
+        _stats.redundant_program_binds++;
+    }
+
+    _bound_program = program;
+    record(DeviceCommandType::use_program, program);
+}
+
+bool RecordingDevice::shader_compiled(GLuint shader, std::string&)
+{
+    return _shaders.contains(shader);
+}
+
+bool RecordingDevice::program_linked(GLuint program, std::string&)
+{
+    return _programs.contains(program);
+}
+
+std::vector<ActiveUniform> RecordingDevice::active_uniforms(GLuint program)
+{
+    const auto it = _programs.find(program);
+    return it != _programs.end()
+        ? it->second.uniforms
+        : std::vector<ActiveUniform>();
+}
+
+std::optional<UniformValue> RecordingDevice::uniform_value(GLuint, GLint, GLenum type)
+{
+    // Initializers aren't parsed, so every uniform reads back as zero
+    return default_uniform_value(type);
+}
+
+GLint RecordingDevice::storage_block_index(GLuint program, const char* name)
+{
+    const auto it = _programs.find(program);
+    if (it == _programs.end())
+    {
+        return -1;
+    }
+
+    const std::vector<std::string>& blocks = it->second.storage_blocks;
+    const auto block_it = std::ranges::find(blocks, name);
+
+    return block_it != blocks.end()
+        ? static_cast<GLint>(block_it - blocks.begin())
+        : -1;
+}
+
+void RecordingDevice::storage_block_binding(GLuint program, GLuint index, GLuint binding)
+{
+    record(DeviceCommandType::storage_block_binding, program, index, binding);
+}
+
+void RecordingDevice::set_uniform(GLint location, const UniformValue& value)
+{
+    _stats.uniform_sets++;
+
+    if (_record_commands)
+    {
+        _uniform_values.push_back(value);
+        record(DeviceCommandType::set_uniform, _bound_program, location, static_cast<int64_t>(_uniform_values.size() - 1));
+    }
+}
+
+void RecordingDevice::set_blend_mode(BlendMode blend_mode)
+{
+    _stats.blend_mode_changes++;
+    if (_blend_mode == blend_mode)
+    {
+        _stats.redundant_blend_mode_changes++;
+    }
+
+    _blend_mode = blend_mode;
+    record(DeviceCommandType::set_blend_mode, 0, static_cast<int64_t>(blend_mode));
+}
+
+void RecordingDevice::set_polygon_mode(GLenum mode)
+{
+    record(DeviceCommandType::set_polygon_mode, 0, mode);
+}
+
+void RecordingDevice::draw_elements(GLsizei num_indices)
+{
+    draw_elements_instanced(num_indices, 1);
+}
+
+void RecordingDevice::draw_elements_instanced(GLsizei num_indices, GLsizei num_instances)
+{
+    check(_bound_program);
+    check(_bound_vertex_array);
+
+    _stats.draw_calls++;
+    _stats.instances += num_instances;
+    _stats.triangles += static_cast<int64_t>(num_indices / 3) * num_instances;
+
+    record(
+        num_instances == 1 ? DeviceCommandType::draw_elements : DeviceCommandType::draw_elements_instanced,
+        _bound_vertex_array, num_indices, num_instances
+    );
+}
+
+GLsync RecordingDevice::fence_sync()
+{
+    const GLuint fence = next_handle();
+    record(DeviceCommandType::fence_sync, fence);
+
+    return reinterpret_cast<GLsync>(static_cast<uintptr_t>(fence));
+}
+
+bool RecordingDevice::wait_sync(GLsync, uint64_t)
+{
+    return true;
+}
+
+void RecordingDevice::delete_sync(GLsync sync)
+{
+    record(DeviceCommandType::delete_sync, static_cast<GLuint>(reinterpret_cast<uintptr_t>(sync)));
+}
+
+void RecordingDevice::push_debug_group(const char*)
+{
+    record(DeviceCommandType::push_debug_group);
+}
+
+void RecordingDevice::pop_debug_group()
+{
+    record(DeviceCommandType::pop_debug_group);
+}
+
+void RecordingDevice::reset()
+{
+    _commands.clear();
+    _uniform_values.clear();
+    _stats = DeviceStats();
+}
+
+void RecordingDevice::write_commands(std::ostream& os) const
+{
+    for (const RecordedCommand& command : _commands)
+    {
+        os << command.type << ' ' << command.object << ' ' << command.args[0] << ' ' << command.args[1] << '\n';
+    }
+}
+
+const std::vector<RecordedCommand>& RecordingDevice::commands() const noexcept
+{
+    return _commands;
+}
+
+const std::vector<UniformValue>& RecordingDevice::uniform_values() const noexcept
+{
+    return _uniform_values;
+}
+
+const DeviceStats& RecordingDevice::stats() const noexcept
+{
+    return _stats;
+}
+
+GLuint RecordingDevice::next_handle() noexcept
+{
+    return ++_last_handle;
+}
+
+void RecordingDevice::record(DeviceCommandType type, GLuint object, int64_t arg0, int64_t arg1)
+{
+    if (_record_commands)
+    {
+        _commands.push_back(RecordedCommand{
+            .type = type,
+            .object = object,
+            .args = { arg0, arg1 }
+        });
+    }
+}
+
+RecordingDevice::ShaderInterface RecordingDevice::parse_interface(std::string_view source)
+{
+    static const std::regex comment_regex(R"(//[^\n]*|/\*[\s\S]*?\*/)");
+    static const std::regex uniform_regex(
+        R"(\buniform\s+(?:(?:lowp|mediump|highp)\s+)?([A-Za-z_]\w*)\s+([A-Za-z_]\w*)\s*(\[[^\]]*\])?\s*(?:=[^;]*)?;)"
+    );
+    static const std::regex storage_block_regex(R"(\bbuffer\s+([A-Za-z_]\w*)\s*\{)");
+
+    const std::string stripped = std::regex_replace(std::string(source), comment_regex, " ");
+    ShaderInterface shader_interface;
+
+    for (auto it = std::sregex_iterator(stripped.begin(), stripped.end(), uniform_regex); it != std::sregex_iterator(); ++it)
+    {
+        const std::smatch& match = *it;
+        if (const std::optional<GLenum> type = glsl_type_to_opengl(match[1]))
+        {
+            // Like OpenGL, arrays are reported by their first element
+            std::string name = match[2];
+            if (match[3].matched)
+            {
+                name += "[0]";
+            }
+
+            shader_interface.uniforms.push_back(ActiveUniform{
+                .name = std::move(name),
+                .type = *type
+            });
+        }
+    }
+
+    for (auto it = std::sregex_iterator(stripped.begin(), stripped.end(), storage_block_regex); it != std::sregex_iterator(); ++it)
+    {
+        shader_interface.storage_blocks.push_back((*it)[1]);
+    }
+
+    return shader_interface;
+}
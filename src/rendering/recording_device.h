@@ -0,0 +1,209 @@
+#pragma once
+
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <utils/flat_hash_map.h>
+
+#include "device.h"
+
+namespace rendering
+{
+    enum class DeviceCommandType
+    {
+        create_buffer,
+        delete_buffer,
+        buffer_data,
+        buffer_sub_data,
+        bind_buffer_base,
+        bind_buffer_range,
+        map_buffer_persistent,
+        create_vertex_array,
+        delete_vertex_array,
+        bind_vertex_array,
+        vertex_attribute,
+        create_texture,
+        delete_texture,
+        texture_parameter,
+        texture_image,
+        compressed_texture_image,
+        texture_sub_image,
+        read_texture_image,
+        generate_mipmaps,
+        bind_texture,
+        compile_shader,
+        delete_shader,
+        link_program,
+        delete_program,
+        use_program,
+        storage_block_binding,
+        set_uniform,
+        set_blend_mode,
+        set_polygon_mode,
+        draw_elements,
+        draw_elements_instanced,
+        fence_sync,
+        delete_sync,
+        push_debug_group,
+        pop_debug_group
+    };
+
+    std::ostream& operator<<(std::ostream& os, DeviceCommandType command_type);
+
+    // A single command issued to a RecordingDevice
+    // object is the handle the command acts on, and args hold the remaining integral arguments in call order
+    // For set_uniform, object is the program in use and args are the location and an index into uniform_values
+    // For fence_sync and delete_sync, object is the id of the fence
+    struct RecordedCommand
+    {
+        DeviceCommandType type;
+        GLuint object = 0;
+        int64_t args[2] = { };
+    };
+
+    struct DeviceStats
+    {
+        int32_t draw_calls = 0;
+        int32_t instances = 0;
+        int64_t triangles = 0;
+        int32_t program_binds = 0;
+        int32_t redundant_program_binds = 0;
+        int32_t vertex_array_binds = 0;
+        int32_t redundant_vertex_array_binds = 0;
+        int32_t texture_binds = 0;
+        int32_t redundant_texture_binds = 0;
+        int32_t blend_mode_changes = 0;
+        int32_t redundant_blend_mode_changes = 0;
+        int32_t uniform_sets = 0;
+        int32_t buffer_uploads = 0;
+        int64_t bytes_uploaded = 0;
+    };
+
+    // Device backend which doesn't touch the GPU at all, for running the renderer headless
+    // Every command is counted in DeviceStats, including binds that would have been no-ops, and
+    // optionally recorded so command streams can be inspected or compared against a known good stream
+    // Shader sources are scanned for plain uniform and storage block declarations so that materials
+    // can still resolve uniforms, uniforms inside structs or interface blocks are not reported
+    // Persistently mapped buffers are backed by host memory, and fences are always signalled
+    // Texture contents aren't kept, so reading back a texture always gives zeroes
+    class RecordingDevice final : public Device
+    {
+    public:
+        explicit RecordingDevice(bool record_commands = true);
+
+        [[nodiscard]] GLuint create_buffer(const char* label) override;
+        void delete_buffer(GLuint buffer) override;
+        void buffer_data(GLenum target, GLuint buffer, size_t size, const void* data, GLenum usage) override;
+        void buffer_sub_data(GLenum target, GLuint buffer, size_t offset, size_t size, const void* data) override;
+        void bind_buffer_base(GLenum target, GLuint index, GLuint buffer) override;
+        void bind_buffer_range(GLenum target, GLuint index, GLuint buffer, size_t offset, size_t size) override;
+        [[nodiscard]] void* map_buffer_persistent(GLenum target, GLuint buffer, size_t size) override;
+        [[nodiscard]] size_t storage_buffer_offset_alignment() override;
+
+        [[nodiscard]] GLuint create_vertex_array(const char* label) override;
+        void delete_vertex_array(GLuint vertex_array) override;
+        void bind_vertex_array(GLuint vertex_array) override;
+        void vertex_attribute(GLuint index, GLuint buffer, GLint num_components, GLenum type, GLboolean normalized, GLsizei stride, size_t offset) override;
+
+        [[nodiscard]] GLuint create_texture(const char* label) override;
+        void delete_texture(GLuint texture) override;
+        void texture_parameter(GLuint texture, GLenum parameter, GLint value) override;
+        void texture_image(
+            GLuint texture,
+            GLint level,
+            GLint internal_format,
+            const math::Vector2i& resolution,
+            GLenum format,
+            GLenum type,
+            const void* data
+        ) override;
+
+        void compressed_texture_image(
+            GLuint texture,
+            GLint level,
+            GLenum internal_format,
+            const math::Vector2i& resolution,
+            size_t size,
+            const void* data
+        ) override;
+        void texture_sub_image(
+            GLuint texture,
+            const math::Vector2i& offset,
+            const math::Vector2i& resolution,
+            GLenum format,
+            GLenum type,
+            const void* data
+        ) override;
+        void read_texture_image(GLuint texture, GLenum format, GLenum type, size_t size, void* data) override;
+        void generate_mipmaps(GLuint texture) override;
+        void bind_texture(GLint slot, GLuint texture) override;
+
+        [[nodiscard]] GLuint compile_shader(GLenum type, std::string_view source, const char* label) override;
+        void delete_shader(GLuint shader) override;
+        [[nodiscard]] GLuint link_program(std::span<const GLuint> shaders, const char* label) override;
+        void delete_program(GLuint program) override;
+        void use_program(GLuint program) override;
+
+        [[nodiscard]] bool shader_compiled(GLuint shader, std::string& error_log) override;
+        [[nodiscard]] bool program_linked(GLuint program, std::string& error_log) override;
+
+        [[nodiscard]] std::vector<ActiveUniform> active_uniforms(GLuint program) override;
+        [[nodiscard]] std::optional<UniformValue> uniform_value(GLuint program, GLint location, GLenum type) override;
+        [[nodiscard]] GLint storage_block_index(GLuint program, const char* name) override;
+        void storage_block_binding(GLuint program, GLuint index, GLuint binding) override;
+
+        void set_uniform(GLint location, const UniformValue& value) override;
+
+        void set_blend_mode(BlendMode blend_mode) override;
+        void set_polygon_mode(GLenum mode) override;
+
+        void draw_elements(GLsizei num_indices) override;
+        void draw_elements_instanced(GLsizei num_indices, GLsizei num_instances) override;
+
+        [[nodiscard]] GLsync fence_sync() override;
+        [[nodiscard]] bool wait_sync(GLsync sync, uint64_t timeout) override;
+        void delete_sync(GLsync sync) override;
+
+        void push_debug_group(const char* name) override;
+        void pop_debug_group() override;
+
+        // Clears the recorded commands and stats, resources and bound state are kept
+        void reset();
+
+        // Writes the recorded commands one per line, suitable for comparing against a known good stream
+        void write_commands(std::ostream& os) const;
+
+        [[nodiscard]] const std::vector<RecordedCommand>& commands() const noexcept;
+        [[nodiscard]] const std::vector<UniformValue>& uniform_values() const noexcept;
+        [[nodiscard]] const DeviceStats& stats() const noexcept;
+
+    private:
+        struct ShaderInterface
+        {
+            std::vector<ActiveUniform> uniforms;
+            std::vector<std::string> storage_blocks;
+        };
+
+        [[nodiscard]] GLuint next_handle() noexcept;
+        void record(DeviceCommandType type, GLuint object = 0, int64_t arg0 = 0, int64_t arg1 = 0);
+
+        [[nodiscard]] static ShaderInterface parse_interface(std::string_view source);
+
+        bool _record_commands;
+        GLuint _last_handle;
+
+        std::vector<RecordedCommand> _commands;
+        std::vector<UniformValue> _uniform_values;
+        DeviceStats _stats;
+
+        utils::flat_hash_map<GLuint, ShaderInterface> _shaders;
+        utils::flat_hash_map<GLuint, ShaderInterface> _programs;
+        utils::flat_hash_map<GLuint, std::unique_ptr<uint8_t[]>> _mapped_buffers;
+
+        GLuint _bound_program;
+        GLuint _bound_vertex_array;
+        std::vector<GLuint> _bound_textures;
+        std::optional<BlendMode> _blend_mode;
+    };
+}
@@ -1,18 +1,23 @@
 #pragma once
 
-#include <variant>
+#include <optional>
+#include <vector>
 
 #include "draw_call.h"
+#include "frame_data.h"
 #include "sprite_draw_call.h"
 
 namespace rendering
 {
-    // Dummy null op render command
-    struct RenderCommandNullOp {};
-
-    using RenderCommand = std::variant<
-        RenderCommandNullOp,
-        DrawCall,
-        SpriteDrawCall
-    >;
-}
\ No newline at end of file
+    // Render commands submitted by a single thread during a frame
+    // Each kind of command has its own list so commands are only ever moved, never wrapped or visited
+    struct RenderCommandList
+    {
+        std::vector<DrawCall> draw_calls;
+        std::vector<SpriteDrawCall> sprite_draw_calls;
+        std::optional<CameraRenderData> camera_data;
+        std::vector<PointLightRenderData> point_lights;
+        std::vector<SpotLightRenderData> spot_lights;
+        std::vector<DirectionalLightRenderData> directional_lights;
+    };
+}
@@ -1,18 +1,39 @@
 #include "render_queue.h"
 
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
 #include <profiling/scoped_event.h>
-#include <utils/functional.h>
 #include <utils/strtools.h>
+#include <utils/timing.h>
+#include <utils/vectools.h>
 
 #include "texture_binding_cache.h"
-#include "draw_call_tree.h"
+#include "texture_atlas.h"
+#include "caching_device.h"
+#include "upload_ring.h"
 
 using namespace rendering;
 
+namespace
+{
+    // Moves all of source onto the end of destination, leaving source empty but with its capacity intact
+    template <typename T>
+    void append_commands(std::vector<T>& destination, std::vector<T>& source)
+    {
+        std::ranges::move(source, std::back_inserter(destination));
+        source.clear();
+    }
+}
+
 RenderQueue::RenderQueue()
-    : _command_queue_consumer(_command_queue)
-    , _command_buffer_size(16)
-    , _last_command_buffer_usage(0)
+    : _frame_data_buffer("FrameData", GL_STREAM_DRAW)
+    , _point_light_buffer("PointLights", GL_STREAM_DRAW)
+    , _spot_light_buffer("SpotLights", GL_STREAM_DRAW)
+    , _directional_light_buffer("DirectionalLights", GL_STREAM_DRAW)
+    , _light_cluster_buffer("LightClusters", GL_STREAM_DRAW)
+    , _light_index_buffer("LightIndices", GL_STREAM_DRAW)
 { }
 
 void RenderQueue::execute()
@@ -20,22 +41,64 @@ void RenderQueue::execute()
     SCOPED_EVENT("RenderQueue - execute");
     RenderQueueStats stats;
 
+    CachingDevice& state_cache = Device::state_cache();
+    state_cache.reset_stats();
+
     flush_queue();
+    cull_draws(stats);
+    upload_frame_data(stats);
 
+    const size_t num_draws = _draw_calls.size();
     _sprite_batcher.convert_draws(_sprite_draw_calls, _draw_calls);
     _sprite_draw_calls.clear();
 
-    const DrawCallTree tree(std::move(_draw_calls));
-    tree.execute(stats);
+    const TextureAtlasStats& atlas_stats = TextureAtlas::get().stats();
+    stats.sprite_batches = static_cast<int32_t>(_draw_calls.size() - num_draws);
+    stats.atlas_pages = atlas_stats.pages;
+    stats.atlas_occupancy = atlas_stats.occupancy();
+
+    _instance_batcher.batch_draws(_draw_calls);
+
+    _draw_call_list.rebuild(std::move(_draw_calls));
+    _draw_call_list.execute(stats);
+    _draw_call_list.clear();
 
     // TODO: for some reason the texture binding cache breaks after pause if you don't clear it
     TextureBindingCache::get().unbind_all();
+
+    const UploadRingStats upload_stats = UploadRing::get().end_frame();
+    stats.bytes_streamed = upload_stats.bytes_uploaded;
+    stats.buffers_streamed = upload_stats.uploads;
+    stats.stream_reallocations = upload_stats.reallocations;
+    stats.stream_stalls = upload_stats.stalls;
+
+    const StateCacheStats& cache_stats = state_cache.stats();
+    stats.state_changes_submitted = cache_stats.state_changes_submitted;
+    stats.state_changes_skipped = cache_stats.state_changes_skipped;
+    stats.uniforms_submitted = cache_stats.uniforms_submitted;
+    stats.uniforms_skipped = cache_stats.uniforms_skipped;
+
     _queue_stats = stats;
 }
 
-void RenderQueue::enqueue_command(RenderCommand&& command)
+void RenderQueue::enqueue_command(const CameraRenderData& camera_data)
+{
+    thread_command_list().camera_data = camera_data;
+}
+
+void RenderQueue::enqueue_command(const PointLightRenderData& point_light)
 {
-    _command_queue.enqueue(command);
+    thread_command_list().point_lights.push_back(point_light);
+}
+
+void RenderQueue::enqueue_command(const SpotLightRenderData& spot_light)
+{
+    thread_command_list().spot_lights.push_back(spot_light);
+}
+
+void RenderQueue::enqueue_command(const DirectionalLightRenderData& directional_light)
+{
+    thread_command_list().directional_lights.push_back(directional_light);
 }
 
 const RenderQueueStats& RenderQueue::last_frame_stats() const noexcept
@@ -43,54 +106,153 @@ const RenderQueueStats& RenderQueue::last_frame_stats() const noexcept
     return _queue_stats;
 }
 
+RenderQueue::ThreadCommandListHandle::~ThreadCommandListHandle()
+{
+    if (command_list)
+    {
+        command_list->released.store(true, std::memory_order_release);
+    }
+}
+
+std::shared_ptr<RenderQueue::ThreadCommandList> RenderQueue::acquire_command_list()
+{
+    std::lock_guard lock(_command_lists_lock);
+
+    std::shared_ptr<ThreadCommandList> command_list;
+    if (_free_command_lists.empty())
+    {
+        command_list = std::make_shared<ThreadCommandList>();
+    }
+    else
+    {
+        command_list = std::move(_free_command_lists.back());
+        _free_command_lists.pop_back();
+    }
+
+    _command_lists.push_back(command_list);
+    return command_list;
+}
+
 void RenderQueue::flush_queue()
 {
-    SCOPED_EVENT("RenderQueue - flush queue");
+    std::lock_guard lock(_command_lists_lock);
+
+    size_t num_draw_calls = 0;
+    size_t num_sprite_draw_calls = 0;
+    for (const std::shared_ptr<ThreadCommandList>& command_list : _command_lists)
+    {
+        num_draw_calls += command_list->commands.draw_calls.size();
+        num_sprite_draw_calls += command_list->commands.sprite_draw_calls.size();
+    }
 
-    size_t peak_buffer_usage = 0;
-    _command_buffer.resize(_command_buffer_size, RenderCommandNullOp());
+    SCOPED_EVENT("RenderQueue - flush queue", strtools::catf_temp(
+        "%zu lists, %zu draws, %zu sprites", _command_lists.size(), num_draw_calls, num_sprite_draw_calls
+    ));
 
-    // Keep dequeuing in bulk until the queue is empty
-    while (const size_t command_count = _command_queue.try_dequeue_bulk(
-        _command_queue_consumer,
-        _command_buffer.begin(),
-        _command_buffer_size
-    ))
+    _draw_calls.reserve(_draw_calls.size() + num_draw_calls);
+    _sprite_draw_calls.reserve(_sprite_draw_calls.size() + num_sprite_draw_calls);
+
+    for (const std::shared_ptr<ThreadCommandList>& command_list : _command_lists)
     {
-        SCOPED_EVENT("RenderQueue - consume commands", strtools::catf_temp("%d commands", command_count));
-        peak_buffer_usage = std::max(peak_buffer_usage, command_count);
+        RenderCommandList& commands = command_list->commands;
+        append_commands(_draw_calls, commands.draw_calls);
+        append_commands(_sprite_draw_calls, commands.sprite_draw_calls);
+        append_commands(_point_lights, commands.point_lights);
+        append_commands(_spot_lights, commands.spot_lights);
+        append_commands(_directional_lights, commands.directional_lights);
 
-        // If the dequeue saturated our buffer, increase the size by 50% on the next dequeue
-        if (command_count == _command_buffer_size)
+        if (commands.camera_data)
         {
-            _command_buffer_size = static_cast<size_t>(std::ceil(static_cast<double>(_command_buffer_size) * 1.5));
-            _command_buffer.resize(_command_buffer_size, RenderCommandNullOp());
+            _camera_data = std::exchange(commands.camera_data, std::nullopt);
         }
+    }
 
-        for (size_t i = 0; i < command_count; i++)
+    // Lists of exited threads are empty now that everything they held has been moved out, so they can be handed
+    // to the next new thread
+    vectools::remove_all(_command_lists, [&](const std::shared_ptr<ThreadCommandList>& command_list)
+    {
+        if (!command_list->released.load(std::memory_order_acquire))
         {
-            consume_command(_command_buffer[i]);
+            return false;
         }
-    }
 
-    // We don't clear the buffer each frame since initializing it with null ops is expensive
-    // To avoid extending lifetime of resources via commands in the buffer
-    // We can compare this frames peak usage to the previous and only clear those commands
-    // This way we don't thrash the buffer when it's being constantly overwritten
-    for (size_t i = peak_buffer_usage; i < _last_command_buffer_usage; i++)
+        command_list->released.store(false, std::memory_order_relaxed);
+        _free_command_lists.push_back(command_list);
+
+        return true;
+    });
+}
+
+void RenderQueue::cull_draws(RenderQueueStats& stats)
+{
+    if (!_camera_data)
     {
-        _command_buffer[i] = RenderCommandNullOp();
+        return;
     }
 
-    _last_command_buffer_usage = peak_buffer_usage;
+    SCOPED_EVENT("RenderQueue - cull draws");
+    stats.culling_ms = static_cast<float>(timing::measure_ms([&]
+    {
+        const math::Frustum frustum(_camera_data->view_matrix);
+        stats.draws_culled = static_cast<int32_t>(_draw_culler.cull_draws(frustum, _draw_calls));
+        stats.sprites_culled = static_cast<int32_t>(_draw_culler.cull_sprite_draws(_sprite_draw_calls));
+    }));
 }
 
-void RenderQueue::consume_command(RenderCommand& command)
+void RenderQueue::upload_frame_data(RenderQueueStats& stats)
 {
-    std::visit(functional::overload{
-        [&](RenderCommandNullOp&) { /* Do nothing */ },
-        [&](DrawCall& x) { _draw_calls.push_back(std::move(x)); },
-        [&](SpriteDrawCall& x) { _sprite_draw_calls.push_back(std::move(x)); }
-    }, command);
+    SCOPED_EVENT("RenderQueue - upload frame data");
+
+    const CameraRenderData camera_data = _camera_data.value_or(CameraRenderData());
+    stats.light_clustering_ms = static_cast<float>(timing::measure_ms([&]
+    {
+        _light_clusterer.build(camera_data, _point_lights, _spot_lights);
+    }));
+
+    stats.lights_clustered = static_cast<int32_t>(_point_lights.size() + _spot_lights.size());
+    stats.light_cluster_entries = static_cast<int32_t>(_light_clusterer.light_indices().size());
+
+    // The cluster layout is filled in by the light clusterer
+    FrameRenderData& frame_data = _frame_data.emplace_back(FrameRenderData{
+        .view_matrix = camera_data.view_matrix,
+        .view_pos = camera_data.view_pos,
+        .num_point_lights = static_cast<uint32_t>(_point_lights.size()),
+        .view_dir = camera_data.view_dir,
+        .num_spot_lights = static_cast<uint32_t>(_spot_lights.size()),
+        .num_directional_lights = static_cast<uint32_t>(_directional_lights.size()),
+        .cluster_count_x = 0,
+        .cluster_count_y = 0,
+        .cluster_count_z = 0,
+        .cluster_depth_scale = 0,
+        .cluster_depth_bias = 0
+    });
+
+    _light_clusterer.write_frame_data(frame_data);
+
+    upload_frame_buffer(FrameBinding::frame_data, _frame_data_buffer, _frame_data);
+    upload_frame_buffer(FrameBinding::point_lights, _point_light_buffer, _point_lights);
+    upload_frame_buffer(FrameBinding::spot_lights, _spot_light_buffer, _spot_lights);
+    upload_frame_buffer(FrameBinding::directional_lights, _directional_light_buffer, _directional_lights);
+    upload_frame_buffer(FrameBinding::light_clusters, _light_cluster_buffer, _light_clusterer.clusters());
+    upload_frame_buffer(FrameBinding::light_indices, _light_index_buffer, _light_clusterer.light_indices());
+
+    _camera_data = std::nullopt;
+    _frame_data.clear();
+    _point_lights.clear();
+    _spot_lights.clear();
+    _directional_lights.clear();
+}
+
+template <typename T>
+void RenderQueue::upload_frame_buffer(FrameBinding binding, StructuredBuffer<T>& buffer, std::vector<T>& data)
+{
+    // Storage blocks need at least one entry behind them, so upload a blank one which shaders skip using the counts in frame_data
+    if (data.empty())
+    {
+        data.emplace_back();
+    }
+
+    buffer.upload(data);
+    buffer.bind(static_cast<GLuint>(binding));
 }
 
@@ -1,13 +1,21 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <vector>
 
-#include <common/common.h>
 #include <utils/singleton.h>
 
 #include "render_command.h"
 #include "render_queue_stats.h"
 #include "sprite_batcher.h"
+#include "instance_batcher.h"
+#include "draw_call_list.h"
+#include "draw_culler.h"
+#include "light_clusterer.h"
+#include "structured_buffer.h"
 
 namespace rendering
 {
@@ -21,26 +29,104 @@ namespace rendering
         // Executes all items in the render queue
         void execute();
 
-        // Enqueues a render command to the queue
-        void enqueue_command(RenderCommand&& command);
+        // Enqueues render commands to the queue, safe to call from any thread
+        // Each thread appends to its own command list, so enqueuing never contends with other threads
+        void enqueue_command(DrawCall&& draw_call);
+        void enqueue_command(SpriteDrawCall&& sprite_draw_call);
+        void enqueue_command(const CameraRenderData& camera_data);
+        void enqueue_command(const PointLightRenderData& point_light);
+        void enqueue_command(const SpotLightRenderData& spot_light);
+        void enqueue_command(const DirectionalLightRenderData& directional_light);
 
         // Various stats about the render queue from the previous frame
         [[nodiscard]] const RenderQueueStats& last_frame_stats() const noexcept;
 
     private:
+        // A command list along with whether the thread it was handed to has exited
+        struct ThreadCommandList
+        {
+            RenderCommandList commands;
+            std::atomic<bool> released = false;
+        };
+
+        // Shares ownership of the calling thread's list with the queue, so that the thread can release the list
+        // when it exits without touching the queue, which may already have been destroyed
+        struct ThreadCommandListHandle
+        {
+            std::shared_ptr<ThreadCommandList> command_list;
+
+            ~ThreadCommandListHandle();
+        };
+
+        // Gets the command list of the calling thread, handing it a list on the thread's first use
+        [[nodiscard]] RenderCommandList& thread_command_list();
+
+        // Hands out a free list, reusing the list of an exited thread where possible so it keeps its capacity
+        [[nodiscard]] std::shared_ptr<ThreadCommandList> acquire_command_list();
+
+        // Moves the commands of every thread's list into the queue, must not run while commands are being enqueued
         void flush_queue();
-        void consume_command(RenderCommand& command);
+
+        // Removes draws outside of the camera's view, does nothing if no camera was submitted
+        void cull_draws(RenderQueueStats& stats);
+
+        // Uploads the camera and lights submitted this frame and binds them for every shader to read
+        void upload_frame_data(RenderQueueStats& stats);
+
+        template <typename T>
+        void upload_frame_buffer(FrameBinding binding, StructuredBuffer<T>& buffer, std::vector<T>& data);
 
         SpriteBatcher _sprite_batcher;
+        InstanceBatcher _instance_batcher;
+        DrawCuller _draw_culler;
+        LightClusterer _light_clusterer;
+        DrawCallList _draw_call_list;
 
-        common::concurrent_queue<RenderCommand> _command_queue;
-        moodycamel::ConsumerToken _command_queue_consumer;
-        std::vector<RenderCommand> _command_buffer;
-        size_t _command_buffer_size;
-        size_t _last_command_buffer_usage;
+        // Lists of exited threads are moved to the free lists once the commands left in them have been flushed
+        std::mutex _command_lists_lock;
+        std::vector<std::shared_ptr<ThreadCommandList>> _command_lists;
+        std::vector<std::shared_ptr<ThreadCommandList>> _free_command_lists;
 
         std::vector<DrawCall> _draw_calls;
         std::vector<SpriteDrawCall> _sprite_draw_calls;
+
+        std::optional<CameraRenderData> _camera_data;
+        std::vector<FrameRenderData> _frame_data;
+        std::vector<PointLightRenderData> _point_lights;
+        std::vector<SpotLightRenderData> _spot_lights;
+        std::vector<DirectionalLightRenderData> _directional_lights;
+
+        StructuredBuffer<FrameRenderData> _frame_data_buffer;
+        StructuredBuffer<PointLightRenderData> _point_light_buffer;
+        StructuredBuffer<SpotLightRenderData> _spot_light_buffer;
+        StructuredBuffer<DirectionalLightRenderData> _directional_light_buffer;
+        StructuredBuffer<LightClusterRenderData> _light_cluster_buffer;
+        StructuredBuffer<uint32_t> _light_index_buffer;
+
         RenderQueueStats _queue_stats;
     };
+
+    // Draws and sprites are enqueued by the thousand every frame, so these are defined here to be inlined into
+    // their callers
+    inline void RenderQueue::enqueue_command(DrawCall&& draw_call)
+    {
+        thread_command_list().draw_calls.push_back(std::move(draw_call));
+    }
+
+    inline void RenderQueue::enqueue_command(SpriteDrawCall&& sprite_draw_call)
+    {
+        thread_command_list().sprite_draw_calls.push_back(std::move(sprite_draw_call));
+    }
+
+    inline RenderCommandList& RenderQueue::thread_command_list()
+    {
+        // Only the first enqueue on each thread takes the lock
+        thread_local ThreadCommandListHandle handle;
+        if (!handle.command_list)
+        {
+            handle.command_list = acquire_command_list();
+        }
+
+        return handle.command_list->commands;
+    }
 }
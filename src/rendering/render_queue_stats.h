@@ -11,5 +11,32 @@ namespace rendering
         int32_t triangles = 0;
         int32_t shader_switches = 0;
         int32_t mesh_switches = 0;
+
+        // Draws removed by frustum culling, and the time spent culling
+        int32_t draws_culled = 0;
+        int32_t sprites_culled = 0;
+        float culling_ms = 0;
+
+        // Draws emitted for all sprites after batching, and how full the texture atlas pages are
+        int32_t sprite_batches = 0;
+        int32_t atlas_pages = 0;
+        float atlas_occupancy = 0;
+
+        // Point and spot lights assigned to clusters, and the time spent building the clusters
+        int32_t lights_clustered = 0;
+        int32_t light_cluster_entries = 0;
+        float light_clustering_ms = 0;
+
+        // Per frame data streamed through the upload ring, and how often it had to grow or wait on the GPU
+        int64_t bytes_streamed = 0;
+        int32_t buffers_streamed = 0;
+        int32_t stream_reallocations = 0;
+        int32_t stream_stalls = 0;
+
+        // Calls that reached the device backend versus those dropped by the state cache as redundant
+        int32_t state_changes_submitted = 0;
+        int32_t state_changes_skipped = 0;
+        int32_t uniforms_submitted = 0;
+        int32_t uniforms_skipped = 0;
     };
 }
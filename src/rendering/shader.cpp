@@ -1,7 +1,6 @@
 #include "shader.h"
 
 #include <unordered_set>
-#include <filesystem>
 
 #include <core/asset.h>
 #include <utils/utils.h>
@@ -9,6 +8,8 @@
 #include <memory/gc.h>
 #include <profiling/scoped_event.h>
 
+#include "device.h"
+#include "frame_data.h"
 #include "shader_compiler.h"
 #include "shader_buffer.h"
 #include "primitives.h"
@@ -19,15 +20,17 @@ using namespace math;
 Shader::Shader(
     const std::string& name,
     const std::string& vert_shader_path,
-    const std::string& frag_shader_path
+    const std::string& frag_shader_path,
+    const std::vector<std::string>& keywords
 )
-    : Shader(utils::copy(name), vert_shader_path, frag_shader_path)
+    : Shader(utils::copy(name), vert_shader_path, frag_shader_path, keywords)
 { }
 
 Shader::Shader(
     std::string&& name,
     const std::string& vert_shader_path,
-    const std::string& frag_shader_path
+    const std::string& frag_shader_path,
+    const std::vector<std::string>& keywords
 )
     : _name(std::move(name))
     , _broken(false)
@@ -37,80 +40,67 @@ Shader::Shader(
     SCOPED_EVENT("Building shader", _name.c_str());
     Logger::log("Building shader '%s'", _name.c_str());
 
-    ShaderCompiler compiler;
-    PreprocessedShader preprocessed_vert_shader = compiler.preprocess_shader(vert_shader_path, ShaderType::vertex);
-    PreprocessedShader preprocessed_frag_shader = compiler.preprocess_shader(frag_shader_path, ShaderType::fragment);
+    const ShaderCompiler compiler;
+    const std::vector<ShaderSymbol> parsed_keywords = ShaderCompiler::parse_keywords(keywords);
 
-    const GLuint vert_shader = compiler.compile_shader(preprocessed_vert_shader);
-    const GLuint frag_shader = compiler.compile_shader(preprocessed_frag_shader);
+    const peng::shared_ref<const CompiledShader> vert_shader = compiler.load_shader(
+        vert_shader_path, ShaderType::vertex, parsed_keywords
+    );
+
+    const peng::shared_ref<const CompiledShader> frag_shader = compiler.load_shader(
+        frag_shader_path, ShaderType::fragment, parsed_keywords
+    );
+
+    _vert_shader = vert_shader;
+    _frag_shader = frag_shader;
 
     std::unordered_set<std::string> seen_symbols;
 
-    for (ShaderSymbol& symbol : preprocessed_vert_shader.symbols)
+    for (const ShaderSymbol& symbol : vert_shader->symbols())
     {
         if (!seen_symbols.contains(symbol.identifier))
         {
             seen_symbols.insert(symbol.identifier);
-            _symbols.push_back(std::move(symbol));
+            _symbols.push_back(symbol);
         }
     }
 
-    for (ShaderSymbol& symbol : preprocessed_frag_shader.symbols)
+    for (const ShaderSymbol& symbol : frag_shader->symbols())
     {
         if (!seen_symbols.contains(symbol.identifier))
         {
             seen_symbols.insert(symbol.identifier);
-            _symbols.push_back(std::move(symbol));
+            _symbols.push_back(symbol);
         }
     }
 
-    _broken |= !validate_shader_compile(vert_shader);
-    _broken |= !validate_shader_compile(frag_shader);
+    _broken |= !validate_shader_compile(*vert_shader.get());
+    _broken |= !validate_shader_compile(*frag_shader.get());
 
-    {
-        namespace fs = std::filesystem;
-        glObjectLabel(GL_SHADER, vert_shader, -1, fs::path(vert_shader_path).filename().string().c_str());
-        glObjectLabel(GL_SHADER, frag_shader, -1, fs::path(frag_shader_path).filename().string().c_str());
-    }
+    Device& device = Device::get();
 
+    // The compiled shaders stay attached to the program since they're shared with other programs
     Logger::log("Linking shader program");
-    _program = glCreateProgram();
-    glAttachShader(_program, vert_shader);
-    glAttachShader(_program, frag_shader);
-    glLinkProgram(_program);
+    const GLuint shaders[] = { vert_shader->shader(), frag_shader->shader() };
+    _program = device.link_program(shaders, _name.c_str());
     _broken |= !validate_shader_link(_program);
 
-    glObjectLabel(GL_PROGRAM, _program, -1, _name.c_str());
-
-    glDeleteShader(vert_shader);
-    glDeleteShader(frag_shader);
-
     if (!_broken)
     {
         Logger::log("Extracting uniform information");
 
-        GLint num_uniforms;
-        glGetProgramiv(_program, GL_ACTIVE_UNIFORMS, &num_uniforms);
+        std::vector<ActiveUniform> active_uniforms = device.active_uniforms(_program);
+        _uniforms.resize(active_uniforms.size());
 
-        _uniforms.resize(num_uniforms);
-        for (GLint i = 0; i < num_uniforms; i++)
+        for (ActiveUniform& active_uniform : active_uniforms)
         {
-            constexpr int32_t buf_size = 512;
-            char name_buf[buf_size];
-            GLint name_length;
-            GLint size;
-            GLenum type;
-
-            glGetActiveUniform(_program, i, buf_size, &name_length, &size, &type, name_buf);
-            const GLint location = glGetUniformLocation(_program, name_buf);
-
             // If a uniform has a location of -1 it's a non user uniform like the built in gl_ uniforms
-            if (location != -1)
+            if (active_uniform.location != -1)
             {
-                Uniform& uniform = _uniforms[location];
-                uniform.location = location;
-                uniform.name = name_buf;
-                uniform.type = type;
+                Uniform& uniform = _uniforms[active_uniform.location];
+                uniform.location = active_uniform.location;
+                uniform.name = std::move(active_uniform.name);
+                uniform.type = active_uniform.type;
                 uniform.default_value = read_uniform(uniform);
             }
         }
@@ -122,18 +112,25 @@ Shader::~Shader()
     SCOPED_EVENT("Destroying shader", _name.c_str());
     Logger::log("Destroying shader '%s'", _name.c_str());
 
-    glDeleteProgram(_program);
+    Device::get().delete_program(_program);
 }
 
 peng::shared_ref<Shader> Shader::load_asset(const Archive& archive)
 {
     const std::string vert = archive.read<std::string>("vert");
     const std::string frag = archive.read<std::string>("frag");
+    const std::vector<std::string> keywords = archive.read_or<std::vector<std::string>>("keywords");
 
-    peng::shared_ref<Shader> shader = memory::GC::alloc<Shader>(archive.name, vert, frag);
+    peng::shared_ref<Shader> shader = memory::GC::alloc<Shader>(archive.name, vert, frag, keywords);
     shader->draw_order() = archive.read_or("draw_order", 0);
     shader->blend_mode() = static_cast<BlendMode>(archive.read_or("blend_mode", 0));
 
+    const std::string instanced_variant = archive.read_or<std::string>("instanced_variant");
+    if (!instanced_variant.empty())
+    {
+        shader->_instanced_variant = Asset<Shader>(instanced_variant).load();
+    }
+
     return shader;
 }
 
@@ -149,35 +146,21 @@ peng::shared_ref<const Shader> Shader::fallback()
 void Shader::use() const
 {
     check(!_broken);
-    glUseProgram(_program);
 
-    switch (_blend_mode)
-    {
-        case BlendMode::opaque:
-        {
-            glDisable(GL_BLEND);
-            glBlendFunc(GL_ONE, GL_ZERO);
-            break;
-        }
-        case BlendMode::alpha_blend:
-        {
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            break;
-        }
-        default:
-        {
-            throw std::runtime_error(strtools::catf("Invalid blend mode %d", _blend_mode));
-        }
-    }
+    Device& device = Device::get();
+    device.use_program(_program);
+    device.set_blend_mode(_blend_mode);
 }
 
 void Shader::bind_buffer(GLint index, const peng::shared_ref<const IShaderBuffer>& buffer) const
 {
     check(index >= 0);
 
-    glShaderStorageBlockBinding(_program, index, index);
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, index, buffer->get_ssbo());
+    // Bindings below FrameBinding::count are reserved for the per frame buffers
+    const GLuint binding = static_cast<GLuint>(index) + static_cast<GLuint>(FrameBinding::count);
+
+    Device::get().storage_block_binding(_program, index, binding);
+    buffer->bind(binding);
 }
 
 int32_t& Shader::draw_order() noexcept
@@ -195,6 +178,16 @@ const std::string& Shader::name() const noexcept
     return _name;
 }
 
+uint32_t Shader::sort_id() const noexcept
+{
+    return _sort_id.value();
+}
+
+const peng::shared_ptr<const Shader>& Shader::instanced_variant() const noexcept
+{
+    return _instanced_variant;
+}
+
 bool Shader::broken() const noexcept
 {
     return _broken;
@@ -219,7 +212,7 @@ BlendMode Shader::blend_mode() const noexcept
     return _blend_mode;
 }
 
-GLint Shader::get_uniform_location(const std::string& name) const
+GLint Shader::get_uniform_location(std::string_view name) const
 {
     for (const Uniform& uniform : _uniforms)
     {
@@ -234,10 +227,7 @@ GLint Shader::get_uniform_location(const std::string& name) const
 
 GLint Shader::get_buffer_location(const std::string& name) const
 {
-    const GLuint index = glGetProgramResourceIndex(_program, GL_SHADER_STORAGE_BLOCK, name.c_str());
-    return index == GL_INVALID_INDEX
-        ? -1
-        : index;
+    return Device::get().storage_block_index(_program, name.c_str());
 }
 
 std::optional<std::string> Shader::get_symbol_value(const std::string& identifier) const noexcept
@@ -276,204 +266,55 @@ const std::vector<ShaderSymbol>& Shader::symbols() const noexcept
     return _symbols;
 }
 
-bool Shader::validate_shader_compile(GLuint shader) const
+bool Shader::validate_shader_compile(const CompiledShader& shader) const
 {
-    GLint success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    std::string error_log;
+    const bool success = Device::get().shader_compiled(shader.shader(), error_log);
 
-    if constexpr (Logger::enabled())
+    if (!success)
     {
-        if (!success)
-        {
-            GLint error_length;
-            glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &error_length);
+        Logger::error(error_log);
 
-            std::vector<GLchar> error_log(error_length);
-            glGetShaderInfoLog(shader, error_length, nullptr, error_log.data());
-            Logger::error(error_log.data());
+        // Errors are reported against source string numbers, which refer to the files the shader was built from
+        for (size_t source = 0; source < shader.sources().size(); source++)
+        {
+            Logger::error("Source %zu is '%s'", source, shader.sources()[source].c_str());
         }
     }
 
-    return success == GL_TRUE;
+    return success;
 }
 
-bool Shader::validate_shader_link(GLuint shader) const
+bool Shader::validate_shader_link(GLuint program) const
 {
-    GLint success;
-    glGetProgramiv(shader, GL_LINK_STATUS, &success);
+    std::string error_log;
+    const bool success = Device::get().program_linked(program, error_log);
 
-    if constexpr (Logger::enabled())
+    if (!success)
     {
-        if (!success)
-        {
-            GLint error_length;
-            glGetProgramiv(shader, GL_INFO_LOG_LENGTH, &error_length);
-
-            std::vector<GLchar> error_log(error_length);
-            glGetProgramInfoLog(shader, error_length, nullptr, error_log.data());
-            Logger::error(error_log.data());
-        }
+        Logger::error(error_log);
     }
 
-    return success == GL_TRUE;
+    return success;
 }
 
 std::optional<Shader::Parameter> Shader::read_uniform(const Uniform& uniform) const
 {
-    switch (uniform.type)
+    if (uniform.type == GL_SAMPLER_2D)
     {
-        case GL_INT:
-        {
-            int32_t value;
-            glGetnUniformiv(_program, uniform.location, sizeof(value), &value);
-
-            return value;
-        }
-        case GL_UNSIGNED_INT:
-        {
-            uint32_t value;
-            glGetnUniformuiv(_program, uniform.location, sizeof(value), &value);
-
-            return value;
-        }
-        case GL_FLOAT:
-        {
-            float value;
-            glGetnUniformfv(_program, uniform.location, sizeof(value), &value);
-
-            return value;
-        }
-        case GL_DOUBLE:
-        {
-            double value;
-            glGetnUniformdv(_program, uniform.location, sizeof(value), &value);
-
-            return value;
-        }
-        case GL_INT_VEC2:
-        {
-            int32_t value[2];
-            glGetnUniformiv(_program, uniform.location, sizeof(value), value);
-
-            return Vector2i(value[0], value[1]);
-        }
-        case GL_UNSIGNED_INT_VEC2:
-        {
-            uint32_t value[2];
-            glGetnUniformuiv(_program, uniform.location, sizeof(value), value);
-
-            return Vector2u(value[0], value[1]);
-        }
-        case GL_FLOAT_VEC2:
-        {
-            float value[2];
-            glGetnUniformfv(_program, uniform.location, sizeof(value), value);
-
-            return Vector2f(value[0], value[1]);
-        }
-        case GL_DOUBLE_VEC2:
-        {
-            double value[2];
-            glGetnUniformdv(_program, uniform.location, sizeof(value), value);
-
-            return Vector2d(value[0], value[1]);
-        }
-        case GL_INT_VEC3:
-        {
-            int32_t value[3];
-            glGetnUniformiv(_program, uniform.location, sizeof(value), value);
-
-            return Vector3i(value[0], value[1], value[2]);
-        }
-        case GL_UNSIGNED_INT_VEC3:
-        {
-            uint32_t value[3];
-            glGetnUniformuiv(_program, uniform.location, sizeof(value), value);
-
-            return Vector3u(value[0], value[1], value[2]);
-        }
-        case GL_FLOAT_VEC3:
-        {
-            float value[3];
-            glGetnUniformfv(_program, uniform.location, sizeof(value), value);
-
-            return Vector3f(value[0], value[1], value[2]);
-        }
-        case GL_DOUBLE_VEC3:
-        {
-            double value[3];
-            glGetnUniformdv(_program, uniform.location, sizeof(value), value);
-
-            return Vector3d(value[0], value[1], value[2]);
-        }
-        case GL_INT_VEC4:
-        {
-            int32_t value[4];
-            glGetnUniformiv(_program, uniform.location, sizeof(value), value);
-
-            return Vector4i(value[0], value[1], value[2], value[3]);
-        }
-        case GL_UNSIGNED_INT_VEC4:
-        {
-            uint32_t value[4];
-            glGetnUniformuiv(_program, uniform.location, sizeof(value), value);
-
-            return Vector4u(value[0], value[1], value[2], value[3]);
-        }
-        case GL_FLOAT_VEC4:
-        {
-            float value[4];
-            glGetnUniformfv(_program, uniform.location, sizeof(value), value);
-
-            return Vector4f(value[0], value[1], value[2], value[3]);
-        }
-        case GL_DOUBLE_VEC4:
-        {
-            double value[4];
-            glGetnUniformdv(_program, uniform.location, sizeof(value), value);
-
-            return Vector4d(value[0], value[1], value[2], value[3]);
-        }
-        case GL_FLOAT_MAT3:
-        {
-            std::array<float, 9> value;
-            glGetnUniformfv(_program, uniform.location, sizeof(value), value.data());
-
-            return Matrix3x3f(value);
-        }
-        case GL_DOUBLE_MAT3:
-        {
-            std::array<double, 9> value;
-            glGetnUniformdv(_program, uniform.location, sizeof(value), value.data());
-
-            return Matrix3x3d(value);
-        }
-        case GL_FLOAT_MAT4:
-        {
-            std::array<float, 16> value;
-            glGetnUniformfv(_program, uniform.location, sizeof(value), value.data());
-
-            return Matrix4x4f(value);
-        }
-        case GL_DOUBLE_MAT4:
-        {
-            std::array<double, 16> value;
-            glGetnUniformdv(_program, uniform.location, sizeof(value), value.data());
+        return Primitives::white_tex();
+    }
 
-            return Matrix4x4d(value);
-        }
-        case GL_SAMPLER_2D:
-        {
-            return Primitives::white_tex();
-        }
-        default:
-        {
-            Logger::get().logf(LogSeverity::error,
-                "Unable to get default value of parameter %s due to unsupported uniform type 0x%x",
-                uniform.name.c_str(), uniform.type
-            );
+    const std::optional<UniformValue> value = Device::get().uniform_value(_program, uniform.location, uniform.type);
+    if (!value)
+    {
+        Logger::get().logf(LogSeverity::error,
+            "Unable to get default value of parameter %s due to unsupported uniform type 0x%x",
+            uniform.name.c_str(), uniform.type
+        );
 
-            return std::nullopt;
-        }
+        return std::nullopt;
     }
+
+    return std::visit([](const auto& x) { return Parameter(x); }, *value);
 }
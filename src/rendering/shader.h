@@ -1,14 +1,16 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <variant>
 #include <optional>
 
 #include <GL/glew.h>
-#include <memory/shared_ref.h>
+#include <memory/shared_ptr.h>
 #include <math/matrix3x3.h>
 #include <math/matrix4x4.h>
+#include <utils/sequential_id.h>
 
 #include "blend_mode.h"
 #include "shader_symbol.h"
@@ -19,6 +21,7 @@ struct Archive;
 namespace rendering
 {
     class IShaderBuffer;
+    class CompiledShader;
 
     // TODO: add back-face culling
     class Shader
@@ -56,16 +59,19 @@ namespace rendering
             std::optional<Parameter> default_value;
         };
 
+        // Keywords are written as NAME or NAME=VALUE and select a permutation of the vertex and fragment shaders
         Shader(
             const std::string& name,
             const std::string& vert_shader_path, 
-            const std::string& frag_shader_path
+            const std::string& frag_shader_path,
+            const std::vector<std::string>& keywords = {}
         );
 
         Shader(
             std::string&& name,
             const std::string& vert_shader_path,
-            const std::string& frag_shader_path
+            const std::string& frag_shader_path,
+            const std::vector<std::string>& keywords = {}
         );
 
         Shader(const Shader&) = delete;
@@ -82,12 +88,20 @@ namespace rendering
         [[nodiscard]] BlendMode& blend_mode() noexcept;
 
         [[nodiscard]] const std::string& name() const noexcept;
+
+        // Small id unique among live shaders, used when sorting draws and reused once this shader is destroyed
+        [[nodiscard]] uint32_t sort_id() const noexcept;
+
+        // A variant of this shader which reads per instance data from a mesh_instance_data buffer
+        // Used to merge draws that only differ in model matrix, normal matrix and base color into an instanced draw
+        [[nodiscard]] const peng::shared_ptr<const Shader>& instanced_variant() const noexcept;
+
         [[nodiscard]] bool broken() const noexcept;
         [[nodiscard]] bool requires_blending() const noexcept;
         [[nodiscard]] int32_t draw_order() const noexcept;
         [[nodiscard]] BlendMode blend_mode() const noexcept;
 
-        [[nodiscard]] GLint get_uniform_location(const std::string& name) const;
+        [[nodiscard]] GLint get_uniform_location(std::string_view name) const;
         [[nodiscard]] GLint get_buffer_location(const std::string& name) const;
         [[nodiscard]] std::optional<std::string> get_symbol_value(const std::string& identifier) const noexcept;
         [[nodiscard]] bool has_symbol(const std::string& identifier) const noexcept;
@@ -96,12 +110,13 @@ namespace rendering
         [[nodiscard]] const std::vector<ShaderSymbol>& symbols() const noexcept;
 
     private:
-        bool validate_shader_compile(GLuint shader) const;
-        bool validate_shader_link(GLuint shader) const;
+        bool validate_shader_compile(const CompiledShader& shader) const;
+        bool validate_shader_link(GLuint program) const;
 
         [[nodiscard]] std::optional<Parameter> read_uniform(const Uniform& uniform) const;
 
         std::string _name;
+        utils::SequentialId<Shader> _sort_id;
         GLuint _program;
         bool _broken;
 
@@ -109,5 +124,10 @@ namespace rendering
         BlendMode _blend_mode;
         std::vector<Uniform> _uniforms;
         std::vector<ShaderSymbol> _symbols;
+        peng::shared_ptr<const Shader> _instanced_variant;
+
+        // Kept so that shaders loaded later can reuse these compiles
+        peng::shared_ptr<const CompiledShader> _vert_shader;
+        peng::shared_ptr<const CompiledShader> _frag_shader;
     };
 }
\ No newline at end of file
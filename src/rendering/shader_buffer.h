@@ -10,8 +10,8 @@ namespace rendering
         IShaderBuffer() = default;
         virtual ~IShaderBuffer() = default;
 
-        // Gets the SSBO for this shader buffer
-        // Requires that data has already been created
-        [[nodiscard]] virtual GLuint get_ssbo() const = 0;
+        // Binds the data of this shader buffer to a shader storage binding point
+        // Requires that data has already been uploaded
+        virtual void bind(GLuint binding) const = 0;
     };
 }
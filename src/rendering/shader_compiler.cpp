@@ -1,62 +1,709 @@
 #include "shader_compiler.h"
 
-#include <regex>
+#include <algorithm>
+#include <filesystem>
 
 #include <core/logger.h>
+#include <profiling/scoped_event.h>
 #include <utils/io.h>
+#include <utils/strtools.h>
+
+#include "device.h"
 
 using namespace rendering;
 
-PreprocessedShader ShaderCompiler::preprocess_shader(const std::string& path, ShaderType type) const
+namespace
 {
-    Logger::log("Loading %s shader '%s'", strtools::cat(type).c_str(), path.c_str());
-    const std::string shader_src = io::read_text_file(path);
+    enum class Directive
+    {
+        none,
+        version,
+        include,
+        pragma_symbol,
+        define,
+        undef,
+        if_defined,
+        if_not_defined,
+        if_expression,
+        else_if,
+        else_branch,
+        end_if
+    };
 
-    return preprocess_shader(path, type, shader_src);
-}
+    // Whether the lines in a conditional block are compiled, unknown for #if expressions which are left to the driver
+    enum class BlockState
+    {
+        active,
+        inactive,
+        unknown
+    };
 
-PreprocessedShader ShaderCompiler::preprocess_shader(const std::string& /*path*/, ShaderType type, const std::string& src) const
-{
-    PreprocessedShader shader;
-    shader.type = type;
-    shader.contents = src;
+    struct Conditional
+    {
+        BlockState state;
+        bool taken;
+    };
+
+    [[nodiscard]] bool is_identifier_start(char c) noexcept
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    [[nodiscard]] bool is_identifier_char(char c) noexcept
+    {
+        return is_identifier_start(c) || (c >= '0' && c <= '9');
+    }
 
-    std::istringstream stream(shader.contents);
-    std::string line;
+    [[nodiscard]] std::string_view trim_start(std::string_view str) noexcept
+    {
+        const size_t start = str.find_first_not_of(" \t");
+        return start == std::string_view::npos ? std::string_view() : str.substr(start);
+    }
 
-    while (std::getline(stream, line))
+    // Consumes an identifier from the start of str, returning an empty view if there isn't one
+    [[nodiscard]] std::string_view read_identifier(std::string_view& str) noexcept
     {
-        static thread_local std::smatch matches;
-        static thread_local std::regex symbol_regex(R"(#pragma\s+symbol\s+([A-Za-z_]+))");
-        static thread_local std::regex define_regex(R"(#define\s+([A-Za-z_]+)\s+([A-Za-z0-9_]+))");
+        if (str.empty() || !is_identifier_start(str[0]))
+        {
+            return {};
+        }
 
-        if (std::regex_search(line, matches, symbol_regex))
+        size_t length = 1;
+        while (length < str.size() && is_identifier_char(str[length]))
         {
-            shader.symbols.push_back(ShaderSymbol{ matches[1], "" });
+            length++;
         }
 
-        if (std::regex_search(line, matches, define_regex))
+        const std::string_view identifier = str.substr(0, length);
+        str.remove_prefix(length);
+
+        return identifier;
+    }
+
+    // Consumes a token up to the next whitespace or comment
+    [[nodiscard]] std::string_view read_token(std::string_view& str) noexcept
+    {
+        size_t length = 0;
+        while (length < str.size() && str[length] != ' ' && str[length] != '\t' && !str.substr(length).starts_with("//"))
         {
-            shader.symbols.push_back(ShaderSymbol{ matches[1], matches[2]});
+            length++;
         }
+
+        const std::string_view token = str.substr(0, length);
+        str.remove_prefix(length);
+
+        return token;
     }
 
-    return shader;
+    // Reads the path from "path" or <path>
+    [[nodiscard]] std::string_view read_include_path(std::string_view str) noexcept
+    {
+        if (str.empty() || (str[0] != '"' && str[0] != '<'))
+        {
+            return {};
+        }
+
+        const size_t end = str.find(str[0] == '"' ? '"' : '>', 1);
+        return end == std::string_view::npos ? std::string_view() : str.substr(1, end - 1);
+    }
+}
+
+struct ShaderCompiler::SourceFile
+{
+    struct Line
+    {
+        Directive directive = Directive::none;
+        std::string_view text;
+        std::string_view name;
+        std::string_view value;
+    };
+
+    std::string path;
+    std::string contents;
+    std::vector<Line> lines;
+
+    // Every identifier in the file, used to find which keywords it could be affected by
+    std::unordered_set<std::string_view> identifiers;
+};
+
+struct ShaderCompiler::PreprocessState
+{
+    std::string contents;
+    std::vector<ShaderSymbol> symbols;
+    std::vector<std::string> sources;
+    std::vector<peng::shared_ref<const ShaderCompiler::SourceFile>> includes;
+    std::unordered_set<std::string> included;
+    std::unordered_set<std::string> defines;
+    std::vector<Conditional> conditionals;
+
+    [[nodiscard]] bool active() const noexcept
+    {
+        return std::ranges::none_of(conditionals, [](const Conditional& conditional)
+        {
+            return conditional.state == BlockState::inactive;
+        });
+    }
+};
+
+std::mutex ShaderCompiler::_sources_mutex;
+std::unordered_map<std::string, peng::shared_ref<const ShaderCompiler::SourceFile>> ShaderCompiler::_sources;
+std::unordered_map<ShaderCompiler::CompiledKey, peng::weak_ptr<const CompiledShader>> ShaderCompiler::_compiled_shaders;
+
+CompiledShader::CompiledShader(GLuint shader, const PreprocessedShader& preprocessed_shader)
+    : _shader(shader)
+    , _type(preprocessed_shader.type)
+    , _symbols(preprocessed_shader.symbols)
+    , _sources(preprocessed_shader.sources)
+{ }
+
+CompiledShader::~CompiledShader()
+{
+    Device::get().delete_shader(_shader);
+}
+
+GLuint CompiledShader::shader() const noexcept
+{
+    return _shader;
+}
+
+ShaderType CompiledShader::type() const noexcept
+{
+    return _type;
+}
+
+const std::vector<ShaderSymbol>& CompiledShader::symbols() const noexcept
+{
+    return _symbols;
+}
+
+const std::vector<std::string>& CompiledShader::sources() const noexcept
+{
+    return _sources;
+}
+
+ShaderCompiler::ShaderCompiler()
+{
+    add_include_path(default_include_root);
+}
+
+PreprocessedShader ShaderCompiler::preprocess_shader(
+    const std::string& path,
+    ShaderType type,
+    std::span<const ShaderSymbol> keywords
+) const
+{
+    Logger::log("Loading %s shader '%s'", strtools::cat(type).c_str(), path.c_str());
+    return preprocess_root(*load_source(path).get(), type, keywords);
+}
+
+PreprocessedShader ShaderCompiler::preprocess_shader(
+    const std::string& path,
+    ShaderType type,
+    const std::string& src,
+    std::span<const ShaderSymbol> keywords
+) const
+{
+    // The file isn't taken from the cache since its source may not match what's on disk
+    return preprocess_root(*parse_source(path, std::string(src)).get(), type, keywords);
 }
 
 GLuint ShaderCompiler::compile_shader(const PreprocessedShader& preprocessed_shader) const
 {
     Logger::log("Compiling %s shader", strtools::cat(preprocessed_shader.type).c_str());
 
-    const GLuint shader = glCreateShader(to_opengl(preprocessed_shader.type));
-    const char* shader_src = preprocessed_shader.contents.c_str();
-    glShaderSource(shader, 1, &shader_src, nullptr);
-    glCompileShader(shader);
+    namespace fs = std::filesystem;
+    const std::string label = fs::path(preprocessed_shader.path).filename().string();
 
-    return shader;
+    return Device::get().compile_shader(
+        to_opengl(preprocessed_shader.type),
+        preprocessed_shader.contents,
+        label.c_str()
+    );
+}
+
+peng::shared_ref<const CompiledShader> ShaderCompiler::load_shader(
+    const std::string& path,
+    ShaderType type,
+    std::span<const ShaderSymbol> keywords
+) const
+{
+    PreprocessedShader preprocessed_shader = preprocess_shader(path, type, keywords);
+
+    peng::weak_ptr<const CompiledShader>& existing = _compiled_shaders[
+        CompiledKey(path, type, hash_keywords(preprocessed_shader.keywords))
+    ];
+
+    if (const peng::shared_ptr<const CompiledShader> existing_locked = existing.lock())
+    {
+        Logger::log("Reusing compiled %s shader", strtools::cat(type).c_str());
+        return existing_locked.to_shared_ref();
+    }
+
+    const GLuint shader = compile_shader(preprocessed_shader);
+    const peng::shared_ref<const CompiledShader> compiled = peng::make_shared<CompiledShader>(shader, preprocessed_shader);
+    existing = compiled;
+
+    return compiled;
 }
 
 void ShaderCompiler::add_include_path(const std::string& include_path)
 {
     _include_roots.push_back(include_path);
 }
+
+std::vector<ShaderSymbol> ShaderCompiler::parse_keywords(std::span<const std::string> keywords)
+{
+    std::vector<ShaderSymbol> parsed;
+    parsed.reserve(keywords.size());
+
+    for (const std::string& keyword : keywords)
+    {
+        const size_t separator = keyword.find('=');
+        if (separator == std::string::npos)
+        {
+            parsed.push_back(ShaderSymbol{ keyword, "" });
+        }
+        else
+        {
+            parsed.push_back(ShaderSymbol{ keyword.substr(0, separator), keyword.substr(separator + 1) });
+        }
+    }
+
+    std::ranges::stable_sort(parsed, {}, &ShaderSymbol::identifier);
+
+    // Where a keyword is given twice the first value is kept
+    const auto duplicates = std::ranges::unique(parsed, {}, &ShaderSymbol::identifier);
+    parsed.erase(duplicates.begin(), duplicates.end());
+
+    return parsed;
+}
+
+size_t ShaderCompiler::hash_keywords(std::span<const ShaderSymbol> keywords) noexcept
+{
+    size_t hash = 0;
+    for (const ShaderSymbol& keyword : keywords)
+    {
+        hash = utils::hash_combine(hash, std::hash<std::string>()(keyword.identifier));
+        hash = utils::hash_combine(hash, std::hash<std::string>()(keyword.value));
+    }
+
+    return hash;
+}
+
+peng::shared_ref<const ShaderCompiler::SourceFile> ShaderCompiler::load_source(const std::string& path)
+{
+    {
+        std::lock_guard lock(_sources_mutex);
+        if (const auto it = _sources.find(path); it != _sources.end())
+        {
+            return it->second;
+        }
+    }
+
+    const peng::shared_ref<const SourceFile> source = parse_source(path, io::read_text_file(path));
+
+    // If another thread parsed the same file first then its copy is used instead
+    std::lock_guard lock(_sources_mutex);
+    return _sources.emplace(path, source).first->second;
+}
+
+peng::shared_ref<const ShaderCompiler::SourceFile> ShaderCompiler::parse_source(const std::string& path, std::string&& contents)
+{
+    const peng::shared_ref<SourceFile> source = peng::make_shared<SourceFile>();
+    source->path = path;
+    source->contents = std::move(contents);
+
+    const std::string_view contents_view = source->contents;
+
+    for (size_t start = 0; start < contents_view.size();)
+    {
+        const size_t end = std::min(contents_view.find('\n', start), contents_view.size());
+
+        SourceFile::Line line;
+        line.text = contents_view.substr(start, end - start);
+        if (line.text.ends_with('\r'))
+        {
+            line.text.remove_suffix(1);
+        }
+
+        start = end + 1;
+
+        std::string_view rest = trim_start(line.text);
+        if (!rest.starts_with('#'))
+        {
+            source->lines.push_back(line);
+            continue;
+        }
+
+        rest = trim_start(rest.substr(1));
+        const std::string_view directive = read_identifier(rest);
+        rest = trim_start(rest);
+
+        if (directive == "version")
+        {
+            line.directive = Directive::version;
+        }
+        else if (directive == "include")
+        {
+            line.directive = Directive::include;
+            line.name = read_include_path(rest);
+        }
+        else if (directive == "pragma")
+        {
+            if (read_identifier(rest) == "symbol")
+            {
+                rest = trim_start(rest);
+                line.directive = Directive::pragma_symbol;
+                line.name = read_identifier(rest);
+            }
+        }
+        else if (directive == "define")
+        {
+            line.directive = Directive::define;
+            line.name = read_identifier(rest);
+
+            // Function-like macros can't be used as symbols
+            if (rest.starts_with('('))
+            {
+                line.directive = Directive::none;
+            }
+
+            rest = trim_start(rest);
+            line.value = read_token(rest);
+        }
+        else if (directive == "undef")
+        {
+            line.directive = Directive::undef;
+            line.name = read_identifier(rest);
+        }
+        else if (directive == "ifdef")
+        {
+            line.directive = Directive::if_defined;
+            line.name = read_identifier(rest);
+        }
+        else if (directive == "ifndef")
+        {
+            line.directive = Directive::if_not_defined;
+            line.name = read_identifier(rest);
+        }
+        else if (directive == "if")
+        {
+            line.directive = Directive::if_expression;
+        }
+        else if (directive == "elif")
+        {
+            line.directive = Directive::else_if;
+        }
+        else if (directive == "else")
+        {
+            line.directive = Directive::else_branch;
+        }
+        else if (directive == "endif")
+        {
+            line.directive = Directive::end_if;
+        }
+
+        source->lines.push_back(line);
+    }
+
+    for (size_t i = 0; i < contents_view.size();)
+    {
+        if (is_identifier_start(contents_view[i]))
+        {
+            std::string_view rest = contents_view.substr(i);
+            const std::string_view identifier = read_identifier(rest);
+
+            source->identifiers.insert(identifier);
+            i += identifier.size();
+        }
+        else if (is_identifier_char(contents_view[i]))
+        {
+            // Skips the rest of a number so that suffixes like the f in 1.0f aren't read as identifiers
+            while (i < contents_view.size() && is_identifier_char(contents_view[i]))
+            {
+                i++;
+            }
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return source;
+}
+
+PreprocessedShader ShaderCompiler::preprocess_root(
+    const SourceFile& root,
+    ShaderType type,
+    std::span<const ShaderSymbol> keywords
+) const
+{
+    SCOPED_EVENT("ShaderCompiler - preprocess", root.path.c_str());
+
+    PreprocessState state;
+    state.contents.reserve(root.contents.size());
+    state.included.insert(root.path);
+
+    for (const ShaderSymbol& keyword : keywords)
+    {
+        state.defines.insert(keyword.identifier);
+    }
+
+    // Keywords go after the #version directive, which has to come first
+    size_t keywords_line = 0;
+    size_t keywords_offset = 0;
+
+    for (size_t line = 0; line < root.lines.size(); line++)
+    {
+        if (root.lines[line].directive == Directive::version)
+        {
+            keywords_line = line + 1;
+            break;
+        }
+    }
+
+    preprocess_source(root, state);
+
+    // The root's lines are emitted first, so the offset of the keywords can be found after the fact
+    for (size_t line = 0, offset = 0; line < keywords_line; line++)
+    {
+        offset = state.contents.find('\n', offset) + 1;
+        keywords_offset = offset;
+    }
+
+    PreprocessedShader shader;
+    shader.type = type;
+    shader.path = root.path;
+
+    // Only keywords which appear in a file the shader was built from are kept, so that shaders sharing a stage
+    // but not its keywords still share its compile
+    std::string keyword_defines;
+    for (const ShaderSymbol& keyword : keywords)
+    {
+        const bool referenced = root.identifiers.contains(keyword.identifier)
+            || std::ranges::any_of(state.includes, [&](const peng::shared_ref<const SourceFile>& include)
+            {
+                return include->identifiers.contains(keyword.identifier);
+            });
+
+        if (referenced)
+        {
+            keyword_defines += keyword.value.empty()
+                ? strtools::catf("#define %s\n", keyword.identifier.c_str())
+                : strtools::catf("#define %s %s\n", keyword.identifier.c_str(), keyword.value.c_str());
+            shader.keywords.push_back(keyword);
+        }
+    }
+
+    if (!keyword_defines.empty())
+    {
+        keyword_defines += strtools::catf("#line %zu 0\n", keywords_line + 1);
+        state.contents.insert(keywords_offset, keyword_defines);
+    }
+
+    shader.contents = std::move(state.contents);
+    shader.symbols = shader.keywords;
+    shader.symbols.insert(shader.symbols.end(), state.symbols.begin(), state.symbols.end());
+    shader.sources = std::move(state.sources);
+
+    if (!state.conditionals.empty())
+    {
+        Logger::warning("Shader '%s' has an #if without a matching #endif", root.path.c_str());
+    }
+
+    return shader;
+}
+
+std::string ShaderCompiler::resolve_include(const std::string& including_path, std::string_view include) const
+{
+    namespace fs = std::filesystem;
+
+    std::vector<fs::path> candidates;
+    candidates.reserve(_include_roots.size() + 1);
+    candidates.push_back(fs::path(including_path).parent_path() / include);
+
+    for (const std::string& include_root : _include_roots)
+    {
+        candidates.push_back(fs::path(include_root) / include);
+    }
+
+    for (const fs::path& candidate : candidates)
+    {
+        const std::string path = candidate.lexically_normal().generic_string();
+
+        // Files which were already parsed are known to exist without touching the disk
+        {
+            std::lock_guard lock(_sources_mutex);
+            if (_sources.contains(path))
+            {
+                return path;
+            }
+        }
+
+        if (fs::is_regular_file(path))
+        {
+            return path;
+        }
+    }
+
+    return {};
+}
+
+void ShaderCompiler::preprocess_source(const SourceFile& source, PreprocessState& state) const
+{
+    const size_t source_number = state.sources.size();
+    state.sources.push_back(source.path);
+
+    for (size_t line_number = 0; line_number < source.lines.size(); line_number++)
+    {
+        const SourceFile::Line& line = source.lines[line_number];
+        const bool active = state.active();
+
+        switch (line.directive)
+        {
+            case Directive::version:
+            {
+                // Only the root file may declare the version
+                if (source_number != 0)
+                {
+                    state.contents += '\n';
+                    continue;
+                }
+
+                break;
+            }
+            case Directive::include:
+            {
+                if (!active)
+                {
+                    state.contents += '\n';
+                    continue;
+                }
+
+                const std::string path = line.name.empty() ? std::string() : resolve_include(source.path, line.name);
+                if (path.empty())
+                {
+                    // Left in place so that the shader fails to compile with the line in its error log
+                    Logger::error(
+                        "Could not resolve '%.*s' in shader '%s'",
+                        static_cast<int>(line.text.size()), line.text.data(), source.path.c_str()
+                    );
+
+                    break;
+                }
+
+                if (state.included.insert(path).second)
+                {
+                    const peng::shared_ref<const SourceFile> include = load_source(path);
+                    state.includes.push_back(include);
+
+                    state.contents += strtools::catf("#line 1 %zu\n", state.sources.size());
+                    preprocess_source(*include.get(), state);
+                    state.contents += strtools::catf("#line %zu %zu\n", line_number + 2, source_number);
+                }
+                else
+                {
+                    state.contents += '\n';
+                }
+
+                continue;
+            }
+            case Directive::pragma_symbol:
+            {
+                if (active && !line.name.empty())
+                {
+                    state.symbols.push_back(ShaderSymbol{ std::string(line.name), "" });
+                }
+
+                break;
+            }
+            case Directive::define:
+            {
+                if (active && !line.name.empty())
+                {
+                    state.defines.emplace(line.name);
+                    state.symbols.push_back(ShaderSymbol{ std::string(line.name), std::string(line.value) });
+                }
+
+                break;
+            }
+            case Directive::undef:
+            {
+                if (active)
+                {
+                    state.defines.erase(std::string(line.name));
+                }
+
+                break;
+            }
+            case Directive::if_defined:
+            case Directive::if_not_defined:
+            {
+                const bool defined = state.defines.contains(std::string(line.name));
+                const bool taken = (line.directive == Directive::if_defined) == defined;
+
+                state.conditionals.push_back(Conditional{
+                    .state = !active || !taken ? BlockState::inactive : BlockState::active,
+                    .taken = taken
+                });
+
+                break;
+            }
+            case Directive::if_expression:
+            {
+                state.conditionals.push_back(Conditional{
+                    .state = active ? BlockState::unknown : BlockState::inactive,
+                    .taken = false
+                });
+
+                break;
+            }
+            case Directive::else_if:
+            case Directive::else_branch:
+            {
+                if (state.conditionals.empty())
+                {
+                    break;
+                }
+
+                Conditional conditional = state.conditionals.back();
+                state.conditionals.pop_back();
+
+                // The branch is only known if the condition was, and the enclosing block is active
+                if (state.active() && conditional.state != BlockState::unknown)
+                {
+                    if (conditional.taken)
+                    {
+                        conditional.state = BlockState::inactive;
+                    }
+                    else
+                    {
+                        conditional.state = line.directive == Directive::else_branch
+                            ? BlockState::active
+                            : BlockState::unknown;
+                    }
+                }
+
+                state.conditionals.push_back(conditional);
+                break;
+            }
+            case Directive::end_if:
+            {
+                if (!state.conditionals.empty())
+                {
+                    state.conditionals.pop_back();
+                }
+
+                break;
+            }
+            case Directive::none:
+            {
+                break;
+            }
+        }
+
+        state.contents += line.text;
+        state.contents += '\n';
+    }
+}
@@ -1,9 +1,18 @@
 #pragma once
 
+#include <mutex>
+#include <span>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include <GL/glew.h>
+#include <memory/shared_ref.h>
+#include <memory/weak_ptr.h>
+#include <utils/hash_helpers.h>
 
 #include "shader_type.h"
 #include "shader_symbol.h"
@@ -13,20 +22,104 @@ namespace rendering
     struct PreprocessedShader
     {
         ShaderType type;
+        std::string path;
         std::string contents;
         std::vector<ShaderSymbol> symbols;
+
+        // The keywords which the shader or its includes refer to, any others couldn't change the output
+        std::vector<ShaderSymbol> keywords;
+
+        // Every file the shader was built from, indexed by the source string number used in #line directives
+        std::vector<std::string> sources;
     };
 
+    // A compiled shader stage, shared by every shader program built from the same file and keywords
+    class CompiledShader
+    {
+    public:
+        CompiledShader(GLuint shader, const PreprocessedShader& preprocessed_shader);
+        CompiledShader(const CompiledShader&) = delete;
+        CompiledShader(CompiledShader&&) = delete;
+        ~CompiledShader();
+
+        [[nodiscard]] GLuint shader() const noexcept;
+        [[nodiscard]] ShaderType type() const noexcept;
+        [[nodiscard]] const std::vector<ShaderSymbol>& symbols() const noexcept;
+        [[nodiscard]] const std::vector<std::string>& sources() const noexcept;
+
+    private:
+        GLuint _shader;
+        ShaderType _type;
+        std::vector<ShaderSymbol> _symbols;
+        std::vector<std::string> _sources;
+    };
+
+    // Preprocesses shaders before handing them to the driver
+    // Supports #include, resolved relative to the including file and then each include root, with each file
+    // included at most once per shader
+    // Keywords select a permutation of a shader and are defined at the top of it, after any #version directive
+    // #pragma symbol and #define directives are extracted as symbols, skipping any inside an #ifdef or #ifndef
+    // block which the keywords and earlier defines rule out
     class ShaderCompiler
     {
     public:
-        [[nodiscard]] PreprocessedShader preprocess_shader(const std::string& path, ShaderType type) const;
-        [[nodiscard]] PreprocessedShader preprocess_shader(const std::string& path, ShaderType type, const std::string& src) const;
+        static constexpr const char* default_include_root = "resources/shaders/include";
+
+        ShaderCompiler();
+
+        [[nodiscard]] PreprocessedShader preprocess_shader(
+            const std::string& path,
+            ShaderType type,
+            std::span<const ShaderSymbol> keywords = {}
+        ) const;
+
+        [[nodiscard]] PreprocessedShader preprocess_shader(
+            const std::string& path,
+            ShaderType type,
+            const std::string& src,
+            std::span<const ShaderSymbol> keywords = {}
+        ) const;
+
         [[nodiscard]] GLuint compile_shader(const PreprocessedShader& preprocessed_shader) const;
 
+        // Preprocesses and compiles the shader, reusing an existing compile of the same file with the same keywords
+        // Must be called on the main thread
+        [[nodiscard]] peng::shared_ref<const CompiledShader> load_shader(
+            const std::string& path,
+            ShaderType type,
+            std::span<const ShaderSymbol> keywords = {}
+        ) const;
+
         void add_include_path(const std::string& include_path);
 
+        // Parses keywords written as NAME or NAME=VALUE, sorted by name so that equal sets hash the same
+        [[nodiscard]] static std::vector<ShaderSymbol> parse_keywords(std::span<const std::string> keywords);
+        [[nodiscard]] static size_t hash_keywords(std::span<const ShaderSymbol> keywords) noexcept;
+
     private:
+        struct SourceFile;
+        struct PreprocessState;
+
+        // Parses the file once and shares it between every shader including it
+        [[nodiscard]] static peng::shared_ref<const SourceFile> load_source(const std::string& path);
+        [[nodiscard]] static peng::shared_ref<const SourceFile> parse_source(const std::string& path, std::string&& contents);
+
+        [[nodiscard]] PreprocessedShader preprocess_root(
+            const SourceFile& root,
+            ShaderType type,
+            std::span<const ShaderSymbol> keywords
+        ) const;
+
+        [[nodiscard]] std::string resolve_include(const std::string& including_path, std::string_view include) const;
+        void preprocess_source(const SourceFile& source, PreprocessState& state) const;
+
         std::vector<std::string> _include_roots;
+
+        static std::mutex _sources_mutex;
+        static std::unordered_map<std::string, peng::shared_ref<const SourceFile>> _sources;
+
+        // Compiled stages are held weakly, so a stage lives for as long as any shader program uses it
+        using CompiledKey = std::tuple<std::string, ShaderType, size_t>;
+        static std::unordered_map<CompiledKey, peng::weak_ptr<const CompiledShader>> _compiled_shaders;
     };
 }
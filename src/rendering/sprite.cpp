@@ -4,6 +4,7 @@
 #include <memory/gc.h>
 
 #include "texture.h"
+#include "texture_atlas.h"
 
 using namespace rendering;
 using namespace math;
@@ -23,11 +24,29 @@ Sprite::Sprite(
     , _position(position)
     , _resolution(resolution)
 {
-    [[maybe_unused]] const Vector2i texture_res = _texture->resolution();
+    const Vector2i texture_res = _texture->resolution();
     check(_position.x >= 0 && _position.y >= 0);
     check(_position.x < texture_res.x && _position.y < texture_res.y);
     check(_resolution.x >= 0 && _resolution.y >= 0);
     check(_position.x + _resolution.x <= texture_res.x && _position.y + _resolution.y <= texture_res.y);
+
+    _size = _resolution / _px_per_unit;
+    _transparency = _texture->transparency();
+
+    // Move the sprite into the atlas if its texture can be shared, so it can batch with sprites from other textures
+    if (const std::optional<AtlasRegion> region = TextureAtlas::get().place(_texture))
+    {
+        _texture = region->page;
+        _position += region->position;
+    }
+
+    // Texture coordinates have an inverted y compared to the pixel position
+    const Vector2i page_res = _texture->resolution();
+    Vector2i pos_corrected = _position;
+    pos_corrected.y = page_res.y - (pos_corrected.y + _resolution.y);
+
+    _tex_scale = Vector2f(_resolution) / Vector2f(page_res);
+    _tex_offset = Vector2f(pos_corrected) / Vector2f(page_res);
 }
 
 peng::shared_ref<Sprite> Sprite::load_asset(const Archive& archive)
@@ -42,7 +61,7 @@ peng::shared_ref<Sprite> Sprite::load_asset(const Archive& archive)
     return memory::GC::alloc<Sprite>(texture, px_per_unit, position, resolution);
 }
 
-peng::shared_ref<const Texture> Sprite::texture() const noexcept
+const peng::shared_ref<const Texture>& Sprite::texture() const noexcept
 {
     return _texture;
 }
@@ -64,10 +83,20 @@ const Vector2i& Sprite::resolution() const
 
 math::Vector2f Sprite::size() const
 {
-    return _resolution / _px_per_unit;
+    return _size;
 }
 
 TransparencyMode Sprite::transparency() const noexcept
 {
-    return _texture->transparency();
+    return _transparency;
+}
+
+const Vector2f& Sprite::tex_scale() const noexcept
+{
+    return _tex_scale;
+}
+
+const Vector2f& Sprite::tex_offset() const noexcept
+{
+    return _tex_offset;
 }
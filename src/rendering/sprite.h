@@ -11,6 +11,9 @@ namespace rendering
 {
     class Texture;
 
+    // A region of a texture drawn as a 2D quad
+    // Sprites whose texture can be atlased are moved into a TextureAtlas page when created,
+    // in which case texture() is the page and position() is relative to the page
     class Sprite
     {
     public:
@@ -24,17 +27,27 @@ namespace rendering
 
         static peng::shared_ref<Sprite> load_asset(const Archive& archive);
 
-        [[nodiscard]] peng::shared_ref<const Texture> texture() const noexcept;
+        [[nodiscard]] const peng::shared_ref<const Texture>& texture() const noexcept;
         [[nodiscard]] float px_per_unit() const noexcept;
         [[nodiscard]] const math::Vector2i& position() const;
         [[nodiscard]] const math::Vector2i& resolution() const;
         [[nodiscard]] math::Vector2f size() const;
         [[nodiscard]] TransparencyMode transparency() const noexcept;
 
+        // Scale and offset that map the unit quad's texture coordinates onto the sprite's region of the texture
+        [[nodiscard]] const math::Vector2f& tex_scale() const noexcept;
+        [[nodiscard]] const math::Vector2f& tex_offset() const noexcept;
+
     private:
         peng::shared_ref<const Texture> _texture;
         float _px_per_unit;
         math::Vector2i _position;
         math::Vector2i _resolution;
+
+        // Derived from the above when the sprite is created, since sprites are drawn far more than they are made
+        math::Vector2f _size;
+        TransparencyMode _transparency;
+        math::Vector2f _tex_scale;
+        math::Vector2f _tex_offset;
     };
 }
\ No newline at end of file
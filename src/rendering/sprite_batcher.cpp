@@ -4,6 +4,7 @@
 #include <execution>
 
 #include <profiling/scoped_event.h>
+#include <utils/radix_sort.h>
 #include <utils/strtools.h>
 
 #include "utils.h"
@@ -17,12 +18,17 @@
 using namespace rendering;
 using namespace math;
 
+namespace
+{
+    constexpr uint32_t no_draw = std::numeric_limits<uint32_t>::max();
+}
+
 void SpriteBatcher::convert_draws(
     const std::vector<SpriteDrawCall>& sprite_draws_in,
     std::vector<DrawCall>& draws_out
 )
 {
-    SCOPED_EVENT("SpriteBatcher - convert draws", strtools::catf_temp("%d sprites", sprite_draws_in.size()));
+    SCOPED_EVENT("SpriteBatcher - convert draws", strtools::catf_temp("%zu sprites", sprite_draws_in.size()));
 
     for (MaterialPool& pool : _material_pools | std::views::values)
     {
@@ -31,10 +37,10 @@ void SpriteBatcher::convert_draws(
 
     _buffer_pool.num_used = 0;
 
-    preprocess_draws(sprite_draws_in, _processed_draw_buffer);
-    sort_draws(_processed_draw_buffer);
-    bin_draws(_processed_draw_buffer, _draw_bin_buffer);
-    emit_draws(_draw_bin_buffer, draws_out);
+    preprocess_draws(sprite_draws_in);
+    sort_draws();
+    bin_draws();
+    emit_draws(sprite_draws_in, draws_out);
 }
 
 void SpriteBatcher::flush()
@@ -45,27 +51,44 @@ void SpriteBatcher::flush()
 }
 
 SpriteBatcher::DrawBin::DrawBin()
-    : _depth_range(std::numeric_limits<float>::min(), std::numeric_limits<float>::min())
+    : key(0)
+    , _depth_range(std::numeric_limits<float>::min(), std::numeric_limits<float>::min())
+    , _first_draw(no_draw)
+    , _last_draw(no_draw)
+    , _num_draws(0)
 { }
 
-void SpriteBatcher::DrawBin::add_draw(const ProcessedSpriteDraw& processed_draw, const BinKey& bin_key)
+void SpriteBatcher::DrawBin::add_draw(
+    uint32_t draw_index,
+    float z_depth,
+    BinKey bin_key,
+    std::vector<uint32_t>& next_draw
+)
 {
-    if (_instance_data.empty())
+    if (_num_draws == 0)
     {
         key = bin_key;
-        _depth_range = Vector2f(processed_draw.z_depth, processed_draw.z_depth);
+        _depth_range = Vector2f(z_depth, z_depth);
+        _first_draw = draw_index;
     }
     else
     {
-        _depth_range.y = processed_draw.z_depth;
+        _depth_range.y = z_depth;
+        next_draw[_last_draw] = draw_index;
     }
 
-    _instance_data.push_back(processed_draw.instance_data);
+    _last_draw = draw_index;
+    _num_draws++;
+}
+
+uint32_t SpriteBatcher::DrawBin::first_draw() const noexcept
+{
+    return _first_draw;
 }
 
-const std::vector<SpriteBatcher::SpriteInstanceData>& SpriteBatcher::DrawBin::instance_data() const noexcept
+uint32_t SpriteBatcher::DrawBin::num_draws() const noexcept
 {
-    return _instance_data;
+    return _num_draws;
 }
 
 float SpriteBatcher::DrawBin::avg_depth() const noexcept
@@ -78,50 +101,53 @@ bool SpriteBatcher::DrawBin::approx_flat() const noexcept
     return _depth_range.y - _depth_range.x < epsilon;
 }
 
-bool SpriteBatcher::DrawBin::approx_overlaps(float z_depth) const noexcept
+bool SpriteBatcher::DrawBin::approx_flat_with(float z_depth) const noexcept
 {
-    return z_depth - _depth_range.x > -epsilon
-        && z_depth - _depth_range.y < +epsilon;
+    return z_depth - _depth_range.x < epsilon;
 }
 
 bool SpriteBatcher::DrawBin::empty() const noexcept
 {
-    return _instance_data.empty();
+    return _num_draws == 0;
 }
 
-void SpriteBatcher::preprocess_draws(
-    const std::vector<SpriteDrawCall>& sprite_draws_in,
-    std::vector<ProcessedSpriteDraw>& processed_draws_out
-) const
+void SpriteBatcher::preprocess_draws(const std::vector<SpriteDrawCall>& sprite_draws_in)
 {
     SCOPED_EVENT("SpriteBatcher - preprocess draws");
-    processed_draws_out.clear();
-    processed_draws_out.reserve(sprite_draws_in.size());
+    _processed_draw_buffer.resize(sprite_draws_in.size());
 
-    for (const SpriteDrawCall& sprite_draw : sprite_draws_in)
-    {
-        processed_draws_out.push_back(preprocess_draw(sprite_draw));
-    }
+    // Each draw writes only to its own slot, so the draws can be processed in any order on any thread
+    const SpriteDrawCall* first_sprite_draw = sprite_draws_in.data();
+    std::for_each(std::execution::par_unseq, sprite_draws_in.begin(), sprite_draws_in.end(),
+        [&](const SpriteDrawCall& sprite_draw)
+        {
+            const size_t index = &sprite_draw - first_sprite_draw;
+
+            ProcessedSpriteDraw& processed_draw = _processed_draw_buffer[index];
+            processed_draw = preprocess_draw(sprite_draw);
+            processed_draw.source_index = static_cast<uint32_t>(index);
+        });
 }
 
-void SpriteBatcher::sort_draws(std::vector<ProcessedSpriteDraw>& processed_draws_in_out) const
+void SpriteBatcher::sort_draws()
 {
     SCOPED_EVENT("SpriteBatcher - sort draws");
 
-    std::sort(std::execution::par_unseq, processed_draws_in_out.begin(), processed_draws_in_out.end(),
-        [](const ProcessedSpriteDraw& x, const ProcessedSpriteDraw& y)
-        {
-            return x.z_depth < y.z_depth;
-        });
+    // Sprites tend to sit on a few flat layers, so most radix passes are skipped
+    _sort_scratch_buffer.resize(_processed_draw_buffer.size());
+    utils::radix_sort<ProcessedSpriteDraw>(_processed_draw_buffer, _sort_scratch_buffer, [](const ProcessedSpriteDraw& draw)
+    {
+        return static_cast<uint64_t>(utils::to_sortable_bits(draw.z_depth)) << 32 | (draw.bin_key & 0xFFFFFFFF);
+    });
 }
 
-void SpriteBatcher::bin_draws(
-    const std::vector<ProcessedSpriteDraw>& processed_draws_in,
-    std::vector<DrawBin>& draw_bins_out
-) const
+void SpriteBatcher::bin_draws()
 {
     SCOPED_EVENT("SpriteBatcher - bin draws");
-    draw_bins_out.clear();
+    _draw_bin_buffer.clear();
+    _alpha_bin_buffer.clear();
+    _opaque_bin_buffer.clear();
+    _next_draw.assign(_processed_draw_buffer.size(), no_draw);
 
     // Translucent sprites require that bins are broken such that two separate translucent
     // bins never overlap in their z-depth range, but allow a small deviation for floating point errors
@@ -129,21 +155,29 @@ void SpriteBatcher::bin_draws(
     // To do this, we only allow 2 scenarios for incomplete alpha bins at any given time:
     // 1. A single bin of any depth range
     // 2. Multiple bins with approximately flat and equal depth
-    std::vector<DrawBin> alpha_bins;
-    std::unordered_map<BinKey, DrawBin> opaque_bins;
+    std::vector<DrawBin>& alpha_bins = _alpha_bin_buffer;
 
-    for (const ProcessedSpriteDraw& processed_draw : processed_draws_in)
-    {
-        const bool requires_alpha =
-            processed_draw.instance_data.color.w < 0.999f ||
-            processed_draw.texture->transparency() == TransparencyMode::translucent;
+    // Neighbouring draws usually share a texture, especially once atlased, so the last opaque bin is tried
+    // before looking the key up
+    BinKey last_opaque_key = 0;
+    DrawBin* last_opaque_bin = nullptr;
 
-        const BinKey bin_key = std::make_tuple(processed_draw.texture, requires_alpha);
+    for (uint32_t draw_index = 0; draw_index < _processed_draw_buffer.size(); draw_index++)
+    {
+        const ProcessedSpriteDraw& processed_draw = _processed_draw_buffer[draw_index];
+        const BinKey bin_key = processed_draw.bin_key;
+        const float z_depth = processed_draw.z_depth;
 
         // Opaque sprites can always be binned together if they have compatible textures
-        if (!requires_alpha)
+        if (!requires_alpha(bin_key))
         {
-            opaque_bins[bin_key].add_draw(processed_draw, bin_key);
+            if (!last_opaque_bin || last_opaque_key != bin_key)
+            {
+                last_opaque_key = bin_key;
+                last_opaque_bin = &_opaque_bin_buffer[bin_key];
+            }
+
+            last_opaque_bin->add_draw(draw_index, z_depth, bin_key, _next_draw);
             continue;
         }
 
@@ -151,7 +185,7 @@ void SpriteBatcher::bin_draws(
         if (alpha_bins.empty())
         {
             DrawBin& alpha_bin = alpha_bins.emplace_back();
-            alpha_bin.add_draw(processed_draw, bin_key);
+            alpha_bin.add_draw(draw_index, z_depth, bin_key, _next_draw);
             continue;
         }
 
@@ -163,16 +197,16 @@ void SpriteBatcher::bin_draws(
             if (alpha_bin.key == bin_key)
             {
                 // If it matches then allow it to grow in depth range
-                alpha_bin.add_draw(processed_draw, bin_key);
+                alpha_bin.add_draw(draw_index, z_depth, bin_key, _next_draw);
                 continue;
             }
 
             if (!alpha_bin.approx_flat())
             {
                 // If it doesn't and the bin isn't flat, it needs flushing and create a new bin
-                draw_bins_out.push_back(std::move(alpha_bin));
+                _draw_bin_buffer.push_back(alpha_bin);
                 alpha_bin = {};
-                alpha_bin.add_draw(processed_draw, bin_key);
+                alpha_bin.add_draw(draw_index, z_depth, bin_key, _next_draw);
                 continue;
             }
         }
@@ -180,78 +214,76 @@ void SpriteBatcher::bin_draws(
         // If we have multiple bins now, they must all be flat and the new draw must overlap with all of them
         // Check that this is true, and if it is, add the draw to the corresponding bin
         // Otherwise flush all of them and create a new bin
-        bool compatible = true;
+        // Draws arrive in z-depth order, so every flat bin lies within epsilon after the start of the first one,
+        // and the new draw overlaps all of them as long as it doesn't leave the first one flat
+        const bool compatible = alpha_bins.front().approx_flat_with(z_depth);
         DrawBin* matching_bin = nullptr;
 
-        for (DrawBin& flat_bin : alpha_bins)
+        if (compatible)
         {
-            compatible &= flat_bin.approx_overlaps(processed_draw.z_depth);
-            if (flat_bin.key == bin_key)
+            for (DrawBin& flat_bin : alpha_bins)
             {
-                matching_bin = &flat_bin;
+                if (flat_bin.key == bin_key)
+                {
+                    matching_bin = &flat_bin;
+                    break;
+                }
             }
         }
 
         // Flush all flat bins since the new draw is incompatible
         if (!compatible)
         {
-#ifdef WIN32
-            draw_bins_out.append_range(std::move(alpha_bins));
-#else
-            append_range(draw_bins_out, std::move(alpha_bins));
-#endif
+            _draw_bin_buffer.insert(_draw_bin_buffer.end(), alpha_bins.begin(), alpha_bins.end());
             alpha_bins.clear();
-            matching_bin = nullptr;
         }
 
         // Add to the existing bin if we have it
         if (matching_bin)
         {
-            matching_bin->add_draw(processed_draw, bin_key);
+            matching_bin->add_draw(draw_index, z_depth, bin_key, _next_draw);
             continue;
         }
 
         // Create a new bin otherwise
         DrawBin& alpha_bin = alpha_bins.emplace_back();
-        alpha_bin.add_draw(processed_draw, bin_key);
+        alpha_bin.add_draw(draw_index, z_depth, bin_key, _next_draw);
     }
 
-#ifdef WIN32
-    draw_bins_out.append_range(std::move(alpha_bins));
-#else
-    append_range(draw_bins_out, std::move(alpha_bins));
-#endif
+    _draw_bin_buffer.insert(_draw_bin_buffer.end(), alpha_bins.begin(), alpha_bins.end());
 
-    for (DrawBin& opaque_bin : opaque_bins | std::views::values)
+    for (const DrawBin& opaque_bin : _opaque_bin_buffer | std::views::values)
     {
-        draw_bins_out.push_back(std::move(opaque_bin));
+        _draw_bin_buffer.push_back(opaque_bin);
     }
+
+    _opaque_bin_buffer.clear();
 }
 
-void SpriteBatcher::emit_draws(const std::vector<DrawBin>& draw_bins_in, std::vector<DrawCall>& draws_out)
+void SpriteBatcher::emit_draws(const std::vector<SpriteDrawCall>& sprite_draws_in, std::vector<DrawCall>& draws_out)
 {
     SCOPED_EVENT("SpriteBatcher - create draws");
 
-    for (const DrawBin& draw_bin : draw_bins_in)
+    for (const DrawBin& draw_bin : _draw_bin_buffer)
     {
-        if (draw_bin.instance_data().size() == 1)
+        if (draw_bin.num_draws() == 1)
         {
-            draws_out.push_back(emit_simple_draw(draw_bin));
+            draws_out.push_back(emit_simple_draw(draw_bin, sprite_draws_in));
         }
-        else if (draw_bin.instance_data().size() > 1)
+        else if (draw_bin.num_draws() > 1)
         {
-            draws_out.push_back(emit_instanced_draw(draw_bin));
+            draws_out.push_back(emit_instanced_draw(draw_bin, sprite_draws_in));
         }
     }
 }
 
-DrawCall SpriteBatcher::emit_simple_draw(const DrawBin& draw_bin)
+DrawCall SpriteBatcher::emit_simple_draw(const DrawBin& draw_bin, const std::vector<SpriteDrawCall>& sprite_draws_in)
 {
-    const peng::shared_ref<const Texture> texture = std::get<0>(draw_bin.key).to_shared_ref();
-    const bool requires_alpha = std::get<1>(draw_bin.key);
-    const SpriteInstanceData& instance_data = draw_bin.instance_data()[0];
+    const peng::shared_ref<const Texture>& texture = bin_texture(draw_bin, sprite_draws_in);
+    const SpriteInstanceData instance_data =
+        make_instance_data(sprite_draws_in[_processed_draw_buffer[draw_bin.first_draw()].source_index]);
 
-    const MaterialPoolKey pool_key = std::make_tuple(false, requires_alpha);
+    const MaterialPoolKey pool_key = std::make_tuple(false, requires_alpha(draw_bin.key));
     peng::shared_ref<Material> material = get_pooled_material(pool_key);
 
     // TODO: use uniform caches
@@ -273,34 +305,31 @@ DrawCall SpriteBatcher::emit_simple_draw(const DrawBin& draw_bin)
     };
 }
 
-DrawCall SpriteBatcher::emit_instanced_draw(const DrawBin& draw_bin)
+DrawCall SpriteBatcher::emit_instanced_draw(const DrawBin& draw_bin, const std::vector<SpriteDrawCall>& sprite_draws_in)
 {
-    const int32_t num_sprites = static_cast<int32_t>(draw_bin.instance_data().size());
+    const int32_t num_sprites = static_cast<int32_t>(draw_bin.num_draws());
 
     SCOPED_EVENT("SpriteBatcher - emit instanced draw", strtools::catf_temp("%d sprites", num_sprites));
     check(num_sprites > 1);
 
-    const peng::shared_ref<const Texture> texture = std::get<0>(draw_bin.key).to_shared_ref();
-    const bool requires_alpha = std::get<1>(draw_bin.key);
-
-    const MaterialPoolKey pool_key = std::make_tuple(true, requires_alpha);
+    const peng::shared_ref<const Texture>& texture = bin_texture(draw_bin, sprite_draws_in);
+    const MaterialPoolKey pool_key = std::make_tuple(true, requires_alpha(draw_bin.key));
 
     peng::shared_ref<Material> material = get_pooled_material(pool_key);
     peng::shared_ref<StructuredBuffer<SpriteInstanceData>> buffer = get_pooled_buffer();
 
+    // Build the bin's instance data in z-depth order straight into the upload buffer, so it is written exactly once
+    // Translucent sprites need to be drawn in reverse z-depth order, so they are written back to front
     const bool requires_blend = material->shader()->requires_blending();
-    if (requires_blend)
+    buffer->upload_in_place(num_sprites, [&](SpriteInstanceData* instances)
     {
-        // Translucent sprites need to be drawn in reverse z-depth order
-        std::vector<SpriteInstanceData> reversed_instance_data(draw_bin.instance_data());
-        std::ranges::reverse(reversed_instance_data);
-
-        buffer->upload(reversed_instance_data);
-    }
-    else
-    {
-        buffer->upload(draw_bin.instance_data());
-    }
+        size_t instance_index = requires_blend ? num_sprites - 1 : 0;
+        for (uint32_t i = draw_bin.first_draw(); i != no_draw; i = _next_draw[i])
+        {
+            instances[instance_index] = make_instance_data(sprite_draws_in[_processed_draw_buffer[i].source_index]);
+            instance_index = requires_blend ? instance_index - 1 : instance_index + 1;
+        }
+    });
 
     material->set_parameter("color_tex", texture);
     material->set_buffer("sprite_instance_data", buffer);
@@ -317,38 +346,56 @@ DrawCall SpriteBatcher::emit_instanced_draw(const DrawBin& draw_bin)
     };
 }
 
-SpriteBatcher::ProcessedSpriteDraw SpriteBatcher::preprocess_draw(const SpriteDrawCall& sprite_draw) const
+SpriteBatcher::ProcessedSpriteDraw SpriteBatcher::preprocess_draw(const SpriteDrawCall& sprite_draw)
 {
-    const peng::shared_ref<const Sprite>& sprite = sprite_draw.sprite;
+    const Sprite& sprite = *sprite_draw.sprite.get();
+
+    const bool requires_alpha =
+        sprite_draw.color.w < 0.999f ||
+        sprite.transparency() == TransparencyMode::translucent;
+
+    // Scaling by the sprite's size leaves the translation untouched, so the depth can be read before it's applied
+    return ProcessedSpriteDraw{
+        .bin_key = static_cast<BinKey>(sprite.texture()->raw()) << 1 | static_cast<BinKey>(requires_alpha),
+        .z_depth = sprite_draw.mvp_matrix.get_translation().z
+    };
+}
+
+SpriteBatcher::SpriteInstanceData SpriteBatcher::make_instance_data(const SpriteDrawCall& sprite_draw)
+{
+    const Sprite& sprite = *sprite_draw.sprite.get();
 
     // Determine mvp matrix of sprite with sprite size accounted for
+    // Scaling by {size, 1} on the right only scales the first two columns, which avoids a full matrix multiply
     Matrix4x4f mvp_matrix = sprite_draw.mvp_matrix;
-    if (sprite->size() != Vector2f::one())
+    const Vector2f size = sprite.size();
+    for (size_t row = 0; row < 4; row++)
     {
-        const Vector3f sprite_scale = Vector3f(sprite->size(), 1);
-        const Matrix4x4f sprite_matrix = Matrix4x4f::from_scale(sprite_scale);
-        mvp_matrix = mvp_matrix * sprite_matrix;
+        mvp_matrix.elements[row] *= size.x;
+        mvp_matrix.elements[4 + row] *= size.y;
     }
 
-    // Calculate texture coordinates of sprite
-    // Texture coordinates have an inverted y compared to the pixel position
-    Vector2i pos_corrected = sprite->position();
-    pos_corrected.y = sprite->texture()->resolution().y - (pos_corrected.y + sprite->resolution().y);
+    return SpriteInstanceData{
+        .color = sprite_draw.color,
+        .mvp_matrix = mvp_matrix,
+        .tex_scale = sprite.tex_scale(),
+        .tex_offset = sprite.tex_offset()
+    };
+}
 
-    const Vector2f texture_res = Vector2f(sprite->texture()->resolution());
-    const Vector2f tex_scale = Vector2f(sprite->resolution()) / texture_res;
-    const Vector2f tex_offset = Vector2f(pos_corrected) / texture_res;
+bool SpriteBatcher::requires_alpha(BinKey bin_key) noexcept
+{
+    return bin_key & 1;
+}
 
-    return ProcessedSpriteDraw{
-        .texture = sprite->texture(),
-        .z_depth = mvp_matrix.get_translation().z,
-        .instance_data = SpriteInstanceData{
-            .color = sprite_draw.color,
-            .mvp_matrix = mvp_matrix,
-            .tex_scale = tex_scale,
-            .tex_offset = tex_offset
-        }
-    };
+const peng::shared_ref<const Texture>& SpriteBatcher::bin_texture(
+    const DrawBin& draw_bin,
+    const std::vector<SpriteDrawCall>& sprite_draws_in
+) const
+{
+    // All draws in a bin share a texture, so any of them can provide it
+    const uint32_t source_index = _processed_draw_buffer[draw_bin.first_draw()].source_index;
+    return sprite_draws_in[source_index].sprite->texture();
 }
 
 peng::shared_ref<const Mesh> SpriteBatcher::get_sprite_mesh()
@@ -407,8 +454,8 @@ peng::shared_ref<StructuredBuffer<SpriteBatcher::SpriteInstanceData>> SpriteBatc
     {
         _buffer_pool.resources.push_back(
             peng::make_shared<StructuredBuffer<SpriteInstanceData>>(
-                strtools::catf("SpriteBatcher[%d]", _buffer_pool.num_used),
-                GL_DYNAMIC_DRAW
+                strtools::catf("SpriteBatcher[%zu]", _buffer_pool.num_used),
+                GL_STREAM_DRAW
             )
         );
     }
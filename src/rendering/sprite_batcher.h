@@ -1,11 +1,10 @@
 #pragma once
 
 #include <vector>
-#include <variant>
-#include <unordered_map>
 
 #include <memory/shared_ptr.h>
 #include <math/matrix4x4.h>
+#include <utils/flat_hash_map.h>
 #include <utils/hash_helpers.h>
 
 #include "structured_buffer.h"
@@ -43,11 +42,17 @@ namespace rendering
             math::Vector2f tex_offset;
         };
 
+        // Bins are keyed by the texture's handle and whether alpha blending is needed, packed into one integer
+        // Atlased sprites share their page's handle, so sprites from different source textures can share a bin
+        using BinKey = uint64_t;
+
+        // Everything needed to sort and bin a draw, its instance data is only built once the draw's bin is known
+        // so that sorting and binning only move these small records around
         struct ProcessedSpriteDraw
         {
-            peng::shared_ref<const Texture> texture;
+            BinKey bin_key = 0;
             float z_depth = 0;
-            SpriteInstanceData instance_data;
+            uint32_t source_index = 0;
         };
 
         template <typename T>
@@ -61,71 +66,77 @@ namespace rendering
         using MaterialPool = ResourcePool<Material>;
         using MaterialPoolKey = std::tuple<bool, bool>;
 
-        using BinKey = std::tuple<peng::shared_ptr<const Texture>, bool>;
-
+        // Draws in a bin are chained through _next_draw in z-depth order, starting from first_draw()
+        // Indices refer to the sorted processed draws
         class DrawBin
         {
         public:
             DrawBin();
 
-            void add_draw(const ProcessedSpriteDraw& processed_draw, const BinKey& bin_key);
-            [[nodiscard]] const std::vector<SpriteInstanceData>& instance_data() const noexcept;
+            void add_draw(uint32_t draw_index, float z_depth, BinKey bin_key, std::vector<uint32_t>& next_draw);
+
+            [[nodiscard]] uint32_t first_draw() const noexcept;
+            [[nodiscard]] uint32_t num_draws() const noexcept;
 
             [[nodiscard]] float avg_depth() const noexcept;
             [[nodiscard]] bool approx_flat() const noexcept;
-            [[nodiscard]] bool approx_overlaps(float z_depth) const noexcept;
+            // Whether the bin would still be approximately flat with a draw at z_depth added, which must not come
+            // before the bin's draws in z-depth order
+            [[nodiscard]] bool approx_flat_with(float z_depth) const noexcept;
             [[nodiscard]] bool empty() const noexcept;
 
             BinKey key;
 
         private:
             math::Vector2f _depth_range;
-            std::vector<SpriteInstanceData> _instance_data;
+            uint32_t _first_draw;
+            uint32_t _last_draw;
+            uint32_t _num_draws;
 
             static constexpr float epsilon = 0.00001f;
         };
 
-        // Preprocess all of the sprite draw calls
-        void preprocess_draws(
-            const std::vector<SpriteDrawCall>& sprite_draws_in,
-            std::vector<ProcessedSpriteDraw>& processed_draws_out
-        ) const;
+        // Preprocess all of the sprite draw calls in parallel
+        void preprocess_draws(const std::vector<SpriteDrawCall>& sprite_draws_in);
 
-        // Sorts draws by their z-depth
-        void sort_draws(
-            std::vector<ProcessedSpriteDraw>& processed_draws_in_out
-        ) const;
+        // Sorts draws by their z-depth and then bin key, keeping draws of equal depth and bin in submission order
+        void sort_draws();
 
         // Bins processed draws by {texture, alpha}
         // This way all draws in a bin can be merged into one draw call
-        // Mutates the input for performance reasons
-        void bin_draws(
-            const std::vector<ProcessedSpriteDraw>& processed_draws_in,
-            std::vector<DrawBin>& draw_bins_out
-        ) const;
+        void bin_draws();
 
         // Emits draw calls from the binned processed draws
         // Bins with more than one draw will result in a merged instanced draw
-        void emit_draws(
-            const std::vector<DrawBin>& draw_bins_in,
-            std::vector<DrawCall>& draws_out
-        );
+        void emit_draws(const std::vector<SpriteDrawCall>& sprite_draws_in, std::vector<DrawCall>& draws_out);
 
         // Emits a draw call when no instancing is used
-        [[nodiscard]] DrawCall emit_simple_draw(const DrawBin& draw_bin);
+        [[nodiscard]] DrawCall emit_simple_draw(const DrawBin& draw_bin, const std::vector<SpriteDrawCall>& sprite_draws_in);
 
         // Emits an instanced draw call when to batch multiple sprites together
-        [[nodiscard]] DrawCall emit_instanced_draw(const DrawBin& draw_bin);
+        [[nodiscard]] DrawCall emit_instanced_draw(const DrawBin& draw_bin, const std::vector<SpriteDrawCall>& sprite_draws_in);
+
+        [[nodiscard]] static ProcessedSpriteDraw preprocess_draw(const SpriteDrawCall& sprite_draw);
+        [[nodiscard]] static SpriteInstanceData make_instance_data(const SpriteDrawCall& sprite_draw);
+
+        [[nodiscard]] static bool requires_alpha(BinKey bin_key) noexcept;
+        [[nodiscard]] const peng::shared_ref<const Texture>& bin_texture(
+            const DrawBin& draw_bin,
+            const std::vector<SpriteDrawCall>& sprite_draws_in
+        ) const;
 
-        [[nodiscard]] ProcessedSpriteDraw preprocess_draw(const SpriteDrawCall& sprite_draw) const;
         [[nodiscard]] peng::shared_ref<const Mesh> get_sprite_mesh();
         [[nodiscard]] peng::shared_ref<Material> get_pooled_material(const MaterialPoolKey& key);
         [[nodiscard]] peng::shared_ref<StructuredBuffer<SpriteInstanceData>> get_pooled_buffer();
 
         peng::shared_ptr<const Mesh> _sprite_mesh;
-        std::unordered_map<MaterialPoolKey, MaterialPool> _material_pools;
+        utils::flat_hash_map<MaterialPoolKey, MaterialPool> _material_pools;
         ResourcePool<StructuredBuffer<SpriteInstanceData>> _buffer_pool;
         std::vector<ProcessedSpriteDraw> _processed_draw_buffer;
+        std::vector<ProcessedSpriteDraw> _sort_scratch_buffer;
+        std::vector<uint32_t> _next_draw;
         std::vector<DrawBin> _draw_bin_buffer;
+        std::vector<DrawBin> _alpha_bin_buffer;
+        utils::flat_hash_map<BinKey, DrawBin> _opaque_bin_buffer;
     };
 }
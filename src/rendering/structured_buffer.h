@@ -1,15 +1,23 @@
 #pragma once
 
+#include <algorithm>
+#include <span>
+#include <type_traits>
 #include <vector>
 #include <string>
 
 #include <profiling/scoped_event.h>
 #include <utils/check.h>
 
+#include "device.h"
 #include "shader_buffer.h"
+#include "upload_ring.h"
 
 namespace rendering
 {
+    // Buffers created with GL_STREAM_DRAW are sub-allocated from the UploadRing, so their data only lasts
+    // until the end of the frame and must be uploaded again every frame they are used
+    // Buffers with any other usage own their storage, which grows geometrically as the data grows
     template <typename T>
     class StructuredBuffer : public IShaderBuffer
     {
@@ -22,9 +30,14 @@ namespace rendering
         StructuredBuffer& operator=(const StructuredBuffer&) = delete;
         StructuredBuffer& operator=(StructuredBuffer&&) = delete;
 
-        void upload(const std::vector<T>& data);
+        void upload(std::span<const T> data);
 
-        [[nodiscard]] GLuint get_ssbo() const override;
+        // Builds count elements in place in the UploadRing rather than uploading a copy, only for stream buffers
+        // write is called once with room for count elements and must fill all of them
+        template <typename F>
+        void upload_in_place(size_t count, F&& write);
+
+        void bind(GLuint binding) const override;
 
     private:
         void release_ssbo();
@@ -34,7 +47,7 @@ namespace rendering
 
         GLuint _ssbo;
         size_t _capacity;
-        size_t _size;
+        BufferRange _stream_range;
     };
 
     template <typename T>
@@ -43,7 +56,6 @@ namespace rendering
         , _usage(usage)
         , _ssbo(0)
         , _capacity(0)
-        , _size(0)
     { }
 
     template <typename T>
@@ -53,41 +65,69 @@ namespace rendering
     }
 
     template <typename T>
-    void StructuredBuffer<T>::upload(const std::vector<T>& data)
+    void StructuredBuffer<T>::upload(std::span<const T> data)
     {
         SCOPED_EVENT("StructuredBuffer - upload", _name.c_str());
 
-        if (data.size() <= _capacity)
+        if (_usage == GL_STREAM_DRAW)
         {
-            // If the data fits in our existing buffer then just upload new data
-            glBindBuffer(GL_SHADER_STORAGE_BUFFER, _ssbo);
-            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, data.size() * sizeof(T), data.data());
-            _size = data.size();
+            _stream_range = UploadRing::get().upload(data.data(), data.size() * sizeof(T));
+            return;
         }
-        else
+
+        Device& device = Device::get();
+        if (!_ssbo || data.size() > _capacity)
         {
-            // Otherwise, free the old buffer and get a new one big enough for the data
-            // TODO: make the growth policy less prone to thrashing
-            release_ssbo();
+            SCOPED_EVENT("StructuredBuffer - allocate", _name.c_str());
 
+            // Growing geometrically keeps buffers that grow a little each frame from reallocating every upload
+            _capacity = std::max(data.size(), _capacity * 2);
+            if (!_ssbo)
             {
-                SCOPED_EVENT("StructuredBuffer - allocate", _name.c_str());
-                glGenBuffers(1, &_ssbo);
-                glBindBuffer(GL_SHADER_STORAGE_BUFFER, _ssbo);
-                glObjectLabel(GL_BUFFER, _ssbo, -1, _name.c_str());
-                glBufferData(GL_SHADER_STORAGE_BUFFER, data.size() * sizeof(T), data.data(), _usage);
+                _ssbo = device.create_buffer(_name.c_str());
             }
 
-            _size = data.size();
-            _capacity = _size;
+            device.buffer_data(GL_SHADER_STORAGE_BUFFER, _ssbo, _capacity * sizeof(T), nullptr, _usage);
         }
+
+        if (!data.empty())
+        {
+            device.buffer_sub_data(GL_SHADER_STORAGE_BUFFER, _ssbo, 0, data.size() * sizeof(T), data.data());
+        }
+    }
+
+    template <typename T>
+    template <typename F>
+    void StructuredBuffer<T>::upload_in_place(size_t count, F&& write)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Elements built in place must be trivially copyable");
+        check(_usage == GL_STREAM_DRAW);
+
+        SCOPED_EVENT("StructuredBuffer - upload in place", _name.c_str());
+
+        _stream_range = UploadRing::get().upload_in_place(count * sizeof(T), [&](uint8_t* destination)
+        {
+            write(reinterpret_cast<T*>(destination));
+        });
     }
 
     template <typename T>
-    GLuint StructuredBuffer<T>::get_ssbo() const
+    void StructuredBuffer<T>::bind(GLuint binding) const
     {
-        check(_ssbo);
-        return _ssbo;
+        Device& device = Device::get();
+        if (_usage == GL_STREAM_DRAW)
+        {
+            check(_stream_range.buffer);
+            device.bind_buffer_range(
+                GL_SHADER_STORAGE_BUFFER, binding,
+                _stream_range.buffer, _stream_range.offset, _stream_range.size
+            );
+        }
+        else
+        {
+            check(_ssbo);
+            device.bind_buffer_base(GL_SHADER_STORAGE_BUFFER, binding, _ssbo);
+        }
     }
 
     template <typename T>
@@ -97,10 +137,9 @@ namespace rendering
         {
             SCOPED_EVENT("StructuredBuffer - release", _name.c_str());
 
-            glDeleteBuffers(1, &_ssbo);
+            Device::get().delete_buffer(_ssbo);
             _ssbo = 0;
             _capacity = 0;
-            _size = 0;
         }
     }
 }
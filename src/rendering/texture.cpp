@@ -9,30 +9,28 @@
 #include <libs/nlohmann/json.hpp>
 #include <profiling/scoped_event.h>
 
-#pragma warning( push, 0 )
-#define STB_IMAGE_IMPLEMENTATION
-#include <libs/stb/stb_image.h>
-#pragma warning( pop )
+#include "device.h"
+#include "texture_cache.h"
 
 using namespace rendering;
 
-Texture::Texture(const std::string& name, const std::string& texture_path, const Config& config)
+Texture::Texture(
+    const std::string& name,
+    const std::string& texture_path,
+    const Config& config,
+    TextureCompression compression
+)
+    : Texture(name, TextureCache::load(texture_path, config.generate_mipmaps, compression), config)
+{ }
+
+Texture::Texture(const std::string& name, const CachedTexture& cached, const Config& config)
     : _name(name)
     , _config(config)
 {
     SCOPED_EVENT("Building texture", _name.c_str());
     Logger::log("Building texture '%s'", _name.c_str());
-    Logger::log("Loading texture data '%s'", texture_path.c_str());
 
-    stbi_set_flip_vertically_on_load(true);
-    stbi_uc* texture_data = stbi_load(texture_path.c_str(), &_resolution.x, &_resolution.y, &_num_channels, 0);
-    if (!texture_data)
-    {
-        throw std::runtime_error(strtools::catf("Could not load texture at %s", texture_path.c_str()));
-    }
-
-    build_from_buffer(texture_data);
-    stbi_image_free(texture_data);
+    build_from_cache(cached);
 }
 
 Texture::Texture(
@@ -93,35 +91,58 @@ Texture::~Texture()
     SCOPED_EVENT("Destroying texture", _name.c_str());
     Logger::log("Destroying texture '%s'", _name.c_str());
 
-    glDeleteTextures(1, &_tex);
+    Device::get().delete_texture(_tex);
 }
 
 peng::shared_ref<Texture> Texture::load_asset(const Archive& archive)
+{
+    return finalize_asset(archive, decode_asset(archive));
+}
+
+CachedTexture Texture::decode_asset(const Archive& archive)
 {
     const std::string texture_path = archive.read<std::string>("texture");
+    const TextureCompression compression = archive.read_or("compression", TextureCompression::none);
+    const Config config = read_config(archive);
 
+    Logger::log("Loading texture data '%s'", texture_path.c_str());
+    return TextureCache::load(texture_path, config.generate_mipmaps, compression);
+}
+
+peng::shared_ref<Texture> Texture::finalize_asset(const Archive& archive, CachedTexture&& cached)
+{
+    return memory::GC::alloc<Texture>(archive.name, cached, read_config(archive));
+}
+
+Texture::Config Texture::read_config(const Archive& archive)
+{
     // TODO: support parsing named items and not just raw decimal literals
-    Config config;
+    Config config = {
+        .wrap_x = GL_REPEAT,
+        .wrap_y = GL_REPEAT,
+        .min_filter = GL_LINEAR_MIPMAP_LINEAR,
+        .max_filter = GL_LINEAR,
+        .generate_mipmaps = true
+    };
+
     archive.try_read("wrap_x", config.wrap_x);
     archive.try_read("wrap_y", config.wrap_y);
     archive.try_read("min_filter", config.min_filter);
     archive.try_read("max_filter", config.max_filter);
     archive.try_read("generate_mipmaps", config.generate_mipmaps);
 
-    return memory::GC::alloc<Texture>(archive.name, texture_path, config);
+    return config;
 }
 
 void Texture::bind(GLint slot) const
 {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, _tex);
+    Device::get().bind_texture(slot, _tex);
 }
 
 void Texture::unbind(GLint slot) const
 {
     // TODO: slot should be stored from bind and used automatically
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    Device::get().bind_texture(slot, 0);
 }
 
 const std::string& Texture::name() const noexcept
@@ -144,6 +165,11 @@ TransparencyMode Texture::transparency() const noexcept
     return _transparency;
 }
 
+const Texture::Config& Texture::config() const noexcept
+{
+    return _config;
+}
+
 void Texture::verify_resolution(const math::Vector2i& resolution, int32_t num_pixels) const
 {
     if (resolution.area() != num_pixels)
@@ -155,16 +181,20 @@ void Texture::verify_resolution(const math::Vector2i& resolution, int32_t num_pi
     }
 }
 
-void Texture::build_from_buffer(const void* texture_data)
+void Texture::create_texture()
 {
-    glGenTextures(1, &_tex);
-    glBindTexture(GL_TEXTURE_2D, _tex);
-    glObjectLabel(GL_TEXTURE, _tex, -1, _name.c_str());
+    Device& device = Device::get();
+    _tex = device.create_texture(_name.c_str());
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _config.wrap_x);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _config.wrap_y);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _config.min_filter);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _config.max_filter);
+    device.texture_parameter(_tex, GL_TEXTURE_WRAP_S, _config.wrap_x);
+    device.texture_parameter(_tex, GL_TEXTURE_WRAP_T, _config.wrap_y);
+    device.texture_parameter(_tex, GL_TEXTURE_MIN_FILTER, _config.min_filter);
+    device.texture_parameter(_tex, GL_TEXTURE_MAG_FILTER, _config.max_filter);
+}
+
+void Texture::build_from_buffer(const void* texture_data)
+{
+    create_texture();
     
     GLenum texture_format;
     switch (_num_channels)
@@ -185,12 +215,66 @@ void Texture::build_from_buffer(const void* texture_data)
         }
     }
 
-    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(texture_format), _resolution.x, _resolution.y, 0, texture_format, GL_UNSIGNED_BYTE, texture_data);
+    Device& device = Device::get();
+    device.texture_image(_tex, 0, static_cast<GLint>(texture_format), _resolution, texture_format, GL_UNSIGNED_BYTE, texture_data);
     _transparency = determine_transparency(_num_channels, texture_data, _resolution.x * _resolution.y);
 
     if (_config.generate_mipmaps)
     {
-        glGenerateMipmap(GL_TEXTURE_2D);
+        device.generate_mipmaps(_tex);
+    }
+}
+
+void Texture::build_from_cache(const CachedTexture& cached)
+{
+    _resolution = cached.level(0).resolution;
+    _num_channels = cached.num_channels();
+    _transparency = cached.transparency();
+
+    create_texture();
+
+    // The mip chain was already built on import, so each level is uploaded as is rather than generated here
+    Device& device = Device::get();
+    for (size_t level = 0; level < cached.num_levels(); level++)
+    {
+        const CachedTextureLevel& level_data = cached.level(level);
+        const GLint gl_level = static_cast<GLint>(level);
+
+        switch (cached.format())
+        {
+            case CachedTextureFormat::rgb8:
+            {
+                device.texture_image(_tex, gl_level, GL_RGB, level_data.resolution, GL_RGB, GL_UNSIGNED_BYTE, level_data.data.data());
+                break;
+            }
+            case CachedTextureFormat::rgba8:
+            {
+                device.texture_image(_tex, gl_level, GL_RGBA, level_data.resolution, GL_RGBA, GL_UNSIGNED_BYTE, level_data.data.data());
+                break;
+            }
+            case CachedTextureFormat::bc1:
+            {
+                device.compressed_texture_image(
+                    _tex, gl_level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, level_data.resolution,
+                    level_data.data.size(), level_data.data.data()
+                );
+                break;
+            }
+            case CachedTextureFormat::bc3:
+            {
+                device.compressed_texture_image(
+                    _tex, gl_level, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, level_data.resolution,
+                    level_data.data.size(), level_data.data.data()
+                );
+                break;
+            }
+            default:
+            {
+                throw std::runtime_error(strtools::catf(
+                    "Texture %s has invalid cached format %d", _name.c_str(), static_cast<int32_t>(cached.format())
+                ));
+            }
+        }
     }
 }
 
@@ -198,7 +282,7 @@ TransparencyMode Texture::determine_transparency(
     int32_t num_channels,
     const void* texture_data,
     int32_t num_pixels
-) const noexcept
+) noexcept
 {
     if (num_channels != 4)
     {
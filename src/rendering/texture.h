@@ -7,12 +7,15 @@
 #include <memory/shared_ref.h>
 #include <math/vector4.h>
 
+#include "texture_compression.h"
 #include "transparency_mode.h"
 
 struct Archive;
 
 namespace rendering
 {
+    class CachedTexture;
+
     class Texture
     {
     public:
@@ -31,7 +34,17 @@ namespace rendering
             bool generate_mipmaps;
         };
 
-        Texture(const std::string& name, const std::string& texture_path, const Config& config = {});
+        // Loads the texture through the TextureCache, so the image is only decoded, mipmapped and compressed the
+        // first time it's loaded
+        Texture(
+            const std::string& name,
+            const std::string& texture_path,
+            const Config& config = {},
+            TextureCompression compression = TextureCompression::none
+        );
+
+        // Builds the texture from data already imported by the TextureCache
+        Texture(const std::string& name, const CachedTexture& cached, const Config& config = {});
 
         Texture(
             const std::string& name,
@@ -61,6 +74,10 @@ namespace rendering
 
         static peng::shared_ref<Texture> load_asset(const Archive& archive);
 
+        // Splits load_asset so that the image can be imported on a background thread, see Asset<T>::load_async
+        [[nodiscard]] static CachedTexture decode_asset(const Archive& archive);
+        [[nodiscard]] static peng::shared_ref<Texture> finalize_asset(const Archive& archive, CachedTexture&& cached);
+
         void bind(GLint slot) const;
         void unbind(GLint slot) const;
 
@@ -68,16 +85,21 @@ namespace rendering
         [[nodiscard]] GLuint raw() const noexcept;
         [[nodiscard]] math::Vector2i resolution() const noexcept;
         [[nodiscard]] TransparencyMode transparency() const noexcept;
+        [[nodiscard]] const Config& config() const noexcept;
 
-    private:
-        void verify_resolution(const math::Vector2i& resolution, int32_t num_pixels) const;
-        void build_from_buffer(const void* texture_data);
-
-        TransparencyMode determine_transparency(
+        [[nodiscard]] static TransparencyMode determine_transparency(
             int32_t num_channels,
             const void* texture_data,
             int32_t num_pixels
-        ) const noexcept;
+        ) noexcept;
+
+    private:
+        [[nodiscard]] static Config read_config(const Archive& archive);
+
+        void verify_resolution(const math::Vector2i& resolution, int32_t num_pixels) const;
+        void create_texture();
+        void build_from_buffer(const void* texture_data);
+        void build_from_cache(const CachedTexture& cached);
 
         std::string _name;
         GLuint _tex;
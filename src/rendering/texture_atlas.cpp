@@ -0,0 +1,245 @@
+#include "texture_atlas.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <core/logger.h>
+#include <profiling/scoped_event.h>
+#include <utils/strtools.h>
+
+#include "texture.h"
+#include "device.h"
+
+using namespace rendering;
+using namespace math;
+
+float TextureAtlasStats::occupancy() const noexcept
+{
+    return capacity_px > 0
+        ? static_cast<float>(used_px) / static_cast<float>(capacity_px)
+        : 0;
+}
+
+std::optional<AtlasRegion> TextureAtlas::place(const peng::shared_ref<const Texture>& texture)
+{
+    if (const auto it = _entries.find(texture.get()); it != _entries.end())
+    {
+        // The entry may belong to a destroyed texture that happened to be allocated at the same address
+        if (it->second.source == texture)
+        {
+            return it->second.region;
+        }
+
+        _entries.erase(it);
+    }
+
+    if (!can_atlas(*texture.get()))
+    {
+        return std::nullopt;
+    }
+
+    SCOPED_EVENT("TextureAtlas - place", texture->name().c_str());
+
+    const Texture::Config& config = texture->config();
+    const Vector2i padded_size = texture->resolution() + Vector2i::one() * (padding * 2);
+
+    Page* page = nullptr;
+    std::optional<Vector2i> position;
+
+    for (Page& existing_page : _pages)
+    {
+        if (existing_page.min_filter == config.min_filter && existing_page.mag_filter == config.max_filter)
+        {
+            position = existing_page.skyline.insert(padded_size);
+            if (position)
+            {
+                page = &existing_page;
+                break;
+            }
+        }
+    }
+
+    if (!page)
+    {
+        Texture::Config page_config;
+        page_config.wrap_x = GL_CLAMP_TO_EDGE;
+        page_config.wrap_y = GL_CLAMP_TO_EDGE;
+        page_config.min_filter = config.min_filter;
+        page_config.max_filter = config.max_filter;
+        page_config.generate_mipmaps = false;
+
+        const Vector2i page_resolution = Vector2i::one() * page_size;
+        const std::vector<Vector4u8> page_data(page_resolution.area(), Vector4u8(0, 0, 0, 0));
+
+        page = &_pages.emplace_back(Page{
+            .texture = peng::make_shared<Texture>(
+                strtools::catf("TextureAtlas[%zu]", _pages.size()), page_data, page_resolution, page_config
+            ),
+            .skyline = Skyline(page_resolution),
+            .min_filter = config.min_filter,
+            .mag_filter = config.max_filter
+        });
+
+        _stats.pages++;
+        _stats.capacity_px += page_resolution.area();
+
+        position = page->skyline.insert(padded_size);
+        check(position);
+    }
+
+    Logger::log("Placing texture '%s' in atlas page '%s'", texture->name().c_str(), page->texture->name().c_str());
+    copy_texture(*texture.get(), *page, *position);
+
+    _stats.textures++;
+    _stats.used_px += padded_size.area();
+
+    // The skyline works from the bottom left like texture coordinates, whereas regions are from the top left
+    const AtlasRegion region{
+        .page = page->texture,
+        .position = Vector2i(
+            position->x + padding,
+            page_size - (position->y + padding + texture->resolution().y)
+        )
+    };
+
+    _entries.try_emplace(texture.get(), Entry{
+        .source = texture,
+        .region = region
+    });
+
+    return region;
+}
+
+const TextureAtlasStats& TextureAtlas::stats() const noexcept
+{
+    return _stats;
+}
+
+TextureAtlas::Skyline::Skyline(const Vector2i& resolution)
+    : _resolution(resolution)
+    , _segments({ Segment{ .x = 0, .y = 0, .width = resolution.x } })
+{ }
+
+std::optional<Vector2i> TextureAtlas::Skyline::insert(const Vector2i& size)
+{
+    constexpr size_t no_segment = std::numeric_limits<size_t>::max();
+
+    size_t best_segment = no_segment;
+    int32_t best_y = std::numeric_limits<int32_t>::max();
+
+    // Try the rectangle's left edge at the start of each segment, it rests on the highest segment it spans
+    for (size_t i = 0; i < _segments.size(); i++)
+    {
+        const int32_t x = _segments[i].x;
+        if (x + size.x > _resolution.x)
+        {
+            break;
+        }
+
+        int32_t y = 0;
+        for (size_t j = i; j < _segments.size() && _segments[j].x < x + size.x; j++)
+        {
+            y = std::max(y, _segments[j].y);
+        }
+
+        if (y + size.y <= _resolution.y && y < best_y)
+        {
+            best_segment = i;
+            best_y = y;
+        }
+    }
+
+    if (best_segment == no_segment)
+    {
+        return std::nullopt;
+    }
+
+    const Segment placed{
+        .x = _segments[best_segment].x,
+        .y = best_y + size.y,
+        .width = size.x
+    };
+
+    // Remove the segments now covered by the rectangle, and trim the last one if it's only partly covered
+    const int32_t placed_end = placed.x + placed.width;
+    size_t covered_end = best_segment;
+
+    while (covered_end < _segments.size() && _segments[covered_end].x + _segments[covered_end].width <= placed_end)
+    {
+        covered_end++;
+    }
+
+    if (covered_end < _segments.size() && _segments[covered_end].x < placed_end)
+    {
+        Segment& partial = _segments[covered_end];
+        partial.width -= placed_end - partial.x;
+        partial.x = placed_end;
+    }
+
+    _segments.erase(_segments.begin() + best_segment, _segments.begin() + covered_end);
+    _segments.insert(_segments.begin() + best_segment, placed);
+
+    // Merge neighbouring segments at the same height so the skyline stays short
+    for (size_t i = 1; i < _segments.size();)
+    {
+        if (_segments[i - 1].y == _segments[i].y)
+        {
+            _segments[i - 1].width += _segments[i].width;
+            _segments.erase(_segments.begin() + i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+
+    return Vector2i(placed.x, best_y);
+}
+
+bool TextureAtlas::can_atlas(const Texture& texture)
+{
+    const Texture::Config& config = texture.config();
+    const Vector2i resolution = texture.resolution();
+
+    const auto plain_filter = [](GLint filter)
+    {
+        return filter == GL_NEAREST || filter == GL_LINEAR;
+    };
+
+    return !config.generate_mipmaps
+        && plain_filter(config.min_filter)
+        && plain_filter(config.max_filter)
+        && resolution.x > 0 && resolution.x <= max_texture_size
+        && resolution.y > 0 && resolution.y <= max_texture_size;
+}
+
+void TextureAtlas::copy_texture(const Texture& texture, Page& page, const Vector2i& position)
+{
+    const Vector2i resolution = texture.resolution();
+    const Vector2i padded_size = resolution + Vector2i::one() * (padding * 2);
+
+    Device& device = Device::get();
+
+    _source_pixels.resize(resolution.area());
+    device.read_texture_image(
+        texture.raw(), GL_RGBA, GL_UNSIGNED_BYTE,
+        _source_pixels.size() * sizeof(Vector4u8), _source_pixels.data()
+    );
+
+    // Pad the texture by clamping each padded pixel to the nearest source pixel
+    _padded_pixels.resize(padded_size.area());
+    for (int32_t y = 0; y < padded_size.y; y++)
+    {
+        const int32_t source_y = std::clamp(y - padding, 0, resolution.y - 1);
+        for (int32_t x = 0; x < padded_size.x; x++)
+        {
+            const int32_t source_x = std::clamp(x - padding, 0, resolution.x - 1);
+            _padded_pixels[y * padded_size.x + x] = _source_pixels[source_y * resolution.x + source_x];
+        }
+    }
+
+    device.texture_sub_image(
+        page.texture->raw(), position, padded_size,
+        GL_RGBA, GL_UNSIGNED_BYTE, _padded_pixels.data()
+    );
+}
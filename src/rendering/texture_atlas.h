@@ -0,0 +1,107 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include <GL/glew.h>
+#include <memory/weak_ptr.h>
+#include <math/vector2.h>
+#include <math/vector4.h>
+#include <utils/flat_hash_map.h>
+#include <utils/singleton.h>
+
+namespace rendering
+{
+    class Texture;
+
+    // Where a texture was placed within an atlas page
+    struct AtlasRegion
+    {
+        peng::shared_ref<const Texture> page;
+
+        // Top left corner of the texture within the page, in pixels from the top left like sprite positions
+        math::Vector2i position;
+    };
+
+    struct TextureAtlasStats
+    {
+        int32_t pages = 0;
+        int32_t textures = 0;
+
+        // Pixels taken up by placed textures including their padding, against the total pixels of all pages
+        int64_t used_px = 0;
+        int64_t capacity_px = 0;
+
+        [[nodiscard]] float occupancy() const noexcept;
+    };
+
+    // Packs small sprite textures into shared pages so that sprites from different textures can be batched together
+    // Textures are copied into a page the first time they are placed, and every later placement reuses that copy
+    // Only textures without mipmaps and with plain nearest or linear filtering can be atlased, and each page only
+    // holds textures with the same filtering. Textures are padded by repeating their edge pixels so filtering
+    // never reads a neighbour. Space isn't reclaimed when a source texture is destroyed
+    // Placing a texture reads it back from the GPU, so this must happen when loading and on the render thread
+    class TextureAtlas : public utils::Singleton<TextureAtlas>
+    {
+        using Singleton::Singleton;
+
+    public:
+        static constexpr int32_t page_size = 1024;
+        static constexpr int32_t max_texture_size = 256;
+        static constexpr int32_t padding = 1;
+
+        // Places the texture into a page if it isn't already in one
+        // Returns nullopt if the texture can't be atlased, in which case it should be used as is
+        [[nodiscard]] std::optional<AtlasRegion> place(const peng::shared_ref<const Texture>& texture);
+
+        [[nodiscard]] const TextureAtlasStats& stats() const noexcept;
+
+    private:
+        // Bottom left skyline packer, the skyline is the top edge of everything placed so far
+        // stored as a list of horizontal segments covering the full width of the page
+        class Skyline
+        {
+        public:
+            explicit Skyline(const math::Vector2i& resolution);
+
+            // Finds the lowest position the rectangle fits at and marks it as used
+            [[nodiscard]] std::optional<math::Vector2i> insert(const math::Vector2i& size);
+
+        private:
+            struct Segment
+            {
+                int32_t x;
+                int32_t y;
+                int32_t width;
+            };
+
+            math::Vector2i _resolution;
+            std::vector<Segment> _segments;
+        };
+
+        struct Page
+        {
+            peng::shared_ref<Texture> texture;
+            Skyline skyline;
+            GLint min_filter;
+            GLint mag_filter;
+        };
+
+        struct Entry
+        {
+            peng::weak_ptr<const Texture> source;
+            AtlasRegion region;
+        };
+
+        [[nodiscard]] static bool can_atlas(const Texture& texture);
+
+        // Copies the texture with its padding into the page, position is the bottom left of the padded texture
+        void copy_texture(const Texture& texture, Page& page, const math::Vector2i& position);
+
+        std::vector<Page> _pages;
+        utils::flat_hash_map<const Texture*, Entry> _entries;
+        std::vector<math::Vector4u8> _source_pixels;
+        std::vector<math::Vector4u8> _padded_pixels;
+        TextureAtlasStats _stats;
+    };
+}
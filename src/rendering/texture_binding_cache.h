@@ -1,9 +1,10 @@
 #pragma once
 
-#include <unordered_map>
+#include <vector>
 
 #include <GL/glew.h>
 #include <memory/shared_ptr.h>
+#include <utils/flat_hash_map.h>
 #include <utils/singleton.h>
 
 namespace rendering
@@ -29,7 +30,7 @@ namespace rendering
     private:
         std::vector<int32_t> _free_slots;
         std::vector<peng::shared_ptr<const Texture>> _texture_slots;
-        std::unordered_map<peng::shared_ptr<const Texture>, GLint> _textures_to_slots;
-        std::unordered_map<GLint, peng::shared_ptr<const Texture>> _slots_to_textures;
+        utils::flat_hash_map<peng::shared_ptr<const Texture>, GLint> _textures_to_slots;
+        utils::flat_hash_map<GLint, peng::shared_ptr<const Texture>> _slots_to_textures;
     };
 }
\ No newline at end of file
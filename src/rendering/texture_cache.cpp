@@ -0,0 +1,676 @@
+#include "texture_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <execution>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include <core/logger.h>
+#include <profiling/scoped_event.h>
+#include <utils/cache_file.h>
+#include <utils/check.h>
+#include <utils/hash_helpers.h>
+#include <utils/strtools.h>
+
+#include "texture.h"
+
+#pragma warning( push, 0 )
+#define STB_IMAGE_IMPLEMENTATION
+#include <libs/stb/stb_image.h>
+#pragma warning( pop )
+
+using namespace rendering;
+using namespace math;
+
+namespace
+{
+    constexpr std::array<char, 4> ptex_magic = { 'P', 'T', 'E', 'X' };
+
+    struct FileHeader
+    {
+        std::array<char, 4> magic;
+        uint32_t version;
+        CachedTextureFormat format;
+        TransparencyMode transparency;
+        TextureCompression compression;
+        uint32_t generate_mipmaps;
+        uint32_t num_levels;
+        uint32_t reserved;
+        uint64_t source_hash;
+    };
+
+    struct LevelHeader
+    {
+        uint64_t offset;
+        uint64_t size;
+        Vector2i resolution;
+    };
+
+    static_assert(std::is_trivially_copyable_v<FileHeader>);
+    static_assert(std::is_trivially_copyable_v<LevelHeader>);
+
+    // A 4x4 block of RGBA texels
+    using TexelBlock = std::array<Vector4u8, 16>;
+
+    [[nodiscard]] uint64_t hash_bytes(const std::byte* data, size_t size) noexcept
+    {
+        size_t hash = utils::hash_mix(size);
+
+        size_t offset = 0;
+        for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, data + offset, sizeof(uint64_t));
+            hash = utils::hash_combine(hash, word);
+        }
+
+        uint64_t tail = 0;
+        std::memcpy(&tail, data + offset, size - offset);
+
+        return utils::hash_combine(hash, tail);
+    }
+
+    [[nodiscard]] int32_t bytes_per_block(CachedTextureFormat format) noexcept
+    {
+        return format == CachedTextureFormat::bc1 ? 8 : 16;
+    }
+
+    [[nodiscard]] Vector2i num_blocks(const Vector2i& resolution) noexcept
+    {
+        return Vector2i((resolution.x + 3) / 4, (resolution.y + 3) / 4);
+    }
+
+    [[nodiscard]] size_t level_size(CachedTextureFormat format, const Vector2i& resolution) noexcept
+    {
+        switch (format)
+        {
+            case CachedTextureFormat::rgb8: return static_cast<size_t>(resolution.area()) * 3;
+            case CachedTextureFormat::rgba8: return static_cast<size_t>(resolution.area()) * 4;
+            case CachedTextureFormat::bc1:
+            case CachedTextureFormat::bc3: return static_cast<size_t>(num_blocks(resolution).area()) * bytes_per_block(format);
+            default: return 0;
+        }
+    }
+
+    // Halves the resolution with a box filter
+    // When a dimension is odd its last row or column has no pair, so it is folded into the last output texel,
+    // which then averages three source texels along that dimension instead of two
+    [[nodiscard]] std::vector<std::byte> downsample(
+        const std::vector<std::byte>& texels,
+        const Vector2i& resolution,
+        const Vector2i& next_resolution,
+        int32_t num_channels
+    )
+    {
+        std::vector<std::byte> next_texels(static_cast<size_t>(next_resolution.area()) * num_channels);
+
+        // Gets the source range [first, last] covered by an output texel along one dimension
+        const auto source_range = [](int32_t index, int32_t size, int32_t next_size)
+        {
+            const int32_t first = index * 2;
+            const int32_t last = index == next_size - 1
+                ? size - 1
+                : index * 2 + 1;
+
+            return std::pair(first, last);
+        };
+
+        for (int32_t y = 0; y < next_resolution.y; y++)
+        {
+            const auto [y0, y1] = source_range(y, resolution.y, next_resolution.y);
+
+            for (int32_t x = 0; x < next_resolution.x; x++)
+            {
+                const auto [x0, x1] = source_range(x, resolution.x, next_resolution.x);
+                const uint32_t num_texels = static_cast<uint32_t>((x1 - x0 + 1) * (y1 - y0 + 1));
+
+                for (int32_t channel = 0; channel < num_channels; channel++)
+                {
+                    uint32_t sum = 0;
+                    for (int32_t ty = y0; ty <= y1; ty++)
+                    {
+                        for (int32_t tx = x0; tx <= x1; tx++)
+                        {
+                            sum += static_cast<uint32_t>(texels[(ty * resolution.x + tx) * num_channels + channel]);
+                        }
+                    }
+
+                    next_texels[(y * next_resolution.x + x) * num_channels + channel] = static_cast<std::byte>(
+                        (sum + num_texels / 2) / num_texels
+                    );
+                }
+            }
+        }
+
+        return next_texels;
+    }
+
+    // Reads a block of texels, clamping to the edge for blocks which hang over the edge of the image
+    [[nodiscard]] TexelBlock read_block(
+        const std::vector<std::byte>& texels,
+        const Vector2i& resolution,
+        int32_t num_channels,
+        const Vector2i& block
+    ) noexcept
+    {
+        TexelBlock block_texels;
+        for (int32_t y = 0; y < 4; y++)
+        {
+            const int32_t ty = std::min(block.y * 4 + y, resolution.y - 1);
+            for (int32_t x = 0; x < 4; x++)
+            {
+                const int32_t tx = std::min(block.x * 4 + x, resolution.x - 1);
+                const std::byte* texel = texels.data() + (ty * resolution.x + tx) * num_channels;
+
+                block_texels[y * 4 + x] = Vector4u8(
+                    static_cast<uint8_t>(texel[0]),
+                    static_cast<uint8_t>(texel[1]),
+                    static_cast<uint8_t>(texel[2]),
+                    num_channels == 4 ? static_cast<uint8_t>(texel[3]) : 0xFF
+                );
+            }
+        }
+
+        return block_texels;
+    }
+
+    [[nodiscard]] uint16_t pack_565(const Vector3i& color) noexcept
+    {
+        const auto quantize = [](int32_t value, int32_t max)
+        {
+            return static_cast<uint16_t>((value * max + 127) / 255);
+        };
+
+        return static_cast<uint16_t>((quantize(color.x, 31) << 11) | (quantize(color.y, 63) << 5) | quantize(color.z, 31));
+    }
+
+    [[nodiscard]] Vector3i unpack_565(uint16_t packed) noexcept
+    {
+        const int32_t r = (packed >> 11) & 0x1F;
+        const int32_t g = (packed >> 5) & 0x3F;
+        const int32_t b = packed & 0x1F;
+
+        return Vector3i((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+    }
+
+    void write_le(std::byte* out, uint64_t value, int32_t num_bytes) noexcept
+    {
+        for (int32_t i = 0; i < num_bytes; i++)
+        {
+            out[i] = static_cast<std::byte>((value >> (i * 8)) & 0xFF);
+        }
+    }
+
+    // Encodes the color of a block as BC1 using the endpoints of its inset bounding box
+    // The diagonal of the box is flipped to follow the block's dominant gradient
+    void encode_color_block(const TexelBlock& block, std::byte* out) noexcept
+    {
+        Vector3i min_color = Vector3i::one() * 255;
+        Vector3i max_color = Vector3i::zero();
+        Vector3i sum = Vector3i::zero();
+
+        for (const Vector4u8& texel : block)
+        {
+            const Vector3i color(texel.x, texel.y, texel.z);
+            min_color = Vector3i(std::min(min_color.x, color.x), std::min(min_color.y, color.y), std::min(min_color.z, color.z));
+            max_color = Vector3i(std::max(max_color.x, color.x), std::max(max_color.y, color.y), std::max(max_color.z, color.z));
+            sum += color;
+        }
+
+        // Green and blue follow red up or down through the block depending on the sign of their covariance
+        int32_t covariance_rg = 0;
+        int32_t covariance_rb = 0;
+        for (const Vector4u8& texel : block)
+        {
+            const Vector3i centered = Vector3i(texel.x, texel.y, texel.z) * 16 - sum;
+            covariance_rg += centered.x * centered.y;
+            covariance_rb += centered.x * centered.z;
+        }
+
+        if (covariance_rg < 0)
+        {
+            std::swap(min_color.y, max_color.y);
+        }
+
+        if (covariance_rb < 0)
+        {
+            std::swap(min_color.z, max_color.z);
+        }
+
+        // Insetting by 1/16 of the range moves the endpoints off outliers, which lowers the average error
+        const Vector3i inset = (max_color - min_color) / 16;
+        max_color -= inset;
+        min_color += inset;
+
+        uint16_t color0 = pack_565(max_color);
+        uint16_t color1 = pack_565(min_color);
+
+        // color0 > color1 selects the four color mode
+        if (color0 < color1)
+        {
+            std::swap(color0, color1);
+        }
+
+        uint32_t indices = 0;
+        if (color0 != color1)
+        {
+            const Vector3i endpoint0 = unpack_565(color0);
+            const Vector3i endpoint1 = unpack_565(color1);
+            const std::array<Vector3i, 4> palette = {
+                endpoint0,
+                endpoint1,
+                (endpoint0 * 2 + endpoint1) / 3,
+                (endpoint0 + endpoint1 * 2) / 3
+            };
+
+            for (size_t i = 0; i < block.size(); i++)
+            {
+                const Vector3i color(block[i].x, block[i].y, block[i].z);
+
+                uint32_t best_index = 0;
+                int32_t best_error = std::numeric_limits<int32_t>::max();
+                for (uint32_t index = 0; index < palette.size(); index++)
+                {
+                    const int32_t error = (palette[index] - color).magnitude_sqr();
+                    if (error < best_error)
+                    {
+                        best_index = index;
+                        best_error = error;
+                    }
+                }
+
+                indices |= best_index << (i * 2);
+            }
+        }
+
+        write_le(out, color0, 2);
+        write_le(out + 2, color1, 2);
+        write_le(out + 4, indices, 4);
+    }
+
+    // Encodes the alpha of a block as a BC3 alpha block using the minimum and maximum alpha as the endpoints
+    // Using the exact extremes keeps fully opaque and fully transparent texels exact, which masked textures rely on
+    void encode_alpha_block(const TexelBlock& block, std::byte* out) noexcept
+    {
+        int32_t alpha0 = 0;
+        int32_t alpha1 = 255;
+        for (const Vector4u8& texel : block)
+        {
+            alpha0 = std::max(alpha0, static_cast<int32_t>(texel.w));
+            alpha1 = std::min(alpha1, static_cast<int32_t>(texel.w));
+        }
+
+        uint64_t indices = 0;
+        if (alpha0 != alpha1)
+        {
+            // alpha0 > alpha1 selects the eight alpha mode, where indices 2 to 7 interpolate between the endpoints
+            std::array<int32_t, 8> palette = { alpha0, alpha1 };
+            for (int32_t index = 2; index < 8; index++)
+            {
+                palette[index] = ((8 - index) * alpha0 + (index - 1) * alpha1) / 7;
+            }
+
+            for (size_t i = 0; i < block.size(); i++)
+            {
+                uint64_t best_index = 0;
+                int32_t best_error = std::numeric_limits<int32_t>::max();
+                for (uint64_t index = 0; index < palette.size(); index++)
+                {
+                    const int32_t error = std::abs(palette[index] - static_cast<int32_t>(block[i].w));
+                    if (error < best_error)
+                    {
+                        best_index = index;
+                        best_error = error;
+                    }
+                }
+
+                indices |= best_index << (i * 3);
+            }
+        }
+
+        write_le(out, static_cast<uint64_t>(alpha0), 1);
+        write_le(out + 1, static_cast<uint64_t>(alpha1), 1);
+        write_le(out + 2, indices, 6);
+    }
+
+    [[nodiscard]] std::vector<std::byte> compress(
+        const std::vector<std::byte>& texels,
+        const Vector2i& resolution,
+        int32_t num_channels,
+        CachedTextureFormat format
+    )
+    {
+        const Vector2i blocks = num_blocks(resolution);
+        const int32_t block_size = bytes_per_block(format);
+
+        std::vector<std::byte> compressed(level_size(format, resolution));
+
+        std::vector<int32_t> block_rows(blocks.y);
+        std::iota(block_rows.begin(), block_rows.end(), 0);
+
+        std::for_each(std::execution::par, block_rows.begin(), block_rows.end(), [&](int32_t block_y)
+        {
+            for (int32_t block_x = 0; block_x < blocks.x; block_x++)
+            {
+                const TexelBlock block = read_block(texels, resolution, num_channels, Vector2i(block_x, block_y));
+                std::byte* out = compressed.data() + static_cast<size_t>(block_y * blocks.x + block_x) * block_size;
+
+                if (format == CachedTextureFormat::bc3)
+                {
+                    encode_alpha_block(block, out);
+                    out += 8;
+                }
+
+                encode_color_block(block, out);
+            }
+        });
+
+        return compressed;
+    }
+}
+
+CachedTexture::CachedTexture(
+    io::MappedFile&& file,
+    CachedTextureFormat format,
+    TransparencyMode transparency,
+    std::vector<CachedTextureLevel>&& levels
+)
+    : _file(std::move(file))
+    , _levels(std::move(levels))
+    , _format(format)
+    , _transparency(transparency)
+{ }
+
+CachedTexture::CachedTexture(
+    std::vector<std::vector<std::byte>>&& level_data,
+    CachedTextureFormat format,
+    TransparencyMode transparency,
+    std::vector<CachedTextureLevel>&& levels
+)
+    : _level_data(std::move(level_data))
+    , _levels(std::move(levels))
+    , _format(format)
+    , _transparency(transparency)
+{ }
+
+CachedTextureFormat CachedTexture::format() const noexcept
+{
+    return _format;
+}
+
+bool CachedTexture::compressed() const noexcept
+{
+    return _format == CachedTextureFormat::bc1 || _format == CachedTextureFormat::bc3;
+}
+
+int32_t CachedTexture::num_channels() const noexcept
+{
+    return _format == CachedTextureFormat::rgb8 || _format == CachedTextureFormat::bc1 ? 3 : 4;
+}
+
+TransparencyMode CachedTexture::transparency() const noexcept
+{
+    return _transparency;
+}
+
+size_t CachedTexture::num_levels() const noexcept
+{
+    return _levels.size();
+}
+
+const CachedTextureLevel& CachedTexture::level(size_t index) const
+{
+    check(index < _levels.size());
+    return _levels[index];
+}
+
+CachedTexture TextureCache::load(const std::string& source_path, bool generate_mipmaps, TextureCompression compression)
+{
+    SCOPED_EVENT("TextureCache - load", source_path.c_str());
+
+    const io::MappedFile source(source_path);
+    if (!source.is_open())
+    {
+        throw std::runtime_error(strtools::catf("Could not load texture at %s", source_path.c_str()));
+    }
+
+    // Hashing the source is far cheaper than decoding it, and unlike a timestamp survives checkouts and copies
+    const uint64_t source_hash = hash_bytes(source.data(), source.size());
+    if (std::optional<CachedTexture> cached = try_load(cache_path(source_path), source_hash, generate_mipmaps, compression))
+    {
+        return std::move(*cached);
+    }
+
+    return import(source_path, source, source_hash, generate_mipmaps, compression);
+}
+
+std::string TextureCache::cache_path(const std::string& source_path)
+{
+    return io::cache_path(source_path, ".ptex");
+}
+
+std::optional<CachedTexture> TextureCache::try_load(
+    const std::string& path,
+    uint64_t source_hash,
+    bool generate_mipmaps,
+    TextureCompression compression
+)
+{
+    io::MappedFile file(path);
+    if (!file.is_open() || file.size() < sizeof(FileHeader))
+    {
+        return std::nullopt;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, file.data(), sizeof(FileHeader));
+
+    const bool up_to_date = header.magic == ptex_magic
+        && header.version == format_version
+        && header.source_hash == source_hash
+        && header.generate_mipmaps == static_cast<uint32_t>(generate_mipmaps)
+        && header.compression == compression
+        && header.format <= CachedTextureFormat::bc3
+        && header.transparency <= TransparencyMode::translucent
+        && header.num_levels > 0
+        && io::cache_headers_in_range(sizeof(FileHeader), header.num_levels, sizeof(LevelHeader), file.size());
+
+    if (!up_to_date)
+    {
+        Logger::log("Texture cache file '%s' is out of date", path.c_str());
+        return std::nullopt;
+    }
+
+    std::vector<CachedTextureLevel> levels;
+    levels.reserve(header.num_levels);
+
+    for (uint32_t level = 0; level < header.num_levels; level++)
+    {
+        LevelHeader level_header;
+        std::memcpy(
+            &level_header,
+            file.data() + sizeof(FileHeader) + level * sizeof(LevelHeader),
+            sizeof(LevelHeader)
+        );
+
+        const bool in_range = level_header.resolution.x > 0
+            && level_header.resolution.y > 0
+            && level_header.size == level_size(header.format, level_header.resolution)
+            && io::cache_block_in_range(level_header.offset, level_header.size, 1, file.size());
+
+        if (!in_range)
+        {
+            Logger::warning("Texture cache file '%s' is truncated", path.c_str());
+            return std::nullopt;
+        }
+
+        levels.push_back(CachedTextureLevel{
+            .data = std::span(file.data() + level_header.offset, static_cast<size_t>(level_header.size)),
+            .resolution = level_header.resolution
+        });
+    }
+
+    return CachedTexture(std::move(file), header.format, header.transparency, std::move(levels));
+}
+
+CachedTexture TextureCache::import(
+    const std::string& source_path,
+    const io::MappedFile& source,
+    uint64_t source_hash,
+    bool generate_mipmaps,
+    TextureCompression compression
+)
+{
+    SCOPED_EVENT("TextureCache - import", source_path.c_str());
+
+    Vector2i resolution;
+    int32_t num_channels;
+
+    // The thread local flag is used since textures can be imported on several threads at once
+    stbi_set_flip_vertically_on_load_thread(true);
+    stbi_uc* stbi_data = stbi_load_from_memory(
+        reinterpret_cast<const stbi_uc*>(source.data()),
+        static_cast<int>(source.size()),
+        &resolution.x, &resolution.y, &num_channels, 0
+    );
+
+    if (!stbi_data)
+    {
+        throw std::runtime_error(strtools::catf("Could not load texture at %s", source_path.c_str()));
+    }
+
+    const std::vector<std::byte> texels(
+        reinterpret_cast<const std::byte*>(stbi_data),
+        reinterpret_cast<const std::byte*>(stbi_data) + static_cast<size_t>(resolution.area()) * num_channels
+    );
+
+    stbi_image_free(stbi_data);
+
+    if (num_channels != 3 && num_channels != 4)
+    {
+        throw std::runtime_error(strtools::catf("Cannot load texture with %d color channels", num_channels));
+    }
+
+    const TransparencyMode transparency = Texture::determine_transparency(num_channels, texels.data(), resolution.area());
+
+    // Opaque textures don't need an alpha block, halving the compressed size
+    CachedTextureFormat format;
+    if (compression == TextureCompression::bc)
+    {
+        format = transparency == TransparencyMode::opaque ? CachedTextureFormat::bc1 : CachedTextureFormat::bc3;
+    }
+    else
+    {
+        format = num_channels == 3 ? CachedTextureFormat::rgb8 : CachedTextureFormat::rgba8;
+    }
+
+    std::vector<std::vector<std::byte>> level_data;
+    std::vector<CachedTextureLevel> levels;
+
+    // Each mip is filtered from the uncompressed level above it, so compression errors don't accumulate
+    std::vector<std::byte> level_texels = texels;
+    Vector2i level_resolution = resolution;
+
+    while (true)
+    {
+        level_data.push_back(compression == TextureCompression::bc
+            ? compress(level_texels, level_resolution, num_channels, format)
+            : level_texels
+        );
+
+        levels.push_back(CachedTextureLevel{
+            .data = level_data.back(),
+            .resolution = level_resolution
+        });
+
+        if (!generate_mipmaps || level_resolution == Vector2i::one())
+        {
+            break;
+        }
+
+        const Vector2i next_resolution(std::max(level_resolution.x / 2, 1), std::max(level_resolution.y / 2, 1));
+        level_texels = downsample(level_texels, level_resolution, next_resolution, num_channels);
+        level_resolution = next_resolution;
+    }
+
+    CachedTexture texture(std::move(level_data), format, transparency, std::move(levels));
+
+    const std::string path = cache_path(source_path);
+    if (write(path, source_hash, generate_mipmaps, compression, texture))
+    {
+        Logger::log("Wrote texture cache file '%s'", path.c_str());
+    }
+    else
+    {
+        Logger::warning("Failed to write texture cache file '%s'", path.c_str());
+    }
+
+    return texture;
+}
+
+bool TextureCache::write(
+    const std::string& path,
+    uint64_t source_hash,
+    bool generate_mipmaps,
+    TextureCompression compression,
+    const CachedTexture& texture
+)
+{
+    SCOPED_EVENT("TextureCache - write", path.c_str());
+
+    const FileHeader header = {
+        .magic = ptex_magic,
+        .version = format_version,
+        .format = texture.format(),
+        .transparency = texture.transparency(),
+        .compression = compression,
+        .generate_mipmaps = static_cast<uint32_t>(generate_mipmaps),
+        .num_levels = static_cast<uint32_t>(texture.num_levels()),
+        .reserved = 0,
+        .source_hash = source_hash
+    };
+
+    std::vector<LevelHeader> level_headers;
+    level_headers.reserve(texture.num_levels());
+
+    size_t offset = io::align_cache_offset(sizeof(FileHeader) + texture.num_levels() * sizeof(LevelHeader));
+    for (size_t level = 0; level < texture.num_levels(); level++)
+    {
+        const CachedTextureLevel& level_view = texture.level(level);
+        level_headers.push_back(LevelHeader{
+            .offset = offset,
+            .size = level_view.data.size(),
+            .resolution = level_view.resolution
+        });
+
+        offset = io::align_cache_offset(offset + level_view.data.size());
+    }
+
+    try
+    {
+        io::CacheFileWriter writer(path);
+        if (!writer.is_open())
+        {
+            return false;
+        }
+
+        writer.write_at(0, &header, sizeof(FileHeader));
+        writer.write_at(sizeof(FileHeader), level_headers.data(), level_headers.size() * sizeof(LevelHeader));
+
+        for (size_t level = 0; level < texture.num_levels(); level++)
+        {
+            writer.write_at(level_headers[level].offset, texture.level(level).data.data(), level_headers[level].size);
+        }
+
+        return writer.commit();
+    }
+    catch (const std::exception& e)
+    {
+        Logger::warning("Error writing texture cache file '%s': %s", path.c_str(), e.what());
+        return false;
+    }
+}
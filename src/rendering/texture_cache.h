@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <math/vector2.h>
+#include <utils/mapped_file.h>
+
+#include "texture_compression.h"
+#include "transparency_mode.h"
+
+namespace rendering
+{
+    // Layout of the texels of every level of a cached texture
+    enum class CachedTextureFormat : uint32_t
+    {
+        rgb8,
+        rgba8,
+        bc1,
+        bc3
+    };
+
+    struct CachedTextureLevel
+    {
+        std::span<const std::byte> data;
+        math::Vector2i resolution;
+    };
+
+    // Imported data for an image file, either mapped from its cache file or freshly imported
+    // Level 0 is the full resolution image, followed by its mip chain if one was generated
+    // Views into the data are only valid for as long as the CachedTexture is alive
+    class CachedTexture
+    {
+    public:
+        explicit CachedTexture(
+            io::MappedFile&& file,
+            CachedTextureFormat format,
+            TransparencyMode transparency,
+            std::vector<CachedTextureLevel>&& levels
+        );
+
+        explicit CachedTexture(
+            std::vector<std::vector<std::byte>>&& level_data,
+            CachedTextureFormat format,
+            TransparencyMode transparency,
+            std::vector<CachedTextureLevel>&& levels
+        );
+
+        CachedTexture(const CachedTexture&) = delete;
+        CachedTexture(CachedTexture&&) = default;
+
+        [[nodiscard]] CachedTextureFormat format() const noexcept;
+        [[nodiscard]] bool compressed() const noexcept;
+        [[nodiscard]] int32_t num_channels() const noexcept;
+        [[nodiscard]] TransparencyMode transparency() const noexcept;
+        [[nodiscard]] size_t num_levels() const noexcept;
+        [[nodiscard]] const CachedTextureLevel& level(size_t index) const;
+
+    private:
+        io::MappedFile _file;
+        std::vector<std::vector<std::byte>> _level_data;
+        std::vector<CachedTextureLevel> _levels;
+        CachedTextureFormat _format;
+        TransparencyMode _transparency;
+    };
+
+    // Binary cache of imported textures, so image files are only decoded, mipmapped and compressed the first time
+    // they're loaded
+    // Each .ptex file holds the final texels of every mip level along with the texture's transparency mode, laid out
+    // so that it can be memory mapped and handed straight to the GPU upload without any decoding
+    // Cache files are rebuilt whenever the hash of their source file changes, or the format or import settings change
+    class TextureCache
+    {
+    public:
+        // Bumped whenever the file layout or the import process changes, invalidating every existing cache file
+        static constexpr uint32_t format_version = 2;
+
+        // Gets the imported data for an image file, importing and caching it first if needed
+        // Throws if the image file can't be loaded
+        [[nodiscard]] static CachedTexture load(
+            const std::string& source_path,
+            bool generate_mipmaps,
+            TextureCompression compression
+        );
+
+        [[nodiscard]] static std::string cache_path(const std::string& source_path);
+
+    private:
+        [[nodiscard]] static std::optional<CachedTexture> try_load(
+            const std::string& path,
+            uint64_t source_hash,
+            bool generate_mipmaps,
+            TextureCompression compression
+        );
+
+        [[nodiscard]] static CachedTexture import(
+            const std::string& source_path,
+            const io::MappedFile& source,
+            uint64_t source_hash,
+            bool generate_mipmaps,
+            TextureCompression compression
+        );
+
+        static bool write(
+            const std::string& path,
+            uint64_t source_hash,
+            bool generate_mipmaps,
+            TextureCompression compression,
+            const CachedTexture& texture
+        );
+    };
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <libs/nlohmann/json.hpp>
+
+namespace rendering
+{
+    // Controls how a texture loaded from an image file is stored on the GPU
+    enum class TextureCompression
+    {
+        // Every texel is stored uncompressed as 8 bit RGB or RGBA
+        none,
+
+        // Block compressed on import, BC1 for opaque textures and BC3 for textures with any transparency
+        bc
+    };
+
+    NLOHMANN_JSON_SERIALIZE_ENUM(TextureCompression, {
+        { TextureCompression::none, "none" },
+        { TextureCompression::bc, "bc" }
+    });
+}
@@ -0,0 +1,186 @@
+#include "upload_ring.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include <profiling/scoped_event.h>
+
+#include "device.h"
+
+using namespace rendering;
+
+namespace
+{
+    // How long to wait for the GPU in a single call before checking again
+    constexpr uint64_t wait_timeout_ns = 1'000'000'000;
+
+    [[nodiscard]] size_t align_up(size_t value, size_t alignment) noexcept
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+UploadRing::~UploadRing()
+{
+    Device& device = Device::get();
+    for (GLsync& fence : _fences)
+    {
+        if (fence)
+        {
+            device.delete_sync(fence);
+            fence = nullptr;
+        }
+    }
+
+    release_buffer(_buffer);
+    for (Buffer& buffer : _retired_buffers)
+    {
+        release_buffer(buffer);
+    }
+}
+
+BufferRange UploadRing::upload(const void* data, size_t size)
+{
+    return upload_in_place(size, [&](uint8_t* destination)
+    {
+        std::memcpy(destination, data, size);
+    });
+}
+
+BufferRange UploadRing::allocate(size_t size)
+{
+    // Empty ranges can't be bound, so even empty uploads take up some space
+    const size_t bound_size = std::max<size_t>(size, 1);
+    reserve(bound_size);
+
+    const size_t offset = _frame * _frame_capacity + _head;
+
+    _head = align_up(_head + bound_size, _alignment);
+    _stats.bytes_uploaded += static_cast<int64_t>(size);
+    _stats.uploads++;
+
+    return BufferRange{
+        .buffer = _buffer.buffer,
+        .offset = offset,
+        .size = bound_size
+    };
+}
+
+UploadRingStats UploadRing::end_frame()
+{
+    SCOPED_EVENT("UploadRing - end frame");
+
+    Device& device = Device::get();
+    if (_buffer.buffer)
+    {
+        // A frame without uploads never waited on its old fence, which the new one supersedes
+        if (_fences[_frame])
+        {
+            device.delete_sync(_fences[_frame]);
+        }
+
+        _fences[_frame] = device.fence_sync();
+    }
+
+    // Deleting is safe once the frame has been submitted, OpenGL keeps buffers alive until the GPU is done with them
+    for (Buffer& buffer : _retired_buffers)
+    {
+        release_buffer(buffer);
+    }
+
+    _retired_buffers.clear();
+
+    _stats.capacity = _frame_capacity * frames_in_flight;
+    const UploadRingStats stats = std::exchange(_stats, UploadRingStats());
+
+    _frame = (_frame + 1) % frames_in_flight;
+    _head = 0;
+    _frame_ready = false;
+
+    return stats;
+}
+
+void UploadRing::reserve(size_t size)
+{
+    if (!_buffer.buffer)
+    {
+        _alignment = Device::get().storage_buffer_offset_alignment();
+        grow(min_frame_capacity);
+    }
+
+    if (!_frame_ready)
+    {
+        wait_for_frame();
+    }
+
+    if (_head + size > _frame_capacity)
+    {
+        // Size for everything this frame has uploaded so far, so the same frame fits next time around
+        grow(std::max(_frame_capacity * 2, _head + size));
+    }
+}
+
+void UploadRing::grow(size_t min_capacity)
+{
+    SCOPED_EVENT("UploadRing - grow");
+
+    if (_buffer.buffer)
+    {
+        _retired_buffers.push_back(std::exchange(_buffer, Buffer()));
+        _stats.reallocations++;
+    }
+
+    Device& device = Device::get();
+    _frame_capacity = align_up(std::max(min_capacity, min_frame_capacity), _alignment);
+    _buffer.buffer = device.create_buffer("UploadRing");
+    _buffer.mapping = static_cast<uint8_t*>(
+        device.map_buffer_persistent(GL_SHADER_STORAGE_BUFFER, _buffer.buffer, _frame_capacity * frames_in_flight)
+    );
+
+    // Nothing has used the new buffer yet, so the fences no longer guard anything
+    for (GLsync& fence : _fences)
+    {
+        if (fence)
+        {
+            device.delete_sync(fence);
+            fence = nullptr;
+        }
+    }
+
+    _head = 0;
+    _frame_ready = true;
+}
+
+void UploadRing::wait_for_frame()
+{
+    _frame_ready = true;
+
+    GLsync& fence = _fences[_frame];
+    if (!fence)
+    {
+        return;
+    }
+
+    Device& device = Device::get();
+    if (!device.wait_sync(fence, 0))
+    {
+        SCOPED_EVENT("UploadRing - stall");
+        _stats.stalls++;
+
+        while (!device.wait_sync(fence, wait_timeout_ns)) { }
+    }
+
+    device.delete_sync(fence);
+    fence = nullptr;
+}
+
+void UploadRing::release_buffer(Buffer& buffer)
+{
+    if (buffer.buffer)
+    {
+        // Deleting a buffer also unmaps it
+        Device::get().delete_buffer(buffer.buffer);
+        buffer = Buffer();
+    }
+}
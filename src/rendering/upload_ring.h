@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <utils/singleton.h>
+
+#include "device.h"
+
+namespace rendering
+{
+    // A range of a buffer holding uploaded data
+    struct BufferRange
+    {
+        GLuint buffer = 0;
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    struct UploadRingStats
+    {
+        int64_t bytes_uploaded = 0;
+        int32_t uploads = 0;
+        int32_t reallocations = 0;
+        int32_t stalls = 0;
+        size_t capacity = 0;
+    };
+
+    // Streams data that is rewritten every frame to the GPU through one persistently mapped buffer
+    // The buffer is split into a region per frame in flight, each frame writes to its own region while the
+    // GPU may still be reading the others, and a fence placed at the end of the frame guards the region
+    // until the GPU is done with it. Uploads are plain copies into the mapping, so steady state uploads
+    // never allocate or stall. If a frame needs more space than its region has the buffer is grown
+    // geometrically, and if persistent mapping isn't supported each upload becomes a buffer_sub_data instead
+    class UploadRing : public utils::Singleton<UploadRing>
+    {
+        using Singleton::Singleton;
+
+    public:
+        ~UploadRing();
+
+        // Copies data into the current frame's region, the range is valid until the end of the frame
+        [[nodiscard]] BufferRange upload(const void* data, size_t size);
+
+        // Reserves size bytes in the current frame's region and has write fill them in place, which saves the copy
+        // upload makes for data that is only built to be uploaded
+        // write is called once with the destination and must fill all size bytes without using the ring
+        template <typename F>
+        [[nodiscard]] BufferRange upload_in_place(size_t size, F&& write);
+
+        // Fences the current frame's region and moves on to the next, must be called after the frame's draws
+        // have been submitted, returns the stats of the frame that ended
+        UploadRingStats end_frame();
+
+    private:
+        static constexpr size_t frames_in_flight = 3;
+        static constexpr size_t min_frame_capacity = 64 * 1024;
+
+        struct Buffer
+        {
+            GLuint buffer = 0;
+            uint8_t* mapping = nullptr;
+        };
+
+        // Takes size bytes from the current frame's region
+        [[nodiscard]] BufferRange allocate(size_t size);
+
+        // Makes sure the current frame's region has space for an allocation of size bytes
+        void reserve(size_t size);
+
+        // Replaces the buffer with one whose regions can each hold at least min_capacity bytes
+        void grow(size_t min_capacity);
+
+        // Waits for the GPU to finish reading the current frame's region
+        void wait_for_frame();
+
+        void release_buffer(Buffer& buffer);
+
+        Buffer _buffer;
+        size_t _frame_capacity = 0;
+        size_t _alignment = 0;
+
+        size_t _frame = 0;
+        size_t _head = 0;
+        bool _frame_ready = false;
+        std::array<GLsync, frames_in_flight> _fences = { };
+
+        // Buffers replaced by a larger one, kept alive until the end of the frame since ranges still refer to them
+        std::vector<Buffer> _retired_buffers;
+
+        // In place uploads are written here first when the buffer can't be mapped
+        std::vector<uint8_t> _staging;
+
+        UploadRingStats _stats;
+    };
+
+    template <typename F>
+    BufferRange UploadRing::upload_in_place(size_t size, F&& write)
+    {
+        const BufferRange range = allocate(size);
+        if (_buffer.mapping)
+        {
+            write(_buffer.mapping + range.offset);
+        }
+        else if (size > 0)
+        {
+            _staging.resize(size);
+            write(_staging.data());
+
+            Device::get().buffer_sub_data(GL_SHADER_STORAGE_BUFFER, range.buffer, range.offset, size, _staging.data());
+        }
+
+        return range;
+    }
+}
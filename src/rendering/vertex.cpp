@@ -1,5 +1,9 @@
 #include "vertex.h"
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
 using namespace rendering;
 using namespace math;
 
@@ -25,3 +29,86 @@ Vertex Vertex::subdivide(const Vertex& a, const Vertex& b)
         (a.color + b.color) / 2
     );
 }
+
+namespace
+{
+    // Converts to an IEEE 754 half float, rounding to nearest even
+    // Values too large for a half become infinity and values too small become signed zero
+    [[nodiscard]] uint16_t float_to_half(float value) noexcept
+    {
+        const uint32_t bits = std::bit_cast<uint32_t>(value);
+        const uint32_t sign = (bits >> 16) & 0x8000;
+        const uint32_t abs_bits = bits & 0x7FFFFFFF;
+
+        // NaN stays NaN, infinity and anything too large for a half become infinity
+        if (abs_bits >= 0x7F800000)
+        {
+            return static_cast<uint16_t>(sign | 0x7C00 | (abs_bits > 0x7F800000 ? 0x200 : 0));
+        }
+
+        if (abs_bits >= 0x477FF000)
+        {
+            return static_cast<uint16_t>(sign | 0x7C00);
+        }
+
+        // Subnormal halves, shift the mantissa with its implicit bit into place
+        if (abs_bits < 0x38800000)
+        {
+            if (abs_bits < 0x33000000)
+            {
+                return static_cast<uint16_t>(sign);
+            }
+
+            const uint32_t exponent = abs_bits >> 23;
+            const uint32_t mantissa = (abs_bits & 0x7FFFFF) | 0x800000;
+            const uint32_t shift = 126 - exponent;
+
+            uint32_t half = mantissa >> shift;
+            const uint32_t remainder = mantissa & ((1u << shift) - 1);
+            const uint32_t halfway = 1u << (shift - 1);
+
+            if (remainder > halfway || (remainder == halfway && (half & 1)))
+            {
+                half++;
+            }
+
+            return static_cast<uint16_t>(sign | half);
+        }
+
+        // Normal halves, rebias the exponent and round the mantissa, letting any carry spill into the exponent
+        uint32_t half = (abs_bits - 0x38000000) >> 13;
+        const uint32_t remainder = abs_bits & 0x1FFF;
+
+        if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        {
+            half++;
+        }
+
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    [[nodiscard]] uint32_t pack_snorm10(float value) noexcept
+    {
+        const float clamped = std::clamp(value, -1.0f, 1.0f);
+        const int32_t quantized = static_cast<int32_t>(std::round(clamped * 511.0f));
+
+        return static_cast<uint32_t>(quantized) & 0x3FF;
+    }
+
+    [[nodiscard]] uint8_t pack_unorm8(float value) noexcept
+    {
+        const float clamped = std::clamp(value, 0.0f, 1.0f);
+        return static_cast<uint8_t>(std::round(clamped * 255.0f));
+    }
+}
+
+CompactVertex::CompactVertex(const Vertex& vertex)
+    : position(vertex.position)
+    , normal(
+        pack_snorm10(vertex.normal.x)
+        | (pack_snorm10(vertex.normal.y) << 10)
+        | (pack_snorm10(vertex.normal.z) << 20)
+    )
+    , tex_coord(float_to_half(vertex.tex_coord.x), float_to_half(vertex.tex_coord.y))
+    , color(pack_unorm8(vertex.color.x), pack_unorm8(vertex.color.y), pack_unorm8(vertex.color.z), 255)
+{ }
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <math/vector2.h>
 #include <math/vector3.h>
+#include <math/vector4.h>
 
 namespace rendering
 {
@@ -16,4 +18,20 @@ namespace rendering
 
         [[nodiscard]] static Vertex subdivide(const Vertex& a, const Vertex& b);
     };
+
+    // Quantized version of Vertex taking 24 bytes instead of 44
+    // Normals are packed as signed normalized 10:10:10:2 integers, texture coordinates as half floats and colors
+    // as normalized bytes. These are all expanded back to floats when the GPU fetches them, so shaders read
+    // compact vertices exactly the same way as full ones
+    struct CompactVertex
+    {
+        math::Vector3f position;
+        uint32_t normal;
+        math::Vector2<uint16_t> tex_coord;
+        math::Vector4u8 color;
+
+        explicit CompactVertex(const Vertex& vertex);
+    };
+
+    static_assert(sizeof(CompactVertex) == 24);
 }
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <libs/nlohmann/json.hpp>
+
+namespace rendering
+{
+    // Controls the layout a mesh's vertices are stored in on the GPU
+    enum class VertexFormat
+    {
+        // Every attribute is stored as full precision floats, see Vertex
+        full,
+
+        // Attributes other than the position are quantized, see CompactVertex
+        compact
+    };
+
+    NLOHMANN_JSON_SERIALIZE_ENUM(VertexFormat, {
+        { VertexFormat::full, "full" },
+        { VertexFormat::compact, "compact" }
+    });
+}
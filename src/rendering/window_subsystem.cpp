@@ -141,7 +141,7 @@ void WindowSubsystem::start()
 	glfwGetFramebufferSize(_window, &_resolution.x, &_resolution.y);
 	glfwMakeContextCurrent(_window);
 
-	Logger::log("OpenGL context created - %s", glGetString(GL_VERSION));
+	Logger::log("OpenGL context created - %s", reinterpret_cast<const char*>(glGetString(GL_VERSION)));
 	Logger::log("GPU selected - %s (%s)",
 		strtools::trim(reinterpret_cast<const char*>(glGetString(GL_RENDERER))).c_str(),
 		strtools::trim(reinterpret_cast<const char*>(glGetString(GL_VENDOR))).c_str()
@@ -3,12 +3,60 @@
 #include <fstream>
 
 #include <core/archive.h>
+#include <core/asset_loader.h>
+#include <core/asset_registry.h>
 #include <core/entity_factory.h>
 #include <core/logger.h>
 #include <profiling/scoped_event.h>
+#include <utils/cache_file.h>
+#include <utils/utils.h>
 
 using namespace scene;
 
+AsyncSceneLoad::AsyncSceneLoad(const std::string& path)
+    : _path(path)
+    , _status(LoadStatus::queued)
+    , _cancel_requested(false)
+    , _preload_progress(0)
+    , _num_entities(0)
+    , _num_entities_loaded(0)
+{ }
+
+void AsyncSceneLoad::cancel() noexcept
+{
+    _cancel_requested = true;
+}
+
+const std::string& AsyncSceneLoad::path() const noexcept
+{
+    return _path;
+}
+
+LoadStatus AsyncSceneLoad::status() const noexcept
+{
+    return _status;
+}
+
+bool AsyncSceneLoad::done() const noexcept
+{
+    return AssetLoader::done(_status);
+}
+
+float AsyncSceneLoad::progress() const noexcept
+{
+    if (done())
+    {
+        return 1;
+    }
+
+    const int32_t num_entities = _num_entities;
+    const float entities_progress = num_entities > 0
+        ? static_cast<float>(_num_entities_loaded) / static_cast<float>(num_entities)
+        : 0;
+
+    return (_preload_progress + entities_progress) / 2;
+}
+
 void SceneLoader::load_from_file(const std::string& path)
 {
     SCOPED_EVENT("SceneLoader - load from file");
@@ -33,7 +81,22 @@ void SceneLoader::load_from_file(const std::string& path)
         return;
     }
 
-    load_from_json(world_def);
+    AssetRegistry& registry = AssetRegistry::get();
+
+    const AssetRegistry::RecordingId recording = registry.begin_recording();
+    std::vector<AssetManifestEntry> manifest;
+
+    {
+        const auto end_recording = utils::finally([&]
+        {
+            manifest = registry.end_recording(recording);
+        });
+
+        load_from_json(world_def);
+    }
+
+    AssetRegistry::save_manifest(manifest_path(path), manifest);
+
     Logger::success("Loaded scene '%s'", path.c_str());
 }
 
@@ -55,11 +118,7 @@ void SceneLoader::load_entities(const nlohmann::json& world_def)
 
         for (const auto& entity_def : *it)
         {
-            Archive archive;
-            archive.json_def = entity_def;
-            archive.name = archive.read_or<std::string>("name");
-
-            EntityFactory::get().load_entity(archive);
+            load_entity(entity_def);
         }
     }
     else
@@ -67,3 +126,200 @@ void SceneLoader::load_entities(const nlohmann::json& world_def)
         Logger::warning("Loading scene with no entities");
     }
 }
+
+peng::shared_ref<AsyncSceneLoad> SceneLoader::load_from_file_async(const std::string& path)
+{
+    Logger::log("Loading scene '%s' asynchronously", path.c_str());
+
+    peng::shared_ref<AsyncSceneLoad> load = peng::make_shared<AsyncSceneLoad>(path);
+    AssetLoader::get().schedule_decode(threading::Job([load]
+    {
+        decode_async(load);
+    }));
+
+    return load;
+}
+
+std::string SceneLoader::manifest_path(const std::string& path)
+{
+    return io::cache_path(path, ".manifest.json");
+}
+
+void SceneLoader::load_entity(const nlohmann::json& entity_def)
+{
+    Archive archive;
+    archive.json_def = entity_def;
+    archive.name = archive.read_or<std::string>("name");
+
+    EntityFactory::get().load_entity(archive);
+}
+
+void SceneLoader::decode_async(const peng::shared_ref<AsyncSceneLoad>& load)
+{
+    SCOPED_EVENT("SceneLoader - decode", load->path().c_str());
+
+    if (load->_cancel_requested)
+    {
+        load->_status = LoadStatus::cancelled;
+        return;
+    }
+
+    load->_status = LoadStatus::decoding;
+
+    std::ifstream file(load->path());
+    if (!file.is_open())
+    {
+        Logger::error("Could not open file %s", load->path().c_str());
+        load->_status = LoadStatus::failed;
+        return;
+    }
+
+    std::shared_ptr<nlohmann::json> world_def = std::make_shared<nlohmann::json>();
+
+    try
+    {
+        *world_def = nlohmann::json::parse(file);
+    }
+    catch (const nlohmann::json::parse_error& e)
+    {
+        Logger::error("Error occurred while parsing JSON - terminating scene loading");
+        Logger::error(e.what());
+        load->_status = LoadStatus::failed;
+        return;
+    }
+
+    // Scenes which haven't been loaded before have no manifest, and simply skip straight to their entities
+    std::vector<AssetManifestEntry> manifest = AssetRegistry::load_manifest(manifest_path(load->path()))
+        .value_or(std::vector<AssetManifestEntry>());
+
+    load->_status = LoadStatus::finalizing;
+
+    AssetLoader::get().schedule_finalize(threading::Job([load, world_def, manifest = std::move(manifest)]
+    {
+        if (load->_cancel_requested)
+        {
+            finish_async(load, LoadStatus::cancelled);
+            return;
+        }
+
+        load->_preload = std::make_unique<AssetBatch>(AssetRegistry::get().preload(manifest));
+        preload_async(load, world_def);
+    }));
+}
+
+void SceneLoader::preload_async(
+    const peng::shared_ref<AsyncSceneLoad>& load,
+    const std::shared_ptr<const nlohmann::json>& world_def
+)
+{
+    if (load->_cancel_requested)
+    {
+        load->_preload->cancel();
+        finish_async(load, LoadStatus::cancelled);
+        return;
+    }
+
+    load->_preload_progress = load->_preload->progress();
+
+    // Polled once per frame until every preloaded asset is done
+    if (!load->_preload->done())
+    {
+        AssetLoader::get().schedule_finalize(threading::Job([load, world_def]
+        {
+            preload_async(load, world_def);
+        }));
+
+        return;
+    }
+
+    start_entities_async(load, world_def);
+}
+
+void SceneLoader::start_entities_async(
+    const peng::shared_ref<AsyncSceneLoad>& load,
+    const std::shared_ptr<const nlohmann::json>& world_def
+)
+{
+    load->_preload_progress = 1;
+    load->_recording = AssetRegistry::get().begin_recording();
+
+    const auto it = world_def->find("entities");
+    if (it == world_def->end() || !it->is_array() || it->empty())
+    {
+        // Loaded the same way as a synchronous load so that problems are reported the same way
+        SceneLoader().load_entities(*world_def);
+        finish_async(load, LoadStatus::loaded);
+
+        return;
+    }
+
+    // Each entity is finalized separately so that creating a large scene is spread across frames
+    load->_num_entities = static_cast<int32_t>(it->size());
+
+    for (size_t index = 0; index < it->size(); index++)
+    {
+        AssetLoader::get().schedule_finalize(threading::Job([load, world_def, index]
+        {
+            finalize_entity_async(load, world_def, index);
+        }));
+    }
+}
+
+void SceneLoader::finish_async(const peng::shared_ref<AsyncSceneLoad>& load, LoadStatus status)
+{
+    // A cancelled load only touched part of the scene, so its recording isn't saved as the manifest
+    if (load->_recording)
+    {
+        std::vector<AssetManifestEntry> manifest = AssetRegistry::get().end_recording(*load->_recording);
+        if (status == LoadStatus::loaded)
+        {
+            AssetRegistry::save_manifest(manifest_path(load->path()), manifest);
+        }
+
+        load->_recording.reset();
+    }
+
+    load->_preload.reset();
+    load->_status = status;
+
+    if (status == LoadStatus::loaded)
+    {
+        Logger::success("Loaded scene '%s'", load->path().c_str());
+    }
+    else if (status == LoadStatus::cancelled)
+    {
+        Logger::warning("Cancelled loading scene '%s'", load->path().c_str());
+    }
+}
+
+void SceneLoader::finalize_entity_async(
+    const peng::shared_ref<AsyncSceneLoad>& load,
+    const std::shared_ptr<const nlohmann::json>& world_def,
+    size_t index
+)
+{
+    if (load->done())
+    {
+        return;
+    }
+
+    if (load->_cancel_requested)
+    {
+        finish_async(load, LoadStatus::cancelled);
+        return;
+    }
+
+    try
+    {
+        load_entity(world_def->at("entities").at(index));
+    }
+    catch (const std::exception& e)
+    {
+        Logger::error("Failed to load entity %zu of scene '%s': %s", index, load->path().c_str(), e.what());
+    }
+
+    if (++load->_num_entities_loaded == load->_num_entities)
+    {
+        finish_async(load, LoadStatus::loaded);
+    }
+}
@@ -1,16 +1,84 @@
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include <core/asset_loader.h>
+#include <core/asset_registry.h>
 #include <libs/nlohmann/json.hpp>
+#include <memory/shared_ref.h>
 
 namespace scene
 {
+    class SceneLoader;
+
+    // Progress of a scene being loaded by SceneLoader::load_from_file_async
+    class AsyncSceneLoad
+    {
+    public:
+        explicit AsyncSceneLoad(const std::string& path);
+
+        // Stops preloading and creating the scene's entities, any which were already created are kept
+        void cancel() noexcept;
+
+        [[nodiscard]] const std::string& path() const noexcept;
+        [[nodiscard]] LoadStatus status() const noexcept;
+        [[nodiscard]] bool done() const noexcept;
+
+        // The first half covers preloading the scene's manifest, the second half creating its entities
+        [[nodiscard]] float progress() const noexcept;
+
+    private:
+        friend SceneLoader;
+
+        const std::string _path;
+        std::atomic<LoadStatus> _status;
+        std::atomic<bool> _cancel_requested;
+        std::atomic<float> _preload_progress;
+        std::atomic<int32_t> _num_entities;
+        std::atomic<int32_t> _num_entities_loaded;
+
+        // Only used on the main thread, the preload is kept until the entities are created so that the assets it
+        // loaded stay alive until the entities take hold of them
+        std::unique_ptr<AssetBatch> _preload;
+        std::optional<AssetRegistry::RecordingId> _recording;
+    };
+
+    // Loading a scene from a file records every asset it uses to a manifest, which later asynchronous loads of the
+    // scene preload in parallel before creating any entities
     class SceneLoader
     {
     public:
         void load_from_file(const std::string& path);
         void load_from_json(const nlohmann::json& world_def);
 
+        // Reads and parses the scene on the AssetLoader's background threads, preloads the assets in its manifest if
+        // it has one, then creates its entities on the main thread a few at a time within the AssetLoader's per-frame
+        // budget
+        [[nodiscard]] static peng::shared_ref<AsyncSceneLoad> load_from_file_async(const std::string& path);
+
+        [[nodiscard]] static std::string manifest_path(const std::string& path);
+
     private:
         void load_entities(const nlohmann::json& world_def);
+
+        static void load_entity(const nlohmann::json& entity_def);
+        static void decode_async(const peng::shared_ref<AsyncSceneLoad>& load);
+        static void preload_async(
+            const peng::shared_ref<AsyncSceneLoad>& load,
+            const std::shared_ptr<const nlohmann::json>& world_def
+        );
+        static void start_entities_async(
+            const peng::shared_ref<AsyncSceneLoad>& load,
+            const std::shared_ptr<const nlohmann::json>& world_def
+        );
+        static void finish_async(const peng::shared_ref<AsyncSceneLoad>& load, LoadStatus status);
+        static void finalize_entity_async(
+            const peng::shared_ref<AsyncSceneLoad>& load,
+            const std::shared_ptr<const nlohmann::json>& world_def,
+            size_t index
+        );
     };
 }
@@ -0,0 +1,121 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <math/vector2.h>
+#include <math/vector3.h>
+#include <rendering/mesh_decoder.h>
+#include <rendering/raw_mesh_data.h>
+
+using namespace rendering;
+using namespace math;
+
+namespace fs = std::filesystem;
+
+// Decodes checked in OBJ fixtures and compares the result against the expected vertices and triangles
+// Usage: peng_mesh_decoder_test
+// Must be run from the repository root so that the fixtures can be found
+
+namespace
+{
+    constexpr const char* mixed_faces_path = "src/tests/fixtures/mixed_faces.obj";
+
+    int32_t num_failures = 0;
+
+    void expect(bool condition, const char* description)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "Failed: %s\n", description);
+            num_failures++;
+        }
+    }
+
+    [[nodiscard]] Vector3f triangle_position(const RawMeshData& raw_data, size_t triangle, size_t corner)
+    {
+        const Vector3u& indices = raw_data.triangles[triangle];
+        const uint32_t vertex = corner == 0 ? indices.x : corner == 1 ? indices.y : indices.z;
+
+        return raw_data.vertices[vertex].position;
+    }
+
+    [[nodiscard]] Vector2f triangle_tex_coord(const RawMeshData& raw_data, size_t triangle, size_t corner)
+    {
+        const Vector3u& indices = raw_data.triangles[triangle];
+        const uint32_t vertex = corner == 0 ? indices.x : corner == 1 ? indices.y : indices.z;
+
+        return raw_data.vertices[vertex].tex_coord;
+    }
+
+    void test_mixed_faces()
+    {
+        const RawMeshData raw_data = MeshDecoder::load_obj(mixed_faces_path);
+        expect(!raw_data.corrupt, "mixed faces decode");
+        if (raw_data.corrupt)
+        {
+            return;
+        }
+
+        // Each quad is a fan of 2 triangles, and vertices are only shared when all of their indices match
+        expect(raw_data.triangles.size() == 5, "mixed faces have 5 triangles");
+        expect(raw_data.vertices.size() == 11, "mixed faces have 11 vertices");
+        if (raw_data.triangles.size() != 5 || raw_data.vertices.size() != 11)
+        {
+            return;
+        }
+
+        expect(triangle_position(raw_data, 0, 0) == Vector3f(0, 0, 0), "v//vn quad starts at its first vertex");
+        expect(triangle_position(raw_data, 1, 2) == Vector3f(0, 1, 0), "v//vn quad ends at its last vertex");
+
+        expect(triangle_position(raw_data, 2, 0) == Vector3f(1, 0, 0), "negative position index -5");
+        expect(triangle_position(raw_data, 2, 1) == Vector3f(2, 0, 0), "negative position index -2");
+        expect(triangle_position(raw_data, 3, 2) == Vector3f(1, 1, 0), "negative position index -4");
+        expect(triangle_tex_coord(raw_data, 2, 0) == Vector2f(0, 0), "negative tex coord index -4");
+        expect(triangle_tex_coord(raw_data, 3, 2) == Vector2f(0, 1), "negative tex coord index -1");
+
+        expect(triangle_position(raw_data, 4, 2) == Vector3f(2, 1, 0), "position only triangle");
+
+        bool normals_facing = true;
+        for (const Vertex& vertex : raw_data.vertices)
+        {
+            normals_facing &= vertex.normal == Vector3f(0, 0, 1);
+        }
+
+        expect(normals_facing, "given and generated normals face +z");
+    }
+
+    void test_empty_file()
+    {
+        const std::string path = (fs::temp_directory_path() / "peng_empty.obj").string();
+        std::ofstream(path, std::ios::trunc).close();
+
+        const RawMeshData raw_data = MeshDecoder::load_obj(path);
+        expect(!raw_data.corrupt, "empty file decodes");
+        expect(raw_data.vertices.empty() && raw_data.triangles.empty(), "empty file has no vertices or triangles");
+
+        fs::remove(path);
+    }
+
+    void test_missing_file()
+    {
+        const RawMeshData raw_data = MeshDecoder::load_obj("src/tests/fixtures/missing.obj");
+        expect(raw_data.corrupt, "missing file is corrupt");
+    }
+}
+
+int main()
+{
+    test_mixed_faces();
+    test_empty_file();
+    test_missing_file();
+
+    if (num_failures > 0)
+    {
+        std::fprintf(stderr, "%d mesh decoder checks failed\n", num_failures);
+        return 1;
+    }
+
+    std::printf("All mesh decoder checks passed\n");
+    return 0;
+}
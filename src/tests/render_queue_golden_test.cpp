@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <math/matrix4x4.h>
+#include <math/vector3.h>
+#include <math/vector4.h>
+#include <rendering/device.h>
+#include <rendering/recording_device.h>
+#include <rendering/render_queue.h>
+#include <rendering/shader.h>
+#include <rendering/material.h>
+#include <rendering/mesh.h>
+#include <rendering/raw_mesh_data.h>
+
+using namespace rendering;
+using namespace math;
+
+// Renders a fixed frame through the render queue on a RecordingDevice and compares the recorded commands
+// against a checked in golden stream, so that any change to what the renderer submits is caught
+// Usage: peng_render_queue_test [--update], where --update rewrites the golden stream with the recorded one
+// Must be run from the repository root so that resources can be found
+
+namespace
+{
+    constexpr const char* golden_path = "src/tests/golden/render_queue_frame.txt";
+
+    [[nodiscard]] peng::shared_ref<const Mesh> make_triangle(const std::string& name)
+    {
+        RawMeshData raw_data;
+        raw_data.vertices = {
+            Vertex(Vector3f(-0.5f, -0.5f, 0), Vector3f(0, 0, 1), Vector2f(0, 0)),
+            Vertex(Vector3f(0.5f, -0.5f, 0), Vector3f(0, 0, 1), Vector2f(1, 0)),
+            Vertex(Vector3f(0, 0.5f, 0), Vector3f(0, 0, 1), Vector2f(0.5f, 1)),
+        };
+        raw_data.triangles = { Vector3u(0, 1, 2) };
+
+        return peng::make_shared<const Mesh>(name, std::move(raw_data));
+    }
+
+    [[nodiscard]] DrawCall make_draw(
+        const peng::shared_ref<const Mesh>& mesh,
+        const peng::shared_ref<Material>& material,
+        float order,
+        const physics::BoundingSphere& bounds = physics::BoundingSphere::infinite()
+    )
+    {
+        return DrawCall{
+            .mesh = mesh,
+            .material = material,
+            .order = order,
+            .instance_count = 1,
+            .bounds = bounds
+        };
+    }
+
+    [[nodiscard]] std::vector<std::string> split_lines(const std::string& text)
+    {
+        std::vector<std::string> lines;
+        std::istringstream stream(text);
+        for (std::string line; std::getline(stream, line);)
+        {
+            lines.push_back(line);
+        }
+
+        return lines;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const bool update = argc > 1 && std::strcmp(argv[1], "--update") == 0;
+
+    // The device has to be installed before any GPU resources are created
+    auto device = std::make_unique<RecordingDevice>();
+    RecordingDevice& recording_device = *device;
+    Device::set(std::move(device));
+
+    const peng::shared_ref<Shader> unlit_shader = peng::make_shared<Shader>(
+        "Test Unlit",
+        "resources/shaders/core/projection.vert",
+        "resources/shaders/core/unlit.frag"
+    );
+
+    const peng::shared_ref<Shader> phong_shader = peng::make_shared<Shader>(
+        "Test Phong",
+        "resources/shaders/core/projection.vert",
+        "resources/shaders/core/phong.frag"
+    );
+
+    const peng::shared_ref<Shader> alpha_shader = peng::make_shared<Shader>(
+        "Test Unlit(Alpha)",
+        "resources/shaders/core/projection.vert",
+        "resources/shaders/core/unlit.frag"
+    );
+    alpha_shader->blend_mode() = BlendMode::alpha_blend;
+    alpha_shader->draw_order() = 2;
+
+    const peng::shared_ref<const Mesh> mesh_a = make_triangle("Test Mesh A");
+    const peng::shared_ref<const Mesh> mesh_b = make_triangle("Test Mesh B");
+
+    std::vector<peng::shared_ref<Material>> materials;
+    for (const peng::shared_ref<Shader>& shader : { unlit_shader, phong_shader, alpha_shader })
+    {
+        for (int32_t i = 0; i < 2; i++)
+        {
+            peng::shared_ref<Material> material = peng::make_shared<Material>(shader);
+            material->set_parameter("base_color", Vector4f(1, 0.5f * static_cast<float>(i), 0, 1));
+            material->set_parameter("model_matrix", Matrix4x4f::from_translation(Vector3f(static_cast<float>(i), 0, 0)));
+            materials.push_back(std::move(material));
+        }
+    }
+
+    RenderQueue& render_queue = RenderQueue::get();
+
+    // Only the frame itself should be recorded, not the resources created above
+    recording_device.reset();
+
+    render_queue.enqueue_command(CameraRenderData{
+        .view_matrix = Matrix4x4f::identity(),
+        .view_pos = Vector3f::zero(),
+        .view_dir = Vector3f::forwards(),
+        .near_clip = 0.01f,
+        .far_clip = 1000.0f
+    });
+
+    render_queue.enqueue_command(DirectionalLightRenderData{
+        .dir = Vector3f(0, -1, 0),
+        .intensity = 1,
+        .color = Vector3f::one(),
+        .padding0 = 0,
+        .ambient = Vector3f(0.1f, 0.1f, 0.1f),
+        .padding1 = 0
+    });
+
+    render_queue.enqueue_command(PointLightRenderData{
+        .pos = Vector3f(0, 0, 0.5f),
+        .range = 5,
+        .color = Vector3f(1, 0, 0),
+        .max_strength = 1,
+        .ambient = Vector3f::zero(),
+        .padding = 0
+    });
+
+    // Submitted out of order, with a draw outside of the view that should be culled
+    render_queue.enqueue_command(make_draw(mesh_b, materials[4], -0.2f));
+    render_queue.enqueue_command(make_draw(mesh_a, materials[3], 0.5f));
+    render_queue.enqueue_command(make_draw(mesh_b, materials[0], 0.3f));
+    render_queue.enqueue_command(make_draw(mesh_a, materials[5], -0.6f));
+    render_queue.enqueue_command(make_draw(mesh_a, materials[1], 0.1f));
+    render_queue.enqueue_command(make_draw(mesh_b, materials[2], 0.2f));
+    render_queue.enqueue_command(make_draw(mesh_a, materials[0], 0.4f, physics::BoundingSphere(Vector3f(100, 0, 0), 1)));
+
+    render_queue.execute();
+
+    std::ostringstream recorded_stream;
+    recording_device.write_commands(recorded_stream);
+    const std::string recorded = recorded_stream.str();
+
+    if (update)
+    {
+        std::ofstream golden_file(golden_path, std::ios::binary);
+        if (!golden_file)
+        {
+            std::fprintf(stderr, "Could not write golden stream '%s'\n", golden_path);
+            return 1;
+        }
+
+        golden_file << recorded;
+        std::printf("Updated golden stream '%s' with %zu commands\n", golden_path, recording_device.commands().size());
+        return 0;
+    }
+
+    std::ifstream golden_file(golden_path, std::ios::binary);
+    if (!golden_file)
+    {
+        std::fprintf(stderr, "Could not read golden stream '%s', run with --update to create it\n", golden_path);
+        return 1;
+    }
+
+    std::ostringstream golden_stream;
+    golden_stream << golden_file.rdbuf();
+
+    const std::vector<std::string> golden_lines = split_lines(golden_stream.str());
+    const std::vector<std::string> recorded_lines = split_lines(recorded);
+
+    const size_t num_lines = std::max(golden_lines.size(), recorded_lines.size());
+    for (size_t i = 0; i < num_lines; i++)
+    {
+        const std::string& expected = i < golden_lines.size() ? golden_lines[i] : "<end of stream>";
+        const std::string& actual = i < recorded_lines.size() ? recorded_lines[i] : "<end of stream>";
+
+        if (expected != actual)
+        {
+            std::fprintf(stderr, "Command %zu differs from the golden stream\n  expected: %s\n  recorded: %s\n",
+                i, expected.c_str(), actual.c_str());
+            return 1;
+        }
+    }
+
+    std::printf("Recorded %zu commands matching the golden stream\n", recorded_lines.size());
+    return 0;
+}
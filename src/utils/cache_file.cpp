@@ -0,0 +1,82 @@
+#include "cache_file.h"
+
+#include <filesystem>
+#include <functional>
+#include <thread>
+
+#include "io.h"
+#include "strtools.h"
+
+namespace io
+{
+    namespace fs = std::filesystem;
+
+    std::string cache_path(const std::string& source_path, const std::string& extension)
+    {
+        fs::path path = fs::path(cache_directory) / fs::path(source_path).relative_path();
+        path.replace_extension(extension);
+
+        return path.string();
+    }
+
+    bool cache_headers_in_range(size_t file_header_size, uint64_t num_headers, size_t header_size, size_t file_size) noexcept
+    {
+        return file_header_size <= file_size
+            && num_headers <= (file_size - file_header_size) / header_size;
+    }
+
+    bool cache_block_in_range(uint64_t offset, uint64_t count, size_t element_size, size_t file_size) noexcept
+    {
+        return offset % cache_block_alignment == 0
+            && offset <= file_size
+            && count <= (file_size - offset) / element_size;
+    }
+
+    CacheFileWriter::CacheFileWriter(const std::string& path)
+        : _path(path)
+        , _temp_path(strtools::catf("%s.%zu.tmp", path.c_str(), std::hash<std::thread::id>{}(std::this_thread::get_id())))
+        , _committed(false)
+    {
+        create_directories_for_file(_path);
+        _file.open(_temp_path, std::ios::binary | std::ios::trunc);
+    }
+
+    CacheFileWriter::~CacheFileWriter()
+    {
+        if (!_committed)
+        {
+            _file.close();
+
+            std::error_code error;
+            fs::remove(_temp_path, error);
+        }
+    }
+
+    bool CacheFileWriter::is_open() const noexcept
+    {
+        return _file.is_open();
+    }
+
+    void CacheFileWriter::write_at(size_t position, const void* data, size_t size)
+    {
+        static constexpr char padding[cache_block_alignment] = {};
+
+        // Blocks are aligned to cache_block_alignment, so gaps are never longer than the padding
+        _file.write(padding, static_cast<std::streamsize>(position - static_cast<size_t>(_file.tellp())));
+        _file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    }
+
+    bool CacheFileWriter::commit()
+    {
+        _file.close();
+        if (!_file)
+        {
+            return false;
+        }
+
+        fs::rename(_temp_path, _path);
+        _committed = true;
+
+        return true;
+    }
+}
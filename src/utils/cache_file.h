@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace io
+{
+    // Every cache file lives under this directory, at the relative path of the file it was built from
+    constexpr const char* cache_directory = "cache";
+
+    // Blocks within binary cache files are aligned to this so they can be read in place from a mapping
+    constexpr size_t cache_block_alignment = 16;
+
+    [[nodiscard]] constexpr size_t align_cache_offset(size_t offset) noexcept
+    {
+        return (offset + cache_block_alignment - 1) & ~(cache_block_alignment - 1);
+    }
+
+    // Gets the path of the cache file built from source_path, with its extension replaced by extension
+    [[nodiscard]] std::string cache_path(const std::string& source_path, const std::string& extension);
+
+    // Whether num_headers headers of header_size fit in a file of file_size after its file header
+    [[nodiscard]] bool cache_headers_in_range(
+        size_t file_header_size,
+        uint64_t num_headers,
+        size_t header_size,
+        size_t file_size
+    ) noexcept;
+
+    // Whether a block of count elements of element_size at offset is aligned and lies within a file of file_size
+    [[nodiscard]] bool cache_block_in_range(uint64_t offset, uint64_t count, size_t element_size, size_t file_size) noexcept;
+
+    // Writes a cache file block by block, padding the gaps between blocks with zeros
+    // Everything is written to a temporary file which only replaces the cache file once committed, so that a failed
+    // write never leaves a valid looking but broken cache file
+    // The temporary file is per thread as the same source can be imported by two asynchronous loads at once
+    class CacheFileWriter
+    {
+    public:
+        explicit CacheFileWriter(const std::string& path);
+
+        CacheFileWriter(const CacheFileWriter&) = delete;
+        CacheFileWriter(CacheFileWriter&&) = delete;
+        ~CacheFileWriter();
+
+        [[nodiscard]] bool is_open() const noexcept;
+
+        // Writes the data at position, which must not be behind the end of the data written so far
+        void write_at(size_t position, const void* data, size_t size);
+
+        // Replaces the cache file with everything written, returns false if any of the writes failed
+        [[nodiscard]] bool commit();
+
+    private:
+        std::string _path;
+        std::string _temp_path;
+        std::ofstream _file;
+        bool _committed;
+    };
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <tuple>
+
+#include "format_string.h"
+#include "traits.h"
+
+namespace strtools
+{
+    // Captures a format string and its arguments in binary form so that formatting
+    // can happen later, typically on a different thread to the one producing the message
+    // Strings are copied into the capture so arguments may safely point to temporaries, as are runtime formats
+    // Literal formats are kept as a pointer since they live for the whole program
+    // Capturing never allocates, instead failing if the arguments do not fit in the inline storage
+    template <size_t Capacity>
+    class DeferredFormat
+    {
+    public:
+        DeferredFormat() = default;
+
+        // Captures the arguments for later expansion, returns false if they did not fit
+        template <typename...Args>
+        [[nodiscard]] bool capture(format_string_for<Args...> format, const Args&...args) noexcept
+        {
+            static_assert(traits::for_none<std::is_class, std::decay_t<Args>...>(), "strtools::DeferredFormat does not work with classes");
+
+            _format = format.get();
+            _format_inline = false;
+            _expand = nullptr;
+            _size = 0;
+
+            if (format.runtime())
+            {
+                if (!write_arg<const char*>(format.get()))
+                {
+                    return false;
+                }
+
+                _format_inline = true;
+            }
+
+            _args_offset = _size;
+
+            const bool fits = (write_arg<stored_arg_t<Args>>(args) && ...);
+            if (fits)
+            {
+                _expand = &expand_impl<stored_arg_t<Args>...>;
+            }
+
+            return fits;
+        }
+
+        // Expands the captured format into out, replacing its contents
+        void expand(std::string& out) const
+        {
+            if (_expand)
+            {
+                const char* format = _format_inline ? reinterpret_cast<const char*>(_data.data()) : _format;
+                _expand(format, _data.data() + _args_offset, out);
+            }
+            else
+            {
+                out.clear();
+            }
+        }
+
+        [[nodiscard]] bool captured() const noexcept
+        {
+            return _expand != nullptr;
+        }
+
+    private:
+        using ExpandFunc = void(*)(const char* format, const std::byte* data, std::string& out);
+
+        template <typename T>
+        static constexpr bool is_string_arg = std::is_same_v<T, const char*>;
+
+        // Strings are stored inline and handed back as const char* on expansion
+        template <typename T>
+        using stored_arg_t = detail::format_arg_t<T>;
+
+        template <typename T>
+        bool write_arg(T arg) noexcept
+        {
+            if constexpr (is_string_arg<T>)
+            {
+                const char* str = arg ? arg : "(null)";
+                const size_t length = std::strlen(str) + 1;
+                if (_size + length > Capacity)
+                {
+                    return false;
+                }
+
+                std::memcpy(_data.data() + _size, str, length);
+                _size += length;
+            }
+            else
+            {
+                if (_size + sizeof(T) > Capacity)
+                {
+                    return false;
+                }
+
+                std::memcpy(_data.data() + _size, &arg, sizeof(T));
+                _size += sizeof(T);
+            }
+
+            return true;
+        }
+
+        template <typename T>
+        static T read_arg(const std::byte* data, size_t& offset) noexcept
+        {
+            if constexpr (is_string_arg<T>)
+            {
+                const char* str = reinterpret_cast<const char*>(data + offset);
+                offset += std::strlen(str) + 1;
+                return str;
+            }
+            else
+            {
+                T arg;
+                std::memcpy(&arg, data + offset, sizeof(T));
+                offset += sizeof(T);
+                return arg;
+            }
+        }
+
+        template <typename...Args>
+        static void expand_impl(const char* format, const std::byte* data, std::string& out)
+        {
+            // Braced initialization guarantees the arguments are read in order
+            size_t offset = 0;
+            const std::tuple<Args...> args { read_arg<Args>(data, offset)... };
+
+            std::apply([&](const Args&...unpacked)
+            {
+                out.resize(out.capacity());
+                int32_t msg_size = snprintf(out.data(), out.size() + 1, format, unpacked...);
+                if (msg_size > static_cast<int32_t>(out.size()))
+                {
+                    out.resize(msg_size);
+                    msg_size = snprintf(out.data(), out.size() + 1, format, unpacked...);
+                }
+
+                out.resize(std::max(msg_size, 0));
+            }, args);
+        }
+
+        const char* _format = nullptr;
+        bool _format_inline = false;
+        ExpandFunc _expand = nullptr;
+        size_t _size = 0;
+        size_t _args_offset = 0;
+        std::array<std::byte, Capacity> _data;
+    };
+}
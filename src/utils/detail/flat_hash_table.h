@@ -0,0 +1,444 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <utils/check.h>
+#include <utils/hash_helpers.h>
+
+namespace utils::detail
+{
+    // Open addressing hash table with linear probing, shared by flat_hash_map and flat_hash_set
+    // All values live in a single contiguous slot array, alongside a parallel array of control bytes
+    // which are either empty, deleted, or hold the low 7 bits of the hash of the value in that slot
+    // so most mismatches are rejected without touching the slot itself
+    template <typename Value, typename Key, typename KeyOf, typename Hash, typename KeyEqual>
+    class flat_hash_table
+    {
+    public:
+        using key_type = Key;
+        using value_type = Value;
+        using size_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using hasher = Hash;
+        using key_equal = KeyEqual;
+
+        template <bool Const>
+        class iterator_impl
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Value;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, const Value*, Value*>;
+            using reference = std::conditional_t<Const, const Value&, Value&>;
+
+            iterator_impl() noexcept = default;
+
+            iterator_impl(const int8_t* ctrl, pointer slot, const int8_t* ctrl_end) noexcept
+                : _ctrl(ctrl)
+                , _slot(slot)
+                , _ctrl_end(ctrl_end)
+            {
+                skip_empty();
+            }
+
+            template <bool OtherConst>
+            requires (Const && !OtherConst)
+            iterator_impl(const iterator_impl<OtherConst>& other) noexcept
+                : _ctrl(other._ctrl)
+                , _slot(other._slot)
+                , _ctrl_end(other._ctrl_end)
+            { }
+
+            [[nodiscard]] reference operator*() const noexcept { return *_slot; }
+            [[nodiscard]] pointer operator->() const noexcept { return _slot; }
+
+            iterator_impl& operator++() noexcept
+            {
+                ++_ctrl;
+                ++_slot;
+                skip_empty();
+
+                return *this;
+            }
+
+            iterator_impl operator++(int) noexcept
+            {
+                iterator_impl prev = *this;
+                ++*this;
+
+                return prev;
+            }
+
+            [[nodiscard]] bool operator==(const iterator_impl& other) const noexcept
+            {
+                return _ctrl == other._ctrl;
+            }
+
+        private:
+            friend class flat_hash_table;
+            friend class iterator_impl<!Const>;
+
+            void skip_empty() noexcept
+            {
+                while (_ctrl != _ctrl_end && *_ctrl < 0)
+                {
+                    ++_ctrl;
+                    ++_slot;
+                }
+            }
+
+            const int8_t* _ctrl = nullptr;
+            pointer _slot = nullptr;
+            const int8_t* _ctrl_end = nullptr;
+        };
+
+        using iterator = iterator_impl<false>;
+        using const_iterator = iterator_impl<true>;
+
+        flat_hash_table() noexcept = default;
+
+        flat_hash_table(const flat_hash_table& other)
+        {
+            reserve(other._size);
+            for (const Value& value : other)
+            {
+                emplace_unique(KeyOf{}(value), value);
+            }
+        }
+
+        flat_hash_table(flat_hash_table&& other) noexcept
+            : _ctrl(std::exchange(other._ctrl, nullptr))
+            , _slots(std::exchange(other._slots, nullptr))
+            , _capacity(std::exchange(other._capacity, 0))
+            , _size(std::exchange(other._size, 0))
+            , _growth_left(std::exchange(other._growth_left, 0))
+        { }
+
+        ~flat_hash_table()
+        {
+            destroy_all();
+            deallocate(_ctrl, _slots);
+        }
+
+        flat_hash_table& operator=(const flat_hash_table& other)
+        {
+            if (this != &other)
+            {
+                clear();
+                reserve(other._size);
+                for (const Value& value : other)
+                {
+                    emplace_unique(KeyOf{}(value), value);
+                }
+            }
+
+            return *this;
+        }
+
+        flat_hash_table& operator=(flat_hash_table&& other) noexcept
+        {
+            if (this != &other)
+            {
+                destroy_all();
+                deallocate(_ctrl, _slots);
+
+                _ctrl = std::exchange(other._ctrl, nullptr);
+                _slots = std::exchange(other._slots, nullptr);
+                _capacity = std::exchange(other._capacity, 0);
+                _size = std::exchange(other._size, 0);
+                _growth_left = std::exchange(other._growth_left, 0);
+            }
+
+            return *this;
+        }
+
+        [[nodiscard]] iterator begin() noexcept { return iterator(_ctrl, _slots, _ctrl + _capacity); }
+        [[nodiscard]] iterator end() noexcept { return iterator(_ctrl + _capacity, _slots + _capacity, _ctrl + _capacity); }
+        [[nodiscard]] const_iterator begin() const noexcept { return const_iterator(_ctrl, _slots, _ctrl + _capacity); }
+        [[nodiscard]] const_iterator end() const noexcept { return const_iterator(_ctrl + _capacity, _slots + _capacity, _ctrl + _capacity); }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+        [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+        [[nodiscard]] size_t size() const noexcept { return _size; }
+        [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+        [[nodiscard]] size_t capacity() const noexcept { return _capacity; }
+
+        // Ensures that count elements can be held without rehashing
+        void reserve(size_t count)
+        {
+            size_t new_capacity = min_capacity;
+            while (max_load(new_capacity) < count)
+            {
+                new_capacity *= 2;
+            }
+
+            if (new_capacity > _capacity)
+            {
+                rehash(new_capacity);
+            }
+        }
+
+        // Destroys all elements but keeps the allocated memory, so refilling the table to a similar size won't allocate
+        void clear() noexcept
+        {
+            destroy_all();
+
+            if (_capacity > 0)
+            {
+                std::memset(_ctrl, ctrl_empty, _capacity);
+            }
+
+            _size = 0;
+            _growth_left = max_load(_capacity);
+        }
+
+        [[nodiscard]] iterator find(const Key& key) noexcept
+        {
+            const size_t index = find_index(key);
+            return index == npos ? end() : iterator_at(index);
+        }
+
+        [[nodiscard]] const_iterator find(const Key& key) const noexcept
+        {
+            const size_t index = find_index(key);
+            return index == npos ? end() : const_iterator_at(index);
+        }
+
+        [[nodiscard]] bool contains(const Key& key) const noexcept
+        {
+            return find_index(key) != npos;
+        }
+
+        [[nodiscard]] size_t count(const Key& key) const noexcept
+        {
+            return contains(key) ? 1 : 0;
+        }
+
+        size_t erase(const Key& key)
+        {
+            const size_t index = find_index(key);
+            if (index == npos)
+            {
+                return 0;
+            }
+
+            erase_index(index);
+            return 1;
+        }
+
+        iterator erase(const_iterator it)
+        {
+            const size_t index = it._ctrl - _ctrl;
+            check(index < _capacity && _ctrl[index] >= 0);
+
+            erase_index(index);
+            return iterator_at(index);
+        }
+
+    protected:
+        // Constructs a value from args if no value with the key exists yet
+        template <typename...Args>
+        std::pair<iterator, bool> emplace_unique(const Key& key, Args&&...args)
+        {
+            const size_t hash = hash_key(key);
+
+            if (const size_t index = find_index(key, hash); index != npos)
+            {
+                return { iterator_at(index), false };
+            }
+
+            if (_capacity == 0)
+            {
+                rehash(min_capacity);
+            }
+
+            size_t index = find_insert_index(hash);
+            if (_ctrl[index] == ctrl_empty && _growth_left == 0)
+            {
+                // Rehashing either grows the table or clears out deleted slots if there are lots of them
+                rehash(_size + 1 > max_load(_capacity) / 2 ? _capacity * 2 : _capacity);
+                index = find_insert_index(hash);
+            }
+
+            new (_slots + index) Value(std::forward<Args>(args)...);
+
+            if (_ctrl[index] == ctrl_empty)
+            {
+                _growth_left--;
+            }
+
+            _ctrl[index] = h2(hash);
+            _size++;
+
+            return { iterator_at(index), true };
+        }
+
+    private:
+        static constexpr int8_t ctrl_empty = -128;
+        static constexpr int8_t ctrl_deleted = -2;
+        static constexpr size_t min_capacity = 8;
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        // Tables are kept at most 7/8 full, including deleted slots, so probing always terminates
+        [[nodiscard]] static constexpr size_t max_load(size_t capacity) noexcept
+        {
+            return capacity - capacity / 8;
+        }
+
+        [[nodiscard]] static size_t hash_key(const Key& key) noexcept
+        {
+            return hash_mix(Hash{}(key));
+        }
+
+        [[nodiscard]] static int8_t h2(size_t hash) noexcept
+        {
+            return static_cast<int8_t>(hash & 0x7F);
+        }
+
+        [[nodiscard]] size_t probe_start(size_t hash) const noexcept
+        {
+            return (hash >> 7) & (_capacity - 1);
+        }
+
+        [[nodiscard]] iterator iterator_at(size_t index) noexcept
+        {
+            return iterator(_ctrl + index, _slots + index, _ctrl + _capacity);
+        }
+
+        [[nodiscard]] const_iterator const_iterator_at(size_t index) const noexcept
+        {
+            return const_iterator(_ctrl + index, _slots + index, _ctrl + _capacity);
+        }
+
+        [[nodiscard]] size_t find_index(const Key& key) const noexcept
+        {
+            return find_index(key, hash_key(key));
+        }
+
+        [[nodiscard]] size_t find_index(const Key& key, size_t hash) const noexcept
+        {
+            if (_capacity == 0)
+            {
+                return npos;
+            }
+
+            const int8_t tag = h2(hash);
+            const size_t mask = _capacity - 1;
+
+            for (size_t index = probe_start(hash); ; index = (index + 1) & mask)
+            {
+                const int8_t ctrl = _ctrl[index];
+                if (ctrl == tag && KeyEqual{}(KeyOf{}(_slots[index]), key))
+                {
+                    return index;
+                }
+
+                if (ctrl == ctrl_empty)
+                {
+                    return npos;
+                }
+            }
+        }
+
+        // Finds the first empty or deleted slot along the probe sequence for the hash
+        [[nodiscard]] size_t find_insert_index(size_t hash) const noexcept
+        {
+            check(_capacity > 0);
+
+            const size_t mask = _capacity - 1;
+            size_t index = probe_start(hash);
+
+            while (_ctrl[index] >= 0)
+            {
+                index = (index + 1) & mask;
+            }
+
+            return index;
+        }
+
+        void erase_index(size_t index)
+        {
+            _slots[index].~Value();
+            _size--;
+
+            // With linear probing a slot can be marked empty rather than deleted
+            // if the next slot is empty, since no probe sequence can continue through it
+            if (_ctrl[(index + 1) & (_capacity - 1)] == ctrl_empty)
+            {
+                _ctrl[index] = ctrl_empty;
+                _growth_left++;
+            }
+            else
+            {
+                _ctrl[index] = ctrl_deleted;
+            }
+        }
+
+        void rehash(size_t new_capacity)
+        {
+            check(new_capacity >= min_capacity && (new_capacity & (new_capacity - 1)) == 0);
+            check(max_load(new_capacity) >= _size);
+
+            int8_t* const old_ctrl = _ctrl;
+            Value* const old_slots = _slots;
+            const size_t old_capacity = _capacity;
+
+            _ctrl = new int8_t[new_capacity];
+            _slots = static_cast<Value*>(::operator new(new_capacity * sizeof(Value), std::align_val_t(alignof(Value))));
+            _capacity = new_capacity;
+            _growth_left = max_load(new_capacity) - _size;
+            std::memset(_ctrl, ctrl_empty, new_capacity);
+
+            for (size_t i = 0; i < old_capacity; i++)
+            {
+                if (old_ctrl[i] >= 0)
+                {
+                    const size_t hash = hash_key(KeyOf{}(old_slots[i]));
+                    const size_t index = find_insert_index(hash);
+
+                    new (_slots + index) Value(std::move(old_slots[i]));
+                    old_slots[i].~Value();
+                    _ctrl[index] = h2(hash);
+                }
+            }
+
+            deallocate(old_ctrl, old_slots);
+        }
+
+        void destroy_all() noexcept
+        {
+            if constexpr (!std::is_trivially_destructible_v<Value>)
+            {
+                for (size_t i = 0; i < _capacity; i++)
+                {
+                    if (_ctrl[i] >= 0)
+                    {
+                        _slots[i].~Value();
+                    }
+                }
+            }
+        }
+
+        static void deallocate(int8_t* ctrl, Value* slots) noexcept
+        {
+            if (ctrl)
+            {
+                delete[] ctrl;
+                ::operator delete(slots, std::align_val_t(alignof(Value)));
+            }
+        }
+
+        int8_t* _ctrl = nullptr;
+        Value* _slots = nullptr;
+        size_t _capacity = 0;
+        size_t _size = 0;
+        size_t _growth_left = 0;
+    };
+}
@@ -6,6 +6,7 @@
 #include <string>
 
 #include "check.h"
+#include "small_vector.h"
 #include "vectools.h"
 
 namespace utils
@@ -35,8 +36,8 @@ namespace utils
         listener_handle get_new_handle();
 
         listener_handle _next_handle = 0;
-        std::vector<named_listener> _listeners;
-        std::vector<std::function<void()>> _pending_actions;
+        small_vector<named_listener, 2> _listeners;
+        small_vector<std::function<void()>, 1> _pending_actions;
         bool _is_invoking = false;
     };
 
@@ -102,7 +103,7 @@ namespace utils
         }
         else
         {
-            vectools::remove_all<named_listener>(_listeners, [&](const named_listener& listener)
+            vectools::remove_all(_listeners, [&](const named_listener& listener)
             {
                 return std::get<listener_handle>(listener) == handle;
             });
@@ -120,7 +121,7 @@ namespace utils
         }
         else
         {
-            vectools::remove_all<named_listener>(_listeners, [&](const named_listener& listener)
+            vectools::remove_all(_listeners, [&](const named_listener& listener)
             {
                 return std::get<std::string>(listener) == name;
             });
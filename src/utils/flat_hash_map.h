@@ -0,0 +1,103 @@
+#pragma once
+
+#include <tuple>
+#include <utility>
+
+#include "detail/flat_hash_table.h"
+
+namespace utils
+{
+    namespace detail
+    {
+        struct flat_hash_map_key_of
+        {
+            template <typename Key, typename Value>
+            const Key& operator()(const std::pair<const Key, Value>& value) const noexcept
+            {
+                return value.first;
+            }
+        };
+    }
+
+    // Cache friendly replacement for std::unordered_map that stores all entries in one contiguous allocation
+    // Unlike std::unordered_map, references and iterators are invalidated whenever the map grows
+    // clear() keeps the allocated memory so tables that are rebuilt every frame won't reallocate
+    template <typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class flat_hash_map
+        : public detail::flat_hash_table<std::pair<const Key, Value>, Key, detail::flat_hash_map_key_of, Hash, KeyEqual>
+    {
+        using Base = detail::flat_hash_table<std::pair<const Key, Value>, Key, detail::flat_hash_map_key_of, Hash, KeyEqual>;
+
+    public:
+        using mapped_type = Value;
+        using typename Base::value_type;
+        using typename Base::iterator;
+        using typename Base::const_iterator;
+
+        flat_hash_map() noexcept = default;
+
+        template <typename...Args>
+        std::pair<iterator, bool> try_emplace(const Key& key, Args&&...args)
+        {
+            return this->emplace_unique(key,
+                std::piecewise_construct,
+                std::forward_as_tuple(key),
+                std::forward_as_tuple(std::forward<Args>(args)...)
+            );
+        }
+
+        template <typename...Args>
+        std::pair<iterator, bool> try_emplace(Key&& key, Args&&...args)
+        {
+            // The key is only moved from once the slot is constructed, after probing has finished with it
+            return this->emplace_unique(key,
+                std::piecewise_construct,
+                std::forward_as_tuple(std::move(key)),
+                std::forward_as_tuple(std::forward<Args>(args)...)
+            );
+        }
+
+        std::pair<iterator, bool> insert(const value_type& value)
+        {
+            return this->emplace_unique(value.first, value);
+        }
+
+        template <typename V>
+        std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value)
+        {
+            auto result = try_emplace(key, std::forward<V>(value));
+            if (!result.second)
+            {
+                result.first->second = std::forward<V>(value);
+            }
+
+            return result;
+        }
+
+        [[nodiscard]] Value& operator[](const Key& key)
+        {
+            return try_emplace(key).first->second;
+        }
+
+        [[nodiscard]] Value& operator[](Key&& key)
+        {
+            return try_emplace(std::move(key)).first->second;
+        }
+
+        [[nodiscard]] Value& at(const Key& key)
+        {
+            const iterator it = this->find(key);
+            check(it != this->end());
+
+            return it->second;
+        }
+
+        [[nodiscard]] const Value& at(const Key& key) const
+        {
+            const const_iterator it = this->find(key);
+            check(it != this->end());
+
+            return it->second;
+        }
+    };
+}
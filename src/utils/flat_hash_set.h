@@ -0,0 +1,83 @@
+#pragma once
+
+#include <utility>
+
+#include "detail/flat_hash_table.h"
+
+namespace utils
+{
+    namespace detail
+    {
+        struct flat_hash_set_key_of
+        {
+            template <typename Key>
+            const Key& operator()(const Key& value) const noexcept
+            {
+                return value;
+            }
+        };
+    }
+
+    // Cache friendly replacement for std::unordered_set that stores all elements in one contiguous allocation
+    // Unlike std::unordered_set, references and iterators are invalidated whenever the set grows
+    // clear() keeps the allocated memory so sets that are rebuilt every frame won't reallocate
+    template <typename Key, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+    class flat_hash_set
+        : private detail::flat_hash_table<Key, Key, detail::flat_hash_set_key_of, Hash, KeyEqual>
+    {
+        using Base = detail::flat_hash_table<Key, Key, detail::flat_hash_set_key_of, Hash, KeyEqual>;
+
+    public:
+        using typename Base::key_type;
+        using typename Base::value_type;
+        using typename Base::size_type;
+        using typename Base::difference_type;
+        using typename Base::hasher;
+        using typename Base::key_equal;
+
+        // Elements of a set can never be modified in place as that would change their hash
+        using iterator = typename Base::const_iterator;
+        using const_iterator = typename Base::const_iterator;
+
+        flat_hash_set() noexcept = default;
+
+        [[nodiscard]] const_iterator begin() const noexcept { return Base::begin(); }
+        [[nodiscard]] const_iterator end() const noexcept { return Base::end(); }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return Base::begin(); }
+        [[nodiscard]] const_iterator cend() const noexcept { return Base::end(); }
+
+        using Base::size;
+        using Base::empty;
+        using Base::capacity;
+        using Base::reserve;
+        using Base::clear;
+        using Base::contains;
+        using Base::count;
+
+        [[nodiscard]] const_iterator find(const Key& key) const noexcept
+        {
+            return Base::find(key);
+        }
+
+        std::pair<const_iterator, bool> insert(const Key& key)
+        {
+            return Base::emplace_unique(key, key);
+        }
+
+        std::pair<const_iterator, bool> insert(Key&& key)
+        {
+            // The key is only moved from once the slot is constructed, after probing has finished with it
+            return Base::emplace_unique(key, std::move(key));
+        }
+
+        size_t erase(const Key& key)
+        {
+            return Base::erase(key);
+        }
+
+        const_iterator erase(const_iterator it)
+        {
+            return Base::erase(it);
+        }
+    };
+}
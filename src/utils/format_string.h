@@ -0,0 +1,292 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+namespace strtools
+{
+    namespace detail
+    {
+        // Deliberately not constexpr so that calling it during constant evaluation fails compilation
+        // The diagnostic will point at the offending format string
+        inline void invalid_format_string(const char*) { }
+
+        // The type an argument is treated as when formatting, strings are always const char*
+        template <typename T>
+        using format_arg_t = std::conditional_t<
+            std::is_same_v<std::decay_t<T>, char*>,
+            const char*,
+            std::decay_t<T>
+        >;
+
+        struct FormatArgInfo
+        {
+            bool integral;
+            bool floating;
+            bool string;
+            bool pointer;
+            size_t size;
+        };
+
+        template <typename T>
+        consteval FormatArgInfo make_format_arg_info()
+        {
+            using Arg = format_arg_t<T>;
+            constexpr bool is_string = std::is_same_v<Arg, const char*>;
+
+            return FormatArgInfo {
+                .integral = std::is_integral_v<Arg> || std::is_enum_v<Arg>,
+                .floating = std::is_floating_point_v<Arg>,
+                .string = is_string,
+                .pointer = std::is_pointer_v<Arg> || std::is_null_pointer_v<Arg>,
+                .size = sizeof(Arg)
+            };
+        }
+    }
+
+    // Wraps a format string that is only checked at runtime, for formats that are not known at compile time
+    struct runtime_format_string
+    {
+        const char* format;
+    };
+
+    [[nodiscard]] constexpr runtime_format_string runtime_format(const char* format) noexcept
+    {
+        return runtime_format_string { format };
+    }
+
+    // A printf style format string which is checked against its arguments at compile time
+    // Mismatched argument counts, conversions that don't match the argument type and
+    // integer conversions with the wrong length modifier (e.g %d for a size_t) fail to compile
+    template <typename...Args>
+    class format_string
+    {
+    public:
+        template <typename T>
+        requires std::is_convertible_v<const T&, const char*>
+        consteval format_string(const T& format)
+            : _format(format)
+        {
+            validate();
+        }
+
+        constexpr format_string(runtime_format_string format) noexcept
+            : _format(format.format)
+            , _runtime(true)
+        { }
+
+        [[nodiscard]] constexpr const char* get() const noexcept
+        {
+            return _format;
+        }
+
+        // Runtime formats may point to a temporary buffer rather than a string literal
+        [[nodiscard]] constexpr bool runtime() const noexcept
+        {
+            return _runtime;
+        }
+
+    private:
+        enum class LengthModifier
+        {
+            none,
+            hh,
+            h,
+            l,
+            ll,
+            j,
+            z,
+            t,
+            L
+        };
+
+        consteval void validate() const
+        {
+            constexpr std::array<detail::FormatArgInfo, sizeof...(Args)> arg_infos = {
+                detail::make_format_arg_info<Args>()...
+            };
+
+            const std::string_view format = _format;
+            size_t arg_index = 0;
+
+            auto next_arg = [&]() -> const detail::FormatArgInfo&
+            {
+                if (arg_index >= arg_infos.size())
+                {
+                    detail::invalid_format_string("Format string has more conversions than arguments");
+                }
+
+                return arg_infos[arg_index++];
+            };
+
+            auto consume_star = [&](size_t& i)
+            {
+                if (i < format.size() && format[i] == '*')
+                {
+                    const detail::FormatArgInfo& arg = next_arg();
+                    if (!arg.integral || arg.size > sizeof(int))
+                    {
+                        detail::invalid_format_string("'*' width and precision require an int argument");
+                    }
+
+                    i++;
+                }
+                else
+                {
+                    while (i < format.size() && format[i] >= '0' && format[i] <= '9')
+                    {
+                        i++;
+                    }
+                }
+            };
+
+            for (size_t i = 0; i < format.size(); i++)
+            {
+                if (format[i] != '%')
+                {
+                    continue;
+                }
+
+                if (++i >= format.size())
+                {
+                    detail::invalid_format_string("Format string ends with an incomplete conversion");
+                }
+
+                if (format[i] == '%')
+                {
+                    continue;
+                }
+
+                // Flags
+                while (i < format.size() && std::string_view("-+ #0").find(format[i]) != std::string_view::npos)
+                {
+                    i++;
+                }
+
+                // Width and precision
+                consume_star(i);
+                if (i < format.size() && format[i] == '.')
+                {
+                    i++;
+                    consume_star(i);
+                }
+
+                // Length modifier
+                LengthModifier length = LengthModifier::none;
+                if (i + 1 < format.size() && format[i] == 'h' && format[i + 1] == 'h')
+                {
+                    length = LengthModifier::hh;
+                    i += 2;
+                }
+                else if (i + 1 < format.size() && format[i] == 'l' && format[i + 1] == 'l')
+                {
+                    length = LengthModifier::ll;
+                    i += 2;
+                }
+                else if (i < format.size())
+                {
+                    switch (format[i])
+                    {
+                        case 'h': length = LengthModifier::h; i++; break;
+                        case 'l': length = LengthModifier::l; i++; break;
+                        case 'j': length = LengthModifier::j; i++; break;
+                        case 'z': length = LengthModifier::z; i++; break;
+                        case 't': length = LengthModifier::t; i++; break;
+                        case 'L': length = LengthModifier::L; i++; break;
+                        default: break;
+                    }
+                }
+
+                if (i >= format.size())
+                {
+                    detail::invalid_format_string("Format string ends with an incomplete conversion");
+                }
+
+                const detail::FormatArgInfo& arg = next_arg();
+                switch (format[i])
+                {
+                    case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'c':
+                    {
+                        if (!arg.integral)
+                        {
+                            detail::invalid_format_string("Integer conversion used with a non integral argument");
+                        }
+
+                        if (arg.size != integer_size(length) && !(arg.size < sizeof(int) && integer_size(length) <= sizeof(int)))
+                        {
+                            detail::invalid_format_string("Integer argument size does not match the length modifier");
+                        }
+
+                        break;
+                    }
+                    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                    {
+                        if (!arg.floating)
+                        {
+                            detail::invalid_format_string("Floating point conversion used with a non floating point argument");
+                        }
+
+                        if ((length == LengthModifier::L) != (arg.size == sizeof(long double) && sizeof(long double) != sizeof(double)))
+                        {
+                            detail::invalid_format_string("Floating point argument size does not match the length modifier");
+                        }
+
+                        break;
+                    }
+                    case 's':
+                    {
+                        if (!arg.string)
+                        {
+                            detail::invalid_format_string("%s conversion used with a non string argument");
+                        }
+
+                        break;
+                    }
+                    case 'p':
+                    {
+                        if (!arg.pointer)
+                        {
+                            detail::invalid_format_string("%p conversion used with a non pointer argument");
+                        }
+
+                        break;
+                    }
+                    default:
+                    {
+                        detail::invalid_format_string("Unsupported conversion in format string");
+                        break;
+                    }
+                }
+            }
+
+            if (arg_index != arg_infos.size())
+            {
+                detail::invalid_format_string("Format string has fewer conversions than arguments");
+            }
+        }
+
+        static consteval size_t integer_size(LengthModifier length)
+        {
+            switch (length)
+            {
+                case LengthModifier::hh: return sizeof(char);
+                case LengthModifier::h: return sizeof(short);
+                case LengthModifier::l: return sizeof(long);
+                case LengthModifier::ll: return sizeof(long long);
+                case LengthModifier::j: return sizeof(intmax_t);
+                case LengthModifier::z: return sizeof(size_t);
+                case LengthModifier::t: return sizeof(ptrdiff_t);
+                default: return sizeof(int);
+            }
+        }
+
+        const char* _format;
+        bool _runtime = false;
+    };
+
+    // Used in function signatures so that the format string does not participate in argument deduction
+    template <typename...Args>
+    using format_string_for = format_string<std::type_identity_t<detail::format_arg_t<Args>>...>;
+}
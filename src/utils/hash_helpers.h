@@ -1,31 +1,56 @@
 #pragma once
 
+#include <cstdint>
 #include <tuple>
 
+namespace utils
+{
+    // Mixes the bits of a hash so that every input bit affects every output bit
+    // Needed for tables indexed by the low bits of a hash, since std::hash is the identity for integers and pointers
+    [[nodiscard]] constexpr size_t hash_mix(size_t hash) noexcept
+    {
+        uint64_t x = static_cast<uint64_t>(hash);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdull;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ull;
+        x ^= x >> 33;
+
+        return static_cast<size_t>(x);
+    }
+
+    // Combines a hash into an existing seed in an order dependent way
+    // Unlike XOR, hash_combine(a, b) != hash_combine(b, a) and equal hashes do not cancel out
+    [[nodiscard]] constexpr size_t hash_combine(size_t seed, size_t hash) noexcept
+    {
+        return hash_mix(seed + 0x9e3779b97f4a7c15ull + hash);
+    }
+}
+
 template<typename...Ts>
 struct std::hash<std::tuple<Ts...>>
 {
 private:
     template <size_t I>
-    size_t hash_inner(const std::tuple<Ts...>& tuple) const
+    size_t hash_inner(const std::tuple<Ts...>& tuple, size_t seed) const
     {
         if constexpr (I == sizeof...(Ts))
         {
-            return 0;
+            return seed;
         }
         else
         {
             const auto& item = std::get<I>(tuple);
             using Ti = std::remove_const_t<std::remove_reference_t<decltype(item)>>;
-            size_t hash = std::hash<Ti>{}(item);
+            const size_t hash = std::hash<Ti>{}(item);
 
-            return hash ^= hash_inner<I + 1>(tuple);
+            return hash_inner<I + 1>(tuple, utils::hash_combine(seed, hash));
         }
     }
 
 public:
     size_t operator()(const std::tuple<Ts...>& tuple) const
     {
-        return hash_inner<0>(tuple);
+        return hash_inner<0>(tuple, 0);
     }
-};
\ No newline at end of file
+};
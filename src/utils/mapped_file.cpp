@@ -0,0 +1,127 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#pragma warning( push, 0 )
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#pragma warning( pop )
+
+namespace io
+{
+    MappedFile::MappedFile(const std::string& filepath)
+    {
+#ifdef _WIN32
+        const HANDLE file = CreateFileA(
+            filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+        );
+
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+
+        LARGE_INTEGER file_size;
+        if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0)
+        {
+            // The view keeps the mapping alive, so neither handle is needed once it has been mapped
+            if (const HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr))
+            {
+                if (const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0))
+                {
+                    _data = static_cast<const std::byte*>(view);
+                    _size = static_cast<size_t>(file_size.QuadPart);
+                }
+
+                CloseHandle(mapping);
+            }
+        }
+
+        CloseHandle(file);
+#else
+        const int file = open(filepath.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            return;
+        }
+
+        // The mapping holds its own reference to the file, so the descriptor can be closed straight away
+        struct stat file_stat = {};
+        if (fstat(file, &file_stat) == 0 && file_stat.st_size > 0)
+        {
+            const size_t file_size = static_cast<size_t>(file_stat.st_size);
+            void* view = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+            if (view != MAP_FAILED)
+            {
+                _data = static_cast<const std::byte*>(view);
+                _size = file_size;
+            }
+        }
+
+        ::close(file);
+#endif
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : _data(std::exchange(other._data, nullptr))
+        , _size(std::exchange(other._size, 0))
+    { }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            _data = std::exchange(other._data, nullptr);
+            _size = std::exchange(other._size, 0);
+        }
+
+        return *this;
+    }
+
+    bool MappedFile::is_open() const noexcept
+    {
+        return _data != nullptr;
+    }
+
+    const std::byte* MappedFile::data() const noexcept
+    {
+        return _data;
+    }
+
+    size_t MappedFile::size() const noexcept
+    {
+        return _size;
+    }
+
+    void MappedFile::close() noexcept
+    {
+        if (!_data)
+        {
+            return;
+        }
+
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+#else
+        munmap(const_cast<std::byte*>(_data), _size);
+#endif
+
+        _data = nullptr;
+        _size = 0;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace io
+{
+    // Read only memory mapping of a whole file, which is unmapped when destroyed
+    // Pages are only read from disk as they're touched, so large files can be opened without reading them up front
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+
+        // Maps the file, is_open() is false if it couldn't be opened or is empty
+        explicit MappedFile(const std::string& filepath);
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile(MappedFile&& other) noexcept;
+        ~MappedFile();
+
+        MappedFile& operator=(const MappedFile&) = delete;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        [[nodiscard]] bool is_open() const noexcept;
+        [[nodiscard]] const std::byte* data() const noexcept;
+        [[nodiscard]] size_t size() const noexcept;
+
+    private:
+        void close() noexcept;
+
+        const std::byte* _data = nullptr;
+        size_t _size = 0;
+    };
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#include "check.h"
+
+namespace utils
+{
+    // Maps a float onto an unsigned integer with the same ordering, so floats can be used as radix sort keys
+    [[nodiscard]] constexpr uint32_t to_sortable_bits(float x) noexcept
+    {
+        const uint32_t bits = std::bit_cast<uint32_t>(x);
+        return (bits & 0x80000000u)
+            ? ~bits
+            : bits | 0x80000000u;
+    }
+
+    // Stable LSD radix sort of items by an unsigned integer key of up to 64 bits, one byte per pass
+    // scratch must be at least as large as items and is clobbered
+    // Passes where every key shares the same byte are skipped, so keys that only use a few bits are cheap
+    template <typename T, typename KeyFunc>
+    void radix_sort(std::span<T> items, std::span<T> scratch, KeyFunc&& key_func)
+    {
+        using Key = std::invoke_result_t<KeyFunc&, const T&>;
+        static_assert(std::is_unsigned_v<Key> && sizeof(Key) <= sizeof(uint64_t), "radix_sort requires unsigned integer keys");
+
+        check(scratch.size() >= items.size());
+
+        // Narrower keys need fewer passes, and are widened before being shifted as shifting them by their width or
+        // more is undefined
+        constexpr size_t num_passes = sizeof(Key);
+        constexpr size_t num_buckets = 256;
+
+        const auto key_byte = [&](const T& item, size_t pass) -> uint64_t
+        {
+            return (static_cast<uint64_t>(key_func(item)) >> (pass * 8)) & 0xFF;
+        };
+
+        std::array<std::array<size_t, num_buckets>, num_passes> histograms = { };
+        for (const T& item : items)
+        {
+            const uint64_t key = static_cast<uint64_t>(key_func(item));
+            for (size_t pass = 0; pass < num_passes; pass++)
+            {
+                histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+            }
+        }
+
+        T* src = items.data();
+        T* dst = scratch.data();
+
+        for (size_t pass = 0; pass < num_passes; pass++)
+        {
+            std::array<size_t, num_buckets>& histogram = histograms[pass];
+
+            const uint64_t first_byte = items.empty() ? 0 : key_byte(src[0], pass);
+            if (histogram[first_byte] == items.size())
+            {
+                continue;
+            }
+
+            size_t offset = 0;
+            for (size_t& count : histogram)
+            {
+                offset += std::exchange(count, offset);
+            }
+
+            for (size_t i = 0; i < items.size(); i++)
+            {
+                const uint64_t byte = key_byte(src[i], pass);
+                dst[histogram[byte]++] = std::move(src[i]);
+            }
+
+            std::swap(src, dst);
+        }
+
+        if (src != items.data())
+        {
+            std::move(src, src + items.size(), items.data());
+        }
+    }
+}
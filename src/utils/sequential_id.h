@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+namespace utils
+{
+    namespace detail
+    {
+        // Hands out the lowest id not currently in use
+        class SequentialIdPool
+        {
+        public:
+            [[nodiscard]] uint32_t acquire()
+            {
+                std::lock_guard lock(_lock);
+                if (_free_ids.empty())
+                {
+                    return _next_id++;
+                }
+
+                const uint32_t id = _free_ids.top();
+                _free_ids.pop();
+                return id;
+            }
+
+            void release(uint32_t id)
+            {
+                std::lock_guard lock(_lock);
+                _free_ids.push(id);
+            }
+
+        private:
+            std::mutex _lock;
+            uint32_t _next_id = 0;
+            std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<>> _free_ids;
+        };
+    }
+
+    // A small id unique among the live objects holding a SequentialId with the same Tag type, counting up from zero
+    // Ids are released when their holder is destroyed and handed out again lowest first, so the ids in use stay
+    // below the number of live objects, which makes them suitable for packing into sort keys
+    // Copies are given their own id
+    template <typename Tag>
+    class SequentialId
+    {
+    public:
+        SequentialId()
+            : _id(pool().acquire())
+        { }
+
+        SequentialId(const SequentialId&)
+            : SequentialId()
+        { }
+
+        SequentialId& operator=(const SequentialId&) noexcept
+        {
+            return *this;
+        }
+
+        ~SequentialId()
+        {
+            pool().release(_id);
+        }
+
+        [[nodiscard]] uint32_t value() const noexcept
+        {
+            return _id;
+        }
+
+    private:
+        [[nodiscard]] static detail::SequentialIdPool& pool()
+        {
+            // Never destroyed, so that holders destroyed during static destruction can still release their ids
+            static detail::SequentialIdPool* pool = new detail::SequentialIdPool();
+            return *pool;
+        }
+
+        uint32_t _id;
+    };
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "check.h"
+
+namespace utils
+{
+    // A vector which stores up to N elements inline before falling back to the heap
+    // Intended for small bookkeeping lists that are usually empty or only hold a few elements,
+    // where a std::vector would allocate on first insert
+    // Unlike std::vector, moving a small_vector that is still inline moves the elements individually
+    template <typename T, size_t N>
+    class small_vector
+    {
+        static_assert(N > 0, "small_vector requires an inline capacity of at least one");
+
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference = T&;
+        using const_reference = const T&;
+        using pointer = T*;
+        using const_pointer = const T*;
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        small_vector() noexcept
+            : _data(inline_data())
+            , _size(0)
+            , _capacity(N)
+        { }
+
+        small_vector(std::initializer_list<T> values)
+            : small_vector()
+        {
+            reserve(values.size());
+            for (const T& value : values)
+            {
+                push_back(value);
+            }
+        }
+
+        small_vector(const small_vector& other)
+            : small_vector()
+        {
+            reserve(other._size);
+            std::uninitialized_copy(other.begin(), other.end(), _data);
+            _size = other._size;
+        }
+
+        small_vector(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+            : small_vector()
+        {
+            steal(std::move(other));
+        }
+
+        ~small_vector()
+        {
+            clear();
+            release_heap();
+        }
+
+        small_vector& operator=(const small_vector& other)
+        {
+            if (this != &other)
+            {
+                clear();
+                reserve(other._size);
+                std::uninitialized_copy(other.begin(), other.end(), _data);
+                _size = other._size;
+            }
+
+            return *this;
+        }
+
+        small_vector& operator=(small_vector&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            if (this != &other)
+            {
+                clear();
+                release_heap();
+                steal(std::move(other));
+            }
+
+            return *this;
+        }
+
+        [[nodiscard]] iterator begin() noexcept { return _data; }
+        [[nodiscard]] iterator end() noexcept { return _data + _size; }
+        [[nodiscard]] const_iterator begin() const noexcept { return _data; }
+        [[nodiscard]] const_iterator end() const noexcept { return _data + _size; }
+        [[nodiscard]] const_iterator cbegin() const noexcept { return begin(); }
+        [[nodiscard]] const_iterator cend() const noexcept { return end(); }
+
+        [[nodiscard]] T* data() noexcept { return _data; }
+        [[nodiscard]] const T* data() const noexcept { return _data; }
+        [[nodiscard]] size_t size() const noexcept { return _size; }
+        [[nodiscard]] size_t capacity() const noexcept { return _capacity; }
+        [[nodiscard]] bool empty() const noexcept { return _size == 0; }
+
+        // If the elements are still stored inline, in which case no heap memory is owned
+        [[nodiscard]] bool is_inline() const noexcept { return _data == inline_data(); }
+
+        [[nodiscard]] static constexpr size_t inline_capacity() noexcept { return N; }
+
+        [[nodiscard]] T& operator[](size_t index)
+        {
+            check(index < _size);
+            return _data[index];
+        }
+
+        [[nodiscard]] const T& operator[](size_t index) const
+        {
+            check(index < _size);
+            return _data[index];
+        }
+
+        [[nodiscard]] T& front() { return (*this)[0]; }
+        [[nodiscard]] const T& front() const { return (*this)[0]; }
+        [[nodiscard]] T& back() { return (*this)[_size - 1]; }
+        [[nodiscard]] const T& back() const { return (*this)[_size - 1]; }
+
+        void reserve(size_t capacity)
+        {
+            if (capacity > _capacity)
+            {
+                T* new_data = allocate(capacity);
+                relocate(new_data);
+                _capacity = capacity;
+            }
+        }
+
+        void push_back(const T& value)
+        {
+            emplace_back(value);
+        }
+
+        void push_back(T&& value)
+        {
+            emplace_back(std::move(value));
+        }
+
+        template <typename...Args>
+        T& emplace_back(Args&&...args)
+        {
+            if (_size == _capacity)
+            {
+                // Construct the new element before relocating in case args reference an existing element
+                const size_t new_capacity = _capacity * 2;
+                T* new_data = allocate(new_capacity);
+                new (new_data + _size) T(std::forward<Args>(args)...);
+
+                relocate(new_data);
+                _capacity = new_capacity;
+            }
+            else
+            {
+                new (_data + _size) T(std::forward<Args>(args)...);
+            }
+
+            return _data[_size++];
+        }
+
+        void pop_back()
+        {
+            check(_size > 0);
+            _data[--_size].~T();
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            return erase(pos, pos + 1);
+        }
+
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            check(first >= begin() && last <= end() && first <= last);
+
+            T* const erase_begin = _data + (first - _data);
+            T* const erase_end = _data + (last - _data);
+
+            T* const new_end = std::move(erase_end, end(), erase_begin);
+            std::destroy(new_end, end());
+            _size = new_end - _data;
+
+            return erase_begin;
+        }
+
+        void clear() noexcept
+        {
+            std::destroy(begin(), end());
+            _size = 0;
+        }
+
+    private:
+        [[nodiscard]] T* inline_data() noexcept
+        {
+            return reinterpret_cast<T*>(_inline_storage);
+        }
+
+        [[nodiscard]] const T* inline_data() const noexcept
+        {
+            return reinterpret_cast<const T*>(_inline_storage);
+        }
+
+        [[nodiscard]] static T* allocate(size_t capacity)
+        {
+            return static_cast<T*>(::operator new(capacity * sizeof(T), std::align_val_t(alignof(T))));
+        }
+
+        // Moves the existing elements into new_data, which must be a heap allocation, and adopts it
+        void relocate(T* new_data)
+        {
+            std::uninitialized_move(begin(), end(), new_data);
+            std::destroy(begin(), end());
+
+            release_heap();
+            _data = new_data;
+        }
+
+        void release_heap() noexcept
+        {
+            if (!is_inline())
+            {
+                ::operator delete(_data, std::align_val_t(alignof(T)));
+                _data = inline_data();
+                _capacity = N;
+            }
+        }
+
+        // Takes the contents of other, which is left empty, assumes this is empty and inline
+        void steal(small_vector&& other)
+        {
+            if (other.is_inline())
+            {
+                std::uninitialized_move(other.begin(), other.end(), _data);
+                _size = other._size;
+                other.clear();
+            }
+            else
+            {
+                _data = std::exchange(other._data, other.inline_data());
+                _size = std::exchange(other._size, 0);
+                _capacity = std::exchange(other._capacity, N);
+            }
+        }
+
+        T* _data;
+        size_t _size;
+        size_t _capacity;
+        alignas(T) std::byte _inline_storage[N * sizeof(T)];
+    };
+
+#pragma region Comparison Operators
+
+    template <typename T, size_t N>
+    [[nodiscard]] bool operator==(const small_vector<T, N>& a, const small_vector<T, N>& b)
+    {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+#pragma endregion
+}
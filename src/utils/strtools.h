@@ -5,6 +5,7 @@
 #include <vector>
 
 #include "traits.h"
+#include "format_string.h"
 
 namespace strtools
 {
@@ -13,28 +14,28 @@ namespace strtools
         std::vector<char>& get_catf_buffer();
     }
 
-    // Creates a formatted string in a temporary buffer for immediate use
-    // The result can safely be used until the next time catf/catf_temp are called
+    // Creates a formatted string in a thread local buffer for immediate use without allocating
+    // The result can safely be used until the next time catf/catf_temp are called on the same thread
     template <typename ...Args>
-    [[nodiscard]] const char* catf_temp(const char* format, Args...args)
+    [[nodiscard]] const char* catf_temp(format_string_for<Args...> format, Args...args)
     {
         static_assert(traits::for_none<std::is_class, Args...>(), "strtools::catf does not work with classes");
         std::vector<char>& char_buf = detail::get_catf_buffer();
 
-        const int32_t msg_size = snprintf(char_buf.data(), char_buf.size(), format, args...);
+        const int32_t msg_size = snprintf(char_buf.data(), char_buf.size(), format.get(), args...);
         if (msg_size < static_cast<int32_t>(char_buf.size()))
         {
             return char_buf.data();
         }
 
         char_buf.resize(msg_size + 1);
-        return catf_temp(format, args...);
+        return catf_temp<Args...>(format, args...);
     }
 
     template <typename ...Args>
-    [[nodiscard]] std::string catf(const char* format, Args...args)
+    [[nodiscard]] std::string catf(format_string_for<Args...> format, Args...args)
     {
-        return catf_temp(format, args...);
+        return catf_temp<Args...>(format, args...);
     }
 
     template <typename T>
@@ -54,7 +55,7 @@ namespace strtools
         char fmt_buf[buf_size];
 
         snprintf(fmt_buf, buf_size, "%%%s%dd", delim, digits);
-        return catf(fmt_buf, num);
+        return catf<T>(runtime_format(fmt_buf), num);
     }
 
     template <typename Out>
@@ -6,8 +6,9 @@
 
 namespace vectools
 {
-    template <typename T>
-    void remove_all(std::vector<T>& v, const std::function<bool(const T&)>& condition)
+    // Vector is any std::vector like container, such as utils::small_vector
+    template <typename Vector>
+    void remove_all(Vector& v, const std::function<bool(const typename Vector::value_type&)>& condition)
     {
         v.erase(
             std::remove_if(v.begin(), v.end(), condition),
@@ -15,14 +16,14 @@ namespace vectools
         );
     }
 
-    template <typename T>
-    void remove(std::vector<T>& v, const T& item)
+    template <typename Vector>
+    void remove(Vector& v, const typename Vector::value_type& item)
     {
         v.erase(std::remove(v.begin(), v.end(), item), v.end());
     }
 
-    template <typename T>
-    bool contains(const std::vector<T>& v, const T& item)
+    template <typename Vector>
+    bool contains(const Vector& v, const typename Vector::value_type& item)
     {
         return std::find(v.begin(), v.end(), item) != v.end();
     }